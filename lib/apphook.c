@@ -25,6 +25,7 @@
 #include "messages.h"
 #include "children.h"
 #include "dnscache.h"
+#include "host-resolve.h"
 #include "alarms.h"
 #include "stats/stats-registry.h"
 #include "metrics/metrics.h"
@@ -221,7 +222,6 @@ app_startup(void)
   crypto_init();
   hostname_global_init();
   dns_caching_global_init();
-  dns_caching_thread_init();
   afinter_global_init();
   child_manager_init();
   alarm_init();
@@ -271,6 +271,7 @@ app_shutdown(void)
   tz_cache_global_deinit();
   msg_stats_deinit();
   run_application_hook(AH_SHUTDOWN);
+  host_resolve_global_deinit();
 
   log_transport_global_deinit();
   filterx_global_deinit();
@@ -292,7 +293,6 @@ app_shutdown(void)
   g_list_free(application_hooks);
   g_list_free_full(application_thread_init_hooks, g_free);
   g_list_free_full(application_thread_deinit_hooks, g_free);
-  dns_caching_thread_deinit();
   dns_caching_global_deinit();
   hostname_global_deinit();
   crypto_deinit();
@@ -352,7 +352,6 @@ void
 app_thread_start(void)
 {
   scratch_buffers_allocator_init();
-  dns_caching_thread_init();
   main_loop_call_thread_init();
   run_application_thread_init_hooks();
 }
@@ -362,7 +361,6 @@ app_thread_stop(void)
 {
   run_application_thread_deinit_hooks();
   main_loop_call_thread_deinit();
-  dns_caching_thread_deinit();
   scratch_buffers_allocator_deinit();
   timeutils_cache_deinit();
 }
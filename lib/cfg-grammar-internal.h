@@ -49,6 +49,7 @@
 #include "rewrite/rewrite-expr-parser.h"
 #include "block-ref-parser.h"
 #include "template/user-function.h"
+#include "template/jit.h"
 #include "cfg-block.h"
 #include "cfg-path.h"
 #include "multi-line/multi-line-factory.h"
@@ -264,6 +264,8 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_BATCH_SIZE                  10601
 %token KW_FILTERX_JIT                 10602
 %token KW_FILTERX_JIT_DEBUG_INFO      10603
+%token KW_TEMPLATE_JIT                10604
+%token KW_FILTERX_JIT_CACHE_DIR       10605
 
 %token KW_STATS                       10400
 %token KW_FREQ                        10401
@@ -304,12 +306,14 @@ main_location_print (FILE *yyo, YYLTYPE const * const yylocp)
 %token KW_PERSIST_ONLY                10140
 %token KW_USE_RCPTID                  10141
 %token KW_USE_UNIQID                  10142
+%token KW_ASYNC                       10143
 
 %token KW_TZ_CONVERT                  10150
 %token KW_TS_FORMAT                   10151
 %token KW_FRAC_DIGITS                 10152
 
 %token KW_LOG_FIFO_SIZE               10160
+%token KW_LOG_FIFO_TYPE               10161
 %token KW_LOG_FETCH_LIMIT             10162
 %token KW_LOG_IW_SIZE                 10163
 %token KW_LOG_PREFIX                  10164
@@ -1157,6 +1161,12 @@ options_item
 	    filterx_config_set_jit_debug_info(fx_cfg, mode);
 	    free($3);
 	  }
+	| KW_FILTERX_JIT_CACHE_DIR '(' path_no_check ')'
+	  {
+	    filterx_config_set_jit_cache_dir(filterx_config_get(configuration), $3);
+	    free($3);
+	  }
+	| KW_TEMPLATE_JIT '(' yesno ')' { log_template_jit_config_enable(log_template_jit_config_get(configuration), $3); }
 	| { last_template_options = &configuration->template_options; } template_option
 	| { last_host_resolve_options = &configuration->host_resolve_options; } host_resolve_option
 	| { last_stats_options = &configuration->stats_options; last_healthcheck_options = &configuration->healthcheck_options; } stat_option
@@ -1232,7 +1242,8 @@ yesnoauto
 
 dnsmode
 	: yesno					{ $$ = $1; }
-	| KW_PERSIST_ONLY                       { $$ = 2; }
+	| KW_PERSIST_ONLY                       { $$ = HOST_RESOLVE_USE_DNS_PERSIST_ONLY; }
+	| KW_ASYNC                              { $$ = HOST_RESOLVE_USE_DNS_ASYNC; }
 	;
 
 nonnegative_integer64
@@ -1431,6 +1442,11 @@ dest_driver_option
         /* NOTE: plugins need to set "last_driver" in order to incorporate this rule in their grammar */
 
 	: KW_LOG_FIFO_SIZE '(' positive_integer ')'	{ ((LogDestDriver *) last_driver)->log_fifo_size = $3; }
+	| KW_LOG_FIFO_TYPE '(' string ')'
+          {
+            CHECK_ERROR(log_dest_driver_set_log_fifo_type(last_driver, $3), @3, "unknown log-fifo-type() argument \"%s\"", $3);
+            free($3);
+          }
 	| KW_THROTTLE '(' nonnegative_integer ')'         { ((LogDestDriver *) last_driver)->throttle = $3; }
         | inner_dest
         | driver_option
@@ -146,8 +146,11 @@ static CfgLexerKeyword main_keywords[] =
   { "log_level",          KW_LOG_LEVEL },
   { "filterx_jit",        KW_FILTERX_JIT },
   { "filterx_jit_debug_info", KW_FILTERX_JIT_DEBUG_INFO },
+  { "template_jit",       KW_TEMPLATE_JIT },
+  { "filterx_jit_cache_dir", KW_FILTERX_JIT_CACHE_DIR },
 
   { "log_fifo_size",      KW_LOG_FIFO_SIZE },
+  { "log_fifo_type",      KW_LOG_FIFO_TYPE },
   { "log_fetch_limit",    KW_LOG_FETCH_LIMIT },
   { "log_iw_size",        KW_LOG_IW_SIZE },
   { "log_msg_size",       KW_LOG_MSG_SIZE },
@@ -173,6 +176,7 @@ static CfgLexerKeyword main_keywords[] =
   { "template_function",  KW_TEMPLATE_FUNCTION },
   { "on_error",           KW_ON_ERROR },
   { "persist_only",       KW_PERSIST_ONLY },
+  { "async",              KW_ASYNC },
   { "dns_cache_hosts",    KW_DNS_CACHE_HOSTS },
   { "dns_cache",          KW_DNS_CACHE },
   { "dns_cache_size",     KW_DNS_CACHE_SIZE },
@@ -24,7 +24,6 @@
 #include "dnscache.h"
 #include "messages.h"
 #include "timeutils/cache.h"
-#include "tls-support.h"
 
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -373,122 +372,246 @@ dns_cache_options_destroy(DNSCacheOptions *options)
  * not be aware of underlying data structures and locking, they can simply
  * call these functions to lookup/query the DNS cache.
  *
- * I would prefer these to be moved into a higher level implementation
- * detail.
+ * The cache is shared by all threads: it is split into a fixed number of
+ * stripes, each with its own lock, so threads looking up different
+ * addresses rarely contend.  Each stripe also keeps track of the lookups
+ * currently in flight, so that concurrent misses for the same address
+ * result in a single DNS query, the rest of the callers are notified when
+ * its result is stored.
  **************************************************************************/
 
-TLS_BLOCK_START
+#define DNS_CACHE_STRIPES 16
+
+typedef struct _DNSCachingWaiter
 {
-  DNSCache *dns_cache;
-}
-TLS_BLOCK_END;
+  DNSCachingNotifyFunc func;
+  gpointer user_data;
+} DNSCachingWaiter;
+
+typedef struct _DNSCachingPendingLookup
+{
+  DNSCacheKey key;
+  GList *waiters;
+} DNSCachingPendingLookup;
 
-#define dns_cache __tls_deref(dns_cache)
+typedef struct _DNSCachingStripe
+{
+  GMutex lock;
+  DNSCache *cache;
+  /* each stripe has its own copy, with cache_size split between the stripes */
+  DNSCacheOptions options;
+  GHashTable *pending_lookups;
+} DNSCachingStripe;
 
 /* DNS cache related options are global, independent of the configuration
- * (e.g.  GlobalConfig instance), and they are stored in the
- * "effective_dns_cache_options" variable below.
- *
- * The reasons for using the global variable are as explained below.
- *
- * Some notes:
- *   1) DNS cache contents are better retained between configuration reloads
- *   2) There are multiple DNSCache instances as they are per-thread data structs.
- *
- * The usual pattern would be:
- *    DNSCache->options -> DNSCacheOptions
- *
- * And options would be a reference and would point inside a DNSCacheOptions
- * instance contained within the GlobalConfig.
- *
- * The problem with this approach is that we don't want to recreate DNSCache
- * instances when reloading the configuration (as we want to keep their
- * config), and this would mean that we'd have to update the "options"
- * pointers in each of the existing instances.  And those instances are
- * per-thread variables, making it a bit more difficult to track them.
- *
- * For this reason, it was a lot simpler to use a global variable to hold
- * configuration options, one that can be updated as the configuration is
- * reloaded.  Then DNSCache instances transparently take the options changes
- * into account as they continue to resolve names.
- *
- * I could come up with even better solutions to this problem (like using a
- * layer above GlobalConfig, a state that encapsulates per-execution state
- * of syslog-ng), however, right now that would be an overkill and I want to
- * get the DNSCache refactors into the master tree.
+ * (e.g.  GlobalConfig instance): DNS cache contents are better retained
+ * between configuration reloads, so the stripes are created once and their
+ * options are updated in place as the configuration is reloaded.
  */
 
-static DNSCacheOptions effective_dns_cache_options;
-G_LOCK_DEFINE_STATIC(unused_dns_caches);
-static GList *unused_dns_caches;
+static DNSCachingStripe dns_caching_stripes[DNS_CACHE_STRIPES];
 
-gboolean
-dns_caching_lookup(gint family, void *addr, const gchar **hostname, gsize *hostname_len, gboolean *positive)
+static void
+_pending_lookup_free(DNSCachingPendingLookup *pending)
 {
-  return dns_cache_lookup(dns_cache, family, addr, hostname, hostname_len, positive);
+  g_list_free_full(pending->waiters, g_free);
+  g_free(pending);
 }
 
-void
-dns_caching_store(gint family, void *addr, const gchar *hostname, gboolean positive)
+static DNSCachingStripe *
+_lookup_stripe(DNSCacheKey *key)
 {
-  dns_cache_store_dynamic(dns_cache, family, addr, hostname, positive);
+  guint hash = dns_cache_key_hash(key);
+
+  /* fold the upper half in, so that all bits of the address matter */
+  return &dns_caching_stripes[(hash ^ (hash >> 16)) % DNS_CACHE_STRIPES];
 }
 
-void
-dns_caching_update_options(const DNSCacheOptions *new_options)
+static void
+_stripe_set_options(DNSCachingStripe *stripe, const DNSCacheOptions *new_options)
 {
-  DNSCacheOptions *options = &effective_dns_cache_options;
+  DNSCacheOptions *options = &stripe->options;
 
-  if (options->hosts)
-    g_free(options->hosts);
+  g_free(options->hosts);
 
-  options->cache_size = new_options->cache_size;
+  options->cache_size = MAX(new_options->cache_size / DNS_CACHE_STRIPES, 1);
   options->expire = new_options->expire;
   options->expire_failed = new_options->expire_failed;
   options->hosts = g_strdup(new_options->hosts);
 }
 
+/*
+ * Copies the cached name of @addr to @hostname, truncating it to
+ * @hostname_size if needed.
+ */
+gboolean
+dns_caching_lookup(gint family, void *addr, gchar *hostname, gsize hostname_size, gsize *hostname_len,
+                   gboolean *positive)
+{
+  DNSCacheKey key;
+  const gchar *cached_hostname;
+  gsize cached_hostname_len;
+  gboolean result;
+
+  dns_cache_fill_key(&key, family, addr);
+  DNSCachingStripe *stripe = _lookup_stripe(&key);
+
+  g_mutex_lock(&stripe->lock);
+  result = dns_cache_lookup(stripe->cache, family, addr, &cached_hostname, &cached_hostname_len, positive);
+  if (result)
+    {
+      g_strlcpy(hostname, cached_hostname, hostname_size);
+      *hostname_len = MIN(cached_hostname_len, hostname_size - 1);
+    }
+  g_mutex_unlock(&stripe->lock);
+  return result;
+}
+
 void
-dns_caching_thread_init(void)
+dns_caching_store(gint family, void *addr, const gchar *hostname, gboolean positive)
 {
-  g_assert(dns_cache == NULL);
+  DNSCacheKey key;
+
+  dns_cache_fill_key(&key, family, addr);
+  DNSCachingStripe *stripe = _lookup_stripe(&key);
+
+  g_mutex_lock(&stripe->lock);
+  dns_cache_store_dynamic(stripe->cache, family, addr, hostname, positive);
+  g_mutex_unlock(&stripe->lock);
+}
 
-  G_LOCK(unused_dns_caches);
-  if (unused_dns_caches)
+/*
+ * Checks whether @addr is in the cache and if it is not, registers @func
+ * to be called once its name is stored using dns_caching_store_and_notify().
+ * @func may be NULL if the caller is not interested in the result.
+ *
+ * Returns DNS_CACHING_LOOKUP_STARTED if the caller is responsible for
+ * resolving the address, DNS_CACHING_LOOKUP_PENDING if someone else is
+ * already doing that, and DNS_CACHING_HIT if the address is cached, in
+ * which case @func is not registered.
+ */
+DNSCachingLookupResult
+dns_caching_lookup_or_wait(gint family, void *addr, DNSCachingNotifyFunc func, gpointer user_data)
+{
+  DNSCachingLookupResult result;
+  DNSCachingPendingLookup *pending;
+  DNSCacheKey key;
+  const gchar *hostname;
+  gsize hostname_len;
+  gboolean positive;
+
+  dns_cache_fill_key(&key, family, addr);
+  DNSCachingStripe *stripe = _lookup_stripe(&key);
+
+  g_mutex_lock(&stripe->lock);
+  if (dns_cache_lookup(stripe->cache, family, addr, &hostname, &hostname_len, &positive))
     {
-      dns_cache = unused_dns_caches->data;
-      unused_dns_caches = g_list_delete_link(unused_dns_caches, unused_dns_caches);
+      g_mutex_unlock(&stripe->lock);
+      return DNS_CACHING_HIT;
     }
-  G_UNLOCK(unused_dns_caches);
 
-  if (!dns_cache)
-    dns_cache = dns_cache_new(&effective_dns_cache_options);
+  pending = g_hash_table_lookup(stripe->pending_lookups, &key);
+  if (pending)
+    {
+      result = DNS_CACHING_LOOKUP_PENDING;
+    }
+  else
+    {
+      pending = g_new0(DNSCachingPendingLookup, 1);
+      pending->key = key;
+      g_hash_table_insert(stripe->pending_lookups, &pending->key, pending);
+      result = DNS_CACHING_LOOKUP_STARTED;
+    }
+
+  if (func)
+    {
+      DNSCachingWaiter *waiter = g_new(DNSCachingWaiter, 1);
+
+      waiter->func = func;
+      waiter->user_data = user_data;
+      pending->waiters = g_list_prepend(pending->waiters, waiter);
+    }
+  g_mutex_unlock(&stripe->lock);
+  return result;
 }
 
+/*
+ * Stores the result of a lookup started by dns_caching_lookup_or_wait()
+ * and calls the functions waiting for it, in the order they registered.
+ * The callbacks are invoked without holding any locks, so they are free to
+ * call back into the cache.
+ */
 void
-dns_caching_thread_deinit(void)
+dns_caching_store_and_notify(gint family, void *addr, const gchar *hostname, gboolean positive)
 {
-  g_assert(dns_cache != NULL);
+  DNSCachingPendingLookup *pending;
+  DNSCacheKey key;
 
-  G_LOCK(unused_dns_caches);
-  unused_dns_caches = g_list_prepend(unused_dns_caches, dns_cache);
-  G_UNLOCK(unused_dns_caches);
-  dns_cache = NULL;
+  dns_cache_fill_key(&key, family, addr);
+  DNSCachingStripe *stripe = _lookup_stripe(&key);
+
+  g_mutex_lock(&stripe->lock);
+  dns_cache_store_dynamic(stripe->cache, family, addr, hostname, positive);
+  pending = g_hash_table_lookup(stripe->pending_lookups, &key);
+  if (pending)
+    g_hash_table_steal(stripe->pending_lookups, &key);
+  g_mutex_unlock(&stripe->lock);
+
+  if (!pending)
+    return;
+
+  pending->waiters = g_list_reverse(pending->waiters);
+  for (GList *l = pending->waiters; l; l = l->next)
+    {
+      DNSCachingWaiter *waiter = l->data;
+      waiter->func(waiter->user_data);
+    }
+  _pending_lookup_free(pending);
+}
+
+void
+dns_caching_update_options(const DNSCacheOptions *new_options)
+{
+  for (gint i = 0; i < DNS_CACHE_STRIPES; i++)
+    {
+      DNSCachingStripe *stripe = &dns_caching_stripes[i];
+
+      g_mutex_lock(&stripe->lock);
+      _stripe_set_options(stripe, new_options);
+      g_mutex_unlock(&stripe->lock);
+    }
 }
 
 void
 dns_caching_global_init(void)
 {
-  dns_cache_options_defaults(&effective_dns_cache_options);
+  DNSCacheOptions default_options;
+
+  dns_cache_options_defaults(&default_options);
+  for (gint i = 0; i < DNS_CACHE_STRIPES; i++)
+    {
+      DNSCachingStripe *stripe = &dns_caching_stripes[i];
+
+      g_mutex_init(&stripe->lock);
+      stripe->options.hosts = NULL;
+      _stripe_set_options(stripe, &default_options);
+      stripe->cache = dns_cache_new(&stripe->options);
+      stripe->pending_lookups = g_hash_table_new_full((GHashFunc) dns_cache_key_hash, (GEqualFunc) dns_cache_key_equal,
+                                                      NULL, (GDestroyNotify) _pending_lookup_free);
+    }
+  dns_cache_options_destroy(&default_options);
 }
 
 void
 dns_caching_global_deinit(void)
 {
-  G_LOCK(unused_dns_caches);
-  g_list_foreach(unused_dns_caches, (GFunc) dns_cache_free, NULL);
-  g_list_free(unused_dns_caches);
-  unused_dns_caches = NULL;
-  G_UNLOCK(unused_dns_caches);
-  dns_cache_options_destroy(&effective_dns_cache_options);
+  for (gint i = 0; i < DNS_CACHE_STRIPES; i++)
+    {
+      DNSCachingStripe *stripe = &dns_caching_stripes[i];
+
+      g_hash_table_destroy(stripe->pending_lookups);
+      dns_cache_free(stripe->cache);
+      dns_cache_options_destroy(&stripe->options);
+      g_mutex_clear(&stripe->lock);
+    }
 }
@@ -47,12 +47,23 @@ void dns_cache_free(DNSCache *self);
 void dns_cache_options_defaults(DNSCacheOptions *options);
 void dns_cache_options_destroy(DNSCacheOptions *options);
 
-gboolean dns_caching_lookup(gint family, void *addr, const gchar **hostname, gsize *hostname_len, gboolean *positive);
+typedef enum
+{
+  DNS_CACHING_HIT,
+  DNS_CACHING_LOOKUP_PENDING,
+  DNS_CACHING_LOOKUP_STARTED,
+} DNSCachingLookupResult;
+
+typedef void (*DNSCachingNotifyFunc)(gpointer user_data);
+
+gboolean dns_caching_lookup(gint family, void *addr, gchar *hostname, gsize hostname_size, gsize *hostname_len,
+                            gboolean *positive);
 void dns_caching_store(gint family, void *addr, const gchar *hostname, gboolean positive);
+DNSCachingLookupResult dns_caching_lookup_or_wait(gint family, void *addr, DNSCachingNotifyFunc func,
+                                                  gpointer user_data);
+void dns_caching_store_and_notify(gint family, void *addr, const gchar *hostname, gboolean positive);
 void dns_caching_update_options(const DNSCacheOptions *dns_cache_options);
 
-void dns_caching_thread_init(void);
-void dns_caching_thread_deinit(void);
 void dns_caching_global_init(void);
 void dns_caching_global_deinit(void);
 
@@ -23,6 +23,7 @@
 
 #include "driver.h"
 #include "logqueue-fifo.h"
+#include "logqueue-ring.h"
 #include "afinter.h"
 #include "cfg-tree.h"
 #include "messages.h"
@@ -269,9 +270,21 @@ _create_memory_queue(LogDestDriver *self, const gchar *persist_name, gint stats_
 
   gint log_fifo_size = self->log_fifo_size < 0 ? cfg->log_fifo_size : self->log_fifo_size;
 
+  if (self->log_fifo_type == LDD_LOG_FIFO_TYPE_RING)
+    return log_queue_ring_new(log_fifo_size, persist_name, stats_level, driver_sck_builder, queue_sck_builder);
+
   return log_queue_fifo_new(log_fifo_size, persist_name, stats_level, driver_sck_builder, queue_sck_builder);
 }
 
+static QueueType
+_get_memory_queue_type(LogDestDriver *self)
+{
+  if (self->log_fifo_type == LDD_LOG_FIFO_TYPE_RING)
+    return log_queue_ring_get_type();
+
+  return log_queue_fifo_get_type();
+}
+
 /* returns a reference */
 static LogQueue *
 log_dest_driver_acquire_memory_queue(LogDestDriver *self, const gchar *persist_name, gint stats_level,
@@ -284,7 +297,7 @@ log_dest_driver_acquire_memory_queue(LogDestDriver *self, const gchar *persist_n
   if (persist_name)
     queue = cfg_persist_config_fetch(cfg, persist_name);
 
-  if (queue && !log_queue_has_type(queue, log_queue_fifo_get_type()))
+  if (queue && !log_queue_has_type(queue, _get_memory_queue_type(self)))
     {
       log_queue_unref(queue);
       queue = NULL;
@@ -414,6 +427,21 @@ log_dest_driver_deinit_method(LogPipe *s)
   return TRUE;
 }
 
+gboolean
+log_dest_driver_set_log_fifo_type(LogDriver *s, const gchar *log_fifo_type)
+{
+  LogDestDriver *self = (LogDestDriver *) s;
+
+  if (strcmp(log_fifo_type, "fifo") == 0)
+    self->log_fifo_type = LDD_LOG_FIFO_TYPE_FIFO;
+  else if (strcmp(log_fifo_type, "ring") == 0)
+    self->log_fifo_type = LDD_LOG_FIFO_TYPE_RING;
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
 void
 log_dest_driver_init_instance(LogDestDriver *self, GlobalConfig *cfg)
 {
@@ -425,6 +453,7 @@ log_dest_driver_init_instance(LogDestDriver *self, GlobalConfig *cfg)
   self->acquire_queue = log_dest_driver_acquire_memory_queue;
   self->release_queue = log_dest_driver_release_queue_method;
   self->log_fifo_size = -1;
+  self->log_fifo_type = LDD_LOG_FIFO_TYPE_FIFO;
   self->throttle = 0;
 }
 
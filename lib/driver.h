@@ -157,6 +157,12 @@ void log_src_driver_free(LogPipe *s);
 
 typedef struct _LogDestDriver LogDestDriver;
 
+typedef enum
+{
+  LDD_LOG_FIFO_TYPE_FIFO,
+  LDD_LOG_FIFO_TYPE_RING,
+} LogDestDriverLogFifoType;
+
 struct _LogDestDriver
 {
   LogDriver super;
@@ -171,6 +177,7 @@ struct _LogDestDriver
   GList *queues;
 
   gint log_fifo_size;
+  LogDestDriverLogFifoType log_fifo_type;
   gint throttle;
   StatsCounterItem *queued_global_messages;
 };
@@ -209,6 +216,7 @@ log_dest_driver_release_queue(LogDestDriver *self, LogQueue *q)
 gboolean log_dest_driver_init_method(LogPipe *s);
 gboolean log_dest_driver_deinit_method(LogPipe *s);
 void log_dest_driver_queue_method(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options);
+gboolean log_dest_driver_set_log_fifo_type(LogDriver *s, const gchar *log_fifo_type);
 
 void log_dest_driver_init_instance(LogDestDriver *self, GlobalConfig *cfg);
 void log_dest_driver_free(LogPipe *s);
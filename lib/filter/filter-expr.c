@@ -76,6 +76,30 @@ filter_expr_eval_root(FilterExprNode *self, LogMessage **msg, const LogPathOptio
   return filter_expr_eval_root_with_context(self, msg, 1, &DEFAULT_TEMPLATE_EVAL_OPTIONS, path_options);
 }
 
+/*
+ * Evaluates the filter against each message of a batch, as if
+ * filter_expr_eval_root() was called for them one by one.
+ */
+void
+filter_expr_eval_root_batch(FilterExprNode *self, LogMessage **msgs, const LogPathOptions **path_options,
+                            gint num_msgs, gboolean *results)
+{
+  if (self->modify)
+    {
+      for (gint i = 0; i < num_msgs; i++)
+        log_msg_make_writable(&msgs[i], path_options[i]);
+    }
+
+  if (self->eval_batch)
+    {
+      self->eval_batch(self, msgs, num_msgs, &DEFAULT_TEMPLATE_EVAL_OPTIONS, results);
+      return;
+    }
+
+  for (gint i = 0; i < num_msgs; i++)
+    results[i] = filter_expr_eval_with_context(self, &msgs[i], 1, &DEFAULT_TEMPLATE_EVAL_OPTIONS);
+}
+
 static FilterExprNode *
 filter_expr_ref(FilterExprNode *self)
 {
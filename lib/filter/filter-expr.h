@@ -40,6 +40,9 @@ struct _FilterExprNode
   const gchar *type;
   gboolean (*init)(FilterExprNode *self, GlobalConfig *cfg);
   gboolean (*eval)(FilterExprNode *self, LogMessage **msg, gint num_msg, LogTemplateEvalOptions *options);
+  /* optional, evaluates each of msgs independently (not as a context), storing the outcomes into results */
+  void (*eval_batch)(FilterExprNode *self, LogMessage **msgs, gint num_msgs, LogTemplateEvalOptions *options,
+                     gboolean *results);
   FilterExprNode *(*clone)(FilterExprNode *self);
   void (*free_fn)(FilterExprNode *self);
   StatsCounterItem *matched;
@@ -62,6 +65,8 @@ gboolean filter_expr_eval_root(FilterExprNode *self, LogMessage **msg, const Log
 gboolean filter_expr_eval_root_with_context(FilterExprNode *self, LogMessage **msgs, gint num_msg,
                                             LogTemplateEvalOptions *options,
                                             const LogPathOptions *path_options);
+void filter_expr_eval_root_batch(FilterExprNode *self, LogMessage **msgs, const LogPathOptions **path_options,
+                                 gint num_msgs, gboolean *results);
 void filter_expr_node_init_instance(FilterExprNode *self);
 void filter_expr_unref(FilterExprNode *self);
 
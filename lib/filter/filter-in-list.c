@@ -23,7 +23,7 @@
 
 #include "filter-in-list.h"
 #include "logmsg/logmsg.h"
-#include "str-utils.h"
+#include "multi-string-matcher.h"
 
 #include <errno.h>
 #include <stdlib.h>
@@ -34,7 +34,7 @@ typedef struct _FilterInList
 {
   FilterExprNode super;
   NVHandle value_handle;
-  GTree *tree;
+  MultiStringMatcher *list;
 } FilterInList;
 
 static gboolean
@@ -46,11 +46,10 @@ filter_in_list_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTempl
   gssize len = 0;
 
   value = log_msg_get_value(msg, self->value_handle, &len);
-  APPEND_ZERO(value, value, len);
 
-  gboolean result = (g_tree_lookup(self->tree, value) != NULL);
+  gboolean result = multi_string_matcher_match_exact(self->list, value, len);
   msg_trace("in-list() evaluation started",
-            evt_tag_str("value", value),
+            evt_tag_mem("value", value, len),
             evt_tag_msg_reference(msg));
 
   return result ^ s->comp;
@@ -61,7 +60,7 @@ filter_in_list_free(FilterExprNode *s)
 {
   FilterInList *self = (FilterInList *)s;
 
-  g_tree_destroy(self->tree);
+  multi_string_matcher_free(self->list);
 }
 
 FilterExprNode *
@@ -83,15 +82,16 @@ filter_in_list_new(const gchar *list_file, const gchar *property)
   self = g_new0(FilterInList, 1);
   filter_expr_node_init_instance(&self->super);
   self->value_handle = log_msg_get_value_handle(property);
-  self->tree = g_tree_new_full((GCompareDataFunc)strcmp, NULL, g_free, NULL);
+  self->list = multi_string_matcher_new(0);
 
   while (fgets(line, sizeof(line), stream) != NULL)
     {
       line[strlen(line) - 1] = '\0';
       if (line[0])
-        g_tree_insert(self->tree, g_strdup(line), GINT_TO_POINTER(1));
+        multi_string_matcher_add_pattern(self->list, line, -1);
     }
   fclose(stream);
+  multi_string_matcher_compile(self->list);
 
   self->super.eval = filter_in_list_eval;
   self->super.free_fn = filter_in_list_free;
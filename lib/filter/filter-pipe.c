@@ -85,6 +85,51 @@ log_filter_pipe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_op
     }
 }
 
+static void
+log_filter_pipe_queue_batch(LogPipe *s, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs)
+{
+  LogFilterPipe *self = (LogFilterPipe *) s;
+  gboolean results[LOG_PIPE_MAX_BATCH_SIZE];
+  LogMessage *matched_msgs[LOG_PIPE_MAX_BATCH_SIZE];
+  const LogPathOptions *matched_path_options[LOG_PIPE_MAX_BATCH_SIZE];
+  gint num_matched = 0;
+
+  msg_trace(">>>>>> filter rule batch evaluation begin",
+            evt_tag_str("rule", self->name),
+            log_pipe_location_tag(s),
+            evt_tag_int("messages", num_msgs));
+
+  filter_expr_eval_root_batch(self->expr, msgs, path_options, num_msgs, results);
+
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      msg_trace("<<<<<< filter rule evaluation result",
+                evt_tag_str("result", results[i] ? "matched" : "unmatched"),
+                evt_tag_str("rule", self->name),
+                log_pipe_location_tag(s),
+                evt_tag_msg_reference(msgs[i]));
+
+      if (results[i])
+        {
+          matched_msgs[num_matched] = msgs[i];
+          matched_path_options[num_matched] = path_options[i];
+          num_matched++;
+        }
+      else
+        {
+          if (path_options[i]->matched)
+            (*path_options[i]->matched) = FALSE;
+          log_msg_drop(msgs[i], path_options[i], AT_PROCESSED);
+        }
+    }
+
+  stats_counter_add(self->matched, num_matched);
+  stats_counter_add(self->not_matched, num_msgs - num_matched);
+
+  if (num_matched > 0)
+    log_pipe_forward_batch(s, matched_msgs, matched_path_options, num_matched);
+}
+
 static LogPipe *
 log_filter_pipe_clone(LogPipe *s)
 {
@@ -124,6 +169,7 @@ log_filter_pipe_new(FilterExprNode *expr, GlobalConfig *cfg)
   self->super.flags |= PIF_CONFIG_RELATED + PIF_SYNC_FILTERX_TO_MSG;
   self->super.init = log_filter_pipe_init;
   self->super.queue = log_filter_pipe_queue;
+  self->super.queue_batch = log_filter_pipe_queue_batch;
   self->super.free_fn = log_filter_pipe_free;
   self->super.clone = log_filter_pipe_clone;
   self->expr = expr;
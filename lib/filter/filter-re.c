@@ -33,6 +33,8 @@ typedef struct _FilterRE
   NVHandle value_handle;
   LogMatcherOptions matcher_options;
   LogMatcher *matcher;
+  /* patterns of string matches OR-ed together with this one, see filter_re_merge_alternatives() */
+  GPtrArray *alternatives;
 } FilterRE;
 
 static gboolean
@@ -51,6 +53,26 @@ filter_re_eval(FilterExprNode *s, LogMessage **msgs, gint num_msg, LogTemplateEv
   return result ^ s->comp;
 }
 
+static void
+filter_re_eval_batch(FilterExprNode *s, LogMessage **msgs, gint num_msgs, LogTemplateEvalOptions *options,
+                     gboolean *results)
+{
+  FilterRE *self = (FilterRE *) s;
+  LogMatcher *matcher = self->matcher;
+  NVHandle value_handle = self->value_handle;
+  gboolean comp = s->comp;
+
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      msg_trace("match() evaluation started against a name-value pair",
+                evt_tag_msg_value_name("name", value_handle),
+                evt_tag_msg_value("value", msgs[i], value_handle),
+                evt_tag_str("pattern", matcher->pattern),
+                evt_tag_msg_reference(msgs[i]));
+      results[i] = log_matcher_match_value(matcher, msgs[i], value_handle) ^ comp;
+    }
+}
+
 static void
 filter_re_free(FilterExprNode *s)
 {
@@ -58,6 +80,8 @@ filter_re_free(FilterExprNode *s)
 
   log_matcher_unref(self->matcher);
   log_matcher_options_destroy(&self->matcher_options);
+  if (self->alternatives)
+    g_ptr_array_free(self->alternatives, TRUE);
 }
 
 static gboolean
@@ -68,6 +92,14 @@ filter_re_init(FilterExprNode *s, GlobalConfig *cfg)
   if (self->matcher_options.flags & LMF_STORE_MATCHES)
     self->super.modify = TRUE;
 
+  if (self->alternatives)
+    {
+      log_matcher_unref(self->matcher);
+      self->matcher = log_matcher_string_set_new(&self->matcher_options, self->alternatives);
+      g_ptr_array_free(self->alternatives, TRUE);
+      self->alternatives = NULL;
+    }
+
   return TRUE;
 }
 
@@ -89,6 +121,62 @@ filter_re_compile_pattern(FilterExprNode *s, const gchar *re, GError **error)
   return log_matcher_compile(self->matcher, re, error);
 }
 
+static gboolean
+filter_re_is_string_match_on_value(FilterExprNode *s)
+{
+  FilterRE *self = (FilterRE *) s;
+
+  /* FilterMatch instances only change their eval function in init() */
+  return s->eval == filter_re_eval &&
+         !s->comp &&
+         self->value_handle &&
+         self->matcher &&
+         strcmp(self->matcher_options.type, "string") == 0 &&
+         (self->matcher_options.flags & LMF_STORE_MATCHES) == 0;
+}
+
+/*
+ * Folds "other" into "s" if both are literal string matches against the
+ * same name-value pair with the same flags, so that "s" alone yields the
+ * result of OR-ing them together.  Long lists of alternatives then become
+ * a single LogMatcher that is evaluated in one pass.
+ *
+ * Returns "s" and consumes "other" if the two could be merged, NULL
+ * otherwise.
+ */
+FilterExprNode *
+filter_re_merge_alternatives(FilterExprNode *s, FilterExprNode *other)
+{
+  FilterRE *self = (FilterRE *) s;
+  FilterRE *other_re = (FilterRE *) other;
+
+  if (!filter_re_is_string_match_on_value(s) || !filter_re_is_string_match_on_value(other))
+    return NULL;
+
+  if (self->value_handle != other_re->value_handle ||
+      self->matcher_options.flags != other_re->matcher_options.flags)
+    return NULL;
+
+  if (!self->alternatives)
+    {
+      self->alternatives = g_ptr_array_new_with_free_func(g_free);
+      g_ptr_array_add(self->alternatives, g_strdup(self->matcher->pattern));
+    }
+
+  if (other_re->alternatives)
+    {
+      for (guint i = 0; i < other_re->alternatives->len; i++)
+        g_ptr_array_add(self->alternatives, g_strdup(g_ptr_array_index(other_re->alternatives, i)));
+    }
+  else
+    {
+      g_ptr_array_add(self->alternatives, g_strdup(other_re->matcher->pattern));
+    }
+
+  filter_expr_unref(other);
+  return s;
+}
+
 static void
 filter_re_init_instance(FilterRE *self, NVHandle value_handle)
 {
@@ -96,6 +184,7 @@ filter_re_init_instance(FilterRE *self, NVHandle value_handle)
   self->value_handle = value_handle;
   self->super.init = filter_re_init;
   self->super.eval = filter_re_eval;
+  self->super.eval_batch = filter_re_eval_batch;
   self->super.free_fn = filter_re_free;
   self->super.type = "regexp";
   log_matcher_options_defaults(&self->matcher_options);
@@ -206,8 +295,12 @@ filter_match_eval_against_template(FilterExprNode *s, LogMessage **msgs, gint nu
 static void
 filter_match_determine_eval_function(FilterMatch *self)
 {
+  self->super.super.eval_batch = NULL;
   if (self->super.value_handle)
-    self->super.super.eval = filter_re_eval;
+    {
+      self->super.super.eval = filter_re_eval;
+      self->super.super.eval_batch = filter_re_eval_batch;
+    }
   else if (self->template)
     self->super.super.eval = filter_match_eval_against_template;
   else
@@ -32,6 +32,7 @@ gboolean filter_re_compile_pattern(FilterExprNode *s, const gchar *re, GError **
 
 FilterExprNode *filter_re_new(NVHandle value_handle);
 FilterExprNode *filter_source_new(void);
+FilterExprNode *filter_re_merge_alternatives(FilterExprNode *s, FilterExprNode *other);
 
 gboolean filter_match_is_usage_obsolete(FilterExprNode *s);
 void filter_match_set_value_handle(FilterExprNode *s, NVHandle value_handle);
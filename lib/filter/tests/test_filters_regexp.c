@@ -387,3 +387,55 @@ Test(filter, test_match_with_template_non_trivial)
   filter_match_set_template_ref(filter, compile_template("$PID $PROGRAM"));
   testcase("<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized", filter, TRUE);
 }
+
+static FilterExprNode *
+_create_string_filter_with_alternatives(gint field, const gchar *patterns[], gint flags)
+{
+  FilterExprNode *filter = compile_pattern(filter_re_new(field), patterns[0], "string", flags);
+
+  for (gint i = 1; patterns[i]; i++)
+    {
+      FilterExprNode *alternative = compile_pattern(filter_re_new(field), patterns[i], "string", flags);
+
+      cr_assert_eq(filter_re_merge_alternatives(filter, alternative), filter);
+    }
+  return filter;
+}
+
+Test(filter, test_string_matches_against_the_same_value_are_merged)
+{
+  const gchar *programs[] = { "sshd", "openvpn", "cron", NULL };
+  const gchar *substrings[] = { "nomatch", "pthread", NULL };
+  const gchar *nomatch[] = { "sshd", "open", "vpn", NULL };
+
+  testcase("<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized",
+           _create_string_filter_with_alternatives(LM_V_PROGRAM, programs, 0), TRUE);
+  testcase("<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized",
+           _create_string_filter_with_alternatives(LM_V_PROGRAM, nomatch, 0), FALSE);
+  testcase("<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized",
+           _create_string_filter_with_alternatives(LM_V_MESSAGE, substrings, LMF_SUBSTRING | LMF_ICASE), TRUE);
+  testcase("<15>Oct 15 16:17:01 host openvpn[2499]: PTHREAD support initialized",
+           _create_string_filter_with_alternatives(LM_V_PROGRAM, nomatch, LMF_PREFIX), TRUE);
+}
+
+Test(filter, test_only_compatible_string_matches_are_merged)
+{
+  FilterExprNode *filter = compile_pattern(filter_re_new(LM_V_PROGRAM), "sshd", "string", 0);
+  FilterExprNode *other_value = compile_pattern(filter_re_new(LM_V_HOST), "sshd", "string", 0);
+  FilterExprNode *other_flags = compile_pattern(filter_re_new(LM_V_PROGRAM), "sshd", "string", LMF_ICASE);
+  FilterExprNode *other_type = create_pcre_regexp_filter(LM_V_PROGRAM, "sshd", 0);
+  FilterExprNode *negated = compile_pattern(filter_re_new(LM_V_PROGRAM), "sshd", "string", 0);
+
+  negated->comp = TRUE;
+
+  cr_assert_null(filter_re_merge_alternatives(filter, other_value));
+  cr_assert_null(filter_re_merge_alternatives(filter, other_flags));
+  cr_assert_null(filter_re_merge_alternatives(filter, other_type));
+  cr_assert_null(filter_re_merge_alternatives(filter, negated));
+
+  filter_expr_unref(negated);
+  filter_expr_unref(other_type);
+  filter_expr_unref(other_flags);
+  filter_expr_unref(other_value);
+  filter_expr_unref(filter);
+}
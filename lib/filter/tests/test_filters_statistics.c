@@ -96,3 +96,42 @@ Test(test_filters_statistics, filter_stastistics)
   log_pipe_deinit(&p->super);
   log_pipe_unref(&p->super);
 }
+
+Test(test_filters_statistics, filter_statistics_with_batch)
+{
+  msg_format_options_defaults(&parse_options);
+  msg_format_options_init(&parse_options, configuration);
+
+  const gchar *raw_msgs[] =
+  {
+    "<15> openvpn[2499]: PTHREAD support initialized",
+    "<16> openvpn[2499]: PTHREAD support initialized",
+    "<15> openvpn[2499]: PTHREAD support initialized",
+    "<16> openvpn[2499]: PTHREAD support initialized",
+    "<16> openvpn[2499]: PTHREAD support initialized",
+  };
+  LogMessage *msgs[G_N_ELEMENTS(raw_msgs)];
+  LogPathOptions path_options[G_N_ELEMENTS(raw_msgs)];
+  const LogPathOptions *path_options_refs[G_N_ELEMENTS(raw_msgs)];
+  gboolean matched[G_N_ELEMENTS(raw_msgs)];
+
+  for (gint i = 0; i < G_N_ELEMENTS(raw_msgs); i++)
+    {
+      msgs[i] = msg_format_parse(&parse_options, (const guchar *) raw_msgs[i], strlen(raw_msgs[i]));
+      path_options[i] = (LogPathOptions) LOG_PATH_OPTIONS_INIT;
+      path_options[i].matched = &matched[i];
+      path_options_refs[i] = &path_options[i];
+      matched[i] = TRUE;
+    }
+
+  LogFilterPipe *p = create_log_filter_pipe();
+  log_pipe_queue_batch(&p->super, msgs, path_options_refs, G_N_ELEMENTS(raw_msgs));
+
+  cr_assert_eq(stats_counter_get(p->matched), 2);
+  cr_assert_eq(stats_counter_get(p->not_matched), 3);
+  cr_assert(matched[0] && matched[2]);
+  cr_assert(!matched[1] && !matched[3] && !matched[4]);
+
+  log_pipe_deinit(&p->super);
+  log_pipe_unref(&p->super);
+}
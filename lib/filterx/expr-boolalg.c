@@ -67,6 +67,135 @@ _eval_not(FilterXExpr *s)
     return filterx_boolean_new(TRUE);
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+/* consumes value, returns an i1 truth value */
+static FilterXIRValue
+_emit_truthy_and_unref(FilterXJIT *jit, FilterXIRValue value)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+
+  FilterXIRValue truthy = fx_jit_emit_object_truthy(jit, value);
+  fx_jit_emit_object_unref(jit, value);
+  return LLVMBuildICmp(ir, LLVMIntNE, truthy, LLVMConstInt(ffi->i32_ty, 0, FALSE), "is_truthy");
+}
+
+static FilterXIRValue
+_emit_boolean_from_i1(FilterXJIT *jit, FilterXIRValue value)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+
+  FilterXIRValue args[] = { LLVMBuildZExt(ir, value, ffi->i32_ty, "bool") };
+  FilterXIRType param_tys[] = { ffi->i32_ty };
+  return fx_jit_emit_extern_call(jit, "fx_jit_boolean_new", ffi->ptr_ty, param_tys, args, 1);
+}
+
+static FilterXIRValue
+_compile_not(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXUnaryOp *self = (FilterXUnaryOp *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+
+  FilterXIRSequence negate = filterx_jit_ir_create_sequence(jit, "not_negate", block);
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "not_finish", block);
+
+  FilterXIRValue operand = filterx_expr_compile_or_eval(self->operand, jit);
+
+  /* if (!operand) goto finish; */
+  LLVMBuildCondBr(ir, LLVMBuildIsNull(ir, operand, "is_null"), finish, negate);
+
+  filterx_jit_ir_add_sequence_to_block(jit, negate, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, negate);
+  FilterXIRValue truthy = _emit_truthy_and_unref(jit, operand);
+  LLVMBuildStore(ir, _emit_boolean_from_i1(jit, LLVMBuildNot(ir, truthy, "negated")), result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+/*
+ * Short-circuiting and/or: the rhs is only evaluated if the lhs did not
+ * decide the result already, see _eval_and() and _eval_or().
+ */
+static FilterXIRValue
+_compile_short_circuit(FilterXBinaryOp *self, FilterXJIT *jit, gboolean short_circuit_on)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "boolalg_finish", block);
+
+  if (self->lhs)
+    {
+      FilterXIRSequence lhs_check = filterx_jit_ir_create_sequence(jit, "boolalg_lhs_check", block);
+      FilterXIRSequence lhs_decided = filterx_jit_ir_create_sequence(jit, "boolalg_lhs_decided", block);
+      FilterXIRSequence eval_rhs = filterx_jit_ir_create_sequence(jit, "boolalg_eval_rhs", block);
+
+      FilterXIRValue lhs = filterx_expr_compile_or_eval(self->lhs, jit);
+      LLVMBuildCondBr(ir, LLVMBuildIsNull(ir, lhs, "lhs_is_null"), finish, lhs_check);
+
+      filterx_jit_ir_add_sequence_to_block(jit, lhs_check, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, lhs_check);
+      FilterXIRValue lhs_truthy = _emit_truthy_and_unref(jit, lhs);
+      if (short_circuit_on)
+        LLVMBuildCondBr(ir, lhs_truthy, lhs_decided, eval_rhs);
+      else
+        LLVMBuildCondBr(ir, lhs_truthy, eval_rhs, lhs_decided);
+
+      filterx_jit_ir_add_sequence_to_block(jit, lhs_decided, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, lhs_decided);
+      LLVMBuildStore(ir, fx_jit_emit_boolean_new(jit, short_circuit_on), result_slot);
+      LLVMBuildBr(ir, finish);
+
+      filterx_jit_ir_add_sequence_to_block(jit, eval_rhs, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, eval_rhs);
+    }
+
+  FilterXIRSequence rhs_check = filterx_jit_ir_create_sequence(jit, "boolalg_rhs_check", block);
+
+  FilterXIRValue rhs = filterx_expr_compile_or_eval(self->rhs, jit);
+  LLVMBuildCondBr(ir, LLVMBuildIsNull(ir, rhs, "rhs_is_null"), finish, rhs_check);
+
+  filterx_jit_ir_add_sequence_to_block(jit, rhs_check, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, rhs_check);
+  LLVMBuildStore(ir, _emit_boolean_from_i1(jit, _emit_truthy_and_unref(jit, rhs)), result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+static FilterXIRValue
+_compile_and(FilterXExpr *s, FilterXJIT *jit)
+{
+  return _compile_short_circuit((FilterXBinaryOp *) s, jit, FALSE);
+}
+
+static FilterXIRValue
+_compile_or(FilterXExpr *s, FilterXJIT *jit)
+{
+  return _compile_short_circuit((FilterXBinaryOp *) s, jit, TRUE);
+}
+
+#endif
+
 FilterXExpr *
 filterx_unary_not_new(FilterXExpr *operand)
 {
@@ -75,6 +204,9 @@ filterx_unary_not_new(FilterXExpr *operand)
   filterx_unary_op_init_instance(self, "not", FXE_READ, operand);
   self->super.optimize = _optimize_not;
   self->super.eval = _eval_not;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _compile_not;
+#endif
   return &self->super;
 }
 
@@ -149,6 +281,9 @@ filterx_binary_and_new(FilterXExpr *lhs, FilterXExpr *rhs)
 
   self->super.optimize = _optimize_and;
   self->super.eval = _eval_and;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _compile_and;
+#endif
   return &self->super;
 
 }
@@ -225,5 +360,8 @@ filterx_binary_or_new(FilterXExpr *lhs, FilterXExpr *rhs)
 
   self->super.optimize = _optimize_or;
   self->super.eval = _eval_or;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _compile_or;
+#endif
   return &self->super;
 }
@@ -291,6 +291,203 @@ _filterx_comparison_free(FilterXExpr *s)
   filterx_binary_op_free_method(s);
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+/* NOTE: operands are borrowed */
+__attribute__((used))
+gboolean
+fx_jit_compare_objects(FilterXObject *lhs, FilterXObject *rhs, gint operator)
+{
+  return filterx_compare_objects(filterx_ref_unwrap_ro(lhs), filterx_ref_unwrap_ro(rhs), operator);
+}
+
+/* string literal on the rhs, compared in TYPE_AWARE, STRING_BASED or TYPE_AND_VALUE_BASED modes */
+__attribute__((used))
+gboolean
+fx_jit_compare_to_string_literal(FilterXObject *obj, FilterXObject *literal, const gchar *literal_str,
+                                 gsize literal_len, gint operator)
+{
+  obj = filterx_ref_unwrap_ro(obj);
+
+  gsize len;
+  const gchar *str = filterx_string_get_value_ref(obj, &len);
+  if (!str)
+    return filterx_compare_objects(obj, literal, operator);
+
+  gint result = memcmp(str, literal_str, MIN(len, literal_len));
+  if (result == 0)
+    result = len - literal_len;
+  return _evaluate_comparison(result, operator & FCMPX_OP_MASK);
+}
+
+/* integer literal on the rhs, compared in TYPE_AWARE, NUM_BASED or TYPE_AND_VALUE_BASED modes */
+__attribute__((used))
+gboolean
+fx_jit_compare_to_integer_literal(FilterXObject *obj, FilterXObject *literal, gint64 literal_value, gint operator)
+{
+  obj = filterx_ref_unwrap_ro(obj);
+
+  gint64 value;
+  if (!filterx_integer_unwrap(obj, &value))
+    return filterx_compare_objects(obj, literal, operator);
+
+  gint result = (value > literal_value) - (value < literal_value);
+  return _evaluate_comparison(result, operator & FCMPX_OP_MASK);
+}
+
+/* a < b is the same as b > a, used to move literals to the rhs */
+static gint
+_swap_operands_in_operator(gint operator)
+{
+  gint swapped = operator & ~(FCMPX_LT | FCMPX_GT);
+
+  if (operator & FCMPX_LT)
+    swapped |= FCMPX_GT;
+  if (operator & FCMPX_GT)
+    swapped |= FCMPX_LT;
+  return swapped;
+}
+
+static FilterXIRValue
+_compile_operand(FilterXComparison *self, FilterXJIT *jit, FilterXObject *literal_operand, FilterXExpr *operand_expr)
+{
+  if (literal_operand)
+    return fx_jit_emit_const_ptr(jit, literal_operand);
+
+  if (self->operator & (FCMPX_TYPE_AWARE + FCMPX_TYPE_AND_VALUE_BASED))
+    return filterx_expr_compile_or_eval_typed(operand_expr, jit);
+  return filterx_expr_compile_or_eval(operand_expr, jit);
+}
+
+/*
+ * If one side of the comparison is a string or integer literal, the
+ * comparison is specialized for it: the literal value is extracted at
+ * compile time, and the other operand is compared to it directly when it
+ * has the same type.  Everything else goes through
+ * filterx_compare_objects().
+ */
+static FilterXIRValue
+_emit_compare(FilterXComparison *self, FilterXJIT *jit, FilterXIRValue lhs, FilterXIRValue rhs)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  gint mode = self->operator & FCMPX_MODE_MASK;
+
+  FilterXObject *literal = NULL;
+  FilterXIRValue obj = NULL;
+  gint operator = self->operator;
+
+  if (self->literal_rhs && !self->literal_lhs)
+    {
+      literal = self->literal_rhs;
+      obj = lhs;
+    }
+  else if (self->literal_lhs && !self->literal_rhs)
+    {
+      literal = self->literal_lhs;
+      obj = rhs;
+      operator = _swap_operands_in_operator(operator);
+    }
+
+  gsize literal_len;
+  const gchar *literal_str;
+  gint64 literal_value;
+
+  if (literal && mode != FCMPX_NUM_BASED && (literal_str = filterx_string_get_value_ref(literal, &literal_len)))
+    {
+      FilterXIRValue args[] =
+      {
+        obj,
+        fx_jit_emit_const_ptr(jit, literal),
+        fx_jit_emit_const_ptr(jit, literal_str),
+        LLVMConstInt(ffi->i64_ty, literal_len, FALSE),
+        LLVMConstInt(ffi->i32_ty, operator, FALSE),
+      };
+      FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, ffi->ptr_ty, ffi->i64_ty, ffi->i32_ty };
+      return fx_jit_emit_extern_call(jit, "fx_jit_compare_to_string_literal", ffi->i32_ty, param_tys, args, 5);
+    }
+
+  if (literal && mode != FCMPX_STRING_BASED && filterx_integer_unwrap(literal, &literal_value))
+    {
+      FilterXIRValue args[] =
+      {
+        obj,
+        fx_jit_emit_const_ptr(jit, literal),
+        LLVMConstInt(ffi->i64_ty, literal_value, TRUE),
+        LLVMConstInt(ffi->i32_ty, operator, FALSE),
+      };
+      FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, ffi->i64_ty, ffi->i32_ty };
+      return fx_jit_emit_extern_call(jit, "fx_jit_compare_to_integer_literal", ffi->i32_ty, param_tys, args, 4);
+    }
+
+  FilterXIRValue args[] = { lhs, rhs, LLVMConstInt(ffi->i32_ty, self->operator, FALSE) };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, ffi->i32_ty };
+  return fx_jit_emit_extern_call(jit, "fx_jit_compare_objects", ffi->i32_ty, param_tys, args, 3);
+}
+
+static FilterXIRValue
+_compile_comparison(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXComparison *self = (FilterXComparison *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "cmp_finish", block);
+
+  FilterXIRValue lhs = _compile_operand(self, jit, self->literal_lhs, self->super.lhs);
+  if (!self->literal_lhs)
+    {
+      /* if (!lhs) goto finish; */
+      FilterXIRSequence eval_rhs = filterx_jit_ir_create_sequence(jit, "cmp_eval_rhs", block);
+      LLVMBuildCondBr(ir, LLVMBuildIsNull(ir, lhs, "lhs_is_null"), finish, eval_rhs);
+
+      filterx_jit_ir_add_sequence_to_block(jit, eval_rhs, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, eval_rhs);
+    }
+
+  FilterXIRValue rhs = _compile_operand(self, jit, self->literal_rhs, self->super.rhs);
+  if (!self->literal_rhs)
+    {
+      /* if (!rhs) { unref(lhs); goto finish; } */
+      FilterXIRSequence rhs_null = filterx_jit_ir_create_sequence(jit, "cmp_rhs_null", block);
+      FilterXIRSequence do_cmp = filterx_jit_ir_create_sequence(jit, "cmp_do_cmp", block);
+      LLVMBuildCondBr(ir, LLVMBuildIsNull(ir, rhs, "rhs_is_null"), rhs_null, do_cmp);
+
+      filterx_jit_ir_add_sequence_to_block(jit, rhs_null, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, rhs_null);
+      if (!self->literal_lhs)
+        fx_jit_emit_object_unref(jit, lhs);
+      LLVMBuildBr(ir, finish);
+
+      filterx_jit_ir_add_sequence_to_block(jit, do_cmp, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, do_cmp);
+    }
+
+  FilterXIRValue cmp_result = _emit_compare(self, jit, lhs, rhs);
+  if (!self->literal_lhs)
+    fx_jit_emit_object_unref(jit, lhs);
+  if (!self->literal_rhs)
+    fx_jit_emit_object_unref(jit, rhs);
+
+  FilterXIRValue args[] = { cmp_result };
+  FilterXIRType param_tys[] = { ffi->i32_ty };
+  LLVMBuildStore(ir, fx_jit_emit_extern_call(jit, "fx_jit_boolean_new", ffi->ptr_ty, param_tys, args, 1),
+                 result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+#endif
+
 /* NOTE: takes the object reference */
 FilterXExpr *
 filterx_comparison_new(FilterXExpr *lhs, FilterXExpr *rhs, gint operator)
@@ -301,6 +498,9 @@ filterx_comparison_new(FilterXExpr *lhs, FilterXExpr *rhs, gint operator)
   self->super.super.optimize = _optimize;
   self->super.super.eval = _eval_comparison;
   self->super.super.free_fn = _filterx_comparison_free;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.super.compile = _compile_comparison;
+#endif
   self->operator = operator;
 
   return &self->super.super;
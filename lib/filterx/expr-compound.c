@@ -319,10 +319,11 @@ _emit_process_expr_result(FilterXJIT *jit, FilterXIRValue result, FilterXExpr *c
   return fx_jit_emit_extern_call(jit, "fx_jit_process_expr_result", ffi->i32_ty, param_tys, args, 4);
 }
 
+/* start_index is an i64 IR value selecting the first statement to run, or
+ * NULL to start from the first one.  An out of range index runs nothing. */
 static FilterXIRValue
-_compound_compile(FilterXExpr *s, FilterXJIT *jit)
+_compound_compile_from(FilterXCompoundExpr *self, FilterXJIT *jit, FilterXIRValue start_index)
 {
-  FilterXCompoundExpr *self = (FilterXCompoundExpr *) s;
   FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
   FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
   FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
@@ -344,15 +345,22 @@ _compound_compile(FilterXExpr *s, FilterXJIT *jit)
       goto exit;
     }
 
+  FilterXIRValue entry_switch = NULL;
+  if (start_index)
+    entry_switch = LLVMBuildSwitch(ir, start_index, finish, n);
+
   FilterXIRValue prev_switch = NULL;
   for (gsize i = 0; i < n; i++)
     {
       FilterXExpr *child = filterx_expr_list_index_fast(&self->exprs, i);
       FilterXIRSequence stmt_seq = filterx_jit_ir_add_new_sequence_to_block(jit, filterx_expr_get_text(child), block);
 
+      if (entry_switch)
+        LLVMAddCase(entry_switch, LLVMConstInt(ffi->i64_ty, i, FALSE), stmt_seq);
+
       if (prev_switch)
         LLVMAddCase(prev_switch, LLVMConstInt(ffi->i32_ty, FXC_STEP_CONTINUE, FALSE), stmt_seq);
-      else
+      else if (!entry_switch)
         LLVMBuildBr(ir, stmt_seq);
 
       filterx_jit_ir_set_insert_point_to_sequence_tail(jit, stmt_seq);
@@ -384,6 +392,22 @@ exit:
   return _emit_process_compound_result(jit, self, success_val, result_val);
 }
 
+static FilterXIRValue
+_compound_compile(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXCompoundExpr *self = (FilterXCompoundExpr *) s;
+
+  return _compound_compile_from(self, jit, NULL);
+}
+
+FilterXIRValue
+filterx_compound_expr_compile_ext(FilterXExpr *s, FilterXJIT *jit, FilterXIRValue start_index)
+{
+  FilterXCompoundExpr *self = (FilterXCompoundExpr *) s;
+
+  return _compound_compile_from(self, jit, start_index);
+}
+
 #endif
 
 FilterXExpr *
@@ -31,4 +31,8 @@ FilterXExpr *filterx_compound_expr_new(gboolean return_value_of_last_expr);
 FilterXExpr *filterx_compound_expr_new_va(gboolean return_value_of_last_expr, FilterXExpr *first, ...);
 gsize filterx_compound_expr_get_count(FilterXExpr *s);
 
+#if SYSLOG_NG_ENABLE_JIT
+FilterXIRValue filterx_compound_expr_compile_ext(FilterXExpr *s, FilterXJIT *jit, FilterXIRValue start_index);
+#endif
+
 #endif
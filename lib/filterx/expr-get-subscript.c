@@ -21,6 +21,9 @@
  */
 #include "filterx/expr-get-subscript.h"
 #include "filterx/filterx-eval.h"
+#include "filterx/expr-literal.h"
+#include "filterx/object-string.h"
+#include "filterx/object-primitive.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster-single.h"
 
@@ -172,6 +175,210 @@ _get_subscript_walk(FilterXExpr *s, FilterXExprWalkFunc f, gpointer user_data)
   return TRUE;
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+/*
+ * Literal keys are not evaluated, they are passed as constants.  String
+ * keys of dicts and integer keys of lists are looked up directly (see
+ * jit-runtime.c), everything else is dispatched through the type of the
+ * object.
+ *
+ * NOTE: the literal key is borrowed from the literal expression.
+ */
+static FilterXIRValue
+_emit_literal_key_call(FilterXJIT *jit, const gchar *fn_prefix, FilterXIRType return_ty,
+                       FilterXIRValue variable, FilterXIRValue key, FilterXObject *literal_key)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  gchar fn_name[64];
+  gint64 index;
+
+  if (filterx_object_is_type(literal_key, &FILTERX_TYPE_NAME(string)))
+    {
+      g_snprintf(fn_name, sizeof(fn_name), "%s_string_key", fn_prefix);
+
+      FilterXIRValue args[] = { variable, key };
+      FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty };
+      return fx_jit_emit_extern_call(jit, fn_name, return_ty, param_tys, args, 2);
+    }
+
+  if (filterx_integer_unwrap(literal_key, &index))
+    {
+      g_snprintf(fn_name, sizeof(fn_name), "%s_integer_key", fn_prefix);
+
+      FilterXIRValue args[] = { variable, key, LLVMConstInt(ffi->i64_ty, index, TRUE) };
+      FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, ffi->i64_ty };
+      return fx_jit_emit_extern_call(jit, fn_name, return_ty, param_tys, args, 3);
+    }
+
+  return NULL;
+}
+
+static FilterXIRValue
+_emit_get_subscript(FilterXJIT *jit, FilterXIRValue variable, FilterXIRValue key, FilterXObject *literal_key)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  if (literal_key)
+    {
+      FilterXIRValue result = _emit_literal_key_call(jit, "fx_jit_get_subscript", ffi->ptr_ty, variable, key,
+                                                     literal_key);
+      if (result)
+        return result;
+    }
+
+  FilterXIRValue args[] = { variable, key };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty };
+  return fx_jit_emit_extern_call(jit, "fx_jit_object_get_subscript", ffi->ptr_ty, param_tys, args, 2);
+}
+
+static FilterXIRValue
+_emit_is_key_set(FilterXJIT *jit, FilterXIRValue variable, FilterXIRValue key, FilterXObject *literal_key)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  if (literal_key)
+    {
+      FilterXIRValue result = _emit_literal_key_call(jit, "fx_jit_is_key_set", ffi->i32_ty, variable, key,
+                                                     literal_key);
+      if (result)
+        return result;
+    }
+
+  FilterXIRValue args[] = { variable, key };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty };
+  return fx_jit_emit_extern_call(jit, "fx_jit_object_is_key_set", ffi->i32_ty, param_tys, args, 2);
+}
+
+/* returns the borrowed literal key, or NULL if the key has to be evaluated */
+static FilterXObject *
+_get_literal_key(FilterXGetSubscript *self)
+{
+  if (!filterx_expr_is_literal(self->key))
+    return NULL;
+
+  FilterXObject *literal_key = filterx_literal_get_value(self->key);
+  filterx_object_unref(literal_key);
+  return literal_key;
+}
+
+static FilterXIRValue
+_get_subscript_compile(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXGetSubscript *self = (FilterXGetSubscript *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+  FilterXObject *literal_key = _get_literal_key(self);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "get_subscript_finish", block);
+
+  FilterXIRValue variable = filterx_expr_compile_or_eval_typed(self->operand, jit);
+  fx_jit_emit_goto_if_null(jit, variable, finish);
+
+  FilterXIRValue key;
+  if (literal_key)
+    {
+      key = fx_jit_emit_const_ptr(jit, literal_key);
+    }
+  else
+    {
+      /* if (!key) { unref(variable); goto finish; } */
+      FilterXIRSequence key_null = filterx_jit_ir_create_sequence(jit, "get_subscript_key_null", block);
+      key = filterx_expr_compile_or_eval_typed(self->key, jit);
+      fx_jit_emit_goto_if_null(jit, key, key_null);
+      FilterXIRSequence lookup = LLVMGetInsertBlock(ir);
+
+      filterx_jit_ir_add_sequence_to_block(jit, key_null, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, key_null);
+      fx_jit_emit_object_unref(jit, variable);
+      LLVMBuildBr(ir, finish);
+
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, lookup);
+    }
+
+  FilterXIRValue result = _emit_get_subscript(jit, variable, key, literal_key);
+  LLVMBuildStore(ir, result, result_slot);
+
+  /* if (!result) filterx_eval_push_error(...); */
+  FilterXIRSequence lookup_failed = filterx_jit_ir_create_sequence(jit, "get_subscript_failed", block);
+  FilterXIRSequence cleanup = filterx_jit_ir_create_sequence(jit, "get_subscript_cleanup", block);
+  LLVMBuildCondBr(ir, LLVMBuildIsNull(ir, result, "result_is_null"), lookup_failed, cleanup);
+
+  filterx_jit_ir_add_sequence_to_block(jit, lookup_failed, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, lookup_failed);
+  fx_jit_emit_eval_push_error(jit, "Failed to get-subscript from object", key);
+  LLVMBuildBr(ir, cleanup);
+
+  filterx_jit_ir_add_sequence_to_block(jit, cleanup, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, cleanup);
+  if (!literal_key)
+    fx_jit_emit_object_unref(jit, key);
+  fx_jit_emit_object_unref(jit, variable);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+/* isset() of a subscript, returns a gboolean */
+FilterXIRValue
+filterx_get_subscript_compile_is_set(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXGetSubscript *self = (FilterXGetSubscript *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+  FilterXObject *literal_key = _get_literal_key(self);
+
+  g_assert(filterx_expr_is_get_subscript(s));
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->i32_ty, "is_set");
+  LLVMBuildStore(ir, LLVMConstInt(ffi->i32_ty, FALSE, FALSE), result_slot);
+
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "is_set_finish", block);
+
+  FilterXIRValue variable = filterx_expr_compile_or_eval_typed(self->operand, jit);
+  fx_jit_emit_goto_if_null(jit, variable, finish);
+
+  if (literal_key)
+    {
+      FilterXIRValue key = fx_jit_emit_const_ptr(jit, literal_key);
+      LLVMBuildStore(ir, _emit_is_key_set(jit, variable, key, literal_key), result_slot);
+      fx_jit_emit_object_unref(jit, variable);
+      LLVMBuildBr(ir, finish);
+    }
+  else
+    {
+      FilterXIRSequence key_null = filterx_jit_ir_create_sequence(jit, "is_set_key_null", block);
+      FilterXIRValue key = filterx_expr_compile_or_eval_typed(self->key, jit);
+      fx_jit_emit_goto_if_null(jit, key, key_null);
+
+      LLVMBuildStore(ir, _emit_is_key_set(jit, variable, key, NULL), result_slot);
+      fx_jit_emit_object_unref(jit, key);
+      fx_jit_emit_object_unref(jit, variable);
+      LLVMBuildBr(ir, finish);
+
+      filterx_jit_ir_add_sequence_to_block(jit, key_null, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, key_null);
+      fx_jit_emit_object_unref(jit, variable);
+      LLVMBuildBr(ir, finish);
+    }
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->i32_ty, result_slot, "is_set");
+}
+
+#endif
+
 /* NOTE: takes the object reference */
 FilterXExpr *
 filterx_get_subscript_new(FilterXExpr *operand, FilterXExpr *key)
@@ -185,6 +392,9 @@ filterx_get_subscript_new(FilterXExpr *operand, FilterXExpr *key)
   self->super.walk_children = _get_subscript_walk;
   self->super.move = _move;
   self->super.free_fn = _free;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _get_subscript_compile;
+#endif
   self->operand = operand;
   self->key = key;
   return &self->super;
@@ -28,6 +28,10 @@ FilterXExpr *filterx_get_subscript_new(FilterXExpr *lhs, FilterXExpr *key);
 
 FILTERX_EXPR_DECLARE_TYPE(get_subscript);
 
+#if SYSLOG_NG_ENABLE_JIT
+FilterXIRValue filterx_get_subscript_compile_is_set(FilterXExpr *s, FilterXJIT *jit);
+#endif
+
 static inline gboolean
 filterx_expr_is_get_subscript(FilterXExpr *expr)
 {
@@ -170,6 +170,38 @@ _getattr_compile(FilterXExpr *s, FilterXJIT *jit)
   return fx_jit_emit_extern_call(jit, "fx_jit_do_getattr", ffi->ptr_ty, param_tys, args, 3);
 }
 
+/* isset() of an attribute, returns a gboolean */
+FilterXIRValue
+filterx_getattr_compile_is_set(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXGetAttr *self = (FilterXGetAttr *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  g_assert(filterx_expr_is_getattr(s));
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->i32_ty, "is_set");
+  LLVMBuildStore(ir, LLVMConstInt(ffi->i32_ty, FALSE, FALSE), result_slot);
+
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "is_set_finish", block);
+
+  FilterXIRValue variable = filterx_expr_compile_or_eval_typed(self->operand, jit);
+  fx_jit_emit_goto_if_null(jit, variable, finish);
+
+  /* the attribute name is a string, looked up directly in dicts */
+  FilterXIRValue args[] = { variable, fx_jit_emit_const_ptr(jit, self->attr) };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty };
+  LLVMBuildStore(ir, fx_jit_emit_extern_call(jit, "fx_jit_is_key_set_string_key", ffi->i32_ty, param_tys, args, 2),
+                 result_slot);
+  fx_jit_emit_object_unref(jit, variable);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->i32_ty, result_slot, "is_set");
+}
+
 #endif
 
 /* NOTE: takes the object reference */
@@ -29,6 +29,10 @@ FilterXExpr *filterx_getattr_new(FilterXExpr *lhs, FilterXObject *attr_name);
 
 FILTERX_EXPR_DECLARE_TYPE(getattr);
 
+#if SYSLOG_NG_ENABLE_JIT
+FilterXIRValue filterx_getattr_compile_is_set(FilterXExpr *s, FilterXJIT *jit);
+#endif
+
 static inline gboolean
 filterx_expr_is_getattr(FilterXExpr *expr)
 {
@@ -22,6 +22,8 @@
 
 #include "filterx/expr-isset.h"
 #include "filterx/object-primitive.h"
+#include "filterx/expr-get-subscript.h"
+#include "filterx/expr-getattr.h"
 
 static FilterXObject *
 _eval_isset(FilterXExpr *s)
@@ -31,11 +33,53 @@ _eval_isset(FilterXExpr *s)
   return filterx_boolean_new(filterx_expr_is_set(self->operand));
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+/*
+ * The subscripts and attributes checked by isset() are compiled inline,
+ * with the key lookup specialized on literal keys.  Other operands are
+ * asked through filterx_expr_is_set().
+ */
+static FilterXIRValue
+_compile_is_set(FilterXExpr *operand, FilterXJIT *jit)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  if (filterx_expr_is_get_subscript(operand))
+    return filterx_get_subscript_compile_is_set(operand, jit);
+
+  if (filterx_expr_is_getattr(operand))
+    return filterx_getattr_compile_is_set(operand, jit);
+
+  FilterXIRValue args[] = { fx_jit_emit_const_ptr(jit, operand) };
+  FilterXIRType param_tys[] = { ffi->ptr_ty };
+  return fx_jit_emit_extern_call(jit, "fx_jit_expr_is_set", ffi->i32_ty, param_tys, args, 1);
+}
+
+static FilterXIRValue
+_compile_isset(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXUnaryOp *self = (FilterXUnaryOp *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  FilterXIRValue args[] = { _compile_is_set(self->operand, jit) };
+  FilterXIRType param_tys[] = { ffi->i32_ty };
+  return fx_jit_emit_extern_call(jit, "fx_jit_boolean_new", ffi->ptr_ty, param_tys, args, 1);
+}
+
+#endif
+
 FilterXExpr *
 filterx_isset_new(FilterXExpr *expr)
 {
   FilterXUnaryOp *self = g_new0(FilterXUnaryOp, 1);
   filterx_unary_op_init_instance(self, "isset", FXE_READ, expr);
   self->super.eval = _eval_isset;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _compile_isset;
+#endif
   return &self->super;
 }
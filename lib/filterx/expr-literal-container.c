@@ -218,6 +218,68 @@ _literal_container_init_instance(FilterXLiteralContainer *self, const gchar *typ
   filterx_pointer_list_init(&self->nonliteral_elements);
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+typedef void (*FilterXLiteralElementCompileFunc)(FilterXLiteralContainer *self, FilterXJIT *jit,
+                                                 FilterXLiteralElement *elem, FilterXIRValue container,
+                                                 FilterXIRSequence error);
+
+/*
+ * The loop over the elements is unrolled: the value (and key) expressions
+ * of each element are compiled inline, followed by the store into the new
+ * container.  Any failure jumps to the error sequence, which drops the
+ * container.
+ */
+static FilterXIRValue
+_literal_container_compile(FilterXLiteralContainer *self, FilterXJIT *jit, FilterXIRValue container,
+                           FilterXPointerList *elements, FilterXLiteralElementCompileFunc compile_elem)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, container, result_slot);
+
+  FilterXIRSequence error = filterx_jit_ir_create_sequence(jit, "literal_container_error", block);
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "literal_container_finish", block);
+
+  gsize len = filterx_pointer_list_get_length(elements);
+  for (gsize i = 0; i < len; i++)
+    compile_elem(self, jit, (FilterXLiteralElement *) filterx_pointer_list_index(elements, i), container, error);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, error, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, error);
+  fx_jit_emit_object_unref(jit, container);
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+/* list and tuple elements: the value is passed to store_fn, which returns a gboolean */
+static void
+_literal_container_compile_value(FilterXJIT *jit, FilterXLiteralElement *elem, FilterXIRValue container,
+                                 FilterXIRSequence error, const gchar *store_fn)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  FilterXIRValue value = filterx_expr_compile_or_eval(elem->value, jit);
+  fx_jit_emit_goto_if_null(jit, value, error);
+
+  FilterXIRValue args[] = { container, value };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty };
+  fx_jit_emit_goto_if_false(jit, fx_jit_emit_extern_call(jit, store_fn, ffi->i32_ty, param_tys, args, 2), error);
+}
+
+#endif
+
 /* Literal dict objects */
 
 static inline gboolean
@@ -344,23 +406,27 @@ error:
   return NULL;
 }
 
+/* the literal members are already set in the sparse container */
+static inline FilterXObject *
+_literal_dict_new_at_runtime(FilterXLiteralContainer *self)
+{
+  if (self->sparse_container)
+    return filterx_object_cow_fork(&self->sparse_container);
+
+  FilterXObject *dict_ref = filterx_dict_new();
+  filterx_object_cow_prepare(&dict_ref);
+  return dict_ref;
+}
+
 static FilterXObject *
 _literal_dict_eval(FilterXExpr *s)
 {
   FilterXLiteralContainer *self = (FilterXLiteralContainer *) s;
   FilterXPointerList *pl = &self->elements;
 
-  FilterXObject *dict_ref;
+  FilterXObject *dict_ref = _literal_dict_new_at_runtime(self);
   if (self->sparse_container)
-    {
-      dict_ref = filterx_object_cow_fork(&self->sparse_container);
-      pl = &self->nonliteral_elements;
-    }
-  else
-    {
-      dict_ref = filterx_dict_new();
-      filterx_object_cow_prepare(&dict_ref);
-    }
+    pl = &self->nonliteral_elements;
   FilterXObject *dict = filterx_ref_unwrap_rw(dict_ref);
 
   gsize len = filterx_pointer_list_get_length(pl);
@@ -382,6 +448,80 @@ error:
   return NULL;
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+__attribute__((used))
+FilterXObject *
+fx_jit_literal_dict_new(FilterXLiteralContainer *self)
+{
+  return _literal_dict_new_at_runtime(self);
+}
+
+/* NOTE: consumes the references of key and value */
+__attribute__((used))
+gboolean
+fx_jit_literal_dict_store_elem(FilterXLiteralContainer *self, FilterXObject *dict_ref, FilterXLiteralElement *elem,
+                               FilterXObject *key, FilterXObject *value)
+{
+  return _literal_dict_store_elem(self, dict_ref, filterx_ref_unwrap_rw(dict_ref), elem, key, value, FALSE);
+}
+
+/*
+ * Literal keys are not evaluated, their reference is taken directly. The
+ * members that have an anchor in the sparse container are stored through
+ * it in _literal_dict_store_elem().
+ */
+static void
+_literal_dict_compile_elem(FilterXLiteralContainer *self, FilterXJIT *jit, FilterXLiteralElement *elem,
+                           FilterXIRValue dict_ref, FilterXIRSequence error)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue key = filterx_expr_compile_or_eval(elem->key, jit);
+  if (!filterx_expr_is_literal(elem->key))
+    fx_jit_emit_goto_if_null(jit, key, error);
+
+  FilterXIRValue value = filterx_expr_compile_or_eval(elem->value, jit);
+  if (!elem->nullv)
+    {
+      /* if (!value) { unref(key); goto error; } */
+      FilterXIRSequence value_null = filterx_jit_ir_create_sequence(jit, "literal_dict_value_null", block);
+      fx_jit_emit_goto_if_null(jit, value, value_null);
+      FilterXIRSequence store = LLVMGetInsertBlock(ir);
+
+      filterx_jit_ir_add_sequence_to_block(jit, value_null, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, value_null);
+      fx_jit_emit_object_unref(jit, key);
+      LLVMBuildBr(ir, error);
+
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, store);
+    }
+
+  FilterXIRValue args[] = { fx_jit_emit_const_ptr(jit, self), dict_ref, fx_jit_emit_const_ptr(jit, elem), key, value };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, ffi->ptr_ty, ffi->ptr_ty, ffi->ptr_ty };
+  FilterXIRValue success = fx_jit_emit_extern_call(jit, "fx_jit_literal_dict_store_elem", ffi->i32_ty,
+                                                   param_tys, args, 5);
+  fx_jit_emit_goto_if_false(jit, success, error);
+}
+
+static FilterXIRValue
+_literal_dict_compile(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXLiteralContainer *self = (FilterXLiteralContainer *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  FilterXIRValue args[] = { fx_jit_emit_const_ptr(jit, self) };
+  FilterXIRType param_tys[] = { ffi->ptr_ty };
+  FilterXIRValue dict_ref = fx_jit_emit_extern_call(jit, "fx_jit_literal_dict_new", ffi->ptr_ty, param_tys, args, 1);
+
+  FilterXPointerList *elements = self->sparse_container ? &self->nonliteral_elements : &self->elements;
+  return _literal_container_compile(self, jit, dict_ref, elements, _literal_dict_compile_elem);
+}
+
+#endif
+
 /* Literal dict objects */
 
 gboolean
@@ -408,6 +548,9 @@ filterx_literal_dict_new(GList *elements)
 
   _literal_container_init_instance(self, FILTERX_EXPR_TYPE_NAME(literal_dict));
   self->super.eval = _literal_dict_eval;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _literal_dict_compile;
+#endif
   self->eval_early = _literal_dict_eval_early;
   filterx_pointer_list_add_list(&self->elements, elements);
 
@@ -416,35 +559,39 @@ filterx_literal_dict_new(GList *elements)
 
 /* Literal list objects */
 
+/* NOTE: consumes the reference of value */
 static inline gboolean
-_literal_list_eval_elem(FilterXLiteralContainer *self, FilterXLiteralElement *elem, FilterXObject *result,
-                        gboolean early_eval)
+_literal_list_append_value(FilterXObject *result, FilterXObject *value)
 {
-  FilterXObject *key = NULL;
-  FilterXObject *value = NULL;
-  gboolean success = FALSE;
-
-  value = _literal_container_eval_expr(elem->value, early_eval, FALSE);
-  if (!value)
-    {
-      goto exit;
-    }
-
   value = filterx_object_cow_fork2(value, NULL);
-  success = filterx_object_set_subscript(result, key, &value);
+  gboolean success = filterx_object_set_subscript(result, NULL, &value);
 
   if (!success)
-    {
-      filterx_eval_push_error_static_info("Failed to create literal container",
-                                          "Failed to set value in container");
-      goto exit;
-    }
-exit:
-  filterx_object_unref(key);
+    filterx_eval_push_error_static_info("Failed to create literal container",
+                                        "Failed to set value in container");
   filterx_object_unref(value);
   return success;
 }
 
+static inline gboolean
+_literal_list_eval_elem(FilterXLiteralContainer *self, FilterXLiteralElement *elem, FilterXObject *result,
+                        gboolean early_eval)
+{
+  FilterXObject *value = _literal_container_eval_expr(elem->value, early_eval, FALSE);
+  if (!value)
+    return FALSE;
+
+  return _literal_list_append_value(result, value);
+}
+
+static inline FilterXObject *
+_literal_list_new_at_runtime(void)
+{
+  FilterXObject *result = filterx_list_new();
+  filterx_object_cow_prepare(&result);
+  return result;
+}
+
 /*
  * This is an inline version with two variants,
  *
@@ -459,8 +606,7 @@ _literal_list_eval_adaptive(FilterXExpr *s, gboolean early_eval)
 {
   FilterXLiteralContainer *self = (FilterXLiteralContainer *) s;
 
-  FilterXObject *result = filterx_list_new();
-  filterx_object_cow_prepare(&result);
+  FilterXObject *result = _literal_list_new_at_runtime();
 
   gsize len = filterx_pointer_list_get_length(&self->elements);
   for (gsize i = 0; i < len; i++)
@@ -495,6 +641,42 @@ _literal_list_eval(FilterXExpr *s)
   return _literal_list_eval_adaptive(s, FALSE);
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+__attribute__((used))
+FilterXObject *
+fx_jit_literal_list_new(void)
+{
+  return _literal_list_new_at_runtime();
+}
+
+/* NOTE: consumes the reference of value */
+__attribute__((used))
+gboolean
+fx_jit_literal_list_append_value(FilterXObject *result, FilterXObject *value)
+{
+  return _literal_list_append_value(result, value);
+}
+
+static void
+_literal_list_compile_elem(FilterXLiteralContainer *self, FilterXJIT *jit, FilterXLiteralElement *elem,
+                           FilterXIRValue result, FilterXIRSequence error)
+{
+  _literal_container_compile_value(jit, elem, result, error, "fx_jit_literal_list_append_value");
+}
+
+static FilterXIRValue
+_literal_list_compile(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXLiteralContainer *self = (FilterXLiteralContainer *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  FilterXIRValue result = fx_jit_emit_extern_call(jit, "fx_jit_literal_list_new", ffi->ptr_ty, NULL, NULL, 0);
+  return _literal_container_compile(self, jit, result, &self->elements, _literal_list_compile_elem);
+}
+
+#endif
+
 gboolean
 filterx_literal_list_foreach(FilterXExpr *s, FilterXLiteralListForeachFunc func, gpointer user_data)
 {
@@ -519,6 +701,9 @@ filterx_literal_list_new(GList *elements)
 
   _literal_container_init_instance(self, FILTERX_EXPR_TYPE_NAME(literal_list));
   self->super.eval = _literal_list_eval;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _literal_list_compile;
+#endif
   self->eval_early = _literal_list_eval_early;
   filterx_pointer_list_add_list(&self->elements, elements);
 
@@ -527,20 +712,25 @@ filterx_literal_list_new(GList *elements)
 
 /* Literal tuple objects */
 
+/* NOTE: consumes the reference of value */
+static inline gboolean
+_literal_tuple_append_value(FilterXObject *result, FilterXObject *value)
+{
+  value = filterx_object_cow_fork2(value, NULL);
+  filterx_tuple_set_subscript(result, filterx_tuple_get_length(result), value);
+  filterx_object_unref(value);
+  return TRUE;
+}
+
 static inline gboolean
 _literal_tuple_eval_elem(FilterXLiteralContainer *self, FilterXLiteralElement *elem, FilterXObject *result,
                          gboolean early_eval)
 {
-  FilterXObject *value = NULL;
-
-  value = _literal_container_eval_expr(elem->value, early_eval, FALSE);
+  FilterXObject *value = _literal_container_eval_expr(elem->value, early_eval, FALSE);
   if (!value)
     return FALSE;
 
-  value = filterx_object_cow_fork2(value, NULL);
-  filterx_tuple_set_subscript(result, filterx_tuple_get_length(result), value);
-  filterx_object_unref(value);
-  return TRUE;
+  return _literal_tuple_append_value(result, value);
 }
 
 /*
@@ -592,6 +782,44 @@ _literal_tuple_eval(FilterXExpr *s)
   return _literal_tuple_eval_adaptive(s, FALSE);
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+__attribute__((used))
+FilterXObject *
+fx_jit_literal_tuple_new(gsize len)
+{
+  return filterx_tuple_new(len);
+}
+
+/* NOTE: consumes the reference of value */
+__attribute__((used))
+gboolean
+fx_jit_literal_tuple_append_value(FilterXObject *result, FilterXObject *value)
+{
+  return _literal_tuple_append_value(result, value);
+}
+
+static void
+_literal_tuple_compile_elem(FilterXLiteralContainer *self, FilterXJIT *jit, FilterXLiteralElement *elem,
+                            FilterXIRValue result, FilterXIRSequence error)
+{
+  _literal_container_compile_value(jit, elem, result, error, "fx_jit_literal_tuple_append_value");
+}
+
+static FilterXIRValue
+_literal_tuple_compile(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXLiteralContainer *self = (FilterXLiteralContainer *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  FilterXIRValue args[] = { LLVMConstInt(ffi->i64_ty, filterx_pointer_list_get_length(&self->elements), FALSE) };
+  FilterXIRType param_tys[] = { ffi->i64_ty };
+  FilterXIRValue result = fx_jit_emit_extern_call(jit, "fx_jit_literal_tuple_new", ffi->ptr_ty, param_tys, args, 1);
+  return _literal_container_compile(self, jit, result, &self->elements, _literal_tuple_compile_elem);
+}
+
+#endif
+
 gboolean
 filterx_literal_tuple_foreach(FilterXExpr *s, FilterXLiteralListForeachFunc func, gpointer user_data)
 {
@@ -616,6 +844,9 @@ filterx_literal_tuple_new(GList *elements)
 
   _literal_container_init_instance(self, FILTERX_EXPR_TYPE_NAME(literal_tuple));
   self->super.eval = _literal_tuple_eval;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _literal_tuple_compile;
+#endif
   self->eval_early = _literal_tuple_eval_early;
   filterx_pointer_list_add_list(&self->elements, elements);
 
@@ -23,6 +23,8 @@
 #include "filterx/object-primitive.h"
 #include "filterx/filterx-sequence.h"
 #include "filterx/object-dict.h"
+#include "filterx/object-list.h"
+#include "filterx/object-string.h"
 #include "filterx/expr-literal.h"
 #include "filterx/filterx-eval.h"
 #include "filterx/filterx-object.h"
@@ -81,6 +83,113 @@ _optimize_in(FilterXExpr *s)
   return result;
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+static gboolean
+_is_list_of_strings(FilterXObject *container)
+{
+  container = filterx_ref_unwrap_ro(container);
+  if (container->type != &FILTERX_TYPE_NAME(list))
+    return FALSE;
+
+  guint64 len;
+  filterx_object_len(container, &len);
+  for (guint64 i = 0; i < len; i++)
+    {
+      if (filterx_list_peek_subscript(container, i)->type != &FILTERX_TYPE_NAME(string))
+        return FALSE;
+    }
+  return TRUE;
+}
+
+/* literal operands are borrowed from the literal expressions */
+static FilterXIRValue
+_compile_operand(FilterXJIT *jit, FilterXExpr *operand, FilterXObject *literal_operand, gboolean typed)
+{
+  if (literal_operand)
+    return fx_jit_emit_const_ptr(jit, literal_operand);
+
+  if (typed)
+    return filterx_expr_compile_or_eval_typed(operand, jit);
+  return filterx_expr_compile_or_eval(operand, jit);
+}
+
+static FilterXObject *
+_get_literal_operand(FilterXExpr *operand)
+{
+  if (!filterx_expr_is_literal(operand))
+    return NULL;
+
+  FilterXObject *value = filterx_literal_get_value(operand);
+  filterx_object_unref(value);
+  return value;
+}
+
+/*
+ * Literal operands are passed as constants.  A literal list of strings on
+ * the rhs (e.g. $HOST in ["a", "b"]) is searched by comparing the member
+ * string to the elements directly.
+ */
+static FilterXIRValue
+_compile_in(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXOperatorIn *self = (FilterXOperatorIn *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+  FilterXObject *literal_member = _get_literal_operand(self->super.lhs);
+  FilterXObject *literal_container = _get_literal_operand(self->super.rhs);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "in_finish", block);
+
+  FilterXIRValue member = _compile_operand(jit, self->super.lhs, literal_member, TRUE);
+  if (!literal_member)
+    fx_jit_emit_goto_if_null(jit, member, finish);
+
+  FilterXIRValue container = _compile_operand(jit, self->super.rhs, literal_container, FALSE);
+  if (!literal_container)
+    {
+      /* if (!container) { unref(member); goto finish; } */
+      FilterXIRSequence container_null = filterx_jit_ir_create_sequence(jit, "in_container_null", block);
+      fx_jit_emit_goto_if_null(jit, container, container_null);
+      FilterXIRSequence lookup = LLVMGetInsertBlock(ir);
+
+      filterx_jit_ir_add_sequence_to_block(jit, container_null, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, container_null);
+      if (!literal_member)
+        fx_jit_emit_object_unref(jit, member);
+      LLVMBuildBr(ir, finish);
+
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, lookup);
+    }
+
+  const gchar *fn_name = "fx_jit_object_is_member_of";
+  if (literal_container && _is_list_of_strings(literal_container))
+    fn_name = "fx_jit_is_member_of_string_list";
+
+  FilterXIRValue args[] = { container, member };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty };
+  LLVMBuildStore(ir, fx_jit_emit_extern_call(jit, fn_name, ffi->ptr_ty, param_tys, args, 2), result_slot);
+
+  if (!literal_container)
+    fx_jit_emit_object_unref(jit, container);
+  if (!literal_member)
+    fx_jit_emit_object_unref(jit, member);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+#endif
+
 FilterXExpr *
 filterx_membership_in_new(FilterXExpr *lhs, FilterXExpr *rhs)
 {
@@ -89,6 +198,9 @@ filterx_membership_in_new(FilterXExpr *lhs, FilterXExpr *rhs)
   filterx_binary_op_init_instance(&self->super, "in", FXE_READ, lhs, rhs);
   self->super.super.optimize = _optimize_in;
   self->super.super.eval = _eval_in;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.super.compile = _compile_in;
+#endif
 
   return &self->super.super;
 }
@@ -34,15 +34,21 @@ struct _FilterXNullCoalesce
   FilterXBinaryOp super;
 };
 
+static inline gboolean
+_lhs_is_null(FilterXObject *lhs_object)
+{
+  return !lhs_object || filterx_object_is_type(lhs_object, &FILTERX_TYPE_NAME(null))
+         || (filterx_object_is_type(lhs_object, &FILTERX_TYPE_NAME(message_value))
+             && filterx_message_value_get_type(lhs_object) == LM_VT_NULL);
+}
+
 static FilterXObject *
 _eval_null_coalesce(FilterXExpr *s)
 {
   FilterXNullCoalesce *self = (FilterXNullCoalesce *) s;
 
   FilterXObject *lhs_object = filterx_expr_eval(self->super.lhs);
-  if (!lhs_object || filterx_object_is_type(lhs_object, &FILTERX_TYPE_NAME(null))
-      || (filterx_object_is_type(lhs_object, &FILTERX_TYPE_NAME(message_value))
-          && filterx_message_value_get_type(lhs_object) == LM_VT_NULL))
+  if (_lhs_is_null(lhs_object))
     {
       if (!lhs_object)
         filterx_eval_dump_errors("FilterX: null coalesce suppressing error");
@@ -73,6 +79,60 @@ _optimize(FilterXExpr *s)
   return filterx_expr_ref(self->super.lhs);
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+__attribute__((used))
+gboolean
+fx_jit_null_coalesce_lhs_is_null(FilterXObject *lhs_object)
+{
+  if (!_lhs_is_null(lhs_object))
+    return FALSE;
+
+  if (!lhs_object)
+    filterx_eval_dump_errors("FilterX: null coalesce suppressing error");
+  return TRUE;
+}
+
+static FilterXIRValue
+_compile_null_coalesce(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXNullCoalesce *self = (FilterXNullCoalesce *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+
+  FilterXIRSequence eval_rhs = filterx_jit_ir_create_sequence(jit, "null_coalesce_eval_rhs", block);
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "null_coalesce_finish", block);
+
+  FilterXIRValue lhs = filterx_expr_compile_or_eval(self->super.lhs, jit);
+  LLVMBuildStore(ir, lhs, result_slot);
+
+  /* if (!_lhs_is_null(lhs)) goto finish; */
+  FilterXIRValue args[] = { lhs };
+  FilterXIRType param_tys[] = { ffi->ptr_ty };
+  FilterXIRValue lhs_is_null = fx_jit_emit_extern_call(jit, "fx_jit_null_coalesce_lhs_is_null", ffi->i32_ty,
+                                                       param_tys, args, 1);
+  LLVMBuildCondBr(ir, LLVMBuildICmp(ir, LLVMIntNE, lhs_is_null, LLVMConstInt(ffi->i32_ty, 0, FALSE), "is_null"),
+                  eval_rhs, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, eval_rhs, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, eval_rhs);
+  LLVMBuildStore(ir, filterx_expr_compile_or_eval(self->super.rhs, jit), result_slot);
+  fx_jit_emit_object_unref(jit, lhs);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+#endif
+
 FilterXExpr *
 filterx_null_coalesce_new(FilterXExpr *lhs, FilterXExpr *rhs)
 {
@@ -80,5 +140,8 @@ filterx_null_coalesce_new(FilterXExpr *lhs, FilterXExpr *rhs)
   filterx_binary_op_init_instance(&self->super, "null_coalesce", FXE_READ, lhs, rhs);
   self->super.super.eval = _eval_null_coalesce;
   self->super.super.optimize = _optimize;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.super.compile = _compile_null_coalesce;
+#endif
   return &self->super.super;
 }
@@ -25,6 +25,7 @@
 #include "filterx/object-null.h"
 #include "filterx/object-message-value.h"
 #include "filterx/object-extractor.h"
+#include "filterx/expr-literal.h"
 #include "scratch-buffers.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster-single.h"
@@ -170,6 +171,181 @@ _set_subscript_walk(FilterXExpr *s, FilterXExprWalkFunc f, gpointer user_data)
   return TRUE;
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+__attribute__((used))
+FilterXObject *
+fx_jit_nullv_set_subscript_suppress_error(void)
+{
+  return _suppress_error();
+}
+
+/*
+ * nullv: the assignment is skipped if new_value is null or its evaluation
+ * failed, in the latter case the error is suppressed.
+ *
+ * On return, the insert point is where new_value is to be stored.
+ */
+static void
+_compile_nullv_check(FilterXJIT *jit, FilterXIRValue new_value, FilterXIRValue result_slot, FilterXIRSequence finish)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRSequence suppress_error = filterx_jit_ir_create_sequence(jit, "nullv_suppress_error", block);
+  FilterXIRSequence skip = filterx_jit_ir_create_sequence(jit, "nullv_skip", block);
+
+  fx_jit_emit_goto_if_null(jit, new_value, suppress_error);
+
+  /* if (filterx_object_extract_null(new_value)) { result = new_value; goto finish; } */
+  FilterXIRValue args[] = { new_value };
+  FilterXIRType param_tys[] = { ffi->ptr_ty };
+  FilterXIRValue is_null = fx_jit_emit_extern_call(jit, "fx_jit_object_extract_null", ffi->i32_ty, param_tys, args, 1);
+  FilterXIRSequence store = filterx_jit_ir_create_sequence(jit, "nullv_store", block);
+  LLVMBuildCondBr(ir, LLVMBuildICmp(ir, LLVMIntNE, is_null, LLVMConstInt(ffi->i32_ty, 0, FALSE), "is_null"),
+                  skip, store);
+
+  filterx_jit_ir_add_sequence_to_block(jit, skip, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, skip);
+  LLVMBuildStore(ir, new_value, result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, suppress_error, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, suppress_error);
+  LLVMBuildStore(ir, fx_jit_emit_extern_call(jit, "fx_jit_nullv_set_subscript_suppress_error", ffi->ptr_ty,
+                                             NULL, NULL, 0),
+                 result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, store, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, store);
+}
+
+/*
+ * Same as _set_subscript(): stores a copy of new_value into the object and
+ * returns the copy, or NULL on error.
+ */
+static FilterXIRValue
+_compile_store(FilterXSetSubscript *self, FilterXJIT *jit, FilterXIRValue key, FilterXIRValue new_value)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue cloned_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "cloned");
+  LLVMBuildStore(ir, fx_jit_emit_object_cow_fork2(jit, fx_jit_emit_object_ref(jit, new_value)), cloned_slot);
+
+  FilterXIRSequence failed = filterx_jit_ir_create_sequence(jit, "set_subscript_store_failed", block);
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "set_subscript_store_finish", block);
+
+  FilterXIRValue object = filterx_expr_compile_or_eval_typed(self->object, jit);
+  fx_jit_emit_goto_if_null(jit, object, failed);
+
+  /* the object is unreferenced both on success and on failure */
+  FilterXIRSequence set_failed = filterx_jit_ir_create_sequence(jit, "set_subscript_set_failed", block);
+
+  FilterXIRValue args[] = { object, key, cloned_slot };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, ffi->ptr_ty };
+  FilterXIRValue success = fx_jit_emit_extern_call(jit, "fx_jit_object_set_subscript", ffi->i32_ty,
+                                                   param_tys, args, 3);
+  fx_jit_emit_object_unref(jit, object);
+  LLVMBuildCondBr(ir, LLVMBuildICmp(ir, LLVMIntNE, success, LLVMConstInt(ffi->i32_ty, 0, FALSE), "success"),
+                  finish, set_failed);
+
+  filterx_jit_ir_add_sequence_to_block(jit, set_failed, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, set_failed);
+  fx_jit_emit_eval_push_error(jit, "Object set-subscript failed", key);
+  LLVMBuildBr(ir, failed);
+
+  filterx_jit_ir_add_sequence_to_block(jit, failed, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, failed);
+  fx_jit_emit_object_unref(jit, LLVMBuildLoad2(ir, ffi->ptr_ty, cloned_slot, "cloned"));
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), cloned_slot);
+  fx_jit_emit_eval_push_error_static_info(jit, "Failed to set element of object", "set-subscript() method failed");
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, cloned_slot, "cloned");
+}
+
+/*
+ * Literal keys (and the missing key of appends) are not evaluated, they are
+ * passed as constants.
+ */
+static FilterXIRValue
+_compile_set_subscript_common(FilterXExpr *s, FilterXJIT *jit, gboolean nullv)
+{
+  FilterXSetSubscript *self = (FilterXSetSubscript *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+  gboolean key_evaluated = self->key && !filterx_expr_is_literal(self->key);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "set_subscript_finish", block);
+
+  FilterXIRValue new_value = filterx_expr_compile_or_eval(self->new_value, jit);
+  if (nullv)
+    _compile_nullv_check(jit, new_value, result_slot, finish);
+  else
+    fx_jit_emit_goto_if_null(jit, new_value, finish);
+
+  FilterXIRValue key;
+  if (!key_evaluated)
+    {
+      FilterXObject *literal_key = self->key ? filterx_literal_get_value(self->key) : NULL;
+      key = literal_key ? fx_jit_emit_const_ptr(jit, literal_key) : LLVMConstNull(ffi->ptr_ty);
+      /* borrowed from the literal expression */
+      filterx_object_unref(literal_key);
+    }
+  else
+    {
+      /* if (!key) { unref(new_value); goto finish; } */
+      FilterXIRSequence key_null = filterx_jit_ir_create_sequence(jit, "set_subscript_key_null", block);
+      key = filterx_expr_compile_or_eval(self->key, jit);
+      fx_jit_emit_goto_if_null(jit, key, key_null);
+      FilterXIRSequence store = LLVMGetInsertBlock(ir);
+
+      filterx_jit_ir_add_sequence_to_block(jit, key_null, block);
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, key_null);
+      fx_jit_emit_object_unref(jit, new_value);
+      LLVMBuildBr(ir, finish);
+
+      filterx_jit_ir_set_insert_point_to_sequence_tail(jit, store);
+    }
+
+  LLVMBuildStore(ir, _compile_store(self, jit, key, new_value), result_slot);
+  fx_jit_emit_object_unref(jit, new_value);
+  if (key_evaluated)
+    fx_jit_emit_object_unref(jit, key);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+static FilterXIRValue
+_set_subscript_compile(FilterXExpr *s, FilterXJIT *jit)
+{
+  return _compile_set_subscript_common(s, jit, FALSE);
+}
+
+static FilterXIRValue
+_nullv_set_subscript_compile(FilterXExpr *s, FilterXJIT *jit)
+{
+  return _compile_set_subscript_common(s, jit, TRUE);
+}
+
+#endif
+
 FilterXExpr *
 filterx_set_subscript_new(FilterXExpr *object, FilterXExpr *key, FilterXExpr *new_value)
 {
@@ -179,6 +355,9 @@ filterx_set_subscript_new(FilterXExpr *object, FilterXExpr *key, FilterXExpr *ne
   self->super.eval = _set_subscript_eval;
   self->super.walk_children = _set_subscript_walk;
   self->super.free_fn = _free;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _set_subscript_compile;
+#endif
   self->object = object;
   self->key = key;
   self->new_value = new_value;
@@ -193,5 +372,8 @@ filterx_nullv_set_subscript_new(FilterXExpr *object, FilterXExpr *key, FilterXEx
 
   self->type = "nullv_set_subscript";
   self->eval = _nullv_set_subscript_eval;
+#if SYSLOG_NG_ENABLE_JIT
+  self->compile = _nullv_set_subscript_compile;
+#endif
   return self;
 }
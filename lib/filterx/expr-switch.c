@@ -326,17 +326,13 @@ _find_matching_case(FilterXSwitch *self, FilterXObject *selector, GError **error
   return NULL;
 }
 
-static FilterXObject *
-_eval_switch(FilterXExpr *s)
-{
-  FilterXSwitch *self = (FilterXSwitch *) s;
-
-  FilterXObject *selector = filterx_expr_eval_typed(self->selector);
-  if (!selector)
-    {
-      return NULL;
-    }
+#define FILTERX_SWITCH_TARGET_ERROR (-2)
 
+/* returns the index of the first body statement to run, -1 if nothing
+ * matched and there is no default, FILTERX_SWITCH_TARGET_ERROR on error */
+static gssize
+_find_target(FilterXSwitch *self, FilterXObject *selector)
+{
   FilterXSwitchCase *switch_case;
   GError *error = NULL;
 
@@ -348,8 +344,7 @@ _eval_switch(FilterXExpr *s)
     {
       filterx_eval_push_error_info_printf("Failed to evaluate switch", "%s", error->message);
       g_clear_error(&error);
-      filterx_object_unref(selector);
-      return NULL;
+      return FILTERX_SWITCH_TARGET_ERROR;
     }
 
   gssize target = -1;
@@ -359,11 +354,106 @@ _eval_switch(FilterXExpr *s)
   if (target < 0)
     target = self->default_target;
 
-  FilterXObject *result = _eval_body(self, target);
+  return target;
+}
+
+/* NOTE: consumes selector */
+static FilterXObject *
+_dispatch(FilterXSwitch *self, FilterXObject *selector)
+{
+  gssize target = _find_target(self, selector);
   filterx_object_unref(selector);
-  return result;
+
+  if (target == FILTERX_SWITCH_TARGET_ERROR)
+    return NULL;
+
+  return _eval_body(self, target);
+}
+
+static FilterXObject *
+_eval_switch(FilterXExpr *s)
+{
+  FilterXSwitch *self = (FilterXSwitch *) s;
+
+  FilterXObject *selector = filterx_expr_eval_typed(self->selector);
+  if (!selector)
+    {
+      return NULL;
+    }
+
+  return _dispatch(self, selector);
 }
 
+#if SYSLOG_NG_ENABLE_JIT
+
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+
+/* NOTE: consumes selector */
+__attribute__((used))
+gint64
+fx_jit_switch_find_target(FilterXSwitch *self, FilterXObject *selector)
+{
+  gssize target = _find_target(self, selector);
+  filterx_object_unref(selector);
+  return target;
+}
+
+/* The selector and the body are compiled, the body is entered through a
+ * jump table on the statement index of the matching case.  The case lookup
+ * itself is a call-out to _find_target(), sharing the literal hash table
+ * and the match functions with the interpreter. */
+static FilterXIRValue
+_compile_switch(FilterXExpr *s, FilterXJIT *jit)
+{
+  FilterXSwitch *self = (FilterXSwitch *) s;
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRValue result_slot = LLVMBuildAlloca(ir, ffi->ptr_ty, "result");
+  LLVMBuildStore(ir, LLVMConstNull(ffi->ptr_ty), result_slot);
+
+  FilterXIRSequence find_target = filterx_jit_ir_create_sequence(jit, "switch_find_target", block);
+  FilterXIRSequence no_match = filterx_jit_ir_create_sequence(jit, "switch_no_match", block);
+  FilterXIRSequence body = filterx_jit_ir_create_sequence(jit, "switch_body", block);
+  FilterXIRSequence finish = filterx_jit_ir_create_sequence(jit, "switch_finish", block);
+
+  /* if (!selector) goto finish; */
+  FilterXIRValue selector = filterx_expr_compile_or_eval_typed(self->selector, jit);
+  LLVMBuildCondBr(ir, LLVMBuildIsNull(ir, selector, "selector_is_null"), finish, find_target);
+
+  filterx_jit_ir_add_sequence_to_block(jit, find_target, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, find_target);
+  FilterXIRValue args[] = { fx_jit_emit_const_ptr(jit, self), selector };
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty };
+  FilterXIRValue target = fx_jit_emit_extern_call(jit, "fx_jit_switch_find_target", ffi->i64_ty, param_tys, args, 2);
+
+  FilterXIRValue target_switch = LLVMBuildSwitch(ir, target, body, 2);
+  LLVMAddCase(target_switch, LLVMConstInt(ffi->i64_ty, FILTERX_SWITCH_TARGET_ERROR, TRUE), finish);
+  LLVMAddCase(target_switch, LLVMConstInt(ffi->i64_ty, -1, TRUE), no_match);
+
+  /* nothing matched and there is no default: TRUE */
+  filterx_jit_ir_add_sequence_to_block(jit, no_match, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, no_match);
+  FilterXIRValue true_args[] = { LLVMConstInt(ffi->i32_ty, TRUE, FALSE) };
+  FilterXIRType true_param_tys[] = { ffi->i32_ty };
+  LLVMBuildStore(ir, fx_jit_emit_extern_call(jit, "fx_jit_boolean_new", ffi->ptr_ty, true_param_tys, true_args, 1),
+                 result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, body, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, body);
+  LLVMBuildStore(ir, filterx_compound_expr_compile_ext(self->body, jit, target), result_slot);
+  LLVMBuildBr(ir, finish);
+
+  filterx_jit_ir_add_sequence_to_block(jit, finish, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, finish);
+  return LLVMBuildLoad2(ir, ffi->ptr_ty, result_slot, "result");
+}
+
+#endif
+
 static gboolean
 _init(FilterXExpr *s, GlobalConfig *cfg)
 {
@@ -444,6 +534,9 @@ filterx_switch_new(FilterXExpr *selector, GList *body)
   self->super.init = _init;
   self->super.optimize = _optimize;
   self->super.eval = _eval_switch;
+#if SYSLOG_NG_ENABLE_JIT
+  self->super.compile = _compile_switch;
+#endif
   self->super.walk_children = _switch_walk;
   self->super.free_fn = _free;
   self->cases = g_ptr_array_new_with_free_func((GDestroyNotify) filterx_expr_unref);
@@ -33,6 +33,7 @@ filterx_config_free(ModuleConfig *s)
   FilterXConfig *self = (FilterXConfig *) s;
 
   filterx_env_clear(&self->global_env);
+  g_free(self->jit_cache_dir);
   module_config_free_method(s);
 }
 
@@ -58,7 +59,7 @@ filterx_config_post_cfg_init(ModuleConfig *s, GlobalConfig *cfg)
 }
 
 static inline FilterXJIT *
-_create_jit(FilterXJITDebugInfo debug_info)
+_create_jit(FilterXJITDebugInfo debug_info, const gchar *cache_dir)
 {
 #if SYSLOG_NG_ENABLE_JIT
   GError *error = NULL;
@@ -71,6 +72,7 @@ _create_jit(FilterXJITDebugInfo debug_info)
       return NULL;
     }
 
+  filterx_jit_set_object_cache_dir(jit, cache_dir);
   return jit;
 #else
   return NULL;
@@ -94,7 +96,7 @@ filterx_config_init(ModuleConfig *s, GlobalConfig *cfg)
     self->enable_jit = FALSE;
 
   if (self->enable_jit)
-    self->jit = _create_jit(self->jit_debug_info);
+    self->jit = _create_jit(self->jit_debug_info, self->jit_cache_dir);
 
   return TRUE;
 }
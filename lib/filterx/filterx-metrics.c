@@ -233,12 +233,8 @@ filterx_metrics_free(FilterXMetrics *self)
   if (self->labels)
     filterx_metrics_labels_free(self->labels);
 
-  stats_lock();
-  {
-    StatsCounterItem *counter = stats_cluster_single_get_counter(self->const_cluster);
-    stats_unregister_dynamic_counter(self->const_cluster, SC_TYPE_SINGLE_VALUE, &counter);
-  }
-  stats_unlock();
+  StatsCounterItem *counter = stats_cluster_single_get_counter(self->const_cluster);
+  stats_unregister_dynamic_counter(self->const_cluster, SC_TYPE_SINGLE_VALUE, &counter);
 
   g_free(self);
 }
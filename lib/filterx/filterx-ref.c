@@ -446,9 +446,22 @@ _filterx_ref_replace_shared_xref_with_a_floating_one(FilterXObject *s, FilterXOb
   FilterXRef *self = (FilterXRef *) s;
   FilterXRef *container = (FilterXRef *) c;
 
-  if (filterx_weakref_is_set_to(&self->parent_container, &container->super) &&
-      g_atomic_counter_get(_get_fx_ref_cnt(container)) <= 1)
-    return s;
+  if (g_atomic_counter_get(_get_fx_ref_cnt(container)) <= 1)
+    {
+      if (filterx_weakref_is_set_to(&self->parent_container, &container->super))
+        return s;
+
+      /* Lazy dicts (parsed from JSON) materialize their members on demand,
+       * without knowing the xref they are accessed through, and mark them
+       * as orphans.  Such orphans are adopted on their first lookup.  Any
+       * other xref without a parent is left alone. */
+      if ((s->flags & FILTERX_REF_FLAG_ORPHAN) && !filterx_weakref_is_set(&self->parent_container) &&
+          !s->floating_ref && !filterx_object_is_preserved(c))
+        {
+          filterx_ref_set_parent_container(s, c);
+          return s;
+        }
+    }
 
   FilterXObject *result = filterx_ref_float(_filterx_ref_new(filterx_object_ref(self->value)));
   filterx_object_unref(&self->super);
@@ -50,6 +50,14 @@ struct _FilterXRef
   FilterXWeakRef parent_container;
 };
 
+/* FilterXObject.flags of FilterXRef instances */
+enum
+{
+  /* stored by a container that does not know the xref it is accessed
+   * through (lazy dicts), the parent container is set on the first lookup */
+  FILTERX_REF_FLAG_ORPHAN = 0x01,
+};
+
 gboolean _filterx_ref_cow_recurse(FilterXObject *s, gpointer user_data);
 
 static inline void
@@ -108,6 +116,7 @@ filterx_ref_set_parent_container(FilterXObject *s, FilterXObject *parent)
 
       g_assert(!parent || filterx_object_is_ref(parent));
       filterx_weakref_set(&self->parent_container, parent);
+      s->flags &= ~FILTERX_REF_FLAG_ORPHAN;
     }
 }
 
@@ -119,9 +128,17 @@ filterx_ref_unset_parent_container(FilterXObject *s)
       FilterXRef *self = (FilterXRef *) s;
 
       filterx_weakref_set(&self->parent_container, NULL);
+      s->flags &= ~FILTERX_REF_FLAG_ORPHAN;
     }
 }
 
+static inline void
+filterx_ref_set_orphan(FilterXObject *s)
+{
+  if (filterx_object_is_ref(s))
+    s->flags |= FILTERX_REF_FLAG_ORPHAN;
+}
+
 static inline FilterXObject *
 filterx_ref_float_unchecked(FilterXObject *s)
 {
@@ -80,6 +80,28 @@ _modify_symbols(LLVMContextRef ctx, LLVMModuleRef mod)
     _mark_symbol_available_externally(g);
 }
 
+/* identifies the embedded bitcode in object cache keys */
+const gchar *
+filterx_jit_get_libfilterx_bitcode_digest(void)
+{
+  static gsize initialized = 0;
+  static gchar *digest;
+
+  if (g_once_init_enter(&initialized))
+    {
+      if (_binary_lib_filterx_jit_libfilterx_bc_start && _binary_lib_filterx_jit_libfilterx_bc_end)
+        {
+          const gchar *bc_start = _binary_lib_filterx_jit_libfilterx_bc_start;
+          const gchar *bc_end = _binary_lib_filterx_jit_libfilterx_bc_end;
+          gsize bc_size = (gsize) (bc_end - bc_start);
+          digest = g_compute_checksum_for_data(G_CHECKSUM_SHA256, (const guchar *) bc_start, bc_size);
+        }
+      g_once_init_leave(&initialized, 1);
+    }
+
+  return digest;
+}
+
 LLVMModuleRef
 filterx_jit_load_libfilterx_bitcode(LLVMContextRef ctx, GError **error)
 {
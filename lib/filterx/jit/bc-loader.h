@@ -31,6 +31,7 @@
 #include <llvm-c/Types.h>
 
 LLVMModuleRef filterx_jit_load_libfilterx_bitcode(LLVMContextRef ctx, GError **error);
+const gchar *filterx_jit_get_libfilterx_bitcode_digest(void);
 
 #endif
 
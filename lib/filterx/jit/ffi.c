@@ -50,6 +50,7 @@ _declare_func(LLVMModuleRef mod, const gchar *name, LLVMTypeRef ret_ty,
   return c;
 }
 
+/* declares the FFI functions into the module of the block being generated */
 void
 filterx_jit_ffi_init(FilterXJIT *jit)
 {
@@ -93,6 +94,12 @@ _emit_call(FilterXJIT *jit, FilterXJITFFICall c, FilterXIRValue *args, unsigned
 FilterXIRValue
 fx_jit_emit_const_ptr(FilterXJIT *jit, gconstpointer p)
 {
+  if (!p)
+    return LLVMConstNull(jit->ffi.ptr_ty);
+
+  if (jit->cache_dir)
+    return filterx_jit_ir_load_const_ptr(jit, p);
+
   LLVMTypeRef ptr_sized_int = LLVMIntTypeInContext(jit->ctx, sizeof(gconstpointer) * 8);
   return LLVMConstIntToPtr(LLVMConstInt(ptr_sized_int, (guintptr) p, FALSE), jit->ffi.ptr_ty);
 }
@@ -152,6 +159,38 @@ fx_jit_emit_expr_propagate_to_error_if_null(FilterXJIT *jit, FilterXExpr *expr,
   return result;
 }
 
+static void
+_emit_goto_if(FilterXJIT *jit, FilterXIRValue condition, FilterXIRSequence target)
+{
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+  FilterXIRValue block = filterx_jit_ir_get_current_block(jit);
+
+  FilterXIRSequence continue_seq = filterx_jit_ir_create_sequence(jit, "continue", block);
+  LLVMBuildCondBr(ir, condition, target, continue_seq);
+
+  filterx_jit_ir_add_sequence_to_block(jit, continue_seq, block);
+  filterx_jit_ir_set_insert_point_to_sequence_tail(jit, continue_seq);
+}
+
+/* if (!obj) goto target; */
+void
+fx_jit_emit_goto_if_null(FilterXJIT *jit, FilterXIRValue obj, FilterXIRSequence target)
+{
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+
+  _emit_goto_if(jit, LLVMBuildIsNull(ir, obj, "is_null"), target);
+}
+
+/* if (!value) goto target; where value is a gboolean */
+void
+fx_jit_emit_goto_if_false(FilterXJIT *jit, FilterXIRValue value, FilterXIRSequence target)
+{
+  FilterXIRBuilder ir = filterx_jit_get_ir_builder(jit);
+
+  _emit_goto_if(jit, LLVMBuildICmp(ir, LLVMIntEQ, value, LLVMConstInt(jit->ffi.i32_ty, 0, FALSE), "is_false"),
+                target);
+}
+
 FilterXIRValue
 fx_jit_emit_object_ref(FilterXJIT *jit, LLVMValueRef obj)
 {
@@ -70,6 +70,9 @@ FilterXIRValue fx_jit_emit_expr_eval_typed(FilterXJIT *jit, FilterXExpr *expr);
 FilterXIRValue fx_jit_emit_expr_make_typed_object(FilterXJIT *jit, FilterXExpr *expr, FilterXIRValue obj);
 FilterXIRValue fx_jit_emit_expr_propagate_to_error_if_null(FilterXJIT *jit, FilterXExpr *expr, FilterXIRValue result);
 
+void fx_jit_emit_goto_if_null(FilterXJIT *jit, FilterXIRValue obj, FilterXIRSequence target);
+void fx_jit_emit_goto_if_false(FilterXJIT *jit, FilterXIRValue value, FilterXIRSequence target);
+
 FilterXIRValue fx_jit_emit_object_ref(FilterXJIT *jit, FilterXIRValue obj);
 void fx_jit_emit_object_unref(FilterXJIT *jit, FilterXIRValue obj);
 FilterXIRValue fx_jit_emit_object_cow_fork2(FilterXJIT *jit, FilterXIRValue obj);
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "filterx/jit/jit-cache.h"
+#include "filterx/jit/bc-loader.h"
+#include "messages.h"
+
+#if SYSLOG_NG_ENABLE_JIT
+
+#include <llvm-c/BitWriter.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm/Config/llvm-config.h>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+
+static void
+_checksum_update_str(GChecksum *checksum, const gchar *str)
+{
+  /* the terminating NUL separates the fields, NULL and "" hash differently */
+  if (!str)
+    {
+      g_checksum_update(checksum, (const guchar *) "\xff", 1);
+      return;
+    }
+
+  g_checksum_update(checksum, (const guchar *) str, strlen(str) + 1);
+}
+
+gchar *
+filterx_jit_cache_compute_key(LLVMModuleRef mod)
+{
+  GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+  _checksum_update_str(checksum, LLVM_VERSION_STRING);
+  _checksum_update_str(checksum, LLVMGetTarget(mod));
+
+  gchar *cpu = LLVMGetHostCPUName();
+  gchar *features = LLVMGetHostCPUFeatures();
+  _checksum_update_str(checksum, cpu);
+  _checksum_update_str(checksum, features);
+  LLVMDisposeMessage(cpu);
+  LLVMDisposeMessage(features);
+
+  _checksum_update_str(checksum, g_getenv("SYSLOG_NG_FILTERX_JIT_PASSES"));
+  _checksum_update_str(checksum, g_getenv("SYSLOG_NG_FILTERX_JIT_LLVM_ARGS"));
+  _checksum_update_str(checksum, filterx_jit_get_libfilterx_bitcode_digest());
+
+  LLVMMemoryBufferRef bc = LLVMWriteBitcodeToMemoryBuffer(mod);
+  g_checksum_update(checksum, (const guchar *) LLVMGetBufferStart(bc), LLVMGetBufferSize(bc));
+  LLVMDisposeMemoryBuffer(bc);
+
+  gchar *key = g_strdup(g_checksum_get_string(checksum));
+  g_checksum_free(checksum);
+  return key;
+}
+
+/*
+ * A cached object file starts with a header.  The object is used only if
+ * its size and SHA-256 digest match the header, so a truncated or corrupted
+ * file is recompiled instead of being handed to the JIT linker.
+ */
+#define FILTERX_JIT_CACHE_MAGIC "FXJITOB1"
+
+typedef struct _FilterXJITCacheHeader
+{
+  gchar magic[8];
+  guint64 size;
+  guint8 digest[32];
+} FilterXJITCacheHeader;
+
+static void
+_compute_digest(const gchar *data, gsize size, guint8 *digest)
+{
+  GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+  gsize digest_len = 32;
+
+  g_checksum_update(checksum, (const guchar *) data, size);
+  g_checksum_get_digest(checksum, digest, &digest_len);
+  g_checksum_free(checksum);
+}
+
+static void
+_header_init(FilterXJITCacheHeader *header, const gchar *data, gsize size)
+{
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, FILTERX_JIT_CACHE_MAGIC, sizeof(header->magic));
+  header->size = size;
+  _compute_digest(data, size, header->digest);
+}
+
+static gboolean
+_is_valid_object(const gchar *contents, gsize length)
+{
+  FilterXJITCacheHeader header;
+  guint8 digest[32];
+
+  if (length < sizeof(header))
+    return FALSE;
+
+  memcpy(&header, contents, sizeof(header));
+  if (memcmp(header.magic, FILTERX_JIT_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.size != length - sizeof(header))
+    return FALSE;
+
+  _compute_digest(contents + sizeof(header), header.size, digest);
+  return memcmp(header.digest, digest, sizeof(digest)) == 0;
+}
+
+/*
+ * Object files are loaded into the process as code, so the cache is only
+ * used if the directory and the files are owned by us and nobody else can
+ * write them.
+ */
+static gboolean
+_is_owned_and_not_writable_by_others(const gchar *path, const struct stat *st)
+{
+  if (st->st_uid == geteuid() && (st->st_mode & (S_IWGRP | S_IWOTH)) == 0)
+    return TRUE;
+
+  msg_warning("FilterX JIT: refusing to use object cache, it must be owned by the current user "
+              "and must not be writable by group or others",
+              evt_tag_str("filename", path),
+              evt_tag_int("uid", st->st_uid),
+              evt_tag_printf("mode", "%04o", (guint) (st->st_mode & 07777)));
+  return FALSE;
+}
+
+static gboolean
+_is_trusted_cache_dir(const gchar *cache_dir)
+{
+  struct stat st;
+
+  if (stat(cache_dir, &st) < 0)
+    {
+      if (errno != ENOENT)
+        msg_warning("FilterX JIT: error accessing object cache directory",
+                    evt_tag_str("dir", cache_dir),
+                    evt_tag_error(EVT_TAG_OSERROR));
+      return FALSE;
+    }
+
+  if (!S_ISDIR(st.st_mode))
+    {
+      msg_warning("FilterX JIT: object cache is not a directory", evt_tag_str("dir", cache_dir));
+      return FALSE;
+    }
+
+  return _is_owned_and_not_writable_by_others(cache_dir, &st);
+}
+
+static inline gchar *
+_object_file_path(const gchar *cache_dir, const gchar *key)
+{
+  gchar *filename = g_strconcat(key, ".o", NULL);
+  gchar *path = g_build_filename(cache_dir, filename, NULL);
+  g_free(filename);
+  return path;
+}
+
+static gboolean
+_read_all(gint fd, gchar *buffer, gsize length)
+{
+  gsize pos = 0;
+
+  while (pos < length)
+    {
+      gssize rc = read(fd, buffer + pos, length - pos);
+      if (rc < 0 && errno == EINTR)
+        continue;
+      if (rc <= 0)
+        return FALSE;
+      pos += rc;
+    }
+  return TRUE;
+}
+
+static gboolean
+_write_all(gint fd, const gchar *buffer, gsize length)
+{
+  gsize pos = 0;
+
+  while (pos < length)
+    {
+      gssize rc = write(fd, buffer + pos, length - pos);
+      if (rc < 0 && errno == EINTR)
+        continue;
+      if (rc < 0)
+        return FALSE;
+      pos += rc;
+    }
+  return TRUE;
+}
+
+LLVMMemoryBufferRef
+filterx_jit_cache_load(const gchar *cache_dir, const gchar *key)
+{
+  LLVMMemoryBufferRef obj = NULL;
+  gchar *contents = NULL;
+  struct stat st;
+
+  if (!_is_trusted_cache_dir(cache_dir))
+    return NULL;
+
+  gchar *path = _object_file_path(cache_dir, key);
+  gint fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd < 0)
+    {
+      if (errno != ENOENT)
+        msg_warning("FilterX JIT: error opening cached object file",
+                    evt_tag_str("filename", path),
+                    evt_tag_error(EVT_TAG_OSERROR));
+      goto exit;
+    }
+
+  if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || !_is_owned_and_not_writable_by_others(path, &st))
+    goto exit;
+
+  contents = g_malloc(st.st_size);
+  if (!_read_all(fd, contents, st.st_size))
+    {
+      msg_warning("FilterX JIT: error reading cached object file",
+                  evt_tag_str("filename", path),
+                  evt_tag_error(EVT_TAG_OSERROR));
+      goto exit;
+    }
+
+  if (!_is_valid_object(contents, st.st_size))
+    {
+      msg_warning("FilterX JIT: cached object file is corrupt, recompiling",
+                  evt_tag_str("filename", path));
+      unlink(path);
+      goto exit;
+    }
+
+  /* eviction drops the least recently used objects first */
+  futimens(fd, NULL);
+
+  obj = LLVMCreateMemoryBufferWithMemoryRangeCopy(contents + sizeof(FilterXJITCacheHeader),
+                                                  st.st_size - sizeof(FilterXJITCacheHeader), path);
+
+exit:
+  if (fd >= 0)
+    close(fd);
+  g_free(contents);
+  g_free(path);
+  return obj;
+}
+
+typedef struct _FilterXJITCachedObject
+{
+  gchar *path;
+  time_t mtime;
+  goffset size;
+} FilterXJITCachedObject;
+
+static gint
+_cached_object_compare_most_recent_first(gconstpointer a, gconstpointer b)
+{
+  const FilterXJITCachedObject *o1 = a;
+  const FilterXJITCachedObject *o2 = b;
+
+  return (o1->mtime < o2->mtime) - (o1->mtime > o2->mtime);
+}
+
+static void
+_remove_cached_object(const gchar *path)
+{
+  if (unlink(path) < 0 && errno != ENOENT)
+    msg_warning("FilterX JIT: error removing cached object file",
+                evt_tag_str("filename", path),
+                evt_tag_error(EVT_TAG_OSERROR));
+  else
+    msg_debug("FilterX JIT: cached object file evicted", evt_tag_str("filename", path));
+}
+
+/*
+ * Objects not used for FILTERX_JIT_CACHE_MAX_AGE seconds are removed, and
+ * the least recently used ones are removed until the cache fits into
+ * FILTERX_JIT_CACHE_MAX_SIZE bytes.  The most recently used object is
+ * always kept.
+ */
+void
+filterx_jit_cache_evict(const gchar *cache_dir)
+{
+  GDir *dir = g_dir_open(cache_dir, 0, NULL);
+  if (!dir)
+    return;
+
+  GArray *objects = g_array_new(FALSE, FALSE, sizeof(FilterXJITCachedObject));
+  time_t now = time(NULL);
+  const gchar *name;
+
+  while ((name = g_dir_read_name(dir)))
+    {
+      struct stat st;
+
+      if (!g_str_has_suffix(name, ".o"))
+        continue;
+
+      gchar *path = g_build_filename(cache_dir, name, NULL);
+      if (lstat(path, &st) < 0 || !S_ISREG(st.st_mode))
+        {
+          g_free(path);
+          continue;
+        }
+
+      if (now - st.st_mtime > FILTERX_JIT_CACHE_MAX_AGE)
+        {
+          _remove_cached_object(path);
+          g_free(path);
+          continue;
+        }
+
+      FilterXJITCachedObject object = { .path = path, .mtime = st.st_mtime, .size = st.st_size };
+      g_array_append_val(objects, object);
+    }
+  g_dir_close(dir);
+
+  g_array_sort(objects, _cached_object_compare_most_recent_first);
+
+  goffset total_size = 0;
+  for (guint i = 0; i < objects->len; i++)
+    {
+      FilterXJITCachedObject *object = &g_array_index(objects, FilterXJITCachedObject, i);
+
+      total_size += object->size;
+      if (i > 0 && total_size > FILTERX_JIT_CACHE_MAX_SIZE)
+        _remove_cached_object(object->path);
+      g_free(object->path);
+    }
+  g_array_free(objects, TRUE);
+}
+
+void
+filterx_jit_cache_store(const gchar *cache_dir, const gchar *key, LLVMMemoryBufferRef obj)
+{
+  if (g_mkdir_with_parents(cache_dir, 0700) < 0)
+    {
+      msg_warning("FilterX JIT: error creating object cache directory",
+                  evt_tag_str("dir", cache_dir),
+                  evt_tag_error(EVT_TAG_OSERROR));
+      return;
+    }
+
+  if (!_is_trusted_cache_dir(cache_dir))
+    return;
+
+  gchar *path = _object_file_path(cache_dir, key);
+  gchar *tmp_path = g_strconcat(path, ".XXXXXX", NULL);
+  const gchar *data = LLVMGetBufferStart(obj);
+  gsize size = LLVMGetBufferSize(obj);
+  FilterXJITCacheHeader header;
+
+  _header_init(&header, data, size);
+
+  /* written to a temporary file and renamed, readers never see partial objects */
+  gint fd = g_mkstemp_full(tmp_path, O_WRONLY | O_CLOEXEC, 0600);
+  if (fd < 0)
+    {
+      msg_warning("FilterX JIT: error creating cached object file",
+                  evt_tag_str("filename", tmp_path),
+                  evt_tag_error(EVT_TAG_OSERROR));
+      goto exit;
+    }
+
+  gboolean success = _write_all(fd, (const gchar *) &header, sizeof(header)) && _write_all(fd, data, size);
+  if (close(fd) < 0)
+    success = FALSE;
+
+  if (!success || rename(tmp_path, path) < 0)
+    {
+      msg_warning("FilterX JIT: error writing cached object file",
+                  evt_tag_str("filename", path),
+                  evt_tag_error(EVT_TAG_OSERROR));
+      unlink(tmp_path);
+      goto exit;
+    }
+
+  msg_debug("FilterX JIT: object file stored in cache", evt_tag_str("filename", path));
+  filterx_jit_cache_evict(cache_dir);
+
+exit:
+  g_free(tmp_path);
+  g_free(path);
+}
+
+#endif
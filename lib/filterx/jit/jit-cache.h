@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef FILTERX_JIT_CACHE_H
+#define FILTERX_JIT_CACHE_H
+
+#include "filterx/jit/jit.h"
+
+#if SYSLOG_NG_ENABLE_JIT
+
+#include <llvm-c/Core.h>
+#include <llvm-c/Types.h>
+
+/*
+ * Content-addressed cache of JIT-compiled object files.
+ *
+ * The key covers everything that influences code generation: the LLVM
+ * version, the target triple and host CPU, the optimization settings, the
+ * embedded libfilterx bitcode and the bitcode of the module itself.
+ *
+ * The cache directory is set by the filterx-jit-cache-dir() global option.
+ * It is ignored unless both the directory and the object files are owned
+ * by the effective user and are not writable by group or others.  Objects
+ * are evicted by age and by the total size of the directory.
+ */
+#define FILTERX_JIT_CACHE_MAX_SIZE (64 * 1024 * 1024)
+#define FILTERX_JIT_CACHE_MAX_AGE (30 * 24 * 60 * 60)
+
+gchar *filterx_jit_cache_compute_key(LLVMModuleRef mod);
+LLVMMemoryBufferRef filterx_jit_cache_load(const gchar *cache_dir, const gchar *key);
+void filterx_jit_cache_store(const gchar *cache_dir, const gchar *key, LLVMMemoryBufferRef obj);
+void filterx_jit_cache_evict(const gchar *cache_dir);
+
+#endif
+
+#endif
@@ -28,6 +28,7 @@
 #if SYSLOG_NG_ENABLE_JIT
 
 #include "filterx/jit/ffi.h"
+#include "stats/stats-counter.h"
 
 #include <llvm-c/Core.h>
 #include <llvm-c/Types.h>
@@ -35,18 +36,53 @@
 #include <llvm-c/TargetMachine.h>
 #include <llvm-c/DebugInfo.h>
 
+typedef struct _FilterXJITMetrics
+{
+  StatsCounterItem *cache_hits;
+  StatsCounterItem *cache_misses;
+} FilterXJITMetrics;
+
+/*
+ * Every block is generated into a module of its own, so blocks are
+ * compiled, cached and timed independently: changing one block of a
+ * configuration does not invalidate the compiled code of the others.
+ */
+typedef struct _FilterXJITBlock
+{
+  gchar *name;
+  gchar *fqn;
+  LLVMModuleRef mod;
+  LLVMDIBuilderRef debug;
+
+  /* object cache, see filterx_jit_set_object_cache_dir() */
+  gchar *cache_key;
+  GPtrArray *consts;
+  GHashTable *const_indices;
+  LLVMValueRef consts_table;
+
+  gint64 compile_start;
+  /* shared by the instances of the module, see _get_compile_time_counter() */
+  StatsCounterItem *compile_time;
+} FilterXJITBlock;
+
 struct _FilterXJIT
 {
   gchar *mod_name;
 
   LLVMOrcThreadSafeContextRef ts_ctx;
   LLVMContextRef ctx;
-  LLVMModuleRef mod;
   LLVMModuleRef libfilterx;
   LLVMBuilderRef ir;
   LLVMOrcLLJITRef j;
   LLVMTargetMachineRef tm;
 
+  GPtrArray *blocks;
+  FilterXJITBlock *compiling_block;
+
+  /* the block being generated and its module */
+  FilterXJITBlock *current_block;
+  LLVMModuleRef mod;
+
   FilterXIRValue current_ir_block;
   LLVMMetadataRef current_debug_info_block;
   FilterXIRValue current_eval_context;
@@ -57,12 +93,19 @@ struct _FilterXJIT
   FilterXJITFFI ffi;
 
   FilterXJITDebugInfo debug_info_mode;
-  LLVMDIBuilderRef debug;
   gint debug_ir_text_memfd;
 
   gboolean mod_finalized;
+
+  /* object cache, see filterx_jit_set_object_cache_dir() */
+  gchar *cache_dir;
+
+  /* shared by the instances of the module, see _get_metrics() */
+  FilterXJITMetrics *metrics;
 };
 
+FilterXIRValue filterx_jit_ir_load_const_ptr(FilterXJIT *self, gconstpointer p);
+
 #else
 
 struct _FilterXJIT
@@ -25,6 +25,9 @@
 #include "filterx/filterx-eval.h"
 #include "filterx/object-primitive.h"
 #include "filterx/object-extractor.h"
+#include "filterx/object-string.h"
+#include "filterx/object-dict.h"
+#include "filterx/object-list.h"
 
 #if SYSLOG_NG_ENABLE_JIT
 
@@ -106,4 +109,141 @@ fx_jit_boolean_new(gboolean value)
   return filterx_boolean_new(value);
 }
 
+__attribute__((used))
+gboolean
+fx_jit_expr_is_set(FilterXExpr *self)
+{
+  return filterx_expr_is_set(self);
+}
+
+/*
+ * Container access
+ *
+ * These are inlined into the compiled blocks, so the type dispatch of the
+ * generic ones is resolved there.  The literal key variants look the key up
+ * directly in dicts (string keys) and lists (integer keys).  Values that
+ * are xrefs themselves are left to filterx_object_get_subscript(), which
+ * returns them as floating xrefs.
+ */
+
+__attribute__((used))
+FilterXObject *
+fx_jit_object_get_subscript(FilterXObject *self, FilterXObject *key)
+{
+  return filterx_object_get_subscript(self, key);
+}
+
+__attribute__((used))
+gboolean
+fx_jit_object_set_subscript(FilterXObject *self, FilterXObject *key, FilterXObject **new_value)
+{
+  return filterx_object_set_subscript(self, key, new_value);
+}
+
+__attribute__((used))
+gboolean
+fx_jit_object_is_key_set(FilterXObject *self, FilterXObject *key)
+{
+  return filterx_object_is_key_set(self, key);
+}
+
+__attribute__((used))
+FilterXObject *
+fx_jit_object_is_member_of(FilterXObject *self, FilterXObject *member)
+{
+  return filterx_object_is_member_of(self, member);
+}
+
+static inline FilterXObject *
+_peek_dict_member(FilterXObject *self, FilterXObject *key)
+{
+  FilterXObject *container = filterx_ref_unwrap_ro(self);
+
+  if (container->type != &FILTERX_TYPE_NAME(dict))
+    return NULL;
+  return filterx_dict_peek_subscript(container, key);
+}
+
+static inline FilterXObject *
+_peek_list_element(FilterXObject *self, gint64 index)
+{
+  FilterXObject *container = filterx_ref_unwrap_ro(self);
+
+  if (container->type != &FILTERX_TYPE_NAME(list))
+    return NULL;
+
+  gint64 len = ((FilterXListObject *) container)->array->len;
+  if (index < 0)
+    index += len;
+  if (index < 0 || index >= len)
+    return NULL;
+  return filterx_list_peek_subscript(container, index);
+}
+
+/* NOTE: key is a string literal */
+__attribute__((used))
+FilterXObject *
+fx_jit_get_subscript_string_key(FilterXObject *self, FilterXObject *key)
+{
+  FilterXObject *value = _peek_dict_member(self, key);
+  if (value && !filterx_object_is_ref(value))
+    return filterx_object_ref(value);
+
+  return filterx_object_get_subscript(self, key);
+}
+
+/* NOTE: key is an integer literal, its value is index */
+__attribute__((used))
+FilterXObject *
+fx_jit_get_subscript_integer_key(FilterXObject *self, FilterXObject *key, gint64 index)
+{
+  FilterXObject *value = _peek_list_element(self, index);
+  if (value && !filterx_object_is_ref(value))
+    return filterx_object_ref(value);
+
+  return filterx_object_get_subscript(self, key);
+}
+
+__attribute__((used))
+gboolean
+fx_jit_is_key_set_string_key(FilterXObject *self, FilterXObject *key)
+{
+  return _peek_dict_member(self, key) || filterx_object_is_key_set(self, key);
+}
+
+/*
+ * NOTE: container is a literal list of strings.  "in" compares with
+ * FCMPX_TYPE_AND_VALUE_BASED, so only members of the string type can match.
+ */
+__attribute__((used))
+FilterXObject *
+fx_jit_is_member_of_string_list(FilterXObject *container, FilterXObject *member)
+{
+  FilterXObject *value = filterx_ref_unwrap_ro(member);
+  if (value->type != &FILTERX_TYPE_NAME(string))
+    return filterx_object_is_member_of(container, member);
+
+  gsize len;
+  const gchar *str = filterx_string_get_value_ref(value, &len);
+
+  FilterXObject *list = filterx_ref_unwrap_ro(container);
+  guint elements_len = ((FilterXListObject *) list)->array->len;
+  for (guint i = 0; i < elements_len; i++)
+    {
+      gsize element_len;
+      const gchar *element_str = filterx_string_get_value_ref(filterx_list_peek_subscript(list, i), &element_len);
+
+      if (element_len == len && memcmp(element_str, str, len) == 0)
+        return filterx_boolean_new(TRUE);
+    }
+  return filterx_boolean_new(FALSE);
+}
+
+__attribute__((used))
+gboolean
+fx_jit_is_key_set_integer_key(FilterXObject *self, FilterXObject *key, gint64 index)
+{
+  return _peek_list_element(self, index) || filterx_object_is_key_set(self, key);
+}
+
 #endif
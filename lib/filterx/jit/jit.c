@@ -23,8 +23,12 @@
 #include "filterx/jit/jit.h"
 #include "filterx/jit/jit-private.h"
 #include "filterx/jit/bc-loader.h"
+#include "filterx/jit/jit-cache.h"
 #include "filterx/jit/ffi.h"
 #include "filterx/filterx-scope-var-layout.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+#include "metrics/metric-names.h"
 #include "messages.h"
 
 #if SYSLOG_NG_ENABLE_JIT
@@ -72,10 +76,10 @@ _assert_verify_block(FilterXJIT *self, FilterXIRValue block)
 }
 
 static inline gboolean
-_verify_module(FilterXJIT *self, GError **error)
+_verify_module(FilterXJIT *self, FilterXJITBlock *block, GError **error)
 {
   gchar *error_msg = NULL;
-  gboolean module_broken = LLVMVerifyModule(self->mod, LLVMReturnStatusAction, &error_msg);
+  gboolean module_broken = LLVMVerifyModule(block->mod, LLVMReturnStatusAction, &error_msg);
   if (module_broken)
     {
       _fxjit_error(error_msg, error);
@@ -88,13 +92,38 @@ _verify_module(FilterXJIT *self, GError **error)
   return TRUE;
 }
 
+static FilterXJITBlock *
+_lookup_block_by_module(FilterXJIT *self, LLVMModuleRef mod)
+{
+  gsize mod_id_len;
+  const gchar *mod_id = LLVMGetModuleIdentifier(mod, &mod_id_len);
+
+  for (guint i = 0; i < self->blocks->len; i++)
+    {
+      FilterXJITBlock *block = g_ptr_array_index(self->blocks, i);
+      if (strlen(block->fqn) == mod_id_len && memcmp(block->fqn, mod_id, mod_id_len) == 0)
+        return block;
+    }
+  return NULL;
+}
+
+/*
+ * Modules are compiled one at a time, on the thread looking up their
+ * block, so the optimization of a module is always followed by its
+ * codegen and by _object_transform().
+ */
 static LLVMErrorRef
 _optimize_module(gpointer s, LLVMModuleRef mod)
 {
   LLVMPassBuilderOptionsRef options = LLVMCreatePassBuilderOptions();
 
   FilterXJIT *self = (FilterXJIT *) s;
-  msg_trace("FilterXJIT optimize module", evt_tag_str("module_name", self->mod_name));
+  self->compiling_block = _lookup_block_by_module(self, mod);
+  msg_trace("FilterXJIT optimize module",
+            evt_tag_str("module_name", self->mod_name),
+            evt_tag_str("block", self->compiling_block ? self->compiling_block->name : "unknown"));
+  if (self->compiling_block)
+    self->compiling_block->compile_start = g_get_monotonic_time();
 
   const gchar *pass_override = g_getenv("SYSLOG_NG_FILTERX_JIT_PASSES");
   LLVMErrorRef err = LLVMRunPasses(mod, pass_override ? : "default<O3>", self->tm, options);
@@ -109,6 +138,30 @@ _optimize_transform(gpointer s, LLVMOrcThreadSafeModuleRef *thr_mod, LLVMOrcMate
   return LLVMOrcThreadSafeModuleWithModuleDo(*thr_mod, _optimize_module, s);
 }
 
+/* sees the relocatable object right after codegen, before it is linked into memory */
+static LLVMErrorRef
+_object_transform(gpointer s, LLVMMemoryBufferRef *obj)
+{
+  FilterXJIT *self = (FilterXJIT *) s;
+  FilterXJITBlock *block = self->compiling_block;
+  self->compiling_block = NULL;
+
+  if (!block)
+    return NULL;
+
+  gint64 compile_time_ms = (g_get_monotonic_time() - block->compile_start) / 1000;
+  stats_counter_set(block->compile_time, compile_time_ms);
+  msg_debug("FilterXJIT block compiled",
+            evt_tag_str("module_name", self->mod_name),
+            evt_tag_str("block", block->name),
+            evt_tag_long("compile_time_ms", compile_time_ms));
+
+  if (block->cache_key)
+    filterx_jit_cache_store(self->cache_dir, block->cache_key, *obj);
+
+  return NULL;
+}
+
 FilterXIRBuilder
 filterx_jit_get_ir_builder(FilterXJIT *self)
 {
@@ -119,10 +172,11 @@ filterx_jit_get_ir_builder(FilterXJIT *self)
 static inline LLVMMetadataRef
 _create_debug_info_block(FilterXJIT *self, const gchar *block_name, const gchar *file, gint line)
 {
-  LLVMMetadataRef di_file = LLVMDIBuilderCreateFile(self->debug, file, strlen(file), "", 0);
-  LLVMMetadataRef subroutine_ty = LLVMDIBuilderCreateSubroutineType(self->debug, di_file, NULL, 0, LLVMDIFlagZero);
+  LLVMDIBuilderRef debug = self->current_block->debug;
+  LLVMMetadataRef di_file = LLVMDIBuilderCreateFile(debug, file, strlen(file), "", 0);
+  LLVMMetadataRef subroutine_ty = LLVMDIBuilderCreateSubroutineType(debug, di_file, NULL, 0, LLVMDIFlagZero);
 
-  return LLVMDIBuilderCreateFunction(self->debug, di_file, block_name, strlen(block_name),
+  return LLVMDIBuilderCreateFunction(debug, di_file, block_name, strlen(block_name),
                                      block_name, strlen(block_name), di_file, line, subroutine_ty, FALSE, TRUE, line,
                                      LLVMDIFlagZero, FALSE);
 }
@@ -153,11 +207,11 @@ _create_fully_qualified_block_name(FilterXJIT *self, const gchar *block_name)
 }
 
 static inline LLVMTypeRef
-_block_function_type(FilterXJIT *self)
+_block_function_type(FilterXJIT *self, LLVMTypeRef return_ty)
 {
   LLVMTypeRef ptr_ty = LLVMPointerTypeInContext(self->ctx, 0);
   LLVMTypeRef params[] = { ptr_ty };
-  return LLVMFunctionType(ptr_ty, params, G_N_ELEMENTS(params), FALSE);
+  return LLVMFunctionType(return_ty, params, G_N_ELEMENTS(params), FALSE);
 }
 
 static inline void
@@ -204,7 +258,8 @@ _inherit_libfilterx_function_attributes(FilterXJIT *self, FilterXIRValue dest)
     _copy_attrs_at_index(tmpl, dest, paramidx);
 }
 
-static const guint8 _fx_jit_var_uninitialized;
+/* referenced by name, the generated code does not depend on where we are loaded */
+const guint8 fx_jit_var_uninitialized;
 
 static inline LLVMTypeRef
 _variable_storage_type(FilterXJIT *self)
@@ -215,7 +270,15 @@ _variable_storage_type(FilterXJIT *self)
 static FilterXIRValue
 _variable_uninitialized_sentinel(FilterXJIT *self)
 {
-  return fx_jit_emit_const_ptr(self, &_fx_jit_var_uninitialized);
+  const gchar *name = "fx_jit_var_uninitialized";
+  LLVMValueRef sentinel = LLVMGetNamedGlobal(self->mod, name);
+
+  if (!sentinel)
+    {
+      sentinel = LLVMAddGlobal(self->mod, LLVMInt8TypeInContext(self->ctx), name);
+      LLVMSetGlobalConstant(sentinel, TRUE);
+    }
+  return sentinel;
 }
 
 FilterXIRValue
@@ -253,17 +316,87 @@ _init_variables(FilterXJIT *self, FilterXScopeVariableLayout *layout)
     }
 }
 
-void
-filterx_jit_ir_add_new_block(FilterXJIT *self, const gchar *block_name, FilterXScopeVariableLayout *layout)
+static inline void
+_setup_module_debug_info(FilterXJIT *self, FilterXJITBlock *block)
+{
+  LLVMValueRef di_version = LLVMConstInt(LLVMInt32TypeInContext(self->ctx), LLVMDebugMetadataVersion(), FALSE);
+  LLVMValueRef dwarf_version = LLVMConstInt(LLVMInt32TypeInContext(self->ctx), 5, FALSE);
+
+  LLVMAddModuleFlag(block->mod, LLVMModuleFlagBehaviorWarning, DEBUG_VERSION_KEY, strlen(DEBUG_VERSION_KEY),
+                    LLVMValueAsMetadata(di_version));
+  LLVMAddModuleFlag(block->mod, LLVMModuleFlagBehaviorWarning, DWARF_VERSION_KEY, strlen(DWARF_VERSION_KEY),
+                    LLVMValueAsMetadata(dwarf_version));
+
+  block->debug = LLVMCreateDIBuilder(block->mod);
+
+  const gchar *dummy_file_name = "<filterx>";
+  LLVMMetadataRef file = LLVMDIBuilderCreateFile(block->debug, dummy_file_name, strlen(dummy_file_name), "", 0);
+
+  const gchar *producer = "AxoSyslog FilterX JIT";
+  LLVMDIBuilderCreateCompileUnit(block->debug, LLVMDWARFSourceLanguageC, file, producer, strlen(producer), FALSE,
+                                 "", 0, 0, "", 0, LLVMDWARFEmissionFull, 0, FALSE, FALSE, "", 0, "", 0);
+}
+
+static StatsCounterItem *_get_compile_time_counter(const gchar *mod_name, const gchar *block_name);
+
+static FilterXJITBlock *
+_block_new(FilterXJIT *self, const gchar *block_name)
+{
+  FilterXJITBlock *block = g_new0(FilterXJITBlock, 1);
+
+  block->name = g_strdup(block_name);
+  block->fqn = _create_fully_qualified_block_name(self, block_name);
+
+  block->mod = LLVMModuleCreateWithNameInContext(block->fqn, self->ctx);
+  LLVMSetTarget(block->mod, LLVMGetTarget(self->libfilterx));
+  LLVMSetDataLayout(block->mod, LLVMGetDataLayoutStr(self->libfilterx));
+  _setup_module_debug_info(self, block);
+
+  if (self->cache_dir)
+    {
+      block->consts = g_ptr_array_new();
+      block->const_indices = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+
+  block->compile_time = _get_compile_time_counter(self->mod_name, block_name);
+  return block;
+}
+
+static void
+_block_free(FilterXJITBlock *block)
+{
+  if (block->debug)
+    LLVMDisposeDIBuilder(block->debug);
+  if (block->mod)
+    LLVMDisposeModule(block->mod);
+
+  if (block->consts)
+    {
+      g_ptr_array_free(block->consts, TRUE);
+      g_hash_table_unref(block->const_indices);
+    }
+  g_free(block->cache_key);
+  g_free(block->fqn);
+  g_free(block->name);
+  g_free(block);
+}
+
+static void
+_add_new_block(FilterXJIT *self, const gchar *block_name, FilterXScopeVariableLayout *layout, gboolean has_result)
 {
   g_assert(!self->mod_finalized);
   g_assert(!self->current_ir_block);
 
-  gchar *fqn = _create_fully_qualified_block_name(self, block_name);
-  self->current_ir_block = LLVMAddFunction(self->mod, fqn, _block_function_type(self));
+  FilterXJITBlock *block = _block_new(self, block_name);
+  g_ptr_array_add(self->blocks, block);
+  self->current_block = block;
+  self->mod = block->mod;
+  filterx_jit_ffi_init(self);
+
+  LLVMTypeRef return_ty = has_result ? self->ffi.ptr_ty : self->ffi.void_ty;
+  self->current_ir_block = LLVMAddFunction(self->mod, block->fqn, _block_function_type(self, return_ty));
   _set_unwind_attributes(self, self->current_ir_block);
   _inherit_libfilterx_function_attributes(self, self->current_ir_block);
-  g_free(fqn);
 
   self->current_eval_context = LLVMGetParam(self->current_ir_block, 0);
   LLVMSetValueName2(self->current_eval_context, "eval_context", strlen("eval_context"));
@@ -274,6 +407,19 @@ filterx_jit_ir_add_new_block(FilterXJIT *self, const gchar *block_name, FilterXS
   _init_variables(self, layout);
 }
 
+void
+filterx_jit_ir_add_new_block(FilterXJIT *self, const gchar *block_name, FilterXScopeVariableLayout *layout)
+{
+  _add_new_block(self, block_name, layout, TRUE);
+}
+
+/* blocks without a result, they are finished with a NULL result */
+void
+filterx_jit_ir_add_new_void_block(FilterXJIT *self, const gchar *block_name, FilterXScopeVariableLayout *layout)
+{
+  _add_new_block(self, block_name, layout, FALSE);
+}
+
 FilterXIRValue
 filterx_jit_ir_get_variable(FilterXJIT *self, gint scope_var_idx)
 {
@@ -300,6 +446,57 @@ filterx_jit_ir_clear_variables(FilterXJIT *self)
   _reset_variables(self);
 }
 
+static inline gchar *
+_consts_table_name(FilterXJITBlock *block)
+{
+  return g_strconcat(block->fqn, "::consts", NULL);
+}
+
+/*
+ * With the object cache enabled, pointers are not embedded into the code as
+ * immediates. They are loaded from a per-block table that is filled when the
+ * module is finalized, so the same block generates the same code in every
+ * process.
+ */
+FilterXIRValue
+filterx_jit_ir_load_const_ptr(FilterXJIT *self, gconstpointer p)
+{
+  g_assert(!self->mod_finalized);
+
+  FilterXJITBlock *block = self->current_block;
+  g_assert(block && block->consts);
+
+  gpointer index_ptr;
+  guint index;
+  if (g_hash_table_lookup_extended(block->const_indices, p, NULL, &index_ptr))
+    {
+      index = GPOINTER_TO_UINT(index_ptr);
+    }
+  else
+    {
+      index = block->consts->len;
+      g_ptr_array_add(block->consts, (gpointer) p);
+      g_hash_table_insert(block->const_indices, (gpointer) p, GUINT_TO_POINTER(index));
+    }
+
+  if (!block->consts_table)
+    {
+      gchar *name = _consts_table_name(block);
+      block->consts_table = LLVMAddGlobal(block->mod, self->ffi.ptr_ty, name);
+      LLVMSetGlobalConstant(block->consts_table, TRUE);
+      g_free(name);
+    }
+
+  LLVMValueRef indices[] = { LLVMConstInt(self->ffi.i64_ty, index, FALSE) };
+  LLVMValueRef slot = LLVMBuildGEP2(self->ir, self->ffi.ptr_ty, block->consts_table, indices, 1, "const_slot");
+  LLVMValueRef value = LLVMBuildLoad2(self->ir, self->ffi.ptr_ty, slot, "const");
+
+  const gchar *invariant_load = "invariant.load";
+  LLVMSetMetadata(value, LLVMGetMDKindIDInContext(self->ctx, invariant_load, strlen(invariant_load)),
+                  LLVMMetadataAsValue(self->ctx, LLVMMDNodeInContext2(self->ctx, NULL, 0)));
+  return value;
+}
+
 FilterXIRValue
 filterx_jit_ir_get_eval_context(FilterXJIT *self)
 {
@@ -314,16 +511,21 @@ filterx_jit_ir_finish_current_block(FilterXJIT *self, FilterXIRValue result)
   g_assert(!self->mod_finalized);
   g_assert(self->current_ir_block);
 
-  LLVMBuildRet(self->ir, result);
+  if (result)
+    LLVMBuildRet(self->ir, result);
+  else
+    LLVMBuildRetVoid(self->ir);
 
   if (self->current_debug_info_block)
-    LLVMDIBuilderFinalizeSubprogram(self->debug, self->current_debug_info_block);
+    LLVMDIBuilderFinalizeSubprogram(self->current_block->debug, self->current_debug_info_block);
 
   _assert_verify_block(self, self->current_ir_block);
 
   self->current_block_variables = NULL;
   self->current_block_variables_size = 0;
 
+  self->current_block = NULL;
+  self->mod = NULL;
   self->current_ir_block = NULL;
   self->current_eval_context = NULL;
   self->current_debug_info_block = NULL;
@@ -401,65 +603,76 @@ _string_append_printf_line_count(GString *str, guint *line, const char *format,
 
 /*
  * LLVM IR debug info
- * Renders each function with one instruction per line into a memfd.
+ * Renders each function of each block with one instruction per line into a
+ * memfd shared by all blocks.
  */
-static gboolean
-_emit_llvm_ir_debug_info(FilterXJIT *self, GError **error)
+static void
+_emit_block_llvm_ir_debug_info(FilterXJIT *self, FilterXJITBlock *block, const gchar *path,
+                               GString *ir_text, guint *line)
 {
-  self->debug_ir_text_memfd = memfd_create(self->mod_name, MFD_CLOEXEC);
-  if (self->debug_ir_text_memfd < 0)
-    {
-      _fxjit_error("memfd_create failed", error);
-      return FALSE;
-    }
-
-  gchar path[64];
-  g_snprintf(path, sizeof(path), "/proc/%d/fd/%d", (int) getpid(), self->debug_ir_text_memfd);
-  LLVMMetadataRef di_file = LLVMDIBuilderCreateFile(self->debug, path, strlen(path), "", 0);
-
-  GString *ir_text = g_string_sized_new(1024);
-  guint line = 0;
+  LLVMMetadataRef di_file = LLVMDIBuilderCreateFile(block->debug, path, strlen(path), "", 0);
 
-  for (LLVMValueRef fn = LLVMGetFirstFunction(self->mod); fn; fn = LLVMGetNextFunction(fn))
+  for (LLVMValueRef fn = LLVMGetFirstFunction(block->mod); fn; fn = LLVMGetNextFunction(fn))
     {
       if (!LLVMGetFirstBasicBlock(fn))
         continue;
 
       const gchar *fn_name = LLVMGetValueName(fn);
-      _string_append_printf_line_count(ir_text, &line, "define @\"%s\" {\n", fn_name);
+      _string_append_printf_line_count(ir_text, line, "define @\"%s\" {\n", fn_name);
 
-      LLVMMetadataRef subroutine_ty = LLVMDIBuilderCreateSubroutineType(self->debug, di_file, NULL, 0, LLVMDIFlagZero);
-      LLVMMetadataRef sp = LLVMDIBuilderCreateFunction(self->debug, di_file, fn_name, strlen(fn_name),
-                                                       fn_name, strlen(fn_name), di_file, line, subroutine_ty,
-                                                       FALSE, TRUE, line, LLVMDIFlagZero, FALSE);
+      LLVMMetadataRef subroutine_ty = LLVMDIBuilderCreateSubroutineType(block->debug, di_file, NULL, 0,
+                                      LLVMDIFlagZero);
+      LLVMMetadataRef sp = LLVMDIBuilderCreateFunction(block->debug, di_file, fn_name, strlen(fn_name),
+                                                       fn_name, strlen(fn_name), di_file, *line, subroutine_ty,
+                                                       FALSE, TRUE, *line, LLVMDIFlagZero, FALSE);
       LLVMSetSubprogram(fn, sp);
 
       gboolean first_sequence = TRUE;
       for (FilterXIRSequence seq = LLVMGetFirstBasicBlock(fn); seq; seq = LLVMGetNextBasicBlock(seq))
         {
           if (!first_sequence)
-            _string_append_line_count(ir_text, &line, "\n");
+            _string_append_line_count(ir_text, line, "\n");
           first_sequence = FALSE;
 
           const gchar *bb_name = LLVMGetBasicBlockName(seq);
           bb_name = bb_name ? bb_name : "";
-          _string_append_printf_line_count(ir_text, &line, "%s:\n", bb_name);
+          _string_append_printf_line_count(ir_text, line, "%s:\n", bb_name);
 
           for (LLVMValueRef inst = LLVMGetFirstInstruction(seq); inst; inst = LLVMGetNextInstruction(inst))
             {
               gchar *inst_text = LLVMPrintValueToString(inst);
-              _string_append_printf_line_count(ir_text, &line, "%s\n", inst_text);
+              _string_append_printf_line_count(ir_text, line, "%s\n", inst_text);
               LLVMDisposeMessage(inst_text);
 
-              LLVMMetadataRef loc = LLVMDIBuilderCreateDebugLocation(self->ctx, line, 1, sp, NULL);
+              LLVMMetadataRef loc = LLVMDIBuilderCreateDebugLocation(self->ctx, *line, 1, sp, NULL);
               LLVMInstructionSetDebugLoc(inst, loc);
             }
         }
 
-      _string_append_line_count(ir_text, &line, "}\n\n");
-      LLVMDIBuilderFinalizeSubprogram(self->debug, sp);
+      _string_append_line_count(ir_text, line, "}\n\n");
+      LLVMDIBuilderFinalizeSubprogram(block->debug, sp);
+    }
+}
+
+static gboolean
+_emit_llvm_ir_debug_info(FilterXJIT *self, GError **error)
+{
+  self->debug_ir_text_memfd = memfd_create(self->mod_name, MFD_CLOEXEC);
+  if (self->debug_ir_text_memfd < 0)
+    {
+      _fxjit_error("memfd_create failed", error);
+      return FALSE;
     }
 
+  gchar path[64];
+  g_snprintf(path, sizeof(path), "/proc/%d/fd/%d", (int) getpid(), self->debug_ir_text_memfd);
+
+  GString *ir_text = g_string_sized_new(1024);
+  guint line = 0;
+
+  for (guint i = 0; i < self->blocks->len; i++)
+    _emit_block_llvm_ir_debug_info(self, g_ptr_array_index(self->blocks, i), path, ir_text, &line);
+
   ssize_t written = write(self->debug_ir_text_memfd, ir_text->str, ir_text->len);
   g_string_free(ir_text, TRUE);
   if (written < 0)
@@ -473,17 +686,14 @@ _emit_llvm_ir_debug_info(FilterXJIT *self, GError **error)
 
 #endif
 
+/* linking consumes the source module, every block inlines from a copy of its own */
 static gboolean
-_link_libfilterx(FilterXJIT *self, GError **error)
+_link_libfilterx(FilterXJIT *self, FilterXJITBlock *block, GError **error)
 {
   if (!self->libfilterx)
     return TRUE;
 
-  LLVMBool link_err = LLVMLinkModules2(self->mod, self->libfilterx);
-  /* libfilterx is consumed */
-  self->libfilterx = NULL;
-
-  if (link_err)
+  if (LLVMLinkModules2(block->mod, LLVMCloneModule(self->libfilterx)))
     {
       _fxjit_error("Failed to link embedded libfilterx bitcode into the JIT module", error);
       return FALSE;
@@ -492,42 +702,167 @@ _link_libfilterx(FilterXJIT *self, GError **error)
   return TRUE;
 }
 
-gboolean
-filterx_jit_finalize(FilterXJIT *self, GError **error)
+static gboolean
+_define_consts_table(FilterXJIT *self, FilterXJITBlock *block, GError **error)
 {
-  if (self->mod_finalized)
+  if (!block->consts_table)
     return TRUE;
 
-#if FILTERX_JIT_DEBUG_INFO_LLVM_IR_SUPPORTED
-  if (self->debug_info_mode == FILTERX_JIT_DEBUG_INFO_LLVM_IR)
+  gchar *name = _consts_table_name(block);
+  LLVMOrcCSymbolMapPair symbol =
+  {
+    .Name = LLVMOrcLLJITMangleAndIntern(self->j, name),
+    .Sym =
     {
-      if (!_emit_llvm_ir_debug_info(self, error))
-        return FALSE;
+      .Address = (LLVMOrcExecutorAddress) (guintptr) block->consts->pdata,
+      .Flags = { .GenericFlags = LLVMJITSymbolGenericFlagsExported, .TargetFlags = 0 },
+    },
+  };
+  g_free(name);
+
+  LLVMOrcMaterializationUnitRef mu = LLVMOrcAbsoluteSymbols(&symbol, 1);
+  LLVMErrorRef err = LLVMOrcJITDylibDefine(LLVMOrcLLJITGetMainJITDylib(self->j), mu);
+  if (err)
+    {
+      LLVMOrcDisposeMaterializationUnit(mu);
+      _llvm_error_to_fxjit_error(err, error);
+      return FALSE;
     }
-#endif
 
-  if (self->debug)
-    LLVMDIBuilderFinalize(self->debug);
+  return TRUE;
+}
 
-  if (!_link_libfilterx(self, error))
+static gboolean
+_add_cached_object(FilterXJIT *self, FilterXJITBlock *block)
+{
+  LLVMMemoryBufferRef obj = filterx_jit_cache_load(self->cache_dir, block->cache_key);
+  if (!obj)
     return FALSE;
 
-  if (!_verify_module(self, error))
+  /* obj is consumed */
+  LLVMErrorRef err = LLVMOrcLLJITAddObjectFile(self->j, LLVMOrcLLJITGetMainJITDylib(self->j), obj);
+  if (err)
+    {
+      gchar *message = LLVMGetErrorMessage(err);
+      msg_warning("FilterXJIT failed to load cached object file, recompiling",
+                  evt_tag_str("module_name", self->mod_name),
+                  evt_tag_str("block", block->name),
+                  evt_tag_str("error", message));
+      LLVMDisposeErrorMessage(message);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* returns TRUE in loaded_from_cache if the compiled block was found in the cache */
+static gboolean
+_lookup_object_cache(FilterXJIT *self, FilterXJITBlock *block, gboolean *loaded_from_cache, GError **error)
+{
+  *loaded_from_cache = FALSE;
+
+  if (!_define_consts_table(self, block, error))
+    return FALSE;
+
+  block->cache_key = filterx_jit_cache_compute_key(block->mod);
+  if (_add_cached_object(self, block))
+    {
+      stats_counter_inc(self->metrics->cache_hits);
+      msg_debug("FilterXJIT block loaded from object cache",
+                evt_tag_str("module_name", self->mod_name),
+                evt_tag_str("block", block->name),
+                evt_tag_str("key", block->cache_key));
+
+      /* the object file is not stored again */
+      g_clear_pointer(&block->cache_key, g_free);
+      *loaded_from_cache = TRUE;
+      return TRUE;
+    }
+
+  stats_counter_inc(self->metrics->cache_misses);
+  return TRUE;
+}
+
+static gboolean
+_finalize_block(FilterXJIT *self, FilterXJITBlock *block, GError **error)
+{
+  /* already added to the JIT by an earlier, partially failed filterx_jit_finalize() */
+  if (!block->mod)
+    return TRUE;
+
+  if (block->debug)
+    {
+      LLVMDIBuilderFinalize(block->debug);
+      g_clear_pointer(&block->debug, LLVMDisposeDIBuilder);
+    }
+
+  if (self->cache_dir)
+    {
+      gboolean loaded_from_cache;
+      if (!_lookup_object_cache(self, block, &loaded_from_cache, error))
+        return FALSE;
+
+      if (loaded_from_cache)
+        {
+          g_clear_pointer(&block->mod, LLVMDisposeModule);
+          return TRUE;
+        }
+    }
+
+  if (!_link_libfilterx(self, block, error))
+    return FALSE;
+
+  if (!_verify_module(self, block, error))
     return FALSE;
 
-  LLVMOrcThreadSafeModuleRef ts_mod = LLVMOrcCreateNewThreadSafeModule(self->mod, self->ts_ctx);
+  /* the module is owned by ts_mod from now on */
+  LLVMOrcThreadSafeModuleRef ts_mod = LLVMOrcCreateNewThreadSafeModule(block->mod, self->ts_ctx);
+  block->mod = NULL;
 
   LLVMOrcJITDylibRef jit_dylib = LLVMOrcLLJITGetMainJITDylib(self->j);
   LLVMErrorRef err = LLVMOrcLLJITAddLLVMIRModule(self->j, jit_dylib, ts_mod);
   if (err)
     {
       _llvm_error_to_fxjit_error(err, error);
-      self->mod = LLVMCloneModule(self->mod);
       LLVMOrcDisposeThreadSafeModule(ts_mod);
       return FALSE;
     }
 
-  msg_trace("FilterXJIT finalized", evt_tag_str("module_name", self->mod_name));
+  return TRUE;
+}
+
+/*
+ * Blocks are added to the JIT as separate modules, they are compiled
+ * lazily, when they are first looked up.
+ */
+gboolean
+filterx_jit_finalize(FilterXJIT *self, GError **error)
+{
+  if (self->mod_finalized)
+    return TRUE;
+
+  g_assert(!self->current_block);
+
+#if FILTERX_JIT_DEBUG_INFO_LLVM_IR_SUPPORTED
+  if (self->debug_info_mode == FILTERX_JIT_DEBUG_INFO_LLVM_IR && self->debug_ir_text_memfd < 0)
+    {
+      if (!_emit_llvm_ir_debug_info(self, error))
+        return FALSE;
+    }
+#endif
+
+  for (guint i = 0; i < self->blocks->len; i++)
+    {
+      if (!_finalize_block(self, g_ptr_array_index(self->blocks, i), error))
+        return FALSE;
+    }
+
+  /* every block has its own copy by now */
+  g_clear_pointer(&self->libfilterx, LLVMDisposeModule);
+
+  msg_trace("FilterXJIT finalized",
+            evt_tag_str("module_name", self->mod_name),
+            evt_tag_int("blocks", self->blocks->len));
 
   self->mod_finalized = TRUE;
   return TRUE;
@@ -590,6 +925,173 @@ _setup_optimizations(FilterXJIT *self)
   LLVMOrcIRTransformLayerSetTransform(transform, _optimize_transform, self);
 }
 
+static inline void
+_setup_object_transform(FilterXJIT *self)
+{
+  LLVMOrcObjectTransformLayerRef transform = LLVMOrcLLJITGetObjTransformLayer(self->j);
+  LLVMOrcObjectTransformLayerSetTransform(transform, _object_transform, self);
+}
+
+static inline void
+_compile_time_key(StatsClusterKey *sc_key, StatsClusterLabel *labels, gsize labels_len)
+{
+  stats_cluster_single_key_set(sc_key, METRIC(filterx_jit_compile_time_seconds), labels, labels_len);
+  stats_cluster_key_add_unit(sc_key, SCU_MILLISECONDS);
+}
+
+/*
+ * Metrics are registered once per JIT module and block name, not per
+ * FilterXJIT instance: the instances of a module (e.g. those of the old and
+ * the new configuration during a reload) share them.  The cache counters
+ * are per module and are only registered for modules that use an object
+ * cache, compile times are per block.
+ *
+ * FilterXJIT instances are created and freed from the main thread.
+ */
+static GHashTable *jit_metrics;
+
+typedef struct _FilterXJITBlockMetrics
+{
+  gchar *mod_name;
+  gchar *block_name;
+  StatsCounterItem *compile_time;
+} FilterXJITBlockMetrics;
+
+static GHashTable *jit_block_metrics;
+
+static void
+_block_metrics_free(FilterXJITBlockMetrics *self)
+{
+  g_free(self->mod_name);
+  g_free(self->block_name);
+  g_free(self);
+}
+
+static FilterXJITMetrics *
+_get_metrics(const gchar *mod_name)
+{
+  if (!jit_metrics)
+    jit_metrics = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+  FilterXJITMetrics *metrics = g_hash_table_lookup(jit_metrics, mod_name);
+  if (!metrics)
+    {
+      metrics = g_new0(FilterXJITMetrics, 1);
+      g_hash_table_insert(jit_metrics, g_strdup(mod_name), metrics);
+    }
+
+  return metrics;
+}
+
+static StatsCounterItem *
+_get_compile_time_counter(const gchar *mod_name, const gchar *block_name)
+{
+  if (!jit_block_metrics)
+    jit_block_metrics = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+                                              (GDestroyNotify) _block_metrics_free);
+
+  gchar *fqn = g_strconcat(mod_name, "::", block_name, NULL);
+  FilterXJITBlockMetrics *metrics = g_hash_table_lookup(jit_block_metrics, fqn);
+  if (metrics)
+    {
+      g_free(fqn);
+      return metrics->compile_time;
+    }
+
+  metrics = g_new0(FilterXJITBlockMetrics, 1);
+  metrics->mod_name = g_strdup(mod_name);
+  metrics->block_name = g_strdup(block_name);
+  g_hash_table_insert(jit_block_metrics, fqn, metrics);
+
+  StatsClusterLabel labels[] =
+  {
+    stats_cluster_label("module", mod_name),
+    stats_cluster_label("block", block_name),
+  };
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  _compile_time_key(&sc_key, labels, G_N_ELEMENTS(labels));
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &metrics->compile_time);
+  stats_unlock();
+  return metrics->compile_time;
+}
+
+static void
+_register_cache_metrics(FilterXJIT *self)
+{
+  if (self->metrics->cache_hits)
+    return;
+
+  StatsClusterLabel labels[] = { stats_cluster_label("module", self->mod_name) };
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_hits_total), labels, G_N_ELEMENTS(labels));
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics->cache_hits);
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_misses_total), labels, G_N_ELEMENTS(labels));
+  stats_register_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &self->metrics->cache_misses);
+  stats_unlock();
+}
+
+static void
+_unregister_metrics(const gchar *mod_name, FilterXJITMetrics *metrics)
+{
+  if (!metrics->cache_hits)
+    return;
+
+  StatsClusterLabel labels[] = { stats_cluster_label("module", mod_name) };
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_hits_total), labels, G_N_ELEMENTS(labels));
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &metrics->cache_hits);
+  stats_cluster_single_key_set(&sc_key, METRIC(filterx_jit_cache_misses_total), labels, G_N_ELEMENTS(labels));
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &metrics->cache_misses);
+  stats_unlock();
+}
+
+static void
+_unregister_block_metrics(FilterXJITBlockMetrics *metrics)
+{
+  StatsClusterLabel labels[] =
+  {
+    stats_cluster_label("module", metrics->mod_name),
+    stats_cluster_label("block", metrics->block_name),
+  };
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  _compile_time_key(&sc_key, labels, G_N_ELEMENTS(labels));
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &metrics->compile_time);
+  stats_unlock();
+}
+
+static void
+_unregister_all_metrics(void)
+{
+  GHashTableIter iter;
+  gpointer key, metrics;
+
+  if (jit_metrics)
+    {
+      g_hash_table_iter_init(&iter, jit_metrics);
+      while (g_hash_table_iter_next(&iter, &key, &metrics))
+        _unregister_metrics(key, metrics);
+
+      g_clear_pointer(&jit_metrics, g_hash_table_unref);
+    }
+
+  if (jit_block_metrics)
+    {
+      g_hash_table_iter_init(&iter, jit_block_metrics);
+      while (g_hash_table_iter_next(&iter, &key, &metrics))
+        _unregister_block_metrics(metrics);
+
+      g_clear_pointer(&jit_block_metrics, g_hash_table_unref);
+    }
+}
+
 static LLVMOrcObjectLayerRef
 _create_object_layer_with_gdb_listener(void *ctx, LLVMOrcExecutionSessionRef es, const char *triple)
 {
@@ -645,23 +1147,6 @@ static inline void
 _setup_debug_info(FilterXJIT *self, LLVMOrcLLJITBuilderRef jit_builder)
 {
   LLVMOrcLLJITBuilderSetObjectLinkingLayerCreator(jit_builder, _create_object_layer_with_gdb_listener, NULL);
-
-  LLVMValueRef di_version = LLVMConstInt(LLVMInt32TypeInContext(self->ctx), LLVMDebugMetadataVersion(), FALSE);
-  LLVMValueRef dwarf_version = LLVMConstInt(LLVMInt32TypeInContext(self->ctx), 5, FALSE);
-
-  LLVMAddModuleFlag(self->mod, LLVMModuleFlagBehaviorWarning, DEBUG_VERSION_KEY, strlen(DEBUG_VERSION_KEY),
-                    LLVMValueAsMetadata(di_version));
-  LLVMAddModuleFlag(self->mod, LLVMModuleFlagBehaviorWarning, DWARF_VERSION_KEY, strlen(DWARF_VERSION_KEY),
-                    LLVMValueAsMetadata(dwarf_version));
-
-  self->debug = LLVMCreateDIBuilder(self->mod);
-
-  const gchar *dummy_file_name = "<filterx>";
-  LLVMMetadataRef file = LLVMDIBuilderCreateFile(self->debug, dummy_file_name, strlen(dummy_file_name), "", 0);
-
-  const gchar *producer = "AxoSyslog FilterX JIT";
-  LLVMDIBuilderCreateCompileUnit(self->debug, LLVMDWARFSourceLanguageC, file, producer, strlen(producer), FALSE, "", 0,
-                                 0, "", 0, LLVMDWARFEmissionFull, 0, FALSE, FALSE, "", 0, "", 0);
 }
 
 FilterXJIT *
@@ -673,6 +1158,7 @@ filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_info, GError
   self->mod_name = g_strdup(module_name);
   self->debug_info_mode = debug_info;
   self->debug_ir_text_memfd = -1;
+  self->blocks = g_ptr_array_new_with_free_func((GDestroyNotify) _block_free);
 
 #if SYSLOG_NG_HAVE_DECL_LLVMORCCREATENEWTHREADSAFECONTEXTFROMLLVMCONTEXT
   self->ctx = LLVMContextCreate();
@@ -682,16 +1168,12 @@ filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_info, GError
   self->ctx = LLVMOrcThreadSafeContextGetContext(self->ts_ctx);
 #endif
 
-  self->mod = LLVMModuleCreateWithNameInContext(self->mod_name, self->ctx);
   self->ir = LLVMCreateBuilderInContext(self->ctx);
 
   self->libfilterx = filterx_jit_load_libfilterx_bitcode(self->ctx, error);
   if (!self->libfilterx)
     goto error;
 
-  LLVMSetTarget(self->mod, LLVMGetTarget(self->libfilterx));
-  LLVMSetDataLayout(self->mod, LLVMGetDataLayoutStr(self->libfilterx));
-
   LLVMOrcLLJITBuilderRef jit_builder = LLVMOrcCreateLLJITBuilder();
   _setup_debug_info(self, jit_builder);
   if (!_setup_target_machine(self, jit_builder, error))
@@ -708,8 +1190,9 @@ filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_info, GError
     goto error;
 
   _setup_optimizations(self);
+  _setup_object_transform(self);
 
-  filterx_jit_ffi_init(self);
+  self->metrics = _get_metrics(self->mod_name);
 
   msg_trace("FilterXJIT created", evt_tag_str("module_name", self->mod_name));
 
@@ -720,22 +1203,40 @@ error:
   return NULL;
 }
 
+/*
+ * Compiled object files are stored in and reused from cache_dir.
+ * Must be called before generating any IR code.
+ */
+void
+filterx_jit_set_object_cache_dir(FilterXJIT *self, const gchar *cache_dir)
+{
+  g_assert(!self->mod_finalized);
+  g_assert(self->blocks->len == 0);
+
+  /* LLVM IR debug info refers to a per-process memfd */
+  if (!cache_dir || self->debug_info_mode == FILTERX_JIT_DEBUG_INFO_LLVM_IR)
+    return;
+
+  g_free(self->cache_dir);
+  self->cache_dir = g_strdup(cache_dir);
+  _register_cache_metrics(self);
+}
+
 void
 filterx_jit_free(FilterXJIT *self)
 {
   if (!self)
     return;
 
-  if (self->debug)
-    LLVMDisposeDIBuilder(self->debug);
   if (self->j)
     LLVMOrcDisposeLLJIT(self->j);
   if (self->tm)
     LLVMDisposeTargetMachine(self->tm);
   LLVMDisposeBuilder(self->ir);
+
+  /* the modules not added to the JIT and the consts tables of the compiled code */
+  g_ptr_array_free(self->blocks, TRUE);
   self->ctx = NULL;
-  if (!self->mod_finalized)
-    LLVMDisposeModule(self->mod);
   if (self->libfilterx)
     LLVMDisposeModule(self->libfilterx);
   LLVMOrcDisposeThreadSafeContext(self->ts_ctx);
@@ -745,6 +1246,7 @@ filterx_jit_free(FilterXJIT *self)
 
   msg_trace("FilterXJIT destroyed", evt_tag_str("module_name", self->mod_name));
 
+  g_free(self->cache_dir);
   g_free(self->mod_name);
   g_free(self);
 }
@@ -780,6 +1282,7 @@ exit:
 void
 filterx_jit_global_deinit(void)
 {
+  _unregister_all_metrics();
   LLVMShutdown();
 }
 
@@ -791,6 +1294,7 @@ FilterXJIT *filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_
 }
 
 void filterx_jit_free(FilterXJIT *self) {}
+void filterx_jit_set_object_cache_dir(FilterXJIT *self, const gchar *cache_dir) {}
 void filterx_jit_global_init(void) {}
 void filterx_jit_global_deinit(void) {}
 
@@ -804,6 +1308,11 @@ void filterx_jit_ir_add_new_block(FilterXJIT *self, const gchar *block_name, Fil
   g_assert_not_reached();
 }
 
+void filterx_jit_ir_add_new_void_block(FilterXJIT *self, const gchar *block_name, FilterXScopeVariableLayout *layout)
+{
+  g_assert_not_reached();
+}
+
 void filterx_jit_ir_finish_current_block(FilterXJIT *self, FilterXIRValue result)
 {
   g_assert_not_reached();
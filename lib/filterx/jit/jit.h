@@ -77,11 +77,14 @@ typedef FilterXObject *(*FilterXJITExecFunc)(struct _FilterXEvalContext *ctx);
 
 FilterXJIT *filterx_jit_new(const gchar *module_name, FilterXJITDebugInfo debug_info, GError **error);
 void filterx_jit_free(FilterXJIT *self);
+void filterx_jit_set_object_cache_dir(FilterXJIT *self, const gchar *cache_dir);
 
 /* IR */
 FilterXIRBuilder filterx_jit_get_ir_builder(FilterXJIT *self);
 void filterx_jit_ir_add_new_block(FilterXJIT *self, const gchar *block_name,
                                   struct _FilterXScopeVariableLayout *layout);
+void filterx_jit_ir_add_new_void_block(FilterXJIT *self, const gchar *block_name,
+                                       struct _FilterXScopeVariableLayout *layout);
 void filterx_jit_ir_finish_current_block(FilterXJIT *self, FilterXIRValue result);
 FilterXIRValue filterx_jit_ir_get_current_block(FilterXJIT *self);
 
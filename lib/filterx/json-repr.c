@@ -57,13 +57,44 @@ TLS_BLOCK_END;
 #define jsmn_tokens      __tls_deref(jsmn_tokens)
 #define jsmn_tokens_len  __tls_deref(jsmn_tokens_len)
 
+/*
+ * FilterXJSONSource keeps the original JSON text along with its jsmn
+ * tokens, so that objects parsed by parse_json() can be materialized on
+ * demand: dicts created from a source only convert the members that are
+ * actually accessed (see object-dict.c).  The source is immutable once
+ * created, it is shared by all the lazy dicts (and their copies) that
+ * refer to it.
+ */
+struct _FilterXJSONSource
+{
+  GAtomicCounter ref_cnt;
+  gchar *text;
+  gsize text_len;
+  gint tokens_len;
+  jsmntok_t tokens[];
+};
+
 /* JSON parsing */
 
 #define FILTERX_JSON_MAX_NESTING_DEPTH 1000
 
 static FilterXObject *
 filterx_object_from_jsmn_tokens(const gchar *json_text, gsize json_len, jsmntok_t **tokens, jsmntok_t *sentinel,
-                                gint depth);
+                                gint depth, FilterXJSONSource *source);
+
+static gint _json_source_skip_value(FilterXJSONSource *self, gint token_index);
+
+static FilterXObject *
+_convert_from_json_object_lazily(FilterXJSONSource *source, jsmntok_t **tokens)
+{
+  gint token_index = *tokens - source->tokens;
+  FilterXObject *res = filterx_dict_new_from_json_source(source, token_index);
+
+  filterx_object_cow_prepare(&res);
+  *tokens = &source->tokens[_json_source_skip_value(source, token_index)];
+  filterx_object_set_dirty(res, FALSE);
+  return res;
+}
 
 static FilterXObject *
 _convert_from_json_object(const gchar *json_text, gsize json_len,
@@ -79,11 +110,11 @@ _convert_from_json_object(const gchar *json_text, gsize json_len,
   token++;
   for (gint i = 0; i < elements && token < sentinel; i++)
     {
-      FilterXObject *key = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel, depth + 1);
+      FilterXObject *key = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel, depth + 1, NULL);
       if (!key)
         goto error;
 
-      FilterXObject *value = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel, depth + 1);
+      FilterXObject *value = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel, depth + 1, NULL);
       if (!value)
         {
           filterx_object_unref(key);
@@ -108,7 +139,7 @@ error:
 
 static FilterXObject *
 _convert_from_json_array(const gchar *json_text, gsize json_len,
-                         jsmntok_t **tokens, jsmntok_t *sentinel, gint depth)
+                         jsmntok_t **tokens, jsmntok_t *sentinel, gint depth, FilterXJSONSource *source)
 {
   FilterXObject *res = filterx_list_new();
   filterx_object_cow_prepare(&res);
@@ -119,7 +150,7 @@ _convert_from_json_array(const gchar *json_text, gsize json_len,
   token++;
   for (gint i = 0; i < elements && token < sentinel; i++)
     {
-      FilterXObject *o = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel, depth + 1);
+      FilterXObject *o = filterx_object_from_jsmn_tokens(json_text, json_len, &token, sentinel, depth + 1, source);
       if (!o)
         goto error;
 
@@ -138,19 +169,26 @@ error:
   return NULL;
 }
 
-static FilterXObject *
-_convert_from_json_number(const gchar *json_text, gsize json_len, jsmntok_t *token)
+static gboolean
+_parse_json_number(const gchar *json_text, jsmntok_t *token, GenericNumber *gn)
 {
   gchar buf[64];
-  GenericNumber gn;
 
   gsize len = token->end - token->start;
   if (len > sizeof(buf) - 1)
-    return NULL;
+    return FALSE;
   memcpy(buf, &json_text[token->start], len);
   buf[len] = 0;
 
-  if (!parse_generic_number(buf, &gn))
+  return parse_generic_number(buf, gn);
+}
+
+static FilterXObject *
+_convert_from_json_number(const gchar *json_text, gsize json_len, jsmntok_t *token)
+{
+  GenericNumber gn;
+
+  if (!_parse_json_number(json_text, token, &gn))
     return NULL;
 
   switch (gn.type)
@@ -219,9 +257,11 @@ _convert_from_json_string(const gchar *json_text, gsize json_len,
   return result;
 }
 
+/* if @source is specified, objects are not converted but are represented
+ * by lazy dicts referring to @source */
 static FilterXObject *
 filterx_object_from_jsmn_tokens(const gchar *json_text, gsize json_len, jsmntok_t **tokens, jsmntok_t *sentinel,
-                                gint depth)
+                                gint depth, FilterXJSONSource *source)
 {
   FilterXObject *result = NULL;
 
@@ -236,10 +276,13 @@ filterx_object_from_jsmn_tokens(const gchar *json_text, gsize json_len, jsmntok_
   switch (token->type)
     {
     case JSMN_OBJECT:
-      result = _convert_from_json_object(json_text, json_len, &token, sentinel, depth);
+      if (source)
+        result = _convert_from_json_object_lazily(source, &token);
+      else
+        result = _convert_from_json_object(json_text, json_len, &token, sentinel, depth);
       break;
     case JSMN_ARRAY:
-      result = _convert_from_json_array(json_text, json_len, &token, sentinel, depth);
+      result = _convert_from_json_array(json_text, json_len, &token, sentinel, depth, source);
       break;
     case JSMN_STRING:
       g_assert(token->start <= token->end && token->end < json_len);
@@ -258,16 +301,13 @@ filterx_object_from_jsmn_tokens(const gchar *json_text, gsize json_len, jsmntok_
   return result;
 }
 
-FilterXObject *
-filterx_object_from_json(const gchar *repr, gssize repr_len, GError **error)
+/* tokenizes @repr into the thread local jsmn_tokens array, returns the
+ * number of tokens or -1 on error */
+static gint
+_json_tokenize(const gchar *repr, gssize repr_len, GError **error)
 {
   const gint min_tokens = 256;
 
-  g_return_val_if_fail(error == NULL || (*error) == NULL, NULL);
-
-  if (repr_len < 0)
-    repr_len = strlen(repr);
-
   jsmn_parser parser;
   jsmn_init(&parser);
 
@@ -300,7 +340,7 @@ filterx_object_from_json(const gchar *repr, gssize repr_len, GError **error)
                           "JSON text too large, could not allocate memory for %"
                           G_GINT64_FORMAT " tokens (size %" G_GSSIZE_FORMAT " bytes)",
                           new_tokens_len, repr_len);
-              return NULL;
+              return -1;
             }
           jsmn_tokens = new_tokens;
           jsmn_tokens_len = new_tokens_len;
@@ -357,17 +397,23 @@ filterx_object_from_json(const gchar *repr, gssize repr_len, GError **error)
         default:
           g_assert_not_reached();
         }
-      return NULL;
+      return -1;
     }
 
+  return r;
+}
+
+static FilterXObject *
+_json_convert_tokens(const gchar *repr, gssize repr_len, gint tokens_len, GError **error)
+{
   jsmntok_t *tokens = jsmn_tokens;
-  FilterXObject *res = filterx_object_from_jsmn_tokens(repr, repr_len, &tokens, tokens + r, 0);
+  FilterXObject *res = filterx_object_from_jsmn_tokens(repr, repr_len, &tokens, tokens + tokens_len, 0, NULL);
 
   if (!res)
     {
       g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR, "Invalid JSON, unrecognized token");
     }
-  else if (tokens != jsmn_tokens + r)
+  else if (tokens != jsmn_tokens + tokens_len)
     {
       g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR,
                   "Expected a single JSON object, multiple top-level objects found");
@@ -378,6 +424,315 @@ filterx_object_from_json(const gchar *repr, gssize repr_len, GError **error)
   return res;
 }
 
+FilterXObject *
+filterx_object_from_json(const gchar *repr, gssize repr_len, GError **error)
+{
+  g_return_val_if_fail(error == NULL || (*error) == NULL, NULL);
+
+  if (repr_len < 0)
+    repr_len = strlen(repr);
+
+  gint r = _json_tokenize(repr, repr_len, error);
+  if (r < 0)
+    return NULL;
+
+  return _json_convert_tokens(repr, repr_len, r, error);
+}
+
+static gboolean
+_json_primitive_is_valid(const gchar *json_text, jsmntok_t *token)
+{
+  GenericNumber gn;
+
+  switch (json_text[token->start])
+    {
+    case 't':
+      return strn_eq_strz(&json_text[token->start], "true", token->end - token->start);
+    case 'f':
+      return strn_eq_strz(&json_text[token->start], "false", token->end - token->start);
+    case 'n':
+      return strn_eq_strz(&json_text[token->start], "null", token->end - token->start);
+    default:
+      return _parse_json_number(json_text, token, &gn);
+    }
+}
+
+/* Reject everything the eager conversion would reject, so that a lazily
+ * parsed object fails in parse_json() and not when its members are
+ * accessed later. */
+static gboolean
+_json_validate_tokens(const gchar *repr, jsmntok_t *tokens, gint tokens_len, GError **error)
+{
+  gint container_ends[FILTERX_JSON_MAX_NESTING_DEPTH + 1];
+  gint depth = 0;
+
+  for (gint i = 0; i < tokens_len; i++)
+    {
+      jsmntok_t *token = &tokens[i];
+
+      while (depth > 0 && token->start >= container_ends[depth - 1])
+        depth--;
+
+      if (i > 0 && depth == 0)
+        {
+          g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR,
+                      "Expected a single JSON object, multiple top-level objects found");
+          return FALSE;
+        }
+
+      if (depth > FILTERX_JSON_MAX_NESTING_DEPTH)
+        goto invalid;
+
+      switch (token->type)
+        {
+        case JSMN_OBJECT:
+        case JSMN_ARRAY:
+          container_ends[depth++] = token->end;
+          break;
+        case JSMN_STRING:
+          break;
+        case JSMN_PRIMITIVE:
+          if (!_json_primitive_is_valid(repr, token))
+            goto invalid;
+          break;
+        default:
+          goto invalid;
+        }
+    }
+  return TRUE;
+
+invalid:
+  g_set_error(error, FILTERX_JSON_ERROR, FILTERX_JSON_ERROR_STORE_ERROR, "Invalid JSON, unrecognized token");
+  return FALSE;
+}
+
+static FilterXJSONSource *
+_json_source_new(const gchar *repr, gsize repr_len, jsmntok_t *tokens, gint tokens_len)
+{
+  FilterXJSONSource *self = g_malloc(sizeof(FilterXJSONSource) + tokens_len * sizeof(jsmntok_t));
+
+  g_atomic_counter_set(&self->ref_cnt, 1);
+  self->text = g_strndup(repr, repr_len);
+  self->text_len = repr_len;
+  self->tokens_len = tokens_len;
+  memcpy(self->tokens, tokens, tokens_len * sizeof(jsmntok_t));
+  return self;
+}
+
+/* Same as filterx_object_from_json(), but JSON objects are returned as lazy
+ * dicts, which only convert the members that are accessed. */
+FilterXObject *
+filterx_object_from_json_lazy(const gchar *repr, gssize repr_len, GError **error)
+{
+  g_return_val_if_fail(error == NULL || (*error) == NULL, NULL);
+
+  if (repr_len < 0)
+    repr_len = strlen(repr);
+
+  gint r = _json_tokenize(repr, repr_len, error);
+  if (r < 0)
+    return NULL;
+
+  if (r == 0 || jsmn_tokens[0].type != JSMN_OBJECT)
+    return _json_convert_tokens(repr, repr_len, r, error);
+
+  if (!_json_validate_tokens(repr, jsmn_tokens, r, error))
+    return NULL;
+
+  FilterXJSONSource *source = _json_source_new(repr, repr_len, jsmn_tokens, r);
+  FilterXObject *res = filterx_dict_new_from_json_source(source, 0);
+  filterx_json_source_unref(source);
+
+  filterx_object_cow_prepare(&res);
+  filterx_object_set_dirty(res, FALSE);
+  return res;
+}
+
+FilterXJSONSource *
+filterx_json_source_ref(FilterXJSONSource *self)
+{
+  g_atomic_counter_inc(&self->ref_cnt);
+  return self;
+}
+
+void
+filterx_json_source_unref(FilterXJSONSource *self)
+{
+  if (self && g_atomic_counter_dec_and_test(&self->ref_cnt))
+    {
+      g_free(self->text);
+      g_free(self);
+    }
+}
+
+/* returns the index of the first token after the value at @token_index */
+static gint
+_json_source_skip_value(FilterXJSONSource *self, gint token_index)
+{
+  gint end = self->tokens[token_index].end;
+  gint i = token_index + 1;
+
+  while (i < self->tokens_len && self->tokens[i].start < end)
+    i++;
+  return i;
+}
+
+static gboolean
+_json_source_key_equals(FilterXJSONSource *self, jsmntok_t *token, const gchar *key, gsize key_len)
+{
+  if (token->flags & JSMN_STRING_NO_ESCAPE)
+    return (gsize) (token->end - token->start) == key_len && memcmp(&self->text[token->start], key, key_len) == 0;
+
+  FilterXObject *unescaped = filterx_string_new_from_json_literal(&self->text[token->start], token->end - token->start);
+  if (!unescaped)
+    return FALSE;
+
+  gsize unescaped_len;
+  const gchar *unescaped_str = filterx_string_get_value_ref(unescaped, &unescaped_len);
+  gboolean result = unescaped_len == key_len && memcmp(unescaped_str, key, key_len) == 0;
+  filterx_object_unref(unescaped);
+  return result;
+}
+
+/* returns the token index of the value of @key in the object at
+ * @object_index, or -1 if not found.  If @key is present multiple times,
+ * the last one wins, just like with eager conversion. */
+gint
+filterx_json_source_lookup_member(FilterXJSONSource *self, gint object_index, const gchar *key, gsize key_len)
+{
+  jsmntok_t *object = &self->tokens[object_index];
+  gint value_index = -1;
+
+  g_assert(object->type == JSMN_OBJECT);
+
+  gint i = object_index + 1;
+  for (gint member = 0; member < object->size; member++)
+    {
+      if (_json_source_key_equals(self, &self->tokens[i], key, key_len))
+        value_index = i + 1;
+      i = _json_source_skip_value(self, i + 1);
+    }
+  return value_index;
+}
+
+gboolean
+filterx_json_source_foreach_member(FilterXJSONSource *self, gint object_index, FilterXJSONSourceMemberFunc func,
+                                   gpointer user_data)
+{
+  jsmntok_t *object = &self->tokens[object_index];
+
+  g_assert(object->type == JSMN_OBJECT);
+
+  gint i = object_index + 1;
+  for (gint member = 0; member < object->size; member++)
+    {
+      if (!func(self, i, i + 1, user_data))
+        return FALSE;
+      i = _json_source_skip_value(self, i + 1);
+    }
+  return TRUE;
+}
+
+/* converts the key or value at @token_index, objects within are lazy themselves */
+FilterXObject *
+filterx_json_source_materialize(FilterXJSONSource *self, gint token_index)
+{
+  jsmntok_t *token = &self->tokens[token_index];
+
+  return filterx_object_from_jsmn_tokens(self->text, self->text_len, &token, &self->tokens[self->tokens_len], 0, self);
+}
+
+/* integers that survive a round trip through gint64 without change */
+static gboolean
+_json_number_is_canonical_integer(const gchar *number, gsize len)
+{
+  gboolean negative = number[0] == '-';
+
+  if (negative)
+    {
+      number++;
+      len--;
+    }
+
+  if (len == 0 || len > 18)
+    return FALSE;
+
+  /* no leading zeros, and no "-0" either */
+  if (number[0] == '0' && (len > 1 || negative))
+    return FALSE;
+
+  for (gsize i = 0; i < len; i++)
+    {
+      if (!g_ascii_isdigit(number[i]))
+        return FALSE;
+    }
+  return TRUE;
+}
+
+/* accumulates the length of @token in the output of format_json(), returns
+ * FALSE if format_json() would not reproduce the token as is */
+static gboolean
+_json_token_add_formatted_len(const gchar *json_text, jsmntok_t *token, gsize *formatted_len)
+{
+  gsize len = token->end - token->start;
+
+  switch (token->type)
+    {
+    case JSMN_OBJECT:
+      /* braces, colons and commas */
+      *formatted_len += 2 + token->size + MAX(token->size - 1, 0);
+      return TRUE;
+    case JSMN_ARRAY:
+      *formatted_len += 2 + MAX(token->size - 1, 0);
+      return TRUE;
+    case JSMN_STRING:
+      *formatted_len += len + 2;
+      return !!(token->flags & JSMN_STRING_NO_ESCAPE);
+    case JSMN_PRIMITIVE:
+      *formatted_len += len;
+      if (json_text[token->start] == 't' || json_text[token->start] == 'f' || json_text[token->start] == 'n')
+        return TRUE;
+
+      /* only integers are guaranteed to be formatted the same way */
+      return _json_number_is_canonical_integer(&json_text[token->start], len);
+    default:
+      return FALSE;
+    }
+}
+
+/* Appends the original text of the value at @token_index to @json if it is
+ * exactly what format_json() would produce from its materialized form
+ * (e.g. it is compact and it has no escapes).  Returns FALSE without
+ * touching @json otherwise. */
+gboolean
+filterx_json_source_append_verbatim(FilterXJSONSource *self, gint token_index, GString *json)
+{
+  jsmntok_t *token = &self->tokens[token_index];
+  gint next_index = _json_source_skip_value(self, token_index);
+  gsize formatted_len = 0;
+
+  for (gint i = token_index; i < next_index; i++)
+    {
+      if (!_json_token_add_formatted_len(self->text, &self->tokens[i], &formatted_len))
+        return FALSE;
+    }
+
+  const gchar *raw = &self->text[token->start];
+  gsize raw_len = token->end - token->start;
+  if (token->type == JSMN_STRING)
+    {
+      /* include the quotes */
+      raw--;
+      raw_len += 2;
+    }
+
+  if (formatted_len != raw_len)
+    return FALSE;
+
+  g_string_append_len(json, raw, raw_len);
+  return TRUE;
+}
+
 FilterXObject *
 filterx_parse_json_call(FilterXExpr *s, FilterXObject *args[], gsize args_len)
 {
@@ -395,7 +750,7 @@ filterx_parse_json_call(FilterXExpr *s, FilterXObject *args[], gsize args_len)
       return NULL;
     }
   GError *error = NULL;
-  FilterXObject *res = filterx_object_from_json(repr, repr_len, &error);
+  FilterXObject *res = filterx_object_from_json_lazy(repr, repr_len, &error);
   if (!res)
     {
       filterx_eval_push_error_info_printf("Error parsing JSON string", "%s", error->message);
@@ -39,10 +39,24 @@ enum FilterXJSONError
 #define FILTERX_JSON_ERROR filterx_json_error_quark()
 GQuark filterx_json_error_quark(void);
 
+typedef struct _FilterXJSONSource FilterXJSONSource;
+typedef gboolean (*FilterXJSONSourceMemberFunc)(FilterXJSONSource *source, gint key_index, gint value_index,
+                                                gpointer user_data);
+
 /* C API */
 FilterXObject *filterx_object_from_json(const gchar *repr, gssize repr_len, GError **error);
+FilterXObject *filterx_object_from_json_lazy(const gchar *repr, gssize repr_len, GError **error);
 gboolean filterx_object_to_json(FilterXObject *o, GString *repr);
 
+/* parsed JSON text backing lazy dicts, members are identified by their token index */
+FilterXJSONSource *filterx_json_source_ref(FilterXJSONSource *self);
+void filterx_json_source_unref(FilterXJSONSource *self);
+gint filterx_json_source_lookup_member(FilterXJSONSource *self, gint object_index, const gchar *key, gsize key_len);
+gboolean filterx_json_source_foreach_member(FilterXJSONSource *self, gint object_index,
+                                            FilterXJSONSourceMemberFunc func, gpointer user_data);
+FilterXObject *filterx_json_source_materialize(FilterXJSONSource *self, gint token_index);
+gboolean filterx_json_source_append_verbatim(FilterXJSONSource *self, gint token_index, GString *json);
+
 /* exported filterx functions */
 FilterXObject *filterx_format_json_call(FilterXExpr *s, FilterXObject *args[], gsize args_len);
 FilterXObject *filterx_parse_json_call(FilterXExpr *s, FilterXObject *args[], gsize args_len);
@@ -526,6 +526,20 @@ _table_free(FilterXDictTable *table, gboolean free_entries)
   g_free(table);
 }
 
+/* drop the entries without detaching the values from their container, as
+ * they are still stored in another table of the same dict */
+static void
+_table_release(FilterXDictTable *table)
+{
+  for (gsize i = 0; i < table->entries_num; i++)
+    {
+      FilterXDictEntry *entry = _table_get_entry(table, i);
+      filterx_object_unref(entry->key);
+      filterx_object_unref(entry->value);
+    }
+  g_free(table);
+}
+
 static inline FilterXDictTable *
 _table_resize_if_needed(FilterXDictTable *old_table)
 {
@@ -544,10 +558,128 @@ typedef struct _FilterXDictObject
   {
     FilterXMapping super;
     FilterXDictTable *table;
+    FilterXJSONSource *json_source;
+    gint json_object_index;
   }
   FILTERX_MUTABLE_OBJECT_TAILER;
 } FilterXDictObject;
 
+/*
+ * Lazy dicts
+ *
+ * Dicts created by parse_json() refer to the original JSON text
+ * (json_source) and use their table as a cache of the members looked up so
+ * far.  Lookups are served from the JSON text, every other operation
+ * materializes the complete dict first (keeping the order of the members)
+ * and drops the JSON text.
+ */
+
+static FilterXObject *
+_lazy_lookup(FilterXDictObject *self, FilterXObject *key)
+{
+  const gchar *key_str;
+  gsize key_len;
+
+  if (!filterx_object_extract_string_ref(key, &key_str, &key_len))
+    return NULL;
+
+  gint value_index = filterx_json_source_lookup_member(self->json_source, self->json_object_index, key_str, key_len);
+  if (value_index < 0)
+    return NULL;
+
+  FilterXObject *value = filterx_json_source_materialize(self->json_source, value_index);
+  if (!value)
+    return NULL;
+
+  if (!self->table)
+    self->table = _table_new(FILTERX_DICT_MIN_SIZE);
+
+  self->table = _table_resize_if_needed(self->table);
+  _table_insert(self->table, filterx_object_vref(key), filterx_object_cow_store(&value));
+  filterx_ref_set_orphan(value);
+  return value;
+}
+
+static gboolean
+_lazy_has_key(FilterXDictObject *self, FilterXObject *key)
+{
+  const gchar *key_str;
+  gsize key_len;
+
+  if (!filterx_object_extract_string_ref(key, &key_str, &key_len))
+    return FALSE;
+
+  return filterx_json_source_lookup_member(self->json_source, self->json_object_index, key_str, key_len) >= 0;
+}
+
+static gboolean
+_lazy_materialize_member(FilterXJSONSource *source, gint key_index, gint value_index, gpointer user_data)
+{
+  gpointer *args = (gpointer *) user_data;
+  FilterXDictTable *cache = (FilterXDictTable *) args[0];
+  FilterXDictTable **ptable = (FilterXDictTable **) args[1];
+
+  FilterXObject *key = filterx_json_source_materialize(source, key_index);
+  if (!key)
+    return FALSE;
+
+  FilterXObject *value;
+  FilterXDictEntry *cached = cache ? _table_lookup_entry(cache, key, NULL) : NULL;
+  if (cached)
+    {
+      /* in case of duplicate keys the cached value belongs to the last
+       * occurrence, which is stored at the position of the first one */
+      if (_table_isset(*ptable, key))
+        {
+          filterx_object_unref(key);
+          return TRUE;
+        }
+      value = filterx_object_ref(cached->value);
+    }
+  else
+    {
+      FilterXObject *materialized = filterx_json_source_materialize(source, value_index);
+      if (!materialized)
+        {
+          filterx_object_unref(key);
+          return FALSE;
+        }
+      value = filterx_object_cow_store(&materialized);
+      filterx_ref_set_orphan(value);
+      filterx_object_unref(materialized);
+    }
+
+  *ptable = _table_resize_if_needed(*ptable);
+  _table_insert(*ptable, key, value);
+  return TRUE;
+}
+
+static gboolean
+_lazy_materialize(FilterXDictObject *self)
+{
+  if (!self->json_source)
+    return TRUE;
+
+  FilterXDictTable *table = _table_new(FILTERX_DICT_MIN_SIZE);
+  gpointer args[] = { self->table, &table };
+
+  if (!filterx_json_source_foreach_member(self->json_source, self->json_object_index, _lazy_materialize_member, args))
+    {
+      _table_release(table);
+      filterx_eval_push_error("Failed to convert JSON object to dict", NULL);
+      return FALSE;
+    }
+
+  /* the cached values are now stored in the new table too */
+  if (self->table)
+    _table_release(self->table);
+  self->table = table;
+
+  filterx_json_source_unref(self->json_source);
+  self->json_source = NULL;
+  return TRUE;
+}
+
 static gboolean
 _filterx_dict_truthy(FilterXObject *s)
 {
@@ -587,6 +719,9 @@ _filterx_dict_repr(FilterXObject *s, GString *repr)
   gboolean first = TRUE;
   gpointer args[] = { repr, &first };
 
+  if (!_lazy_materialize(self))
+    return FALSE;
+
   g_string_append_c(repr, '{');
 
   if (self->table)
@@ -611,13 +746,13 @@ _filterx_dict_get_subscript(FilterXObject *s, FilterXObject *key)
       return NULL;
     }
 
-  if (!self->table)
-    return NULL;
-
   FilterXObject *value = NULL;
-  if (!_table_lookup(self->table, key, &value))
-    return NULL;
-  return value;
+  if (self->table && _table_lookup(self->table, key, &value))
+    return value;
+
+  if (self->json_source)
+    return _lazy_lookup(self, key);
+  return NULL;
 }
 
 static gboolean
@@ -632,6 +767,9 @@ _filterx_dict_set_subscript(FilterXObject *s, FilterXObject *key, FilterXObject
       return FALSE;
     }
 
+  if (!_lazy_materialize(self))
+    return FALSE;
+
   if (!self->table)
     self->table = _table_new(FILTERX_DICT_MIN_SIZE);
 
@@ -653,10 +791,10 @@ _filterx_dict_is_key_set(FilterXObject *s, FilterXObject *key)
       return FALSE;
     }
 
-  if (!self->table)
-    return FALSE;
+  if (self->table && _table_isset(self->table, key))
+    return TRUE;
 
-  return _table_isset(self->table, key);
+  return self->json_source && _lazy_has_key(self, key);
 }
 
 static FilterXObject *
@@ -671,10 +809,12 @@ _filterx_dict_is_member_of(FilterXObject *s, FilterXObject *member)
       return FALSE;
     }
 
-  if (!self->table)
+  if (!self->table && !self->json_source)
     return FALSE;
 
-  return filterx_boolean_new(_table_isset(self->table, member));
+  gboolean is_member = (self->table && _table_isset(self->table, member))
+                       || (self->json_source && _lazy_has_key(self, member));
+  return filterx_boolean_new(is_member);
 }
 
 static gboolean
@@ -689,6 +829,9 @@ _filterx_dict_unset_key(FilterXObject *s, FilterXObject *key)
       return FALSE;
     }
 
+  if (!_lazy_materialize(self))
+    return FALSE;
+
   if (!self->table)
     return TRUE;
 
@@ -707,6 +850,9 @@ _filterx_dict_move_key(FilterXObject *s, FilterXObject *key)
       return FALSE;
     }
 
+  if (!_lazy_materialize(self))
+    return NULL;
+
   if (!self->table)
     return NULL;
 
@@ -718,6 +864,9 @@ _filterx_dict_len(FilterXObject *s, guint64 *len)
 {
   FilterXDictObject *self = (FilterXDictObject *) s;
 
+  if (!_lazy_materialize(self))
+    return FALSE;
+
   if (self->table)
     {
       *len = _table_size(self->table);
@@ -742,12 +891,89 @@ _filterx_dict_iter(FilterXObject *s, FilterXObjectIterFunc func, gpointer user_d
 {
   FilterXDictObject *self = (FilterXDictObject *) s;
 
+  if (!_lazy_materialize(self))
+    return FALSE;
+
   if (!self->table)
     return TRUE;
   gpointer args[] = { func, user_data };
   return _table_foreach(self->table, _filterx_dict_foreach_inner, args);
 }
 
+static gboolean
+_format_json_lazy_member(FilterXJSONSource *source, gint key_index, gint value_index, gpointer user_data)
+{
+  gpointer *args = (gpointer *) user_data;
+  FilterXDictObject *self = (FilterXDictObject *) args[0];
+  GString *json = (GString *) args[1];
+  gboolean *first = (gboolean *) args[2];
+  FilterXObject *key = NULL;
+  FilterXObject *value = NULL;
+  gboolean result = FALSE;
+
+  if (!(*first))
+    g_string_append_c(json, ',');
+  else
+    *first = FALSE;
+
+  /* members looked up earlier may have been changed since */
+  if (self->table)
+    {
+      key = filterx_json_source_materialize(source, key_index);
+      if (!key)
+        goto exit;
+      _table_lookup(self->table, key, &value);
+    }
+
+  if (!filterx_json_source_append_verbatim(source, key_index, json))
+    {
+      if (!key)
+        key = filterx_json_source_materialize(source, key_index);
+      if (!key || !filterx_object_format_json_append(key, json))
+        goto exit;
+    }
+  g_string_append_c(json, ':');
+
+  if (!value && filterx_json_source_append_verbatim(source, value_index, json))
+    {
+      result = TRUE;
+      goto exit;
+    }
+
+  if (!value)
+    value = filterx_json_source_materialize(source, value_index);
+  result = value && filterx_object_format_json_append(value, json);
+
+exit:
+  filterx_object_unref(key);
+  filterx_object_unref(value);
+  return result;
+}
+
+static gboolean
+_filterx_dict_format_json(FilterXObject *s, GString *json)
+{
+  FilterXDictObject *self = (FilterXDictObject *) s;
+
+  if (!self->json_source)
+    return FILTERX_TYPE_NAME(mapping).format_json(s, json);
+
+  /* nothing has been looked up yet, reuse the original text if we can */
+  if (!self->table && filterx_json_source_append_verbatim(self->json_source, self->json_object_index, json))
+    return TRUE;
+
+  gboolean first = TRUE;
+  gpointer args[] = { self, json, &first };
+
+  g_string_append_c(json, '{');
+
+  if (!filterx_json_source_foreach_member(self->json_source, self->json_object_index, _format_json_lazy_member, args))
+    return FALSE;
+
+  g_string_append_c(json, '}');
+  return TRUE;
+}
+
 static FilterXObject *
 filterx_dict_new_with_table(FilterXDictTable *table)
 {
@@ -755,6 +981,7 @@ filterx_dict_new_with_table(FilterXDictTable *table)
 
   filterx_mapping_init_instance(&self->super, &FILTERX_TYPE_NAME(dict));
   self->table = table;
+  self->json_source = NULL;
   return &self->super.super;
 }
 
@@ -770,7 +997,15 @@ _filterx_dict_clone_container(FilterXObject *s, FilterXObject *container, Filter
       new_table = _table_new(self->table->size);
       _table_clone(new_table, self->table, container, child_of_interest, dup);
     }
-  return filterx_dict_new_with_table(new_table);
+
+  FilterXDictObject *clone = (FilterXDictObject *) filterx_dict_new_with_table(new_table);
+  if (self->json_source)
+    {
+      /* the JSON text is immutable, the copy can share it */
+      clone->json_source = filterx_json_source_ref(self->json_source);
+      clone->json_object_index = self->json_object_index;
+    }
+  return &clone->super.super;
 }
 
 static FilterXObject *
@@ -794,6 +1029,9 @@ _filterx_dict_dedup(FilterXObject **pself, FilterXObjectDeduplicator *freezer)
 {
   FilterXDictObject *self = (FilterXDictObject *) *pself;
 
+  gboolean ok = _lazy_materialize(self);
+  g_assert(ok);
+
   if (!self->table)
     return;
 
@@ -817,6 +1055,10 @@ _filterx_dict_freeze(FilterXObject *s, FilterXObjectFreezer *freezer)
 
   filterx_object_freezer_keep(freezer, s);
 
+  /* frozen objects are shared between threads, they cannot be materialized on demand */
+  gboolean ok = _lazy_materialize(self);
+  g_assert(ok);
+
   if (!self->table)
     return;
 
@@ -845,6 +1087,22 @@ filterx_dict_set_subscript_by_anchor(FilterXObject *s, FilterXDictAnchor anchor,
   entry->value = filterx_object_cow_store(new_value);
 }
 
+/*
+ * Lookup in the table only: the key must be hashable, members of lazy dicts
+ * not looked up so far are not found.  Returns a borrowed reference.
+ */
+FilterXObject *
+filterx_dict_peek_subscript(FilterXObject *s, FilterXObject *key)
+{
+  FilterXDictObject *self = (FilterXDictObject *) s;
+
+  if (!self->table)
+    return NULL;
+
+  FilterXDictEntry *entry = _table_lookup_entry(self->table, key, NULL);
+  return entry ? entry->value : NULL;
+}
+
 FilterXObject *
 filterx_dict_new(void)
 {
@@ -863,6 +1121,16 @@ filterx_dict_sized_new(gsize init_size)
   return filterx_dict_new_with_table(_table_new(init_size));
 }
 
+FilterXObject *
+filterx_dict_new_from_json_source(FilterXJSONSource *source, gint object_index)
+{
+  FilterXDictObject *self = (FilterXDictObject *) filterx_dict_new_with_table(NULL);
+
+  self->json_source = filterx_json_source_ref(source);
+  self->json_object_index = object_index;
+  return &self->super.super;
+}
+
 static void
 _filterx_dict_free(FilterXObject *s)
 {
@@ -870,6 +1138,7 @@ _filterx_dict_free(FilterXObject *s)
 
   if (self->table)
     _table_free(self->table, TRUE);
+  filterx_json_source_unref(self->json_source);
   filterx_object_free_method(s);
 }
 
@@ -937,6 +1206,7 @@ FILTERX_DEFINE_TYPE(dict, FILTERX_TYPE_NAME(mapping),
                     .free_fn = _filterx_dict_free,
                     .marshal = _filterx_dict_marshal,
                     .repr = _filterx_dict_repr,
+                    .format_json = _filterx_dict_format_json,
                     .clone = _filterx_dict_clone,
                     .clone_container = _filterx_dict_clone_container,
                     .get_subscript = _filterx_dict_get_subscript,
@@ -25,6 +25,7 @@
 #define FILTERX_OBJECT_DICT_H
 
 #include "filterx/filterx-object.h"
+#include "filterx/json-repr.h"
 
 typedef gint32 FilterXDictAnchor;
 
@@ -32,9 +33,11 @@ FILTERX_DECLARE_TYPE(dict);
 
 FilterXObject *filterx_dict_new(void);
 FilterXObject *filterx_dict_sized_new(gsize init_size);
+FilterXObject *filterx_dict_new_from_json_source(FilterXJSONSource *source, gint object_index);
 FilterXObject *filterx_dict_new_from_args(FilterXExpr *s, FilterXObject *args[], gsize args_len);
 
 FilterXDictAnchor filterx_dict_get_anchor_for_key(FilterXObject *s, FilterXObject *key);
 void filterx_dict_set_subscript_by_anchor(FilterXObject *s, FilterXDictAnchor anchor, FilterXObject **new_value);
+FilterXObject *filterx_dict_peek_subscript(FilterXObject *s, FilterXObject *key);
 
 #endif
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/filterx-lib.h"
+
+#include "filterx/jit/jit-cache.h"
+#include "filterx/jit/jit.h"
+#include "filterx/jit/ffi.h"
+#include "apphook.h"
+
+#if SYSLOG_NG_ENABLE_JIT
+
+#include <glib/gstdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+static gchar *cache_dir;
+
+static LLVMModuleRef
+_create_module(const gchar *function_names[])
+{
+  LLVMModuleRef mod = LLVMModuleCreateWithName("test");
+  LLVMTypeRef fn_ty = LLVMFunctionType(LLVMVoidType(), NULL, 0, FALSE);
+
+  for (gint i = 0; function_names[i]; i++)
+    LLVMAddFunction(mod, function_names[i], fn_ty);
+  return mod;
+}
+
+static LLVMMemoryBufferRef
+_object(const gchar *contents)
+{
+  return LLVMCreateMemoryBufferWithMemoryRangeCopy(contents, strlen(contents), "object");
+}
+
+static gchar *
+_object_path(const gchar *key)
+{
+  gchar *filename = g_strconcat(key, ".o", NULL);
+  gchar *path = g_build_filename(cache_dir, filename, NULL);
+  g_free(filename);
+  return path;
+}
+
+static void
+_assert_cached_object(const gchar *key, const gchar *expected)
+{
+  LLVMMemoryBufferRef obj = filterx_jit_cache_load(cache_dir, key);
+
+  cr_assert_not_null(obj, "cached object not found: %s", key);
+  cr_assert_eq(LLVMGetBufferSize(obj), strlen(expected));
+  cr_assert(memcmp(LLVMGetBufferStart(obj), expected, strlen(expected)) == 0);
+  LLVMDisposeMemoryBuffer(obj);
+}
+
+Test(filterx_jit_cache, key_is_stable_and_depends_on_the_module)
+{
+  const gchar *functions[] = { "a", "b", NULL };
+  const gchar *other_functions[] = { "a", "c", NULL };
+  LLVMModuleRef mod1 = _create_module(functions);
+  LLVMModuleRef mod2 = _create_module(functions);
+  LLVMModuleRef mod3 = _create_module(other_functions);
+
+  gchar *key1 = filterx_jit_cache_compute_key(mod1);
+  gchar *key2 = filterx_jit_cache_compute_key(mod2);
+  gchar *key3 = filterx_jit_cache_compute_key(mod3);
+
+  cr_assert_eq(strlen(key1), 64);
+  cr_assert_str_eq(key1, key2);
+  cr_assert_str_neq(key1, key3);
+
+  gchar *key1_again = filterx_jit_cache_compute_key(mod1);
+  cr_assert_str_eq(key1, key1_again);
+
+  g_free(key1_again);
+  g_free(key1);
+  g_free(key2);
+  g_free(key3);
+  LLVMDisposeModule(mod1);
+  LLVMDisposeModule(mod2);
+  LLVMDisposeModule(mod3);
+}
+
+Test(filterx_jit_cache, stored_object_is_loaded_back)
+{
+  cr_assert_null(filterx_jit_cache_load(cache_dir, "key"));
+
+  LLVMMemoryBufferRef obj = _object("object file contents");
+  filterx_jit_cache_store(cache_dir, "key", obj);
+  LLVMDisposeMemoryBuffer(obj);
+
+  _assert_cached_object("key", "object file contents");
+
+  gchar *path = _object_path("key");
+  GStatBuf st;
+  cr_assert(g_stat(path, &st) == 0);
+  cr_assert_eq(st.st_mode & 077, 0, "cached object file is accessible by others: %o", st.st_mode);
+  g_free(path);
+}
+
+Test(filterx_jit_cache, truncated_or_corrupt_object_is_not_loaded)
+{
+  LLVMMemoryBufferRef obj = _object("object file contents");
+  filterx_jit_cache_store(cache_dir, "key", obj);
+
+  gchar *path = _object_path("key");
+  gchar *contents;
+  gsize length;
+  cr_assert(g_file_get_contents(path, &contents, &length, NULL));
+
+  cr_assert(truncate(path, length - 5) == 0);
+  cr_assert_null(filterx_jit_cache_load(cache_dir, "key"));
+  cr_assert_not(g_file_test(path, G_FILE_TEST_EXISTS), "corrupt cached object was not removed");
+
+  filterx_jit_cache_store(cache_dir, "key", obj);
+  contents[length - 1] ^= 0x01;
+  cr_assert(g_file_set_contents(path, contents, length, NULL));
+  cr_assert(chmod(path, 0600) == 0);
+  cr_assert_null(filterx_jit_cache_load(cache_dir, "key"));
+
+  filterx_jit_cache_store(cache_dir, "key", obj);
+  _assert_cached_object("key", "object file contents");
+
+  g_free(contents);
+  g_free(path);
+  LLVMDisposeMemoryBuffer(obj);
+}
+
+Test(filterx_jit_cache, cache_writable_by_others_is_refused)
+{
+  LLVMMemoryBufferRef obj = _object("object file contents");
+  filterx_jit_cache_store(cache_dir, "key", obj);
+  gchar *path = _object_path("key");
+
+  cr_assert(chmod(path, 0622) == 0);
+  cr_assert_null(filterx_jit_cache_load(cache_dir, "key"));
+  cr_assert(chmod(path, 0600) == 0);
+  _assert_cached_object("key", "object file contents");
+
+  cr_assert(chmod(cache_dir, 0777) == 0);
+  cr_assert_null(filterx_jit_cache_load(cache_dir, "key"));
+  filterx_jit_cache_store(cache_dir, "other-key", obj);
+  gchar *other_path = _object_path("other-key");
+  cr_assert_not(g_file_test(other_path, G_FILE_TEST_EXISTS));
+  cr_assert(chmod(cache_dir, 0700) == 0);
+
+  g_free(other_path);
+  g_free(path);
+  LLVMDisposeMemoryBuffer(obj);
+}
+
+Test(filterx_jit_cache, objects_not_used_for_a_long_time_are_evicted)
+{
+  LLVMMemoryBufferRef obj = _object("object file contents");
+  filterx_jit_cache_store(cache_dir, "old", obj);
+  filterx_jit_cache_store(cache_dir, "recent", obj);
+
+  gchar *old_path = _object_path("old");
+  time_t expired = time(NULL) - FILTERX_JIT_CACHE_MAX_AGE - 60;
+  struct utimbuf times = { .actime = expired, .modtime = expired };
+  cr_assert(utime(old_path, &times) == 0);
+
+  filterx_jit_cache_evict(cache_dir);
+
+  cr_assert_not(g_file_test(old_path, G_FILE_TEST_EXISTS));
+  _assert_cached_object("recent", "object file contents");
+
+  g_free(old_path);
+  LLVMDisposeMemoryBuffer(obj);
+}
+
+static void
+_add_block(FilterXJIT *jit, const gchar *block_name, gboolean with_call)
+{
+  filterx_jit_ir_add_new_void_block(jit, block_name, NULL);
+
+  if (with_call)
+    {
+      FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+      FilterXIRType param_tys[] = { ffi->ptr_ty };
+      FilterXIRValue args[] = { LLVMConstNull(ffi->ptr_ty) };
+      fx_jit_emit_extern_call(jit, "g_free", ffi->void_ty, param_tys, args, G_N_ELEMENTS(args));
+    }
+
+  filterx_jit_ir_finish_current_block(jit, NULL);
+}
+
+static void
+_compile_blocks(gboolean b_with_call)
+{
+  GError *error = NULL;
+  FilterXJIT *jit = filterx_jit_new("test", FILTERX_JIT_DEBUG_INFO_FILTERX, &error);
+  cr_assert_not_null(jit, "%s", error ? error->message : "");
+
+  filterx_jit_set_object_cache_dir(jit, cache_dir);
+  _add_block(jit, "a", FALSE);
+  _add_block(jit, "b", b_with_call);
+  cr_assert(filterx_jit_finalize(jit, &error), "%s", error ? error->message : "");
+
+  cr_assert(filterx_jit_lookup(jit, "a", &error), "%s", error ? error->message : "");
+  cr_assert(filterx_jit_lookup(jit, "b", &error), "%s", error ? error->message : "");
+
+  filterx_jit_free(jit);
+}
+
+static guint
+_count_cached_objects(void)
+{
+  GDir *dir = g_dir_open(cache_dir, 0, NULL);
+  const gchar *name;
+  guint count = 0;
+
+  while (dir && (name = g_dir_read_name(dir)))
+    count += g_str_has_suffix(name, ".o");
+  if (dir)
+    g_dir_close(dir);
+  return count;
+}
+
+Test(filterx_jit_cache, every_block_is_cached_on_its_own)
+{
+  _compile_blocks(FALSE);
+  cr_assert_eq(_count_cached_objects(), 2);
+
+  /* the same blocks are loaded from the cache */
+  _compile_blocks(FALSE);
+  cr_assert_eq(_count_cached_objects(), 2);
+
+  /* only the changed block is compiled again */
+  _compile_blocks(TRUE);
+  cr_assert_eq(_count_cached_objects(), 3);
+}
+
+static void
+_remove_cache_dir(void)
+{
+  GDir *dir = g_dir_open(cache_dir, 0, NULL);
+  const gchar *name;
+
+  while (dir && (name = g_dir_read_name(dir)))
+    {
+      gchar *path = g_build_filename(cache_dir, name, NULL);
+      g_unlink(path);
+      g_free(path);
+    }
+  if (dir)
+    g_dir_close(dir);
+  g_rmdir(cache_dir);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  init_libtest_filterx();
+  cache_dir = g_dir_make_tmp("filterx-jit-cache-XXXXXX", NULL);
+  cr_assert_not_null(cache_dir);
+}
+
+static void
+teardown(void)
+{
+  _remove_cache_dir();
+  g_free(cache_dir);
+  deinit_libtest_filterx();
+  app_shutdown();
+}
+
+TestSuite(filterx_jit_cache, .init = setup, .fini = teardown);
+
+#endif
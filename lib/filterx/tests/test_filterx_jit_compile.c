@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/filterx-lib.h"
+
+#include "filterx/expr-get-subscript.h"
+#include "filterx/expr-set-subscript.h"
+#include "filterx/expr-isset.h"
+#include "filterx/expr-membership.h"
+#include "filterx/expr-literal.h"
+#include "filterx/expr-literal-container.h"
+#include "filterx/object-string.h"
+#include "filterx/object-primitive.h"
+#include "filterx/object-list.h"
+#include "filterx/jit/jit.h"
+#include "apphook.h"
+
+#if SYSLOG_NG_ENABLE_JIT
+
+/*
+ * These tests check which code is emitted for an expression: the native
+ * paths call their specialized helpers and evaluate only the operands that
+ * cannot be compiled, never the expression itself.
+ */
+
+static FilterXJIT *jit;
+static GHashTable *calls;
+
+static void
+_collect_calls(FilterXIRValue fn)
+{
+  for (FilterXIRSequence seq = LLVMGetFirstBasicBlock(fn); seq; seq = LLVMGetNextBasicBlock(seq))
+    {
+      for (LLVMValueRef inst = LLVMGetFirstInstruction(seq); inst; inst = LLVMGetNextInstruction(inst))
+        {
+          if (!LLVMIsACallInst(inst))
+            continue;
+
+          const gchar *name = LLVMGetValueName(LLVMGetCalledValue(inst));
+          guint count = GPOINTER_TO_UINT(g_hash_table_lookup(calls, name));
+          g_hash_table_insert(calls, g_strdup(name), GUINT_TO_POINTER(count + 1));
+        }
+    }
+}
+
+static void
+_compile(FilterXExpr *expr)
+{
+  filterx_jit_ir_add_new_block(jit, "test", NULL);
+  FilterXIRValue result = filterx_expr_compile(expr, jit);
+
+  _collect_calls(filterx_jit_ir_get_current_block(jit));
+  /* verifies the emitted code */
+  filterx_jit_ir_finish_current_block(jit, result);
+  filterx_expr_unref(expr);
+}
+
+static guint
+_count_calls(const gchar *name)
+{
+  return GPOINTER_TO_UINT(g_hash_table_lookup(calls, name));
+}
+
+static guint
+_count_evals(void)
+{
+  return _count_calls("fx_jit_expr_eval") + _count_calls("fx_jit_expr_eval_typed");
+}
+
+static FilterXExpr *
+_string_literal(const gchar *str)
+{
+  return filterx_literal_new(filterx_string_new(str, -1));
+}
+
+static FilterXExpr *
+_string_non_literal(const gchar *str)
+{
+  return filterx_object_expr_new(filterx_string_new(str, -1));
+}
+
+Test(filterx_jit_compile, get_subscript_with_string_literal_key)
+{
+  _compile(filterx_get_subscript_new(filterx_object_expr_new(filterx_test_dict_new()), _string_literal("key")));
+
+  cr_assert_eq(_count_calls("fx_jit_get_subscript_string_key"), 1);
+  cr_assert_eq(_count_calls("fx_jit_object_get_subscript"), 0);
+  /* the operand only */
+  cr_assert_eq(_count_evals(), 1);
+}
+
+Test(filterx_jit_compile, get_subscript_with_integer_literal_key)
+{
+  _compile(filterx_get_subscript_new(filterx_object_expr_new(filterx_test_list_new()),
+                                     filterx_literal_new(filterx_integer_new(-1))));
+
+  cr_assert_eq(_count_calls("fx_jit_get_subscript_integer_key"), 1);
+  cr_assert_eq(_count_calls("fx_jit_object_get_subscript"), 0);
+  cr_assert_eq(_count_evals(), 1);
+}
+
+Test(filterx_jit_compile, get_subscript_with_evaluated_key)
+{
+  _compile(filterx_get_subscript_new(filterx_object_expr_new(filterx_test_dict_new()), _string_non_literal("key")));
+
+  cr_assert_eq(_count_calls("fx_jit_object_get_subscript"), 1);
+  cr_assert_eq(_count_evals(), 2);
+}
+
+Test(filterx_jit_compile, set_subscript_with_literal_key)
+{
+  _compile(filterx_set_subscript_new(filterx_object_expr_new(filterx_test_dict_new()), _string_literal("key"),
+                                     _string_non_literal("value")));
+
+  cr_assert_eq(_count_calls("fx_jit_object_set_subscript"), 1);
+  /* the object and the new value, the key is a constant */
+  cr_assert_eq(_count_evals(), 2);
+}
+
+Test(filterx_jit_compile, nullv_set_subscript_with_literal_key)
+{
+  _compile(filterx_nullv_set_subscript_new(filterx_object_expr_new(filterx_test_dict_new()), _string_literal("key"),
+                                           _string_non_literal("value")));
+
+  cr_assert_eq(_count_calls("fx_jit_object_set_subscript"), 1);
+  cr_assert_eq(_count_calls("fx_jit_object_extract_null"), 1);
+  cr_assert_eq(_count_evals(), 2);
+}
+
+Test(filterx_jit_compile, isset_of_subscript_is_compiled_inline)
+{
+  FilterXExpr *subscript = filterx_get_subscript_new(filterx_object_expr_new(filterx_test_dict_new()),
+                                                     _string_literal("key"));
+  _compile(filterx_isset_new(subscript));
+
+  cr_assert_eq(_count_calls("fx_jit_is_key_set_string_key"), 1);
+  cr_assert_eq(_count_calls("fx_jit_expr_is_set"), 0);
+  cr_assert_eq(_count_evals(), 1);
+}
+
+Test(filterx_jit_compile, in_literal_list_of_strings)
+{
+  FilterXExpr *list = filterx_literal_new(filterx_list_new_from_syslog_ng_list("foo,bar,baz", -1));
+  _compile(filterx_membership_in_new(_string_non_literal("bar"), list));
+
+  cr_assert_eq(_count_calls("fx_jit_is_member_of_string_list"), 1);
+  cr_assert_eq(_count_calls("fx_jit_object_is_member_of"), 0);
+  cr_assert_eq(_count_evals(), 1);
+}
+
+Test(filterx_jit_compile, in_evaluated_container)
+{
+  _compile(filterx_membership_in_new(_string_literal("bar"), filterx_object_expr_new(filterx_test_list_new())));
+
+  cr_assert_eq(_count_calls("fx_jit_object_is_member_of"), 1);
+  cr_assert_eq(_count_evals(), 1);
+}
+
+Test(filterx_jit_compile, literal_dict_is_constructed_inline)
+{
+  GList *elements = NULL;
+  elements = g_list_append(elements, filterx_literal_element_new(_string_literal("literal"), _string_literal("a")));
+  elements = g_list_append(elements, filterx_literal_element_new(_string_literal("evaluated"),
+                                                                 _string_non_literal("b")));
+  FilterXExpr *dict = filterx_literal_dict_new(elements);
+  _compile(dict);
+
+  cr_assert_eq(_count_calls("fx_jit_literal_dict_new"), 1);
+  cr_assert_eq(_count_calls("fx_jit_literal_dict_store_elem"), 2);
+  /* the non-literal value only */
+  cr_assert_eq(_count_evals(), 1);
+}
+
+Test(filterx_jit_compile, literal_list_is_constructed_inline)
+{
+  GList *elements = NULL;
+  elements = g_list_append(elements, filterx_literal_element_new(NULL, _string_literal("a")));
+  elements = g_list_append(elements, filterx_literal_element_new(NULL, _string_non_literal("b")));
+  FilterXExpr *list = filterx_literal_list_new(elements);
+  _compile(list);
+
+  cr_assert_eq(_count_calls("fx_jit_literal_list_new"), 1);
+  cr_assert_eq(_count_calls("fx_jit_literal_list_append_value"), 2);
+  cr_assert_eq(_count_evals(), 1);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  init_libtest_filterx();
+
+  GError *error = NULL;
+  jit = filterx_jit_new("test", FILTERX_JIT_DEBUG_INFO_FILTERX, &error);
+  cr_assert_not_null(jit, "%s", error ? error->message : "");
+  calls = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static void
+teardown(void)
+{
+  g_hash_table_unref(calls);
+  filterx_jit_free(jit);
+  deinit_libtest_filterx();
+  app_shutdown();
+}
+
+TestSuite(filterx_jit_compile, .init = setup, .fini = teardown);
+
+#endif
@@ -25,6 +25,9 @@
 
 #include "filterx/json-repr.h"
 #include "filterx/filterx-object.h"
+#include "filterx/object-dict.h"
+#include "filterx/object-string.h"
+#include "filterx/object-primitive.h"
 
 #include "apphook.h"
 #include "scratch-buffers.h"
@@ -79,6 +82,185 @@ Test(filterx_json_repr, array_exceeding_legacy_max_tokens_is_parsed_successfully
   g_string_free(large, TRUE);
 }
 
+static FilterXObject *
+_parse_lazily(const gchar *json)
+{
+  GError *error = NULL;
+  FilterXObject *obj = filterx_object_from_json_lazy(json, -1, &error);
+
+  cr_assert_null(error, "%s", error ? error->message : "");
+  cr_assert(filterx_object_is_type_or_ref(obj, &FILTERX_TYPE_NAME(dict)));
+  return obj;
+}
+
+Test(filterx_json_repr, lazy_object_looks_up_members_from_the_json_text)
+{
+  FilterXObject *obj = _parse_lazily("{\"a\":1,\"b\":{\"c\":\"d\"},\"a\":2,\"e\\u0041\":3}");
+
+  FilterXObject *key = filterx_string_new("a", -1);
+  FilterXObject *value = filterx_object_get_subscript(obj, key);
+  assert_object_json_equals(value, "2");
+  cr_assert(filterx_object_is_key_set(obj, key));
+  filterx_object_unref(value);
+  filterx_object_unref(key);
+
+  key = filterx_string_new("eA", -1);
+  value = filterx_object_get_subscript(obj, key);
+  assert_object_json_equals(value, "3");
+  filterx_object_unref(value);
+  filterx_object_unref(key);
+
+  key = filterx_string_new("b", -1);
+  value = filterx_object_get_subscript(obj, key);
+  cr_assert(filterx_object_is_type_or_ref(value, &FILTERX_TYPE_NAME(dict)));
+  assert_object_json_equals(value, "{\"c\":\"d\"}");
+  filterx_object_unref(value);
+  filterx_object_unref(key);
+
+  key = filterx_string_new("x", -1);
+  cr_assert_null(filterx_object_get_subscript(obj, key));
+  cr_assert_not(filterx_object_is_key_set(obj, key));
+  filterx_object_unref(key);
+
+  filterx_object_unref(obj);
+}
+
+Test(filterx_json_repr, lazy_object_is_materialized_in_the_original_order)
+{
+  FilterXObject *obj = _parse_lazily("{\"a\":1,\"b\":true,\"a\":2,\"c\":null}");
+
+  FilterXObject *key = filterx_string_new("c", -1);
+  FilterXObject *value = filterx_object_get_subscript(obj, key);
+  filterx_object_unref(value);
+  filterx_object_unref(key);
+
+  guint64 len;
+  cr_assert(filterx_object_len(obj, &len));
+  cr_assert_eq(len, 3);
+  assert_object_json_equals(obj, "{\"a\":2,\"b\":true,\"c\":null}");
+
+  filterx_object_unref(obj);
+}
+
+Test(filterx_json_repr, lazy_object_is_formatted_from_the_original_text_if_unchanged)
+{
+  const gchar *compact = "{\"a\":1,\"b\":[\"x\",false,{\"c\":-42}],\"d\":{}}";
+  FilterXObject *obj = _parse_lazily(compact);
+  assert_object_json_equals(obj, compact);
+  filterx_object_unref(obj);
+
+  obj = _parse_lazily("{ \"a\" : 1.50, \"b\\/\": [ \"x\\n\" ] }");
+  assert_object_json_equals(obj, "{\"a\":1.5,\"b/\":[\"x\\n\"]}");
+  filterx_object_unref(obj);
+}
+
+Test(filterx_json_repr, lazy_object_is_formatted_with_its_changes)
+{
+  FilterXObject *obj = _parse_lazily("{\"a\":1,\"b\":{\"c\":\"d\"}}");
+
+  FilterXObject *key = filterx_string_new("b", -1);
+  FilterXObject *nested = filterx_object_get_subscript(obj, key);
+  filterx_object_unref(key);
+
+  key = filterx_string_new("c", -1);
+  FilterXObject *value = filterx_string_new("e", -1);
+  cr_assert(filterx_object_set_subscript(nested, key, &value));
+  filterx_object_unref(value);
+  filterx_object_unref(key);
+  filterx_object_unref(nested);
+
+  assert_object_json_equals(obj, "{\"a\":1,\"b\":{\"c\":\"e\"}}");
+
+  key = filterx_string_new("f", -1);
+  value = filterx_integer_new(5);
+  cr_assert(filterx_object_set_subscript(obj, key, &value));
+  filterx_object_unref(value);
+  filterx_object_unref(key);
+
+  assert_object_json_equals(obj, "{\"a\":1,\"b\":{\"c\":\"e\"},\"f\":5}");
+  filterx_object_unref(obj);
+}
+
+static void
+_set_string_member(FilterXObject *obj, const gchar *name, const gchar *str)
+{
+  FilterXObject *key = filterx_string_new(name, -1);
+  FilterXObject *value = filterx_string_new(str, -1);
+  cr_assert(filterx_object_set_subscript(obj, key, &value));
+  filterx_object_unref(value);
+  filterx_object_unref(key);
+}
+
+static FilterXObject *
+_get_member(FilterXObject *obj, const gchar *name)
+{
+  FilterXObject *key = filterx_string_new(name, -1);
+  FilterXObject *value = filterx_object_get_subscript(obj, key);
+  filterx_object_unref(key);
+  cr_assert_not_null(value);
+  return value;
+}
+
+Test(filterx_json_repr, lazy_object_shared_between_copies_is_copied_on_nested_write)
+{
+  FilterXObject *obj = _parse_lazily("{\"a\":1,\"b\":{\"c\":\"d\"},\"l\":[{\"x\":\"y\"}]}");
+  FilterXObject *copy = filterx_object_copy(obj);
+
+  FilterXObject *nested = _get_member(copy, "b");
+  _set_string_member(nested, "c", "e");
+  filterx_object_unref(nested);
+
+  assert_object_json_equals(obj, "{\"a\":1,\"b\":{\"c\":\"d\"},\"l\":[{\"x\":\"y\"}]}");
+  assert_object_json_equals(copy, "{\"a\":1,\"b\":{\"c\":\"e\"},\"l\":[{\"x\":\"y\"}]}");
+
+  FilterXObject *list = _get_member(obj, "l");
+  FilterXObject *index = filterx_integer_new(0);
+  FilterXObject *element = filterx_object_get_subscript(list, index);
+  cr_assert_not_null(element);
+  _set_string_member(element, "x", "z");
+  filterx_object_unref(element);
+  filterx_object_unref(index);
+  filterx_object_unref(list);
+
+  assert_object_json_equals(obj, "{\"a\":1,\"b\":{\"c\":\"d\"},\"l\":[{\"x\":\"z\"}]}");
+  assert_object_json_equals(copy, "{\"a\":1,\"b\":{\"c\":\"e\"},\"l\":[{\"x\":\"y\"}]}");
+
+  filterx_object_unref(copy);
+  filterx_object_unref(obj);
+}
+
+Test(filterx_json_repr, only_lazily_materialized_members_are_adopted)
+{
+  FilterXObject *obj = _parse_lazily("{\"b\":{\"c\":\"d\"}}");
+  FilterXObject *nested = _get_member(obj, "b");
+
+  cr_assert(filterx_object_is_ref(nested));
+  cr_assert(filterx_weakref_is_set_to(&((FilterXRef *) nested)->parent_container, obj));
+  cr_assert_not(nested->flags & FILTERX_REF_FLAG_ORPHAN);
+  filterx_object_unref(nested);
+
+  FilterXObject *eager = filterx_object_from_json("{\"b\":{\"c\":\"d\"}}", -1, NULL);
+  nested = _get_member(eager, "b");
+  cr_assert_not(nested->flags & FILTERX_REF_FLAG_ORPHAN);
+  filterx_object_unref(nested);
+
+  filterx_object_unref(eager);
+  filterx_object_unref(obj);
+}
+
+Test(filterx_json_repr, lazy_parsing_rejects_what_eager_parsing_rejects)
+{
+  GError *error = NULL;
+
+  cr_assert_null(filterx_object_from_json_lazy("{\"a\":tru}", -1, &error));
+  cr_assert_not_null(error);
+  g_clear_error(&error);
+
+  cr_assert_null(filterx_object_from_json_lazy("{\"a\":1} {\"b\":2}", -1, &error));
+  cr_assert_not_null(error);
+  g_clear_error(&error);
+}
+
 static void
 setup(void)
 {
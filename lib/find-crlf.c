@@ -23,26 +23,45 @@
 #include "find-crlf.h"
 
 #include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define FIND_CRLF_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Line terminators are located using SIMD kernels where available (SSE2 is
+ * always there on x86_64, AVX2 is detected at runtime), with a portable
+ * word-at-a-time implementation as a fallback.  The kernels look for NUL
+ * and up to two other characters (c1 and c2).
+ */
+
+typedef const gchar *(*FindCRLFKernel)(const gchar *s, gsize n, gchar c1, gchar c2);
+typedef void (*ReplaceCRLFKernel)(gchar *s, gsize n, gchar c1, gchar c2, gchar replacement);
+
+static inline gboolean
+_is_terminator(gchar c, gchar c1, gchar c2)
+{
+  return c == c1 || c == c2 || c == 0;
+}
+
 /**
- * This is an optimized version of finding either a CR or LF or NUL
- * character in a buffer.  It is used to find these line terminators in
- * syslog traffic.
+ * This is an optimized version of finding either c1, c2 or a NUL character
+ * in a buffer.
  *
  * It uses an algorithm very similar to what there's in libc memchr/strchr.
  **/
-const gchar *
-find_cr_or_lf_or_nul(const gchar *s, gsize n)
+static const gchar *
+_find_scalar(const gchar *s, gsize n, gchar c1, gchar c2)
 {
   const gchar *char_ptr;
   gulong *longword_ptr;
-  gulong longword, magic_bits, cr_charmask, lf_charmask;
-  const char CR = '\r';
-  const char LF = '\n';
+  gulong longword, magic_bits, c1_charmask, c2_charmask;
 
   /* align input to long boundary */
   for (char_ptr = s; n > 0 && ((gulong) char_ptr & (sizeof(longword) - 1)) != 0; ++char_ptr, n--)
     {
-      if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
+      if (_is_terminator(*char_ptr, c1, c2))
         return char_ptr;
     }
 
@@ -55,15 +74,15 @@ find_cr_or_lf_or_nul(const gchar *s, gsize n)
 #else
 #error "unknown architecture"
 #endif
-  memset(&cr_charmask, CR, sizeof(cr_charmask));
-  memset(&lf_charmask, LF, sizeof(lf_charmask));
+  memset(&c1_charmask, c1, sizeof(c1_charmask));
+  memset(&c2_charmask, c2, sizeof(c2_charmask));
 
   while (n > sizeof(longword))
     {
       longword = *longword_ptr++;
       if ((((longword + magic_bits) ^ ~longword) & ~magic_bits) != 0 ||
-          ((((longword ^ cr_charmask) + magic_bits) ^ ~(longword ^ cr_charmask)) & ~magic_bits) != 0 ||
-          ((((longword ^ lf_charmask) + magic_bits) ^ ~(longword ^ lf_charmask)) & ~magic_bits) != 0)
+          ((((longword ^ c1_charmask) + magic_bits) ^ ~(longword ^ c1_charmask)) & ~magic_bits) != 0 ||
+          ((((longword ^ c2_charmask) + magic_bits) ^ ~(longword ^ c2_charmask)) & ~magic_bits) != 0)
         {
           gint i;
 
@@ -71,7 +90,7 @@ find_cr_or_lf_or_nul(const gchar *s, gsize n)
 
           for (i = 0; i < sizeof(longword); i++)
             {
-              if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
+              if (_is_terminator(*char_ptr, c1, c2))
                 return char_ptr;
               char_ptr++;
             }
@@ -83,10 +102,267 @@ find_cr_or_lf_or_nul(const gchar *s, gsize n)
 
   while (n-- > 0)
     {
-      if (*char_ptr == CR || *char_ptr == LF || *char_ptr == 0)
+      if (_is_terminator(*char_ptr, c1, c2))
         return char_ptr;
       ++char_ptr;
     }
 
   return NULL;
 }
+
+static void
+_replace_scalar(gchar *s, gsize n, gchar c1, gchar c2, gchar replacement)
+{
+  gchar *end = s + n;
+
+  while ((s = (gchar *) _find_scalar(s, end - s, c1, c2)))
+    {
+      *s = replacement;
+      s++;
+    }
+}
+
+#if FIND_CRLF_X86_SIMD
+
+static inline const gchar *
+_find_bytewise(const gchar *s, gsize n, gchar c1, gchar c2)
+{
+  for (; n > 0; s++, n--)
+    {
+      if (_is_terminator(*s, c1, c2))
+        return s;
+    }
+  return NULL;
+}
+
+static inline void
+_replace_bytewise(gchar *s, gsize n, gchar c1, gchar c2, gchar replacement)
+{
+  for (; n > 0; s++, n--)
+    {
+      if (_is_terminator(*s, c1, c2))
+        *s = replacement;
+    }
+}
+
+static inline __m128i
+_sse2_match(__m128i chunk, __m128i v1, __m128i v2)
+{
+  return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1), _mm_cmpeq_epi8(chunk, v2)),
+                      _mm_cmpeq_epi8(chunk, _mm_setzero_si128()));
+}
+
+static const gchar *
+_find_sse2(const gchar *s, gsize n, gchar c1, gchar c2)
+{
+  const __m128i v1 = _mm_set1_epi8(c1);
+  const __m128i v2 = _mm_set1_epi8(c2);
+
+  for (; n >= sizeof(__m128i); s += sizeof(__m128i), n -= sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) s);
+      guint mask = _mm_movemask_epi8(_sse2_match(chunk, v1, v2));
+
+      if (mask)
+        return s + __builtin_ctz(mask);
+    }
+  return _find_bytewise(s, n, c1, c2);
+}
+
+static void
+_replace_sse2(gchar *s, gsize n, gchar c1, gchar c2, gchar replacement)
+{
+  const __m128i v1 = _mm_set1_epi8(c1);
+  const __m128i v2 = _mm_set1_epi8(c2);
+  const __m128i replacements = _mm_set1_epi8(replacement);
+
+  for (; n >= sizeof(__m128i); s += sizeof(__m128i), n -= sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) s);
+      __m128i match = _sse2_match(chunk, v1, v2);
+
+      /* only write back chunks that have changed */
+      if (_mm_movemask_epi8(match))
+        _mm_storeu_si128((__m128i *) s,
+                         _mm_or_si128(_mm_andnot_si128(match, chunk), _mm_and_si128(match, replacements)));
+    }
+  _replace_bytewise(s, n, c1, c2, replacement);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i
+_avx2_match(__m256i chunk, __m256i v1, __m256i v2)
+{
+  return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, v1), _mm256_cmpeq_epi8(chunk, v2)),
+                         _mm256_cmpeq_epi8(chunk, _mm256_setzero_si256()));
+}
+
+__attribute__((target("avx2")))
+static const gchar *
+_find_avx2(const gchar *s, gsize n, gchar c1, gchar c2)
+{
+  const __m256i v1 = _mm256_set1_epi8(c1);
+  const __m256i v2 = _mm256_set1_epi8(c2);
+
+  for (; n >= sizeof(__m256i); s += sizeof(__m256i), n -= sizeof(__m256i))
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) s);
+      guint32 mask = (guint32) _mm256_movemask_epi8(_avx2_match(chunk, v1, v2));
+
+      if (mask)
+        return s + __builtin_ctz(mask);
+    }
+  return _find_sse2(s, n, c1, c2);
+}
+
+__attribute__((target("avx2")))
+static void
+_replace_avx2(gchar *s, gsize n, gchar c1, gchar c2, gchar replacement)
+{
+  const __m256i v1 = _mm256_set1_epi8(c1);
+  const __m256i v2 = _mm256_set1_epi8(c2);
+  const __m256i replacements = _mm256_set1_epi8(replacement);
+
+  for (; n >= sizeof(__m256i); s += sizeof(__m256i), n -= sizeof(__m256i))
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) s);
+      __m256i match = _avx2_match(chunk, v1, v2);
+
+      if (_mm256_movemask_epi8(match))
+        _mm256_storeu_si256((__m256i *) s, _mm256_blendv_epi8(chunk, replacements, match));
+    }
+  _replace_sse2(s, n, c1, c2, replacement);
+}
+
+static gboolean
+_cpu_supports_avx2(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+static FindCRLFKernel find_kernel;
+static ReplaceCRLFKernel replace_kernel;
+
+static FindCRLFKernelType
+_detect_kernel(void)
+{
+#if FIND_CRLF_X86_SIMD
+  if (_cpu_supports_avx2())
+    return FIND_CRLF_KERNEL_AVX2;
+  return FIND_CRLF_KERNEL_SSE2;
+#else
+  return FIND_CRLF_KERNEL_SCALAR;
+#endif
+}
+
+static gboolean
+_lookup_kernels(FindCRLFKernelType type, FindCRLFKernel *find, ReplaceCRLFKernel *replace)
+{
+  switch (type)
+    {
+    case FIND_CRLF_KERNEL_SCALAR:
+      *find = _find_scalar;
+      *replace = _replace_scalar;
+      return TRUE;
+#if FIND_CRLF_X86_SIMD
+    case FIND_CRLF_KERNEL_SSE2:
+      *find = _find_sse2;
+      *replace = _replace_sse2;
+      return TRUE;
+    case FIND_CRLF_KERNEL_AVX2:
+      if (!_cpu_supports_avx2())
+        return FALSE;
+      *find = _find_avx2;
+      *replace = _replace_avx2;
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+    }
+}
+
+/*
+ * The kernels are normally selected by the CPU features on first use,
+ * FIND_CRLF_KERNEL_AUTO.  The unit tests override this to exercise all
+ * kernels available on the host.  Returns FALSE if the kernel is not
+ * available.
+ */
+gboolean
+find_crlf_set_kernel(FindCRLFKernelType type)
+{
+  FindCRLFKernel selected_find;
+  ReplaceCRLFKernel selected_replace;
+
+  if (type == FIND_CRLF_KERNEL_AUTO)
+    type = _detect_kernel();
+
+  if (!_lookup_kernels(type, &selected_find, &selected_replace))
+    return FALSE;
+
+  /* concurrent callers may select the kernels at the same time, they all end up with the same result */
+  g_atomic_pointer_set(&replace_kernel, selected_replace);
+  g_atomic_pointer_set(&find_kernel, selected_find);
+  return TRUE;
+}
+
+static void
+_select_kernels(void)
+{
+  find_crlf_set_kernel(FIND_CRLF_KERNEL_AUTO);
+}
+
+static inline FindCRLFKernel
+_get_find_kernel(void)
+{
+  FindCRLFKernel kernel = g_atomic_pointer_get(&find_kernel);
+
+  if (G_UNLIKELY(!kernel))
+    {
+      _select_kernels();
+      kernel = g_atomic_pointer_get(&find_kernel);
+    }
+  return kernel;
+}
+
+static inline ReplaceCRLFKernel
+_get_replace_kernel(void)
+{
+  ReplaceCRLFKernel kernel = g_atomic_pointer_get(&replace_kernel);
+
+  if (G_UNLIKELY(!kernel))
+    {
+      _select_kernels();
+      kernel = g_atomic_pointer_get(&replace_kernel);
+    }
+  return kernel;
+}
+
+/**
+ * Find either a CR or LF or NUL character in a buffer.  It is used to find
+ * these line terminators in syslog traffic.
+ **/
+const gchar *
+find_cr_or_lf_or_nul(const gchar *s, gsize n)
+{
+  return _get_find_kernel()(s, n, '\r', '\n');
+}
+
+/**
+ * Find either an LF or NUL character in a buffer, this is the end of a
+ * message in newline separated streams.
+ **/
+const gchar *
+find_lf_or_nul(const gchar *s, gsize n)
+{
+  return _get_find_kernel()(s, n, '\n', '\n');
+}
+
+/* replace all CR, LF and NUL characters in the buffer with @replacement */
+void
+replace_cr_or_lf_or_nul(gchar *s, gsize n, gchar replacement)
+{
+  _get_replace_kernel()(s, n, '\r', '\n', replacement);
+}
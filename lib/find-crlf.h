@@ -26,5 +26,18 @@
 #include "syslog-ng.h"
 
 const gchar *find_cr_or_lf_or_nul(const gchar *s, gsize n);
+const gchar *find_lf_or_nul(const gchar *s, gsize n);
+void replace_cr_or_lf_or_nul(gchar *s, gsize n, gchar replacement);
+
+typedef enum
+{
+  FIND_CRLF_KERNEL_AUTO = 0,
+  FIND_CRLF_KERNEL_SCALAR,
+  FIND_CRLF_KERNEL_SSE2,
+  FIND_CRLF_KERNEL_AVX2,
+} FindCRLFKernelType;
+
+/* for the unit tests, the kernel is selected automatically otherwise */
+gboolean find_crlf_set_kernel(FindCRLFKernelType type);
 
 #endif
@@ -323,6 +323,25 @@ resolve_address_using_gethostbyaddr(GSockAddr *saddr, gchar *buf, gsize buf_len)
 
 #endif
 
+static const gchar *
+resolve_address_using_system_resolver(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+#ifdef SYSLOG_NG_HAVE_GETNAMEINFO
+  return resolve_address_using_getnameinfo(saddr, buf, buf_len);
+#else
+  return resolve_address_using_gethostbyaddr(saddr, buf, buf_len);
+#endif
+}
+
+static HostResolveReverseLookupFunc reverse_lookup_func = resolve_address_using_system_resolver;
+
+/* replaces the function used for reverse lookups, NULL restores the system resolver, used by tests */
+void
+host_resolve_set_reverse_lookup_func(HostResolveReverseLookupFunc func)
+{
+  reverse_lookup_func = func ? : resolve_address_using_system_resolver;
+}
+
 static void *
 sockaddr_to_dnscache_key(GSockAddr *saddr)
 {
@@ -340,6 +359,124 @@ sockaddr_to_dnscache_key(GSockAddr *saddr)
     }
 }
 
+/****************************************************************************
+ * Background reverse lookups, used by use-dns(async)
+ *
+ * Lookups are performed by a small pool of dedicated threads, so that
+ * slow DNS servers do not stall the threads processing messages.  The
+ * results are stored in the DNS cache, which also deduplicates the lookups
+ * in flight and notifies the parties waiting for them.
+ ****************************************************************************/
+
+#define HOST_RESOLVE_BACKGROUND_THREADS 4
+
+static GMutex background_lock;
+static GAsyncQueue *background_requests;
+static GThread *background_threads[HOST_RESOLVE_BACKGROUND_THREADS];
+static gboolean background_lookups_stopping;
+
+/* pushed to the request queue to stop a resolver thread */
+static GSockAddr background_stop_request;
+
+static gpointer
+_background_resolver_thread(gpointer user_data)
+{
+  GAsyncQueue *requests = (GAsyncQueue *) user_data;
+  GSockAddr *saddr;
+
+  iv_init();
+  app_thread_start();
+  while ((saddr = g_async_queue_pop(requests)) != &background_stop_request)
+    {
+      gchar buf[256];
+      const gchar *hname;
+      gboolean positive;
+
+      hname = reverse_lookup_func(saddr, buf, sizeof(buf));
+      positive = (hname != NULL);
+      if (!hname)
+        hname = g_sockaddr_format(saddr, buf, sizeof(buf), GSA_ADDRESS_ONLY);
+
+      dns_caching_store_and_notify(saddr->sa.sa_family, sockaddr_to_dnscache_key(saddr), hname, positive);
+      g_sockaddr_unref(saddr);
+    }
+  app_thread_stop();
+  iv_deinit();
+  return NULL;
+}
+
+static void
+_start_background_lookup(GSockAddr *saddr)
+{
+  g_mutex_lock(&background_lock);
+  if (!background_requests && !background_lookups_stopping)
+    {
+      background_requests = g_async_queue_new();
+      for (gint i = 0; i < HOST_RESOLVE_BACKGROUND_THREADS; i++)
+        background_threads[i] = g_thread_new("dns-resolver", _background_resolver_thread, background_requests);
+    }
+  if (background_requests)
+    g_async_queue_push(background_requests, g_sockaddr_ref(saddr));
+  g_mutex_unlock(&background_lock);
+}
+
+static void
+_stop_background_lookups(void)
+{
+  GAsyncQueue *requests;
+  GSockAddr *saddr;
+
+  /* the resolver threads may start new lookups while finishing, so don't hold the lock while joining them */
+  g_mutex_lock(&background_lock);
+  requests = background_requests;
+  background_lookups_stopping = TRUE;
+  g_mutex_unlock(&background_lock);
+
+  if (requests)
+    {
+      for (gint i = 0; i < HOST_RESOLVE_BACKGROUND_THREADS; i++)
+        g_async_queue_push(requests, &background_stop_request);
+      for (gint i = 0; i < HOST_RESOLVE_BACKGROUND_THREADS; i++)
+        g_thread_join(background_threads[i]);
+    }
+
+  g_mutex_lock(&background_lock);
+  background_requests = NULL;
+  background_lookups_stopping = FALSE;
+  g_mutex_unlock(&background_lock);
+
+  if (requests)
+    {
+      while ((saddr = g_async_queue_try_pop(requests)))
+        g_sockaddr_unref(saddr);
+      g_async_queue_unref(requests);
+    }
+}
+
+/*
+ * Starts resolving @saddr in the background, unless its name is readily
+ * available (cached, local or DNS is not used asynchronously).
+ *
+ * Returns TRUE if a lookup is in progress, in which case @func is called
+ * from a resolver thread once it finishes, after which
+ * resolve_sockaddr_to_hostname() returns the name from the cache.
+ * Returns FALSE if resolve_sockaddr_to_hostname() can be called right
+ * away, @func is not called in this case.
+ */
+gboolean
+resolve_sockaddr_to_hostname_in_background(GSockAddr *saddr, const HostResolveOptions *host_resolve_options,
+                                           DNSCachingNotifyFunc func, gpointer user_data)
+{
+  if (host_resolve_options->use_dns != HOST_RESOLVE_USE_DNS_ASYNC || is_sockaddr_local(saddr))
+    return FALSE;
+
+  DNSCachingLookupResult result = dns_caching_lookup_or_wait(saddr->sa.sa_family, sockaddr_to_dnscache_key(saddr),
+                                                             func, user_data);
+  if (result == DNS_CACHING_LOOKUP_STARTED)
+    _start_background_lookup(saddr);
+  return result != DNS_CACHING_HIT;
+}
+
 static const gchar *
 resolve_sockaddr_to_inet_or_inet6_hostname(gsize *result_len, GSockAddr *saddr,
                                            const HostResolveOptions *host_resolve_options)
@@ -356,17 +493,22 @@ resolve_sockaddr_to_inet_or_inet6_hostname(gsize *result_len, GSockAddr *saddr,
 
   if (host_resolve_options->use_dns_cache)
     {
-      if (dns_caching_lookup(saddr->sa.sa_family, dnscache_key, (const gchar **) &hname, &hname_len, &positive))
-        return hostname_apply_options_fqdn(hname_len, result_len, hname, positive, host_resolve_options);
+      if (dns_caching_lookup(saddr->sa.sa_family, dnscache_key, hostname_buffer, sizeof(hostname_buffer),
+                             &hname_len, &positive))
+        return hostname_apply_options_fqdn(hname_len, result_len, hostname_buffer, positive, host_resolve_options);
     }
 
-  if (!hname && host_resolve_options->use_dns && host_resolve_options->use_dns != 2)
+  if (host_resolve_options->use_dns == HOST_RESOLVE_USE_DNS_ASYNC)
     {
-#ifdef SYSLOG_NG_HAVE_GETNAMEINFO
-      hname = resolve_address_using_getnameinfo(saddr, hostname_buffer, sizeof(hostname_buffer));
-#else
-      hname = resolve_address_using_gethostbyaddr(saddr, hostname_buffer, sizeof(hostname_buffer));
-#endif
+      /* never block on DNS: use the address until the name gets into the cache */
+      resolve_sockaddr_to_hostname_in_background(saddr, host_resolve_options, NULL, NULL);
+      hname = g_sockaddr_format(saddr, hostname_buffer, sizeof(hostname_buffer), GSA_ADDRESS_ONLY);
+      return hostname_apply_options_fqdn(-1, result_len, hname, FALSE, host_resolve_options);
+    }
+
+  if (host_resolve_options->use_dns && host_resolve_options->use_dns != HOST_RESOLVE_USE_DNS_PERSIST_ONLY)
+    {
+      hname = reverse_lookup_func(saddr, hostname_buffer, sizeof(hostname_buffer));
       positive = (hname != NULL);
     }
 
@@ -446,6 +588,11 @@ _init_options(HostResolveOptions *options)
     {
       options->use_dns_cache = 0;
     }
+  else if (options->use_dns == HOST_RESOLVE_USE_DNS_ASYNC)
+    {
+      /* background lookups deliver their results through the cache */
+      options->use_dns_cache = 1;
+    }
 }
 
 void
@@ -484,3 +631,9 @@ host_resolve_global_init(void)
 {
   register_application_hook(AH_CONFIG_STOPPED, _reinit_resolver, NULL, AHM_RUN_REPEAT);
 }
+
+void
+host_resolve_global_deinit(void)
+{
+  _stop_background_lookups();
+}
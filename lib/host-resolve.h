@@ -24,6 +24,11 @@
 
 #include "syslog-ng.h"
 #include "gsockaddr.h"
+#include "dnscache.h"
+
+/* use_dns values besides TRUE and FALSE */
+#define HOST_RESOLVE_USE_DNS_PERSIST_ONLY 2
+#define HOST_RESOLVE_USE_DNS_ASYNC        3
 
 typedef struct _HostResolveOptions
 {
@@ -36,6 +41,8 @@ typedef struct _HostResolveOptions
 /* name resolution */
 const gchar *resolve_sockaddr_to_hostname(gsize *result_len, GSockAddr *saddr,
                                           const HostResolveOptions *host_resolve_options);
+gboolean resolve_sockaddr_to_hostname_in_background(GSockAddr *saddr, const HostResolveOptions *host_resolve_options,
+                                                    DNSCachingNotifyFunc func, gpointer user_data);
 gboolean resolve_hostname_to_sockaddr(GSockAddr **addr, gint family, const gchar *name);
 const gchar *resolve_hostname_to_hostname(gsize *result_len, const gchar *hostname, HostResolveOptions *options);
 
@@ -45,4 +52,10 @@ void host_resolve_options_init_globals(HostResolveOptions *options);
 void host_resolve_options_init(HostResolveOptions *options, HostResolveOptions *global_options);
 void host_resolve_options_destroy(HostResolveOptions *options);
 
+typedef const gchar *(*HostResolveReverseLookupFunc)(GSockAddr *saddr, gchar *buf, gsize buf_len);
+void host_resolve_set_reverse_lookup_func(HostResolveReverseLookupFunc func);
+
+void host_resolve_global_init(void);
+void host_resolve_global_deinit(void);
+
 #endif
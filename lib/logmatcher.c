@@ -26,6 +26,7 @@
 #include "cfg.h"
 #include "str-utils.h"
 #include "scratch-buffers.h"
+#include "multi-string-matcher.h"
 #include "compat/string.h"
 #include "compat/pcre.h"
 
@@ -205,6 +206,71 @@ log_matcher_string_new(const LogMatcherOptions *options)
   return &self->super;
 }
 
+/*
+ * Matches if any of a set of literal strings match, with the same flags
+ * as the "string" matcher.  This is what filters use when the same
+ * name-value pair is matched against several alternatives, so that a
+ * single pass over the value is needed, regardless of their number.
+ */
+typedef struct _LogMatcherStringSet
+{
+  LogMatcher super;
+  MultiStringMatcher *strings;
+} LogMatcherStringSet;
+
+static gboolean
+log_matcher_string_set_match(LogMatcher *s, LogMessage *msg, gint value_handle, const gchar *value,
+                             gssize value_len)
+{
+  LogMatcherStringSet *self = (LogMatcherStringSet *) s;
+
+  if (value_len < 0)
+    value_len = strlen(value);
+
+  if (G_LIKELY((self->super.flags & (LMF_SUBSTRING + LMF_PREFIX)) == 0))
+    return multi_string_matcher_match_exact(self->strings, value, value_len);
+  else if (self->super.flags & LMF_PREFIX)
+    return multi_string_matcher_match_prefix(self->strings, value, value_len);
+  else
+    return multi_string_matcher_match_substring(self->strings, value, value_len);
+}
+
+static void
+log_matcher_string_set_free(LogMatcher *s)
+{
+  LogMatcherStringSet *self = (LogMatcherStringSet *) s;
+
+  multi_string_matcher_free(self->strings);
+  log_matcher_free_method(s);
+}
+
+LogMatcher *
+log_matcher_string_set_new(const LogMatcherOptions *options, GPtrArray *patterns)
+{
+  LogMatcherStringSet *self = g_new0(LogMatcherStringSet, 1);
+  GString *joined_patterns = g_string_new("");
+
+  log_matcher_init(&self->super, options);
+  self->super.match = log_matcher_string_set_match;
+  self->super.free_fn = log_matcher_string_set_free;
+
+  self->strings = multi_string_matcher_new(((self->super.flags & LMF_ICASE) ? MSM_ICASE : 0) |
+                                          ((self->super.flags & LMF_SUBSTRING) ? MSM_SUBSTRING : 0));
+  for (guint i = 0; i < patterns->len; i++)
+    {
+      const gchar *pattern = g_ptr_array_index(patterns, i);
+
+      multi_string_matcher_add_pattern(self->strings, pattern, -1);
+      if (i > 0)
+        g_string_append(joined_patterns, ", ");
+      g_string_append(joined_patterns, pattern);
+    }
+  multi_string_matcher_compile(self->strings);
+
+  self->super.pattern = g_string_free(joined_patterns, FALSE);
+  return &self->super;
+}
+
 typedef struct _LogMatcherGlob
 {
   LogMatcher super;
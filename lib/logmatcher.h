@@ -114,6 +114,7 @@ log_matcher_is_replace_supported(LogMatcher *s)
 
 LogMatcher *log_matcher_pcre_re_new(const LogMatcherOptions *options);
 LogMatcher *log_matcher_string_new(const LogMatcherOptions *options);
+LogMatcher *log_matcher_string_set_new(const LogMatcherOptions *options, GPtrArray *patterns);
 LogMatcher *log_matcher_glob_new(const LogMatcherOptions *options);
 
 LogMatcher *log_matcher_new(const LogMatcherOptions *options);
@@ -179,6 +179,107 @@ log_multiplexer_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_op
   log_pipe_forward_msg(s, msg, path_options);
 }
 
+/*
+ * Batched version of log_multiplexer_queue(): each branch receives the
+ * messages of the batch in one go, instead of each message being sent
+ * along all branches before the next one is considered.  The per-message
+ * semantics (fallback branches, final flag, delivery propagation) are the
+ * same as above.
+ *
+ * NOTE: this changes the interleaving of deliveries across branches.  With
+ * two branches A and B, log_multiplexer_queue() produces A1 B1 A2 B2, while
+ * we produce A1 A2 B1 B2.  Within a branch the order of messages is kept,
+ * and as messages are write protected before the fork, one branch can't
+ * observe the changes of another, so the only visible difference is the
+ * relative timing of the deliveries to different branches.
+ */
+static void
+log_multiplexer_queue_batch(LogPipe *s, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs)
+{
+  LogMultiplexer *self = (LogMultiplexer *) s;
+  LogPathOptions local_path_options[LOG_PIPE_MAX_BATCH_SIZE];
+  gboolean matched[LOG_PIPE_MAX_BATCH_SIZE];
+  gboolean delivered[LOG_PIPE_MAX_BATCH_SIZE] = { 0 };
+  gboolean done[LOG_PIPE_MAX_BATCH_SIZE] = { 0 };
+  LogMessage *branch_msgs[LOG_PIPE_MAX_BATCH_SIZE];
+  const LogPathOptions *branch_path_options[LOG_PIPE_MAX_BATCH_SIZE];
+  gint branch_msg_index[LOG_PIPE_MAX_BATCH_SIZE];
+  gboolean multiple_arcs = _has_multiple_arcs(self);
+  gint fallback;
+
+  for (gint m = 0; m < num_msgs; m++)
+    {
+      log_path_options_push_junction(&local_path_options[m], &matched[m], path_options[m]);
+      if (multiple_arcs)
+        {
+          filterx_eval_prepare_for_fork(path_options[m]->filterx_context, &msgs[m], path_options[m]);
+          log_msg_write_protect(msgs[m]);
+        }
+    }
+
+  for (fallback = 0; fallback < (self->fallback_exists ? 2 : 1); fallback++)
+    {
+      /* fallback branches only get the messages that were not delivered by the regular ones */
+      if (fallback)
+        {
+          for (gint m = 0; m < num_msgs; m++)
+            done[m] = delivered[m];
+        }
+
+      for (gint i = 0; i < self->next_hops->len; i++)
+        {
+          LogPipe *next_hop = g_ptr_array_index(self->next_hops, i);
+          gint num_branch_msgs = 0;
+
+          if (G_UNLIKELY(fallback == 0 && (next_hop->flags & PIF_BRANCH_FALLBACK) != 0))
+            continue;
+          else if (G_UNLIKELY(fallback && (next_hop->flags & PIF_BRANCH_FALLBACK) == 0))
+            continue;
+
+          for (gint m = 0; m < num_msgs; m++)
+            {
+              if (done[m])
+                continue;
+
+              matched[m] = TRUE;
+              log_msg_add_ack(msgs[m], &local_path_options[m]);
+              branch_msgs[num_branch_msgs] = log_msg_ref(msgs[m]);
+              branch_path_options[num_branch_msgs] = &local_path_options[m];
+              branch_msg_index[num_branch_msgs] = m;
+              num_branch_msgs++;
+            }
+
+          if (num_branch_msgs == 0)
+            continue;
+
+          log_pipe_queue_batch(next_hop, branch_msgs, branch_path_options, num_branch_msgs);
+
+          for (gint b = 0; b < num_branch_msgs; b++)
+            {
+              gint m = branch_msg_index[b];
+
+              if (matched[m])
+                {
+                  delivered[m] = TRUE;
+                  if (G_UNLIKELY(next_hop->flags & PIF_BRANCH_FINAL))
+                    done[m] = TRUE;
+                }
+            }
+        }
+    }
+
+  /* NOTE: see log_multiplexer_queue() on delivery propagation */
+  if (self->delivery_propagation)
+    {
+      for (gint m = 0; m < num_msgs; m++)
+        {
+          if (!delivered[m] && path_options[m]->matched)
+            *path_options[m]->matched = FALSE;
+        }
+    }
+  log_pipe_forward_batch(s, msgs, path_options, num_msgs);
+}
+
 static void
 log_multiplexer_free(LogPipe *s)
 {
@@ -210,6 +311,7 @@ log_multiplexer_new(GlobalConfig *cfg)
   self->super.init = log_multiplexer_init;
   self->super.deinit = log_multiplexer_deinit;
   self->super.queue = log_multiplexer_queue;
+  self->super.queue_batch = log_multiplexer_queue_batch;
   self->super.walk = log_multiplexer_walk;
   self->super.free_fn = log_multiplexer_free;
   self->next_hops = g_ptr_array_new();
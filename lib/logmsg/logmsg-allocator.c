@@ -0,0 +1,523 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logmsg/logmsg-allocator.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+#include "metrics/metric-names.h"
+#include "apphook.h"
+#include "tls-support.h"
+
+/*
+ * Size-class caching allocator for LogMessage instances and their queue
+ * nodes.
+ *
+ * Every LogMessage goes through a malloc()/free() pair, and in a
+ * source -> destination pipeline these usually happen in different
+ * threads, which is the worst case for most general purpose allocators.
+ * This allocator keeps freed blocks around in per-thread "magazines", one
+ * pair per size class, so that a steady state of allocations and frees
+ * never leaves the thread.
+ *
+ * Full and empty magazines are exchanged with a global, per-class depot
+ * protected by a mutex, which is also the return path for blocks freed in
+ * a different thread than the one that allocated them: the freeing thread
+ * collects them into its own magazines and hands those over to the depot
+ * once they fill up, where the allocating thread picks them up again.
+ *
+ * All blocks are allocated using g_malloc(), so a block may always be
+ * released with g_free() too.  This is what happens in threads that have
+ * no cache (e.g. non-syslog-ng threads) and when the depot is at its
+ * capacity.
+ */
+
+#define LOG_MSG_ALLOCATOR_CLASSES 12
+#define LOG_MSG_ALLOCATOR_MAGAZINE_ROUNDS 64
+
+/* upper limit of memory kept in full magazines of a single depot */
+#define LOG_MSG_ALLOCATOR_DEPOT_BYTES (4 * 1024 * 1024)
+
+/* local stats are published once every this many operations */
+#define LOG_MSG_ALLOCATOR_STATS_PERIOD 1024
+
+static const gsize log_msg_allocator_class_sizes[LOG_MSG_ALLOCATOR_CLASSES] =
+{
+  32, 64, 128, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+typedef struct _LogMsgMagazine LogMsgMagazine;
+struct _LogMsgMagazine
+{
+  LogMsgMagazine *next;
+  gint rounds;
+  gpointer blocks[LOG_MSG_ALLOCATOR_MAGAZINE_ROUNDS];
+};
+
+typedef struct _LogMsgDepot
+{
+  GMutex lock;
+  LogMsgMagazine *full;
+  LogMsgMagazine *empty;
+  gint full_count;
+  gint max_full;
+} LogMsgDepot;
+
+typedef struct _LogMsgThreadCache
+{
+  struct
+  {
+    LogMsgMagazine *loaded;
+    LogMsgMagazine *previous;
+  } classes[LOG_MSG_ALLOCATOR_CLASSES];
+
+  gint ops;
+  gssize allocs;
+  gssize frees;
+  gssize system_allocs;
+  gssize used_bytes;
+  gssize cached_bytes;
+} LogMsgThreadCache;
+
+TLS_BLOCK_START
+{
+  LogMsgThreadCache *log_msg_allocator_cache;
+}
+TLS_BLOCK_END;
+
+#define log_msg_allocator_cache __tls_deref(log_msg_allocator_cache)
+
+static LogMsgDepot depots[LOG_MSG_ALLOCATOR_CLASSES];
+
+static StatsCounterItem *stats_log_msg_allocator_allocs;
+static StatsCounterItem *stats_log_msg_allocator_frees;
+static StatsCounterItem *stats_log_msg_allocator_system_allocs;
+
+/*
+ * The byte gauges are maintained from the very first allocation, and only
+ * exposed as external counters: blocks allocated before the stats are
+ * registered may be freed after that (or vice versa), which would make a
+ * registered-only counter go negative.
+ */
+static atomic_gssize log_msg_allocator_used_bytes;
+static atomic_gssize log_msg_allocator_cached_bytes;
+
+guint8
+log_msg_allocator_get_size_class(gsize size)
+{
+  for (guint8 i = 0; i < LOG_MSG_ALLOCATOR_CLASSES; i++)
+    {
+      if (size <= log_msg_allocator_class_sizes[i])
+        return i;
+    }
+  return LOG_MSG_ALLOCATOR_HEAP_CLASS;
+}
+
+gsize
+log_msg_allocator_get_class_size(guint8 size_class)
+{
+  g_assert(size_class < LOG_MSG_ALLOCATOR_CLASSES);
+  return log_msg_allocator_class_sizes[size_class];
+}
+
+static LogMsgMagazine *
+_magazine_new(void)
+{
+  LogMsgMagazine *self = g_new(LogMsgMagazine, 1);
+
+  self->next = NULL;
+  self->rounds = 0;
+  return self;
+}
+
+/* returns the number of bytes released */
+static gsize
+_magazine_free(LogMsgMagazine *self, gsize block_size)
+{
+  gsize released = self->rounds * block_size;
+
+  for (gint i = 0; i < self->rounds; i++)
+    g_free(self->blocks[i]);
+  g_free(self);
+  return released;
+}
+
+/* depot */
+
+static void
+_depot_init(LogMsgDepot *self, gsize block_size)
+{
+  g_mutex_init(&self->lock);
+  self->full = NULL;
+  self->empty = NULL;
+  self->full_count = 0;
+  self->max_full = MAX(4, LOG_MSG_ALLOCATOR_DEPOT_BYTES / (block_size * LOG_MSG_ALLOCATOR_MAGAZINE_ROUNDS));
+}
+
+static gsize
+_depot_deinit(LogMsgDepot *self, gsize block_size)
+{
+  gsize released = 0;
+
+  while (self->full)
+    {
+      LogMsgMagazine *magazine = self->full;
+
+      self->full = magazine->next;
+      released += _magazine_free(magazine, block_size);
+    }
+  while (self->empty)
+    {
+      LogMsgMagazine *magazine = self->empty;
+
+      self->empty = magazine->next;
+      _magazine_free(magazine, block_size);
+    }
+  self->full_count = 0;
+  g_mutex_clear(&self->lock);
+  return released;
+}
+
+/* trade an empty magazine for a full one, returns NULL if the depot has none */
+static LogMsgMagazine *
+_depot_exchange_empty(LogMsgDepot *self, LogMsgMagazine *empty)
+{
+  LogMsgMagazine *full = NULL;
+
+  g_mutex_lock(&self->lock);
+  if (self->full)
+    {
+      full = self->full;
+      self->full = full->next;
+      self->full_count--;
+
+      empty->next = self->empty;
+      self->empty = empty;
+    }
+  g_mutex_unlock(&self->lock);
+  return full;
+}
+
+/* trade a full magazine for an empty one, returns NULL if the depot is at capacity */
+static LogMsgMagazine *
+_depot_exchange_full(LogMsgDepot *self, LogMsgMagazine *full)
+{
+  LogMsgMagazine *empty = NULL;
+  gboolean accepted = FALSE;
+
+  g_mutex_lock(&self->lock);
+  if (self->full_count < self->max_full)
+    {
+      full->next = self->full;
+      self->full = full;
+      self->full_count++;
+      accepted = TRUE;
+
+      if (self->empty)
+        {
+          empty = self->empty;
+          self->empty = empty->next;
+        }
+    }
+  g_mutex_unlock(&self->lock);
+
+  if (accepted && !empty)
+    empty = _magazine_new();
+  return empty;
+}
+
+/* hand over a magazine of an exiting thread, returns the number of bytes released */
+static gsize
+_depot_return(LogMsgDepot *self, LogMsgMagazine *magazine, gsize block_size)
+{
+  g_mutex_lock(&self->lock);
+  if (magazine->rounds > 0 && self->full_count < self->max_full)
+    {
+      magazine->next = self->full;
+      self->full = magazine;
+      self->full_count++;
+      magazine = NULL;
+    }
+  else if (magazine->rounds == 0)
+    {
+      magazine->next = self->empty;
+      self->empty = magazine;
+      magazine = NULL;
+    }
+  g_mutex_unlock(&self->lock);
+
+  if (magazine)
+    return _magazine_free(magazine, block_size);
+  return 0;
+}
+
+/* thread cache */
+
+static void
+_thread_cache_flush_stats(LogMsgThreadCache *self)
+{
+  stats_counter_add(stats_log_msg_allocator_allocs, self->allocs);
+  stats_counter_add(stats_log_msg_allocator_frees, self->frees);
+  stats_counter_add(stats_log_msg_allocator_system_allocs, self->system_allocs);
+  atomic_gssize_add(&log_msg_allocator_used_bytes, self->used_bytes);
+  atomic_gssize_add(&log_msg_allocator_cached_bytes, self->cached_bytes);
+
+  self->ops = 0;
+  self->allocs = 0;
+  self->frees = 0;
+  self->system_allocs = 0;
+  self->used_bytes = 0;
+  self->cached_bytes = 0;
+}
+
+static inline void
+_thread_cache_tick(LogMsgThreadCache *self)
+{
+  if (++self->ops >= LOG_MSG_ALLOCATOR_STATS_PERIOD)
+    _thread_cache_flush_stats(self);
+}
+
+static gpointer
+_thread_cache_pop(LogMsgThreadCache *self, guint8 size_class)
+{
+  LogMsgMagazine *loaded = self->classes[size_class].loaded;
+
+  if (loaded->rounds == 0)
+    {
+      LogMsgMagazine *previous = self->classes[size_class].previous;
+
+      if (previous->rounds == 0)
+        {
+          LogMsgMagazine *full = _depot_exchange_empty(&depots[size_class], previous);
+
+          if (!full)
+            return NULL;
+          previous = full;
+        }
+      self->classes[size_class].previous = loaded;
+      self->classes[size_class].loaded = previous;
+      loaded = previous;
+    }
+  return loaded->blocks[--loaded->rounds];
+}
+
+static gboolean
+_thread_cache_push(LogMsgThreadCache *self, guint8 size_class, gpointer block)
+{
+  LogMsgMagazine *loaded = self->classes[size_class].loaded;
+
+  if (loaded->rounds == LOG_MSG_ALLOCATOR_MAGAZINE_ROUNDS)
+    {
+      LogMsgMagazine *previous = self->classes[size_class].previous;
+
+      if (previous->rounds == LOG_MSG_ALLOCATOR_MAGAZINE_ROUNDS)
+        {
+          LogMsgMagazine *empty = _depot_exchange_full(&depots[size_class], previous);
+
+          if (!empty)
+            return FALSE;
+          previous = empty;
+        }
+      self->classes[size_class].previous = loaded;
+      self->classes[size_class].loaded = previous;
+      loaded = previous;
+    }
+  loaded->blocks[loaded->rounds++] = block;
+  return TRUE;
+}
+
+static void
+_init_thread_cache(gpointer user_data)
+{
+  g_assert(!log_msg_allocator_cache);
+
+  LogMsgThreadCache *self = g_new0(LogMsgThreadCache, 1);
+  for (gint i = 0; i < LOG_MSG_ALLOCATOR_CLASSES; i++)
+    {
+      self->classes[i].loaded = _magazine_new();
+      self->classes[i].previous = _magazine_new();
+    }
+  log_msg_allocator_cache = self;
+}
+
+static void
+_deinit_thread_cache(gpointer user_data)
+{
+  LogMsgThreadCache *self = log_msg_allocator_cache;
+
+  if (!self)
+    return;
+
+  for (gint i = 0; i < LOG_MSG_ALLOCATOR_CLASSES; i++)
+    {
+      gsize block_size = log_msg_allocator_class_sizes[i];
+
+      self->cached_bytes -= _depot_return(&depots[i], self->classes[i].loaded, block_size);
+      self->cached_bytes -= _depot_return(&depots[i], self->classes[i].previous, block_size);
+    }
+  _thread_cache_flush_stats(self);
+  g_free(self);
+  log_msg_allocator_cache = NULL;
+}
+
+/* public API */
+
+gpointer
+log_msg_allocator_alloc(guint8 size_class, gsize size)
+{
+  LogMsgThreadCache *cache = log_msg_allocator_cache;
+
+  if (size_class == LOG_MSG_ALLOCATOR_HEAP_CLASS)
+    {
+      stats_counter_inc(stats_log_msg_allocator_allocs);
+      stats_counter_inc(stats_log_msg_allocator_system_allocs);
+      return g_malloc(size);
+    }
+
+  gsize block_size = log_msg_allocator_class_sizes[size_class];
+  g_assert(size <= block_size);
+
+  if (!cache)
+    {
+      stats_counter_inc(stats_log_msg_allocator_allocs);
+      stats_counter_inc(stats_log_msg_allocator_system_allocs);
+      atomic_gssize_add(&log_msg_allocator_used_bytes, block_size);
+      return g_malloc(block_size);
+    }
+
+  gpointer block = _thread_cache_pop(cache, size_class);
+
+  cache->allocs++;
+  cache->used_bytes += block_size;
+  if (block)
+    {
+      cache->cached_bytes -= block_size;
+    }
+  else
+    {
+      cache->system_allocs++;
+      block = g_malloc(block_size);
+    }
+  _thread_cache_tick(cache);
+  return block;
+}
+
+void
+log_msg_allocator_free(gpointer block, guint8 size_class)
+{
+  LogMsgThreadCache *cache = log_msg_allocator_cache;
+
+  if (size_class == LOG_MSG_ALLOCATOR_HEAP_CLASS)
+    {
+      stats_counter_inc(stats_log_msg_allocator_frees);
+      g_free(block);
+      return;
+    }
+
+  gsize block_size = log_msg_allocator_class_sizes[size_class];
+
+  if (!cache)
+    {
+      stats_counter_inc(stats_log_msg_allocator_frees);
+      atomic_gssize_sub(&log_msg_allocator_used_bytes, block_size);
+      g_free(block);
+      return;
+    }
+
+  cache->frees++;
+  cache->used_bytes -= block_size;
+  if (_thread_cache_push(cache, size_class, block))
+    cache->cached_bytes += block_size;
+  else
+    g_free(block);
+  _thread_cache_tick(cache);
+}
+
+void
+log_msg_allocator_flush_stats(void)
+{
+  if (log_msg_allocator_cache)
+    _thread_cache_flush_stats(log_msg_allocator_cache);
+}
+
+void
+log_msg_allocator_register_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_allocations_total), NULL, 0);
+  stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_log_msg_allocator_allocs);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_frees_total), NULL, 0);
+  stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_log_msg_allocator_frees);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_system_allocations_total), NULL, 0);
+  stats_register_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &stats_log_msg_allocator_system_allocs);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_used_bytes), NULL, 0);
+  stats_register_external_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &log_msg_allocator_used_bytes);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_cached_bytes), NULL, 0);
+  stats_register_external_counter(1, &sc_key, SC_TYPE_SINGLE_VALUE, &log_msg_allocator_cached_bytes);
+  stats_unlock();
+}
+
+void
+log_msg_allocator_unregister_stats(void)
+{
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_allocations_total), NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_log_msg_allocator_allocs);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_frees_total), NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_log_msg_allocator_frees);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_system_allocations_total), NULL, 0);
+  stats_unregister_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &stats_log_msg_allocator_system_allocs);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_used_bytes), NULL, 0);
+  stats_unregister_external_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &log_msg_allocator_used_bytes);
+  stats_cluster_single_key_set(&sc_key, METRIC(events_allocator_cached_bytes), NULL, 0);
+  stats_unregister_external_counter(&sc_key, SC_TYPE_SINGLE_VALUE, &log_msg_allocator_cached_bytes);
+  stats_unlock();
+}
+
+void
+log_msg_allocator_global_init(void)
+{
+  for (gint i = 0; i < LOG_MSG_ALLOCATOR_CLASSES; i++)
+    _depot_init(&depots[i], log_msg_allocator_class_sizes[i]);
+
+  register_application_thread_init_hook(_init_thread_cache, NULL);
+  register_application_thread_deinit_hook(_deinit_thread_cache, NULL);
+  register_application_hook(AH_RUNNING, (ApplicationHookFunc) log_msg_allocator_register_stats, NULL, AHM_RUN_ONCE);
+
+  _init_thread_cache(NULL);
+}
+
+void
+log_msg_allocator_global_deinit(void)
+{
+  _deinit_thread_cache(NULL);
+
+  gssize released = 0;
+  for (gint i = 0; i < LOG_MSG_ALLOCATOR_CLASSES; i++)
+    released += _depot_deinit(&depots[i], log_msg_allocator_class_sizes[i]);
+  atomic_gssize_sub(&log_msg_allocator_cached_bytes, released);
+
+  log_msg_allocator_unregister_stats();
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef LOGMSG_ALLOCATOR_H_INCLUDED
+#define LOGMSG_ALLOCATOR_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/* blocks larger than the largest size class bypass the caches */
+#define LOG_MSG_ALLOCATOR_HEAP_CLASS 0xFF
+
+guint8 log_msg_allocator_get_size_class(gsize size);
+gsize log_msg_allocator_get_class_size(guint8 size_class);
+
+gpointer log_msg_allocator_alloc(guint8 size_class, gsize size);
+void log_msg_allocator_free(gpointer block, guint8 size_class);
+
+void log_msg_allocator_flush_stats(void);
+void log_msg_allocator_register_stats(void);
+void log_msg_allocator_unregister_stats(void);
+
+void log_msg_allocator_global_init(void);
+void log_msg_allocator_global_deinit(void);
+
+#endif
@@ -29,6 +29,7 @@
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
 #include "logmsg/nvtable.h"
+#include "logmsg/logmsg-allocator.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster-single.h"
 #include "template/templates.h"
@@ -387,7 +388,8 @@ log_msg_alloc_queue_node(LogMessage *msg, const LogPathOptions *path_options)
        */
       if (nodes < LOGMSG_MAX_NODES && nodes <= msg->num_nodes)
         logmsg_queue_node_max = msg->num_nodes + 1;
-      node = g_slice_new(LogMessageQueueNode);
+      node = log_msg_allocator_alloc(log_msg_allocator_get_size_class(sizeof(LogMessageQueueNode)),
+                                     sizeof(LogMessageQueueNode));
       node->embedded = FALSE;
     }
   log_msg_init_queue_node(msg, node, path_options);
@@ -400,7 +402,7 @@ log_msg_free_queue_node(LogMessageQueueNode *node)
   gboolean is_embedded = node->embedded;
   log_msg_unref(node->msg);
   if (!is_embedded)
-    g_slice_free(LogMessageQueueNode, node);
+    log_msg_allocator_free(node, log_msg_allocator_get_size_class(sizeof(LogMessageQueueNode)));
 }
 
 static gboolean
@@ -1290,9 +1292,11 @@ log_msg_alloc(gsize payload_size)
       payload_ofs = alloc_size;
       alloc_size += payload_space;
     }
-  msg = g_malloc(alloc_size);
+  guint8 alloc_class = log_msg_allocator_get_size_class(alloc_size);
+  msg = log_msg_allocator_alloc(alloc_class, alloc_size);
 
   memset(msg, 0, sizeof(LogMessage));
+  msg->alloc_class = alloc_class;
 
   if (payload_size)
     msg->payload = nv_table_init_borrowed(((gchar *) msg) + payload_ofs, payload_space, LM_V_MAX);
@@ -1346,9 +1350,11 @@ log_msg_alloc_clone(LogMessage *original)
   gint nodes = (volatile gint) logmsg_queue_node_max;
 
   gsize alloc_size = sizeof(LogMessage) + sizeof(LogMessageQueueNode) * nodes;
-  msg = g_malloc(alloc_size);
+  guint8 alloc_class = log_msg_allocator_get_size_class(alloc_size);
+  msg = log_msg_allocator_alloc(alloc_class, alloc_size);
 
   memcpy(msg, original, sizeof(*msg));
+  msg->alloc_class = alloc_class;
   msg->allocated_bytes = 0;
   msg->num_nodes = nodes;
   log_msg_update_allocation(msg, alloc_size);
@@ -1483,7 +1489,7 @@ log_msg_new_mark(void)
  *
  * Frees a LogMessage instance.
  **/
-void
+static void
 _log_msg_free(LogMessage *self)
 {
   if (log_msg_chk_flag(self, LF_STATE_OWN_PAYLOAD) && self->payload)
@@ -1503,7 +1509,199 @@ _log_msg_free(LogMessage *self)
 
   stats_counter_sub(count_allocated_bytes, self->allocated_bytes);
 
-  g_free(self);
+  log_msg_allocator_free(self, self->alloc_class);
+}
+
+/*
+ * Ref/ACK cache
+ *
+ * The thread that posts a message (e.g. log_source_post()) processes it
+ * synchronously along the log path: each filter, parser, rewrite rule and
+ * each branch of a LogMultiplexer takes references and requests ACKs on
+ * the same message, and most of these are dropped before the thread
+ * returns.  Instead of doing an atomic CAS on the shared counter for each
+ * of these, the changes are accumulated in thread local variables and
+ * applied to the message in one step by log_msg_refcache_stop().
+ *
+ * Other threads (e.g. destination threads consuming from a queue) may
+ * access the message in the meanwhile, and they keep using the atomic
+ * counter.  To prevent them from dropping the counters to zero (and thus
+ * freeing the message or calling its ack callback) while we still hold
+ * cached values, both counters are biased by LOGMSG_REFCACHE_BIAS when
+ * the cache is started, which is removed along with the cached changes
+ * when it is stopped.
+ *
+ * The producer is expected to request at least one ACK for the message
+ * while the cache is active.
+ */
+
+#define LOGMSG_REFCACHE_BIAS 0x00002000
+
+TLS_BLOCK_START
+{
+  LogMessage *logmsg_current;
+  gint logmsg_cached_refs;
+  gint logmsg_cached_acks;
+  gboolean logmsg_cached_abort;
+  gboolean logmsg_cached_suspend;
+  gint logmsg_refcache_nesting;
+}
+TLS_BLOCK_END;
+
+#define logmsg_current          __tls_deref(logmsg_current)
+#define logmsg_cached_refs      __tls_deref(logmsg_cached_refs)
+#define logmsg_cached_acks      __tls_deref(logmsg_cached_acks)
+#define logmsg_cached_abort     __tls_deref(logmsg_cached_abort)
+#define logmsg_cached_suspend   __tls_deref(logmsg_cached_suspend)
+#define logmsg_refcache_nesting __tls_deref(logmsg_refcache_nesting)
+
+static inline AckType
+_ack_and_ref_and_abort_and_suspend_to_acktype(gint value)
+{
+  AckType type = AT_PROCESSED;
+
+  if (IS_SUSPENDFLAG_ON(LOGMSG_REFCACHE_VALUE_TO_SUSPEND(value)))
+    type = AT_SUSPENDED;
+  else if (IS_ABORTFLAG_ON(LOGMSG_REFCACHE_VALUE_TO_ABORT(value)))
+    type = AT_ABORTED;
+
+  return type;
+}
+
+/**
+ * log_msg_ref:
+ * @self: LogMessage instance
+ *
+ * Increment reference count of @self and return the new reference.
+ **/
+LogMessage *
+log_msg_ref(LogMessage *self)
+{
+  gint old_value;
+
+  if (!self)
+    return NULL;
+
+  if (logmsg_current == self)
+    {
+      logmsg_cached_refs++;
+      return self;
+    }
+
+  old_value = log_msg_update_ack_and_ref(self, 1, 0);
+  g_assert(LOGMSG_REFCACHE_VALUE_TO_REF(old_value) >= 1);
+  return self;
+}
+
+/**
+ * log_msg_unref:
+ * @self: LogMessage instance
+ *
+ * Decrement reference count and free self if the reference count becomes 0.
+ **/
+void
+log_msg_unref(LogMessage *self)
+{
+  gint old_value;
+
+  if (!self)
+    return;
+
+  if (logmsg_current == self)
+    {
+      logmsg_cached_refs--;
+      return;
+    }
+
+  old_value = log_msg_update_ack_and_ref(self, -1, 0);
+  g_assert(LOGMSG_REFCACHE_VALUE_TO_REF(old_value) >= 1);
+
+  if (LOGMSG_REFCACHE_VALUE_TO_REF(old_value) == 1)
+    {
+      _log_msg_free(self);
+    }
+}
+
+/**
+ * log_msg_refcache_start_producer:
+ * @self: LogMessage instance
+ *
+ * Start caching ref/ack changes of @self in the current thread, until
+ * log_msg_refcache_stop() is called.  Nested calls (e.g. a message posted
+ * while another one is being processed) leave the outer cache in place.
+ **/
+void
+log_msg_refcache_start_producer(LogMessage *self)
+{
+  if (logmsg_current)
+    {
+      logmsg_refcache_nesting++;
+      return;
+    }
+
+  log_msg_update_ack_and_ref(self, LOGMSG_REFCACHE_BIAS, LOGMSG_REFCACHE_BIAS);
+
+  logmsg_current = self;
+  logmsg_cached_refs = -LOGMSG_REFCACHE_BIAS;
+  logmsg_cached_acks = -LOGMSG_REFCACHE_BIAS;
+  logmsg_cached_abort = FALSE;
+  logmsg_cached_suspend = FALSE;
+}
+
+/**
+ * log_msg_refcache_stop:
+ *
+ * Apply the cached ref/ack changes to the current message and stop
+ * caching.  This may invoke the ack callback and free the message.
+ **/
+void
+log_msg_refcache_stop(void)
+{
+  LogMessage *self = logmsg_current;
+  gint old_value;
+
+  if (logmsg_refcache_nesting > 0)
+    {
+      logmsg_refcache_nesting--;
+      return;
+    }
+
+  g_assert(self != NULL);
+
+  /* validate that we didn't overflow the biased values */
+  g_assert(logmsg_cached_acks < LOGMSG_REFCACHE_BIAS - 1);
+  g_assert(logmsg_cached_acks >= -LOGMSG_REFCACHE_BIAS);
+  g_assert(logmsg_cached_refs < LOGMSG_REFCACHE_BIAS - 1);
+  g_assert(logmsg_cached_refs >= -LOGMSG_REFCACHE_BIAS);
+
+  /* ACKs first: the ack callback may still use the message and it may
+   * take or drop references, which are still being cached at this point */
+  gint cached_acks = logmsg_cached_acks;
+  gboolean cached_abort = logmsg_cached_abort;
+  gboolean cached_suspend = logmsg_cached_suspend;
+
+  logmsg_cached_acks = 0;
+  old_value = log_msg_update_ack_and_ref_and_abort_and_suspended(self, 0, cached_acks, cached_abort, cached_suspend);
+  if (LOGMSG_REFCACHE_VALUE_TO_ACK(old_value) == -cached_acks)
+    {
+      gint new_value = old_value |
+                       LOGMSG_REFCACHE_ABORT_TO_VALUE(cached_abort) |
+                       LOGMSG_REFCACHE_SUSPEND_TO_VALUE(cached_suspend);
+
+      self->ack_func(self, _ack_and_ref_and_abort_and_suspend_to_acktype(new_value));
+
+      /* the ack counter has already dropped to zero, the ack callback
+       * must not change it any further */
+      g_assert(logmsg_cached_acks == 0);
+    }
+
+  gint cached_refs = logmsg_cached_refs;
+
+  logmsg_current = NULL;
+  logmsg_cached_refs = 0;
+  old_value = log_msg_update_ack_and_ref(self, cached_refs, 0);
+  if (LOGMSG_REFCACHE_VALUE_TO_REF(old_value) == -cached_refs)
+    _log_msg_free(self);
 }
 
 /**
@@ -1524,19 +1722,6 @@ log_msg_drop(LogMessage *msg, const LogPathOptions *path_options, AckType ack_ty
     }
 }
 
-static inline AckType
-_ack_and_ref_and_abort_and_suspend_to_acktype(gint value)
-{
-  AckType type = AT_PROCESSED;
-
-  if (IS_SUSPENDFLAG_ON(LOGMSG_REFCACHE_VALUE_TO_SUSPEND(value)))
-    type = AT_SUSPENDED;
-  else if (IS_ABORTFLAG_ON(LOGMSG_REFCACHE_VALUE_TO_ABORT(value)))
-    type = AT_ABORTED;
-
-  return type;
-}
-
 /**
  * log_msg_add_ack:
  * @m: LogMessage instance
@@ -1548,7 +1733,10 @@ log_msg_add_ack(LogMessage *self, const LogPathOptions *path_options)
 {
   if (path_options->ack_needed)
     {
-      log_msg_update_ack_and_ref(self, 0, 1);
+      if (logmsg_current == self)
+        logmsg_cached_acks++;
+      else
+        log_msg_update_ack_and_ref(self, 0, 1);
     }
 }
 
@@ -1568,6 +1756,14 @@ log_msg_ack(LogMessage *self, const LogPathOptions *path_options, AckType ack_ty
 
   if (path_options->ack_needed)
     {
+      if (logmsg_current == self)
+        {
+          logmsg_cached_acks--;
+          logmsg_cached_abort |= IS_ACK_ABORTED(ack_type);
+          logmsg_cached_suspend |= IS_ACK_SUSPENDED(ack_type);
+          return;
+        }
+
       old_value = log_msg_update_ack_and_ref_and_abort_and_suspended(self, 0, -1, IS_ACK_ABORTED(ack_type),
                   IS_ACK_SUSPENDED(ack_type));
       if (LOGMSG_REFCACHE_VALUE_TO_ACK(old_value) == 1)
@@ -1730,6 +1926,7 @@ log_msg_global_init(void)
   log_msg_registry_init();
   log_tags_global_init();
   log_msg_tags_init();
+  log_msg_allocator_global_init();
 
   /* NOTE: we always initialize counters as they are on stats-level(0),
    * however we need to defer that as the stats subsystem may not be
@@ -1747,6 +1944,7 @@ log_msg_get_handle_name(NVHandle handle, gssize *length)
 void
 log_msg_global_deinit(void)
 {
+  log_msg_allocator_global_deinit();
   log_tags_global_deinit();
   log_msg_registry_deinit();
 }
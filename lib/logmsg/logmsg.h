@@ -296,6 +296,8 @@ struct _LogMessage
 
   /* is this message currently read only, used to track when we need to copy-on-write */
   guint8 write_protected;
+  /* size class of the block holding this LogMessage, see logmsg-allocator.h */
+  guint8 alloc_class;
   /* identifier of the source host */
   guint32 host_id;
   /* unique message identifier (upon receipt) */
@@ -347,6 +349,12 @@ extern gint logmsg_node_max;
  * counter becomes somewhat more complicated, therefore a g_atomic_int_add()
  * doesn't suffice.  We're using a CAS loop (compare-and-exchange) to do our
  * stuff, but that shouldn't have that much of an overhead.
+ *
+ * The synchronous processing path (filters, parsers, rewrites and the
+ * fan-out to destinations) takes and drops a lot of references and ACKs on
+ * the same message in the same thread.  To avoid doing a CAS for each of
+ * these, the producer may enable a per-thread ref/ack cache using
+ * log_msg_refcache_start_producer(), see logmsg.c for the details.
  */
 
 #define LOGMSG_REFCACHE_SUSPEND_SHIFT                 31 /* number of bits to shift to get the SUSPEND flag */
@@ -398,49 +406,8 @@ log_msg_update_ack_and_ref(LogMessage *self, gint add_ref, gint add_ack)
   return log_msg_update_ack_and_ref_and_abort_and_suspended(self, add_ref, add_ack, 0, 0);
 }
 
-/**
- * log_msg_ref:
- * @self: LogMessage instance
- *
- * Increment reference count of @self and return the new reference.
- **/
-static inline LogMessage *
-log_msg_ref(LogMessage *self)
-{
-  if (!self)
-    return NULL;
-
-  gint old_value;
-
-  old_value = log_msg_update_ack_and_ref(self, 1, 0);
-  g_assert(LOGMSG_REFCACHE_VALUE_TO_REF(old_value) >= 1);
-  return self;
-}
-
-void _log_msg_free(LogMessage *self);
-
-/**
- * log_msg_unref:
- * @self: LogMessage instance
- *
- * Decrement reference count and free self if the reference count becomes 0.
- **/
-static inline void
-log_msg_unref(LogMessage *self)
-{
-  if (!self)
-    return;
-
-  gint old_value;
-
-  old_value = log_msg_update_ack_and_ref(self, -1, 0);
-  g_assert(LOGMSG_REFCACHE_VALUE_TO_REF(old_value) >= 1);
-
-  if (LOGMSG_REFCACHE_VALUE_TO_REF(old_value) == 1)
-    {
-      _log_msg_free(self);
-    }
-}
+LogMessage *log_msg_ref(LogMessage *self);
+void log_msg_unref(LogMessage *self);
 
 typedef gpointer LogMessagePin;
 
@@ -731,6 +698,9 @@ LogMessage *log_msg_new_internal(gint prio, const gchar *msg);
 LogMessage *log_msg_new_empty(void);
 LogMessage *log_msg_new_local(void);
 
+void log_msg_refcache_start_producer(LogMessage *self);
+void log_msg_refcache_stop(void);
+
 void log_msg_add_ack(LogMessage *msg, const LogPathOptions *path_options);
 void log_msg_ack(LogMessage *msg, const LogPathOptions *path_options, AckType ack_type);
 void log_msg_drop(LogMessage *msg, const LogPathOptions *path_options, AckType ack_type);
@@ -25,6 +25,9 @@
 
 #include <string.h>
 #include <stdlib.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 static GMutex nv_registry_lock;
 
@@ -297,11 +300,58 @@ nv_table_resolve_entry(NVTable *self, NVEntry *entry, gssize *length, NVType *ty
     return nv_table_resolve_direct(self, entry, length);
 }
 
+/* the binary search in _find_index_entry() stops once the range is
+ * narrowed down to this many entries, the rest is counted linearly */
+#define NV_INDEX_SCAN_BLOCK 16
+
+#if defined(__SSE2__)
+
+/* number of entries in index_table[0..n) with a handle smaller than @handle,
+ * comparing four handles at a time */
+static inline gint
+_count_smaller_handles(NVIndexEntry *index_table, gint n, NVHandle handle)
+{
+  /* SSE2 only has signed compares, flip the sign bits to compare unsigned */
+  const __m128i bias = _mm_set1_epi32(G_MININT32);
+  const __m128i needle = _mm_xor_si128(_mm_set1_epi32(handle), bias);
+  gint count = 0;
+  gint i;
+
+  for (i = 0; i + 4 <= n; i += 4)
+    {
+      /* each 16 bytes hold two (handle, ofs) pairs, pick the handles */
+      __m128 lo = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) &index_table[i]));
+      __m128 hi = _mm_castsi128_ps(_mm_loadu_si128((const __m128i *) &index_table[i + 2]));
+      __m128i handles = _mm_xor_si128(_mm_castps_si128(_mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))), bias);
+      gint mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(handles, needle)));
+
+      count += __builtin_popcount(mask);
+      if (mask != 0xF)
+        return count;
+    }
+  for (; i < n && index_table[i].handle < handle; i++)
+    count++;
+  return count;
+}
+
+#else
+
+static inline gint
+_count_smaller_handles(NVIndexEntry *index_table, gint n, NVHandle handle)
+{
+  gint i;
+
+  for (i = 0; i < n && index_table[i].handle < handle; i++)
+    ;
+  return i;
+}
+
+#endif
+
 static inline NVIndexEntry *
 _find_index_entry(NVIndexEntry *index_table, gint index_size, NVHandle handle, NVIndexEntry **index_slot)
 {
   gint l, h, m;
-  NVHandle mv;
 
   /* short-cut, check if "handle" is larger than the last - sorted -
    * element.  If it is, we won't be finding it in this table.  The loop
@@ -313,29 +363,27 @@ _find_index_entry(NVIndexEntry *index_table, gint index_size, NVHandle handle, N
       return NULL;
     }
 
-  /* open-coded binary search */
+  /* open-coded lower bound search: entries below l are smaller than
+   * handle, entries starting at h are larger or equal.  Large indexes
+   * (e.g. after json-parser() or kv-parser()) are narrowed down to a
+   * single block first, which is then compared in one go, instead of
+   * continuing with the mispredicted branches of the binary search. */
   l = 0;
-  h = index_size - 1;
-  while (l <= h)
+  h = index_size;
+  while (h - l > NV_INDEX_SCAN_BLOCK)
     {
-      m = (l+h) >> 1;
-      mv = index_table[m].handle;
-      if (mv == handle)
-        {
-          *index_slot = &index_table[m];
-          return &index_table[m];
-        }
-      else if (mv > handle)
-        {
-          h = m - 1;
-        }
+      m = (l + h) >> 1;
+      if (index_table[m].handle < handle)
+        l = m + 1;
       else
-        {
-          l = m + 1;
-        }
+        h = m;
     }
-  *index_slot = &index_table[l];
+  l += _count_smaller_handles(&index_table[l], h - l, handle);
+
   g_assert(l <= index_size);
+  *index_slot = &index_table[l];
+  if (l < index_size && index_table[l].handle == handle)
+    return &index_table[l];
   return NULL;
 }
 
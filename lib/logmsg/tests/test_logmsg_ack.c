@@ -177,3 +177,123 @@ ParameterizedTest(struct nv_pair *param, msg_ack, test_cloned_clone)
   cr_assert(t->acked);
   ack_record_free(t);
 }
+
+static gint refcache_ack_calls;
+static AckType refcache_ack_type;
+
+static void
+_count_acks(LogMessage *msg, AckType ack_type)
+{
+  refcache_ack_calls++;
+  refcache_ack_type = ack_type;
+}
+
+static LogMessage *
+_create_msg_with_ack(LogPathOptions *path_options)
+{
+  LogMessage *msg = log_msg_new_empty();
+
+  refcache_ack_calls = 0;
+  refcache_ack_type = AT_PROCESSED;
+  msg->ack_func = _count_acks;
+  path_options->ack_needed = TRUE;
+  return msg;
+}
+
+Test(msg_ack, refcache_delays_the_ack_until_stopped)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = _create_msg_with_ack(&path_options);
+
+  log_msg_refcache_start_producer(msg);
+  log_msg_add_ack(msg, &path_options);
+
+  /* fan out to a few branches, each of them acking and dropping the message */
+  for (gint i = 0; i < 8; i++)
+    {
+      log_msg_add_ack(msg, &path_options);
+      log_msg_ref(msg);
+    }
+  for (gint i = 0; i < 8; i++)
+    log_msg_drop(msg, &path_options, AT_PROCESSED);
+
+  log_msg_ack(msg, &path_options, AT_PROCESSED);
+  cr_assert_eq(refcache_ack_calls, 0);
+
+  log_msg_ref(msg);
+  log_msg_refcache_stop();
+  cr_assert_eq(refcache_ack_calls, 1);
+  cr_assert_eq(refcache_ack_type, AT_PROCESSED);
+
+  /* we still hold two references: the initial one and the one taken above */
+  log_msg_unref(msg);
+  log_msg_unref(msg);
+}
+
+Test(msg_ack, refcache_propagates_aborted_acks)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = _create_msg_with_ack(&path_options);
+
+  log_msg_refcache_start_producer(msg);
+  log_msg_add_ack(msg, &path_options);
+  log_msg_add_ack(msg, &path_options);
+  log_msg_ack(msg, &path_options, AT_ABORTED);
+  log_msg_ack(msg, &path_options, AT_PROCESSED);
+  log_msg_refcache_stop();
+
+  cr_assert_eq(refcache_ack_calls, 1);
+  cr_assert_eq(refcache_ack_type, AT_ABORTED);
+  log_msg_unref(msg);
+}
+
+static gpointer
+_ack_and_unref_in_another_thread(gpointer user_data)
+{
+  LogMessage *msg = (LogMessage *) user_data;
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  path_options.ack_needed = TRUE;
+  log_msg_drop(msg, &path_options, AT_PROCESSED);
+  return NULL;
+}
+
+Test(msg_ack, refcache_keeps_message_alive_while_other_threads_release_it)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = _create_msg_with_ack(&path_options);
+
+  log_msg_refcache_start_producer(msg);
+  log_msg_add_ack(msg, &path_options);
+  log_msg_ref(msg);
+
+  /* the last ref and ack is released by a different thread, e.g. a destination */
+  log_msg_unref(msg);
+  GThread *thread = g_thread_new(NULL, _ack_and_unref_in_another_thread, msg);
+  g_thread_join(thread);
+  cr_assert_eq(refcache_ack_calls, 0);
+
+  /* the message is acked and freed here */
+  log_msg_refcache_stop();
+  cr_assert_eq(refcache_ack_calls, 1);
+}
+
+Test(msg_ack, refcache_nested_start_keeps_outer_cache)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = _create_msg_with_ack(&path_options);
+  LogMessage *other = log_msg_new_empty();
+
+  log_msg_refcache_start_producer(msg);
+  log_msg_add_ack(msg, &path_options);
+
+  log_msg_refcache_start_producer(other);
+  log_msg_unref(other);
+  log_msg_refcache_stop();
+
+  log_msg_ack(msg, &path_options, AT_PROCESSED);
+  cr_assert_eq(refcache_ack_calls, 0);
+  log_msg_refcache_stop();
+  cr_assert_eq(refcache_ack_calls, 1);
+  log_msg_unref(msg);
+}
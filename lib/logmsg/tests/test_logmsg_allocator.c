@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "logmsg/logmsg-allocator.h"
+#include "logmsg/logmsg.h"
+#include "logpipe.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-cluster-single.h"
+#include "metrics/metric-names.h"
+#include "apphook.h"
+
+#include <iv.h>
+#include <string.h>
+
+#define BLOCK_SIZE 200
+#define NUM_BLOCKS 256
+
+static gssize
+_get_counter(const gchar *name)
+{
+  StatsClusterKey sc_key;
+
+  log_msg_allocator_flush_stats();
+
+  stats_lock();
+  stats_cluster_single_key_set(&sc_key, name, NULL, 0);
+  StatsCounterItem *counter = stats_get_counter(&sc_key, SC_TYPE_SINGLE_VALUE);
+  stats_unlock();
+
+  cr_assert(counter, "counter is not registered: %s", name);
+  return (gssize) stats_counter_get(counter);
+}
+
+#define ALLOCS() _get_counter(METRIC(events_allocator_allocations_total))
+#define FREES() _get_counter(METRIC(events_allocator_frees_total))
+#define SYSTEM_ALLOCS() _get_counter(METRIC(events_allocator_system_allocations_total))
+#define USED_BYTES() _get_counter(METRIC(events_allocator_used_bytes))
+#define CACHED_BYTES() _get_counter(METRIC(events_allocator_cached_bytes))
+
+Test(logmsg_allocator, size_classes)
+{
+  cr_assert_eq(log_msg_allocator_get_size_class(1), 0);
+  cr_assert_eq(log_msg_allocator_get_size_class(32), 0);
+  cr_assert_eq(log_msg_allocator_get_size_class(33), 1);
+  cr_assert_eq(log_msg_allocator_get_class_size(log_msg_allocator_get_size_class(BLOCK_SIZE)), 256);
+  cr_assert_eq(log_msg_allocator_get_class_size(log_msg_allocator_get_size_class(4096)), 4096);
+  cr_assert_eq(log_msg_allocator_get_size_class(4097), LOG_MSG_ALLOCATOR_HEAP_CLASS);
+}
+
+Test(logmsg_allocator, freed_block_is_reused_by_the_same_thread)
+{
+  guint8 size_class = log_msg_allocator_get_size_class(BLOCK_SIZE);
+
+  gpointer block = log_msg_allocator_alloc(size_class, BLOCK_SIZE);
+  log_msg_allocator_free(block, size_class);
+
+  gpointer reused = log_msg_allocator_alloc(size_class, BLOCK_SIZE);
+  cr_assert_eq(reused, block);
+  log_msg_allocator_free(reused, size_class);
+}
+
+Test(logmsg_allocator, heap_class_blocks_bypass_the_cache)
+{
+  gpointer block = log_msg_allocator_alloc(LOG_MSG_ALLOCATOR_HEAP_CLASS, 8192);
+
+  memset(block, 0, 8192);
+  log_msg_allocator_free(block, LOG_MSG_ALLOCATOR_HEAP_CLASS);
+}
+
+Test(logmsg_allocator, stats_track_allocations_frees_used_and_cached_bytes)
+{
+  guint8 size_class = log_msg_allocator_get_size_class(BLOCK_SIZE);
+  gsize block_size = log_msg_allocator_get_class_size(size_class);
+  gpointer blocks[NUM_BLOCKS];
+
+  gssize used_bytes = USED_BYTES();
+  gssize cached_bytes = CACHED_BYTES();
+  gssize allocs = ALLOCS();
+  gssize frees = FREES();
+
+  for (gint i = 0; i < NUM_BLOCKS; i++)
+    blocks[i] = log_msg_allocator_alloc(size_class, BLOCK_SIZE);
+
+  cr_assert_eq(ALLOCS(), allocs + NUM_BLOCKS);
+  cr_assert_eq(FREES(), frees);
+  cr_assert_eq(USED_BYTES(), used_bytes + NUM_BLOCKS * block_size);
+
+  for (gint i = 0; i < NUM_BLOCKS; i++)
+    log_msg_allocator_free(blocks[i], size_class);
+
+  cr_assert_eq(FREES(), frees + NUM_BLOCKS);
+  cr_assert_eq(USED_BYTES(), used_bytes);
+  cr_assert_gt(CACHED_BYTES(), cached_bytes);
+}
+
+Test(logmsg_allocator, heap_class_blocks_are_counted)
+{
+  gssize allocs = ALLOCS();
+  gssize frees = FREES();
+  gssize system_allocs = SYSTEM_ALLOCS();
+
+  log_msg_allocator_free(log_msg_allocator_alloc(LOG_MSG_ALLOCATOR_HEAP_CLASS, 8192), LOG_MSG_ALLOCATOR_HEAP_CLASS);
+
+  cr_assert_eq(ALLOCS(), allocs + 1);
+  cr_assert_eq(FREES(), frees + 1);
+  cr_assert_eq(SYSTEM_ALLOCS(), system_allocs + 1);
+}
+
+Test(logmsg_allocator, byte_gauges_survive_stats_reregistration)
+{
+  guint8 size_class = log_msg_allocator_get_size_class(BLOCK_SIZE);
+  gsize block_size = log_msg_allocator_get_class_size(size_class);
+
+  gssize used_bytes = USED_BYTES();
+
+  /* allocated while unregistered, freed while registered */
+  log_msg_allocator_unregister_stats();
+  gpointer block = log_msg_allocator_alloc(size_class, BLOCK_SIZE);
+  log_msg_allocator_flush_stats();
+  log_msg_allocator_register_stats();
+  cr_assert_eq(USED_BYTES(), used_bytes + block_size);
+
+  log_msg_allocator_free(block, size_class);
+  cr_assert_eq(USED_BYTES(), used_bytes);
+  cr_assert_geq(USED_BYTES(), 0);
+}
+
+static gpointer
+_free_blocks_in_another_thread(gpointer user_data)
+{
+  gpointer *blocks = (gpointer *) user_data;
+  guint8 size_class = log_msg_allocator_get_size_class(BLOCK_SIZE);
+
+  iv_init();
+  app_thread_start();
+  for (gint i = 0; i < NUM_BLOCKS; i++)
+    log_msg_allocator_free(blocks[i], size_class);
+  app_thread_stop();
+  iv_deinit();
+  return NULL;
+}
+
+Test(logmsg_allocator, blocks_freed_by_another_thread_are_returned_to_the_allocating_thread)
+{
+  guint8 size_class = log_msg_allocator_get_size_class(BLOCK_SIZE);
+  gpointer blocks[NUM_BLOCKS];
+
+  for (gint i = 0; i < NUM_BLOCKS; i++)
+    blocks[i] = log_msg_allocator_alloc(size_class, BLOCK_SIZE);
+
+  GThread *thread = g_thread_new(NULL, _free_blocks_in_another_thread, blocks);
+  g_thread_join(thread);
+
+  gssize system_allocs = SYSTEM_ALLOCS();
+
+  for (gint i = 0; i < NUM_BLOCKS; i++)
+    blocks[i] = log_msg_allocator_alloc(size_class, BLOCK_SIZE);
+
+  cr_assert_eq(SYSTEM_ALLOCS(), system_allocs,
+               "blocks released by the other thread should have been reused");
+
+  for (gint i = 0; i < NUM_BLOCKS; i++)
+    log_msg_allocator_free(blocks[i], size_class);
+}
+
+Test(logmsg_allocator, log_messages_and_queue_nodes_use_the_allocator)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  gssize allocs = ALLOCS();
+  gssize used_bytes = USED_BYTES();
+
+  LogMessage *msg = log_msg_new_empty();
+  LogMessage *clone = log_msg_clone_cow(msg, &path_options);
+
+  GList *nodes = NULL;
+  for (gint i = 0; i < LOGMSG_MAX_NODES + 1; i++)
+    nodes = g_list_prepend(nodes, log_msg_alloc_queue_node(msg, &path_options));
+  g_list_free_full(nodes, (GDestroyNotify) log_msg_free_queue_node);
+
+  cr_assert_gt(ALLOCS(), allocs + 2);
+
+  log_msg_unref(clone);
+  log_msg_unref(msg);
+  cr_assert_eq(USED_BYTES(), used_bytes);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 1;
+  stats_reinit(&stats_opts);
+  log_msg_allocator_register_stats();
+}
+
+static void
+teardown(void)
+{
+  app_shutdown();
+}
+
+TestSuite(logmsg_allocator, .init = setup, .fini = teardown);
@@ -874,6 +874,51 @@ Test(nvtable, test_nvtable_lookup)
     }
 }
 
+static gboolean
+_check_index_is_sorted(NVHandle handle, NVEntry *entry, NVIndexEntry *index_entry, gpointer user_data)
+{
+  NVHandle *prev_handle = (NVHandle *) user_data;
+
+  cr_assert_gt(handle, *prev_handle);
+  *prev_handle = handle;
+  return FALSE;
+}
+
+Test(nvtable, test_nvtable_lookup_in_large_index)
+{
+  NVTable *tab = nv_table_new(STATIC_VALUES, 16, 65536);
+  gchar name[16];
+  guint32 memory_needed;
+  NVHandle prev_handle = 0;
+
+  /* odd handles only, inserted in an order that is neither ascending nor
+   * descending, so that every insertion position gets exercised */
+  for (gint i = 0; i < 500; i++)
+    {
+      NVHandle handle = STATIC_VALUES + 1 + 2 * ((i * 7919) % 500);
+
+      g_snprintf(name, sizeof(name), "VAL%d", handle);
+      cr_assert(nv_table_add_value(tab, handle, name, strlen(name), name, strlen(name), 0, NULL, &memory_needed));
+    }
+  cr_assert_eq(tab->index_size, 500);
+
+  for (NVHandle handle = STATIC_VALUES + 1; handle < STATIC_VALUES + 1002; handle++)
+    {
+      if ((handle - STATIC_VALUES - 1) % 2 == 0)
+        {
+          g_snprintf(name, sizeof(name), "VAL%d", handle);
+          assert_nvtable(tab, handle, name, strlen(name));
+        }
+      else
+        {
+          cr_assert_not(nv_table_is_value_set(tab, handle), "handle %d should not be set", handle);
+        }
+    }
+
+  nv_table_foreach_entry(tab, _check_index_is_sorted, &prev_handle);
+  nv_table_unref(tab);
+}
+
 Test(nvtable, test_nvtable_clone_grows_the_cloned_structure)
 {
   NVTable *tab, *tab_clone;
@@ -113,6 +113,66 @@ log_pipe_queue(LogPipe *self, LogMessage *msg, const LogPathOptions *path_option
     log_pipe_queue_slow_path(self, msg, path_options);
 }
 
+/*
+ * Batched variant of log_pipe_queue(): msgs[i] travels with
+ * path_options[i], the same way as if log_pipe_queue() was called for each
+ * message in order.
+ *
+ * Pipes that implement queue_batch() get the messages in chunks of at most
+ * LOG_PIPE_MAX_BATCH_SIZE, so they can use fixed size arrays on the stack.
+ * Pipes that don't, or those that need to alter the path options of the
+ * messages passing through, get them one by one.
+ */
+static inline gboolean
+_is_batch_fastpath(LogPipe *self)
+{
+  if (!self->queue_batch)
+    return FALSE;
+
+  if ((self->flags & PIF_CONFIG_RELATED) != 0 && pipe_single_step_hook)
+    return FALSE;
+
+  if (self->flags & (PIF_HARD_FLOW_CONTROL | PIF_NO_HARD_FLOW_CONTROL | PIF_JUNCTION_END | PIF_CONDITIONAL_MIDPOINT))
+    return FALSE;
+
+  return TRUE;
+}
+
+void
+log_pipe_queue_batch(LogPipe *self, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs)
+{
+  g_assert((self->flags & PIF_INITIALIZED) != 0);
+
+  if (!_is_batch_fastpath(self))
+    {
+      for (gint i = 0; i < num_msgs; i++)
+        log_pipe_queue(self, msgs[i], path_options[i]);
+      return;
+    }
+
+  if (self->flags & PIF_SYNC_FILTERX_TO_MSG)
+    {
+      for (gint i = 0; i < num_msgs; i++)
+        filterx_eval_sync_message(path_options[i]->filterx_context, &msgs[i], path_options[i]);
+    }
+
+  for (gint i = 0; i < num_msgs; i += LOG_PIPE_MAX_BATCH_SIZE)
+    self->queue_batch(self, &msgs[i], &path_options[i], MIN(num_msgs - i, LOG_PIPE_MAX_BATCH_SIZE));
+}
+
+void
+log_pipe_forward_batch(LogPipe *self, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs)
+{
+  if (self->pipe_next)
+    {
+      log_pipe_queue_batch(self->pipe_next, msgs, path_options, num_msgs);
+    }
+  else
+    {
+      for (gint i = 0; i < num_msgs; i++)
+        log_msg_drop(msgs[i], path_options[i], AT_PROCESSED);
+    }
+}
 
 EVTTAG *
 log_pipe_location_tag(LogPipe *pipe)
@@ -296,6 +296,9 @@ log_path_options_pop_junction(LogPathOptions *local_path_options)
     local_path_options->lpo_parent_junction = local_path_options->lpo_parent_junction->lpo_parent_junction;
 }
 
+/* upper limit on the number of messages passed to a single queue_batch() call */
+#define LOG_PIPE_MAX_BATCH_SIZE 64
+
 typedef struct _LogPipeOptions LogPipeOptions;
 
 struct _LogPipeOptions
@@ -309,6 +312,8 @@ struct _LogPipe
   gint32 flags;
 
   void (*queue)(LogPipe *self, LogMessage *msg, const LogPathOptions *path_options);
+  /* optional, processes up to LOG_PIPE_MAX_BATCH_SIZE messages in one call, see log_pipe_queue_batch() */
+  void (*queue_batch)(LogPipe *self, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs);
 
   GlobalConfig *cfg;
   LogExprNode *expr_node;
@@ -464,6 +469,8 @@ const gchar *log_pipe_get_persist_name(const LogPipe *self);
 
 void log_pipe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options);
 void log_pipe_forward_msg(LogPipe *self, LogMessage *msg, const LogPathOptions *path_options);
+void log_pipe_queue_batch(LogPipe *self, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs);
+void log_pipe_forward_batch(LogPipe *self, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs);
 
 void log_pipe_set_options(LogPipe *self, const LogPipeOptions *options);
 void log_pipe_set_internal(LogPipe *self, gboolean internal);
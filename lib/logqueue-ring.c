@@ -0,0 +1,660 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "logqueue-ring.h"
+#include "logpipe.h"
+#include "messages.h"
+#include "stats/stats-registry.h"
+#include "stats/stats-counter.h"
+#include "stats/stats-cluster-single.h"
+#include "compat/pow2.h"
+
+#include <string.h>
+
+QueueType log_queue_ring_type = "RING";
+
+/*
+ * LogQueueRing is an alternative to LogQueueFifo, optimized for the case
+ * where a lot of input threads feed a single destination.
+ *
+ *   - producers put items into a bounded, lock-free multi-producer/single
+ *     consumer ring buffer (the design follows Dmitry Vyukov's bounded
+ *     queue: every slot has a sequence number which tells producers and the
+ *     consumer whether the slot is free or published)
+ *
+ *   - if the ring is full, items go to a mutex-protected overflow list.
+ *     This only happens if the ring is smaller than the number of
+ *     flow-controlled items in flight, as non-flow-controlled items are
+ *     dropped above log-fifo-size anyway.  While the overflow list is
+ *     non-empty, producers keep using it, so the ordering of the items
+ *     pushed by a single thread is retained.
+ *
+ *   - the consumer side (output list and backlog) is private to the
+ *     output thread and is stored in plain arrays, so there's no
+ *     per-message allocation anywhere on the path.
+ *
+ * The items flow in this sequence:
+ *
+ *    ring/overflow (any thread) -> output (output thread) -> backlog (output thread)
+ *
+ * and rewinds move items from the backlog back to the head of the output
+ * list, the same way LogQueueFifo does it.
+ *
+ * Waking up the consumer: log_queue_check_items() registers the push
+ * notification callback under the protection of LogQueue->lock if it saw
+ * an empty queue. Producers only take that lock if they were the ones who
+ * put the first item into an empty ring, every other push is lockless.
+ */
+
+#define LOG_QUEUE_RING_CACHE_LINE_SIZE 64
+#define LOG_QUEUE_RING_MIN_SLOTS 64
+#define LOG_QUEUE_RING_MAX_SLOTS (1 << 20)
+
+#define LOG_QUEUE_RING_ENTRY_ACK_NEEDED                0x01
+#define LOG_QUEUE_RING_ENTRY_FLOW_CONTROL_REQUESTED    0x02
+
+typedef struct _LogQueueRingEntry
+{
+  LogMessage *msg;
+  guint8 flags;
+} LogQueueRingEntry;
+
+typedef struct _LogQueueRingSlot
+{
+  gint sequence;
+  guint8 flags;
+  LogMessage *msg;
+} LogQueueRingSlot;
+
+/* growable circular array, only used by a single thread at a time */
+typedef struct _LogQueueRingList
+{
+  LogQueueRingEntry *entries;
+  guint size;
+  guint head;
+  guint len;
+} LogQueueRingList;
+
+typedef struct _LogQueueRing
+{
+  LogQueue super;
+
+  gint log_fifo_size;
+  gint num_slots;
+  LogQueueRingSlot *slots;
+
+  /* items in the ring, overflow and output list, used to enforce log_fifo_size */
+  gint non_flow_controlled_len;
+
+  /* protected by super.lock */
+  LogQueueRingList overflow;
+  gint overflow_len;
+
+  /* output thread only */
+  LogQueueRingList output;
+  LogQueueRingList backlog;
+
+  struct
+  {
+    StatsClusterKey *capacity_sc_key;
+    StatsCounterItem *capacity;
+  } metrics;
+
+  /* producer and consumer positions live on their own cache lines */
+  gchar _pad0[LOG_QUEUE_RING_CACHE_LINE_SIZE];
+  gint tail;
+  gchar _pad1[LOG_QUEUE_RING_CACHE_LINE_SIZE - sizeof(gint)];
+  gint head;
+  gchar _pad2[LOG_QUEUE_RING_CACHE_LINE_SIZE - sizeof(gint)];
+} LogQueueRing;
+
+static inline guint8
+_entry_flags_from_path_options(const LogPathOptions *path_options)
+{
+  return (path_options->ack_needed ? LOG_QUEUE_RING_ENTRY_ACK_NEEDED : 0) |
+         (path_options->flow_control_requested ? LOG_QUEUE_RING_ENTRY_FLOW_CONTROL_REQUESTED : 0);
+}
+
+static inline gboolean
+_entry_is_flow_controlled(const LogQueueRingEntry *entry)
+{
+  return !!(entry->flags & LOG_QUEUE_RING_ENTRY_FLOW_CONTROL_REQUESTED);
+}
+
+static inline gboolean
+_entry_ack_needed(const LogQueueRingEntry *entry)
+{
+  return !!(entry->flags & LOG_QUEUE_RING_ENTRY_ACK_NEEDED);
+}
+
+/* LogQueueRingList */
+
+static void
+_list_grow(LogQueueRingList *self)
+{
+  guint new_size = self->size ? self->size * 2 : 16;
+  LogQueueRingEntry *new_entries = g_new(LogQueueRingEntry, new_size);
+
+  for (guint i = 0; i < self->len; i++)
+    new_entries[i] = self->entries[(self->head + i) & (self->size - 1)];
+
+  g_free(self->entries);
+  self->entries = new_entries;
+  self->size = new_size;
+  self->head = 0;
+}
+
+static inline void
+_list_push_tail(LogQueueRingList *self, LogQueueRingEntry entry)
+{
+  if (self->len == self->size)
+    _list_grow(self);
+
+  self->entries[(self->head + self->len) & (self->size - 1)] = entry;
+  self->len++;
+}
+
+static inline void
+_list_push_head(LogQueueRingList *self, LogQueueRingEntry entry)
+{
+  if (self->len == self->size)
+    _list_grow(self);
+
+  self->head = (self->head - 1) & (self->size - 1);
+  self->entries[self->head] = entry;
+  self->len++;
+}
+
+static inline LogQueueRingEntry *
+_list_peek(LogQueueRingList *self, guint n)
+{
+  g_assert(n < self->len);
+  return &self->entries[(self->head + n) & (self->size - 1)];
+}
+
+static inline LogQueueRingEntry
+_list_pop_head(LogQueueRingList *self)
+{
+  LogQueueRingEntry entry = *_list_peek(self, 0);
+
+  self->head = (self->head + 1) & (self->size - 1);
+  self->len--;
+  return entry;
+}
+
+static inline LogQueueRingEntry
+_list_pop_tail(LogQueueRingList *self)
+{
+  LogQueueRingEntry entry = *_list_peek(self, self->len - 1);
+
+  self->len--;
+  return entry;
+}
+
+static inline void
+_list_swap(LogQueueRingList *a, LogQueueRingList *b)
+{
+  LogQueueRingList tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+static void
+_list_free(LogQueueRingList *self)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  while (self->len > 0)
+    {
+      LogQueueRingEntry entry = _list_pop_head(self);
+
+      path_options.ack_needed = _entry_ack_needed(&entry);
+      log_msg_ack(entry.msg, &path_options, AT_ABORTED);
+      log_msg_unref(entry.msg);
+    }
+  g_free(self->entries);
+  self->entries = NULL;
+  self->size = 0;
+}
+
+/* ring buffer */
+
+static gboolean
+_ring_try_push(LogQueueRing *self, LogMessage *msg, guint8 flags, gboolean *was_empty)
+{
+  LogQueueRingSlot *slot;
+  guint pos = (guint) g_atomic_int_get(&self->tail);
+
+  while (TRUE)
+    {
+      slot = &self->slots[pos & (self->num_slots - 1)];
+      gint diff = (gint) ((guint) g_atomic_int_get(&slot->sequence) - pos);
+
+      if (diff == 0)
+        {
+          if (g_atomic_int_compare_and_exchange(&self->tail, (gint) pos, (gint) (pos + 1)))
+            break;
+          pos = (guint) g_atomic_int_get(&self->tail);
+        }
+      else if (diff < 0)
+        {
+          /* the slot still holds an item from the previous lap: full */
+          return FALSE;
+        }
+      else
+        {
+          /* another producer claimed this position, retry with the new tail */
+          pos = (guint) g_atomic_int_get(&self->tail);
+        }
+    }
+
+  *was_empty = (pos == (guint) g_atomic_int_get(&self->head));
+
+  slot->msg = msg;
+  slot->flags = flags;
+  g_atomic_int_set(&slot->sequence, (gint) (pos + 1));
+  return TRUE;
+}
+
+/* can only run from the output thread */
+static gboolean
+_ring_try_pop(LogQueueRing *self, LogQueueRingEntry *entry)
+{
+  guint pos = (guint) g_atomic_int_get(&self->head);
+  LogQueueRingSlot *slot = &self->slots[pos & (self->num_slots - 1)];
+
+  /* either empty, or the producer has claimed the slot but has not published it yet */
+  if ((guint) g_atomic_int_get(&slot->sequence) != pos + 1)
+    return FALSE;
+
+  entry->msg = slot->msg;
+  entry->flags = slot->flags;
+  slot->msg = NULL;
+
+  g_atomic_int_set(&slot->sequence, (gint) (pos + self->num_slots));
+  g_atomic_int_set(&self->head, (gint) (pos + 1));
+  return TRUE;
+}
+
+static inline gint64
+_ring_get_length(LogQueueRing *self)
+{
+  guint head = (guint) g_atomic_int_get(&self->head);
+  guint tail = (guint) g_atomic_int_get(&self->tail);
+
+  return (gint) (tail - head);
+}
+
+/* NOTE: this is inherently racy, the same way as it is in LogQueueFifo */
+static gint64
+log_queue_ring_get_length(LogQueue *s)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+
+  return _ring_get_length(self) + g_atomic_int_get(&self->overflow_len) + self->output.len;
+}
+
+/* NOTE: this is inherently racy, can only be called if log processing is suspended (e.g. reload time) */
+static gboolean
+log_queue_ring_keep_on_reload(LogQueue *s)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+  return log_queue_ring_get_length(s) > 0 || self->backlog.len > 0;
+}
+
+static inline gboolean
+_message_has_to_be_dropped(LogQueueRing *self, const LogPathOptions *path_options)
+{
+  return !path_options->flow_control_requested
+         && g_atomic_int_get(&self->non_flow_controlled_len) >= self->log_fifo_size;
+}
+
+static void
+_push_tail_to_overflow(LogQueueRing *self, LogQueueRingEntry entry)
+{
+  g_mutex_lock(&self->super.lock);
+  _list_push_tail(&self->overflow, entry);
+  g_atomic_int_set(&self->overflow_len, self->overflow.len);
+  log_queue_push_notify(&self->super);
+  g_mutex_unlock(&self->super.lock);
+}
+
+/*
+ * Can be called from any thread.
+ *
+ * NOTE: It consumes the reference passed by the caller.
+ */
+static void
+log_queue_ring_push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+
+  /* the race on non_flow_controlled_len has the same consequences as in
+   * LogQueueFifo: we might drop or keep a couple of messages more than
+   * what log_fifo_size would permit. */
+  if (_message_has_to_be_dropped(self, path_options))
+    {
+      log_queue_dropped_messages_inc(&self->super);
+      log_msg_drop(msg, path_options, AT_PROCESSED);
+
+      msg_debug("Destination queue full, dropping message",
+                evt_tag_int("queue_len", log_queue_ring_get_length(&self->super)),
+                evt_tag_int("log_fifo_size", self->log_fifo_size),
+                evt_tag_str("persist_name", self->super.persist_name));
+      return;
+    }
+
+  log_msg_write_protect(msg);
+
+  LogQueueRingEntry entry = { .msg = msg, .flags = _entry_flags_from_path_options(path_options) };
+
+  /* account before publishing, as the consumer may pop the item right away */
+  log_queue_queued_messages_inc(&self->super);
+  log_queue_memory_usage_add(&self->super, log_msg_get_size(msg));
+  if (!path_options->flow_control_requested)
+    g_atomic_int_inc(&self->non_flow_controlled_len);
+
+  gboolean was_empty = FALSE;
+  if (g_atomic_int_get(&self->overflow_len) == 0 && _ring_try_push(self, entry.msg, entry.flags, &was_empty))
+    {
+      if (was_empty)
+        {
+          g_mutex_lock(&self->super.lock);
+          log_queue_push_notify(&self->super);
+          g_mutex_unlock(&self->super.lock);
+        }
+      return;
+    }
+
+  /* slow path, the ring is full or older items are waiting in the overflow list */
+  _push_tail_to_overflow(self, entry);
+}
+
+/*
+ * Can only run from the output thread.
+ */
+static void
+_move_items_from_overflow_to_output(LogQueueRing *self)
+{
+  g_mutex_lock(&self->super.lock);
+  if (self->output.len == 0)
+    {
+      _list_swap(&self->output, &self->overflow);
+    }
+  else
+    {
+      while (self->overflow.len > 0)
+        _list_push_tail(&self->output, _list_pop_head(&self->overflow));
+    }
+  g_atomic_int_set(&self->overflow_len, 0);
+  g_mutex_unlock(&self->super.lock);
+}
+
+/*
+ * Can only run from the output thread.
+ *
+ * Makes sure the next item (if any) is at the head of the output list.
+ */
+static gboolean
+_fetch_output(LogQueueRing *self)
+{
+  if (self->output.len > 0)
+    return TRUE;
+
+  LogQueueRingEntry entry;
+  if (_ring_try_pop(self, &entry))
+    {
+      _list_push_tail(&self->output, entry);
+      return TRUE;
+    }
+
+  /* the overflow list is only used while the ring is full or while older
+   * items are still in the overflow list, so it is safe to take them once
+   * the ring has been emptied. */
+  if (g_atomic_int_get(&self->overflow_len) > 0 && _ring_get_length(self) == 0)
+    _move_items_from_overflow_to_output(self);
+
+  return self->output.len > 0;
+}
+
+/*
+ * Can only run from the output thread.
+ */
+static LogMessage *
+log_queue_ring_peek_head(LogQueue *s)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+
+  if (!_fetch_output(self))
+    return NULL;
+
+  return log_msg_ref(_list_peek(&self->output, 0)->msg);
+}
+
+/*
+ * Can only run from the output thread.
+ *
+ * NOTE: this returns a reference which the caller must take care to free.
+ */
+static LogMessage *
+log_queue_ring_pop_head(LogQueue *s, LogPathOptions *path_options)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+
+  if (!_fetch_output(self))
+    return NULL;
+
+  LogQueueRingEntry entry = _list_pop_head(&self->output);
+
+  path_options->ack_needed = _entry_ack_needed(&entry);
+  if (!_entry_is_flow_controlled(&entry))
+    g_atomic_int_add(&self->non_flow_controlled_len, -1);
+
+  log_queue_queued_messages_dec(&self->super);
+
+  /* push to backlog */
+  _list_push_tail(&self->backlog, entry);
+  return log_msg_ref(entry.msg);
+}
+
+/*
+ * Can only run from the output thread.
+ */
+static void
+log_queue_ring_ack_backlog(LogQueue *s, guint rewind_count)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  for (guint pos = 0; pos < rewind_count && self->backlog.len > 0; pos++)
+    {
+      LogQueueRingEntry entry = _list_pop_head(&self->backlog);
+
+      log_queue_memory_usage_sub(&self->super, log_msg_get_size(entry.msg));
+
+      path_options.ack_needed = _entry_ack_needed(&entry);
+      log_msg_ack(entry.msg, &path_options, AT_PROCESSED);
+      log_msg_unref(entry.msg);
+    }
+}
+
+/*
+ * Can only run from the output thread.
+ */
+static LogMessage *
+log_queue_ring_peek_backlog(LogQueue *s, guint n)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+
+  if (n >= self->backlog.len)
+    return NULL;
+
+  return log_msg_ref(_list_peek(&self->backlog, n)->msg);
+}
+
+/*
+ * Can only run from the output thread.
+ */
+static void
+log_queue_ring_rewind_backlog(LogQueue *s, guint rewind_count)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+
+  if (rewind_count > self->backlog.len)
+    rewind_count = self->backlog.len;
+
+  for (guint pos = 0; pos < rewind_count; pos++)
+    {
+      LogQueueRingEntry entry = _list_pop_tail(&self->backlog);
+
+      _list_push_head(&self->output, entry);
+      if (!_entry_is_flow_controlled(&entry))
+        g_atomic_int_inc(&self->non_flow_controlled_len);
+
+      log_queue_queued_messages_inc(&self->super);
+    }
+}
+
+/*
+ * Can only run from the output thread.
+ */
+static void
+log_queue_ring_rewind_backlog_all(LogQueue *s)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+
+  log_queue_ring_rewind_backlog(s, self->backlog.len);
+}
+
+static inline void
+_register_counters(LogQueueRing *self, gint stats_level, StatsClusterKeyBuilder *builder)
+{
+  if (!builder)
+    return;
+
+  {
+    stats_cluster_key_builder_push(builder);
+
+    stats_cluster_key_builder_set_name(builder, "capacity");
+    self->metrics.capacity_sc_key = stats_cluster_key_builder_build_single(builder);
+
+    stats_cluster_key_builder_pop(builder);
+  }
+
+  {
+    stats_lock();
+    stats_register_counter(stats_level, self->metrics.capacity_sc_key, SC_TYPE_SINGLE_VALUE,
+                           &self->metrics.capacity);
+    stats_unlock();
+  }
+}
+
+static void
+_unregister_counters(LogQueueRing *self)
+{
+  {
+    stats_lock();
+    if (self->metrics.capacity_sc_key)
+      {
+        stats_unregister_counter(self->metrics.capacity_sc_key, SC_TYPE_SINGLE_VALUE,
+                                 &self->metrics.capacity);
+
+        stats_cluster_key_free(self->metrics.capacity_sc_key);
+      }
+    stats_unlock();
+  }
+}
+
+static void
+log_queue_ring_free(LogQueue *s)
+{
+  LogQueueRing *self = (LogQueueRing *) s;
+  LogQueueRingEntry entry;
+
+  while (_ring_try_pop(self, &entry))
+    _list_push_tail(&self->output, entry);
+
+  _list_free(&self->output);
+  _list_free(&self->overflow);
+  _list_free(&self->backlog);
+  g_free(self->slots);
+
+  _unregister_counters(self);
+
+  log_queue_free_method(s);
+}
+
+static gint
+_calculate_num_slots(gint log_fifo_size)
+{
+  gint num_slots = pow2(round_to_log2(log_fifo_size));
+
+  return CLAMP(num_slots, LOG_QUEUE_RING_MIN_SLOTS, LOG_QUEUE_RING_MAX_SLOTS);
+}
+
+LogQueue *
+log_queue_ring_new(gint log_fifo_size, const gchar *persist_name, gint stats_level,
+                   StatsClusterKeyBuilder *driver_sck_builder, StatsClusterKeyBuilder *queue_sck_builder)
+{
+  LogQueueRing *self = g_new0(LogQueueRing, 1);
+
+  if (queue_sck_builder)
+    {
+      stats_cluster_key_builder_push(queue_sck_builder);
+      stats_cluster_key_builder_set_name_prefix(queue_sck_builder, "memory_queue_");
+    }
+
+  log_queue_init_instance(&self->super, persist_name, stats_level, driver_sck_builder, queue_sck_builder);
+  self->super.type = log_queue_ring_type;
+  self->super.get_length = log_queue_ring_get_length;
+  self->super.keep_on_reload = log_queue_ring_keep_on_reload;
+  self->super.push_tail = log_queue_ring_push_tail;
+  self->super.pop_head = log_queue_ring_pop_head;
+  self->super.peek_head = log_queue_ring_peek_head;
+  self->super.ack_backlog = log_queue_ring_ack_backlog;
+  self->super.peek_backlog = log_queue_ring_peek_backlog;
+  self->super.rewind_backlog = log_queue_ring_rewind_backlog;
+  self->super.rewind_backlog_all = log_queue_ring_rewind_backlog_all;
+
+  self->super.free_fn = log_queue_ring_free;
+
+  self->log_fifo_size = log_fifo_size;
+  self->num_slots = _calculate_num_slots(log_fifo_size);
+  self->slots = g_new0(LogQueueRingSlot, self->num_slots);
+  for (gint i = 0; i < self->num_slots; i++)
+    self->slots[i].sequence = i;
+
+  _register_counters(self, stats_level, queue_sck_builder);
+
+  stats_counter_set(self->metrics.capacity, self->log_fifo_size);
+
+  if (queue_sck_builder)
+    stats_cluster_key_builder_pop(queue_sck_builder);
+
+  return &self->super;
+}
+
+QueueType
+log_queue_ring_get_type(void)
+{
+  return log_queue_ring_type;
+}
@@ -56,6 +56,45 @@ _reinject_message(LogPipe *front_pipe, LogMessage *msg, const LogPathOptions *pa
 
 #if SYSLOG_NG_HAVE_IV_WORK_POOL_SUBMIT_CONTINUATION
 
+/*
+ * Messages of a LogSchedulerBatch are reinjected in chunks via
+ * log_pipe_queue_batch(), so that pipes along the path can amortize their
+ * per-message setup costs.  The received timestamps are saved upfront, as
+ * the messages may be freed by the time the chunk returns.
+ */
+static void
+_reinject_messages(LogPipe *front_pipe, LogMessage **msgs, LogPathOptions *path_options, gint num_msgs,
+                   StatsAggregator *processing_latency)
+{
+  const LogPathOptions *path_options_refs[LOG_PIPE_MAX_BATCH_SIZE];
+  UnixTime recvd_timestamps[LOG_PIPE_MAX_BATCH_SIZE];
+
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      path_options_refs[i] = &path_options[i];
+      if (processing_latency)
+        recvd_timestamps[i] = msgs[i]->timestamps[LM_TS_RECVD];
+    }
+
+  if (front_pipe)
+    {
+      log_pipe_queue_batch(front_pipe, msgs, path_options_refs, num_msgs);
+    }
+  else
+    {
+      for (gint i = 0; i < num_msgs; i++)
+        log_msg_drop(msgs[i], path_options_refs[i], AT_PROCESSED);
+    }
+
+  if (!processing_latency)
+    return;
+
+  UnixTime now;
+  unix_time_set_precise_now(&now);
+  for (gint i = 0; i < num_msgs; i++)
+    stats_aggregator_add_data_point(processing_latency, unix_time_diff_in_msec(&now, &recvd_timestamps[i]));
+}
+
 /* LogSchedulerBatch */
 
 LogSchedulerBatch *
@@ -118,21 +157,31 @@ _work(gpointer s, gpointer arg)
         LogSchedulerBatch *batch = iv_list_entry(batch_list_head, LogSchedulerBatch, list);
         iv_list_del(&batch->list);
 
+        LogMessage *msgs[LOG_PIPE_MAX_BATCH_SIZE];
+        LogPathOptions path_options[LOG_PIPE_MAX_BATCH_SIZE];
+        gint num_msgs = 0;
+
         iv_list_for_each_safe(msg_list_head, next_msg_list_head, &batch->elements)
         {
           LogMessageQueueNode *node = iv_list_entry(msg_list_head, LogMessageQueueNode, list);
 
           iv_list_del(&node->list);
 
-          LogMessage *msg = log_msg_ref(node->msg);
+          msgs[num_msgs] = log_msg_ref(node->msg);
 
-          LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
-          path_options.ack_needed = node->ack_needed;
-          path_options.flow_control_requested = node->flow_control_requested;
+          path_options[num_msgs] = (LogPathOptions) LOG_PATH_OPTIONS_INIT;
+          path_options[num_msgs].ack_needed = node->ack_needed;
+          path_options[num_msgs].flow_control_requested = node->flow_control_requested;
+          num_msgs++;
 
           log_msg_free_queue_node(node);
 
-          _reinject_message(partition->front_pipe, msg, &path_options, partition->metrics.processing_latency);
+          if (num_msgs == LOG_PIPE_MAX_BATCH_SIZE)
+            {
+              _reinject_messages(partition->front_pipe, msgs, path_options, num_msgs,
+                                 partition->metrics.processing_latency);
+              num_msgs = 0;
+            }
 
           msgs_processed++;
           stats_counter_inc(partition->metrics.processed_events_total);
@@ -140,6 +189,9 @@ _work(gpointer s, gpointer arg)
           /* We process the current batch even if we bumped into the limit during its processing. */
           fetch_limit_reached = partition->log_fetch_limit > 0 && msgs_processed >= partition->log_fetch_limit;
         }
+        if (num_msgs > 0)
+          _reinject_messages(partition->front_pipe, msgs, path_options, num_msgs,
+                             partition->metrics.processing_latency);
         _batch_free(batch);
       }
       g_mutex_lock(&partition->batches_lock);
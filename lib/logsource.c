@@ -38,6 +38,7 @@
 #include "scratch-buffers.h"
 #include "mainloop.h"
 #include "mainloop-call.h"
+#include "mainloop-io-worker.h"
 #include "compat/valgrind.h"
 
 #include <string.h>
@@ -486,6 +487,8 @@ _allocate_counter_keys(LogSource *self)
   stats_cluster_key_builder_pop(kb);
 }
 
+static void _close_parking(LogSource *self);
+
 gboolean
 log_source_init(LogPipe *s)
 {
@@ -500,6 +503,7 @@ log_source_init(LogPipe *s)
 
   _allocate_counter_keys(self);
   _register_counters(self);
+  self->parked.closed = FALSE;
 
   return TRUE;
 }
@@ -508,6 +512,8 @@ gboolean
 log_source_deinit(LogPipe *s)
 {
   LogSource *self = (LogSource *) s;
+
+  _close_parking(self);
   ack_tracker_deinit(self->ack_tracker);
 
   _unregister_counters(self);
@@ -528,6 +534,10 @@ log_source_post(LogSource *self, LogMessage *msg)
   if (path_options.flow_control_requested)
     msg_trace("Enabling flow control", log_pipe_location_tag(&self->super), evt_tag_msg_reference(msg));
 
+  /* NOTE: the message is processed synchronously in this thread, so the
+   * ref/ack changes along the log path are batched up until we return */
+  log_msg_refcache_start_producer(msg);
+
   ack_tracker_track_msg(self->ack_tracker, msg);
 
   /* NOTE: we start by enabling flow-control, thus we need an acknowledgement */
@@ -560,6 +570,8 @@ log_source_post(LogSource *self, LogMessage *msg)
   log_pipe_queue(&self->super, msg, &path_options);
   scratch_buffers_reclaim_marked(mark);
 
+  log_msg_refcache_stop();
+
   valgrind_stop_instrumentation();
 }
 
@@ -612,9 +624,9 @@ _update_processing_latency(LogSource *self, UnixTime *recvd_stamp)
 }
 
 static void
-log_source_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+_process_msg(LogSource *self, LogMessage *msg, const LogPathOptions *path_options)
 {
-  LogSource *self = (LogSource *) s;
+  LogPipe *s = &self->super;
   gint i;
 
   msg_set_context(msg);
@@ -676,6 +688,261 @@ log_source_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options
   msg_set_context(NULL);
 }
 
+/*
+ * use-dns(async) support
+ *
+ * Messages whose sender is not in the DNS cache are parked until a
+ * resolver thread looks it up, instead of blocking the thread that posted
+ * them.  Messages arriving later are parked behind them to keep their
+ * order, even if their sender is already known.  Parked messages keep
+ * their flow-control window slot, so a source with a slow DNS server is
+ * eventually suspended, the same way as one with a slow destination.
+ *
+ * Only one lookup is waited for at a time: the one of the oldest parked
+ * message. Its callback holds a reference to the source.
+ *
+ * The resolver thread only moves the messages that became ready to
+ * parked.ready, they are forwarded by log_source_flush_parked_messages(),
+ * scheduled to run on an I/O worker via schedule_parked_flush().  While a
+ * flush is scheduled, new messages are queued behind the ready ones.
+ */
+
+typedef struct _LogSourceParkedMessage
+{
+  LogMessage *msg;
+  LogPathOptions path_options;
+} LogSourceParkedMessage;
+
+static void _hostname_resolved(gpointer user_data);
+
+static gboolean
+_can_park_msg(LogSource *self, const LogPathOptions *path_options)
+{
+  if (self->options->host_resolve_options.use_dns != HOST_RESOLVE_USE_DNS_ASYNC)
+    return FALSE;
+
+  /* these point to the stack of the caller, they would not survive parking */
+  return !path_options->matched && !path_options->lpo_parent_junction && !path_options->filterx_context;
+}
+
+/* returns TRUE if _hostname_resolved() will be called once the sender of @msg is resolved */
+static gboolean
+_wait_for_hostname(LogSource *self, LogMessage *msg)
+{
+  log_pipe_ref(&self->super);
+  if (resolve_sockaddr_to_hostname_in_background(msg->saddr, &self->options->host_resolve_options,
+                                                 _hostname_resolved, self))
+    return TRUE;
+
+  log_pipe_unref(&self->super);
+  return FALSE;
+}
+
+static void
+_process_parked_msg(LogSource *self, LogSourceParkedMessage *parked)
+{
+  ScratchBuffersMarker mark;
+
+  scratch_buffers_mark(&mark);
+  _process_msg(self, parked->msg, &parked->path_options);
+  scratch_buffers_reclaim_marked(mark);
+  g_free(parked);
+}
+
+/* must be called with parked.lock held, returns TRUE if a flush has to be scheduled */
+static gboolean
+_move_ready_messages(LogSource *self, gboolean head_resolved)
+{
+  LogSourceParkedMessage *parked;
+
+  while ((parked = g_queue_peek_head(&self->parked.messages)))
+    {
+      /* the head is processed even if its name was evicted from the cache in the meantime */
+      if (!head_resolved && _wait_for_hostname(self, parked->msg))
+        break;
+
+      g_queue_push_tail(&self->parked.ready, g_queue_pop_head(&self->parked.messages));
+      head_resolved = FALSE;
+    }
+
+  if (g_queue_is_empty(&self->parked.ready) || self->parked.flush_scheduled)
+    return FALSE;
+
+  self->parked.flush_scheduled = TRUE;
+  return TRUE;
+}
+
+/* NOTE: runs in the resolver thread */
+static void
+_hostname_resolved(gpointer user_data)
+{
+  LogSource *self = (LogSource *) user_data;
+  gboolean schedule_flush = FALSE;
+
+  g_mutex_lock(&self->parked.lock);
+  if (!self->parked.closed)
+    schedule_flush = _move_ready_messages(self, TRUE);
+  g_mutex_unlock(&self->parked.lock);
+
+  if (schedule_flush)
+    self->schedule_parked_flush(self);
+
+  log_pipe_unref(&self->super);
+}
+
+/* forwards the messages whose sender has been resolved, in order of arrival */
+void
+log_source_flush_parked_messages(LogSource *self)
+{
+  GQueue ready = G_QUEUE_INIT;
+  LogSourceParkedMessage *parked;
+
+  g_mutex_lock(&self->parked.lock);
+  while (!g_queue_is_empty(&self->parked.ready))
+    {
+      ready = self->parked.ready;
+      g_queue_init(&self->parked.ready);
+      g_mutex_unlock(&self->parked.lock);
+
+      while ((parked = g_queue_pop_head(&ready)))
+        _process_parked_msg(self, parked);
+
+      g_mutex_lock(&self->parked.lock);
+    }
+  self->parked.flush_scheduled = FALSE;
+  g_mutex_unlock(&self->parked.lock);
+}
+
+static void
+_flush_parked_messages_work(gpointer user_data, gpointer arg)
+{
+  log_source_flush_parked_messages((LogSource *) user_data);
+}
+
+static void
+_submit_parked_flush_job(LogSource *self)
+{
+  if (self->parked.flush_job.working)
+    {
+      self->parked.flush_job_resubmit = TRUE;
+      return;
+    }
+  main_loop_io_worker_job_submit(&self->parked.flush_job, NULL);
+}
+
+static void
+_flush_parked_messages_finished(gpointer user_data, gpointer arg)
+{
+  LogSource *self = (LogSource *) user_data;
+
+  if (self->parked.flush_job_resubmit)
+    {
+      self->parked.flush_job_resubmit = FALSE;
+      _submit_parked_flush_job(self);
+    }
+}
+
+/* NOTE: runs in the main thread */
+static gpointer
+_schedule_parked_flush_in_main_thread(gpointer user_data)
+{
+  LogSource *self = (LogSource *) user_data;
+
+  g_mutex_lock(&self->parked.lock);
+  gboolean closed = self->parked.closed;
+  g_mutex_unlock(&self->parked.lock);
+
+  if (!closed)
+    _submit_parked_flush_job(self);
+
+  log_pipe_unref(&self->super);
+  return NULL;
+}
+
+static void
+_schedule_parked_flush(LogSource *self)
+{
+  log_pipe_ref(&self->super);
+  main_loop_call(_schedule_parked_flush_in_main_thread, self, FALSE);
+}
+
+static gboolean
+_park_msg(LogSource *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  GQueue *queue = NULL;
+
+  g_mutex_lock(&self->parked.lock);
+  if (self->parked.closed)
+    queue = NULL;
+  else if (!g_queue_is_empty(&self->parked.messages) || _wait_for_hostname(self, msg))
+    queue = &self->parked.messages;
+  else if (self->parked.flush_scheduled)
+    queue = &self->parked.ready;
+
+  if (queue)
+    {
+      LogSourceParkedMessage *parked_msg = g_new(LogSourceParkedMessage, 1);
+
+      parked_msg->msg = msg;
+      parked_msg->path_options = *path_options;
+      g_queue_push_tail(queue, parked_msg);
+    }
+  g_mutex_unlock(&self->parked.lock);
+
+  return queue != NULL;
+}
+
+static void
+_drop_parked_messages(LogSource *self, GQueue *messages)
+{
+  LogSourceParkedMessage *parked;
+
+  while ((parked = g_queue_pop_head(messages)))
+    {
+      log_msg_drop(parked->msg, &parked->path_options, AT_ABORTED);
+      g_free(parked);
+    }
+}
+
+/* parked messages are not forwarded at deinit, they are acked as aborted, the pending lookup is left to finish on its own */
+static void
+_close_parking(LogSource *self)
+{
+  GQueue messages = G_QUEUE_INIT;
+  GQueue ready = G_QUEUE_INIT;
+
+  g_mutex_lock(&self->parked.lock);
+  self->parked.closed = TRUE;
+  self->parked.flush_scheduled = FALSE;
+  messages = self->parked.messages;
+  ready = self->parked.ready;
+  g_queue_init(&self->parked.messages);
+  g_queue_init(&self->parked.ready);
+  g_mutex_unlock(&self->parked.lock);
+
+  guint dropped = messages.length + ready.length;
+  if (dropped > 0)
+    {
+      msg_warning("Dropping messages waiting for use-dns(async) to resolve their sender",
+                  evt_tag_int("count", dropped),
+                  log_pipe_location_tag(&self->super));
+    }
+
+  _drop_parked_messages(self, &ready);
+  _drop_parked_messages(self, &messages);
+}
+
+static void
+log_source_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  LogSource *self = (LogSource *) s;
+
+  if (_can_park_msg(self, path_options) && _park_msg(self, msg, path_options))
+    return;
+
+  _process_msg(self, msg, path_options);
+}
+
 static void
 _initialize_window(LogSource *self, gint init_window_size)
 {
@@ -751,6 +1018,17 @@ log_source_init_instance(LogSource *self, GlobalConfig *cfg)
   self->window_initialized = FALSE;
   self->ack_tracker_factory = instant_ack_tracker_bookmarkless_factory_new();
   self->ack_tracker = NULL;
+  g_mutex_init(&self->parked.lock);
+  g_queue_init(&self->parked.messages);
+  g_queue_init(&self->parked.ready);
+  main_loop_io_worker_job_init(&self->parked.flush_job);
+  self->parked.flush_job.type = MLIOJ_SOURCE;
+  self->parked.flush_job.user_data = self;
+  self->parked.flush_job.work = _flush_parked_messages_work;
+  self->parked.flush_job.completion = _flush_parked_messages_finished;
+  self->parked.flush_job.engage = (void (*)(gpointer)) log_pipe_ref;
+  self->parked.flush_job.release = (void (*)(gpointer)) log_pipe_unref;
+  self->schedule_parked_flush = _schedule_parked_flush;
 }
 
 static gpointer
@@ -767,6 +1045,10 @@ log_source_free(LogPipe *s)
 {
   LogSource *self = (LogSource *) s;
 
+  g_assert(g_queue_is_empty(&self->parked.messages));
+  g_assert(g_queue_is_empty(&self->parked.ready));
+  g_mutex_clear(&self->parked.lock);
+
   ack_tracker_free(self->ack_tracker);
   self->ack_tracker = NULL;
 
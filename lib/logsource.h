@@ -31,6 +31,7 @@
 #include "stats/aggregator/stats-aggregator.h"
 #include "window-size-counter.h"
 #include "dynamic-window.h"
+#include "mainloop-io-worker.h"
 
 typedef struct _LogSourceOptions
 {
@@ -108,8 +109,23 @@ struct _LogSource
   AckTrackerFactory *ack_tracker_factory;
   AckTracker *ack_tracker;
 
+  /* messages waiting for use-dns(async) to resolve their sender, in order of arrival */
+  struct
+  {
+    GMutex lock;
+    GQueue messages;
+    /* resolved, waiting for log_source_flush_parked_messages() */
+    GQueue ready;
+    gboolean flush_scheduled;
+    gboolean closed;
+    MainLoopIOWorkerJob flush_job;
+    gboolean flush_job_resubmit;
+  } parked;
+
   void (*wakeup)(LogSource *s);
   void (*schedule_dynamic_window_realloc)(LogSource *s);
+  /* called from a resolver thread, log_source_flush_parked_messages() is to be called from a worker */
+  void (*schedule_parked_flush)(LogSource *s);
 };
 
 static inline gboolean
@@ -141,6 +157,7 @@ gboolean log_source_init(LogPipe *s);
 gboolean log_source_deinit(LogPipe *s);
 
 void log_source_post(LogSource *self, LogMessage *msg);
+void log_source_flush_parked_messages(LogSource *self);
 
 void log_source_set_options(LogSource *self, LogSourceOptions *options, const gchar *stats_id,
                             StatsClusterKeyBuilder *kb, gboolean threaded, LogExprNode *expr_node);
@@ -483,7 +483,7 @@ _should_flush_due_to_partition_key_change(LogThreadedDestWorker *self, LogMessag
   LogTemplateEvalOptions options = DEFAULT_TEMPLATE_EVAL_OPTIONS;
   log_template_format(self->owner->worker_partition_key, msg, &options, buffer);
 
-  gboolean should_flush = self->batch_size != 0 && strcmp(self->partitioning.last_key->str, buffer->str) != 0;
+  gboolean should_flush = log_threaded_dest_worker_get_current_batch_size(self) != 0 && strcmp(self->partitioning.last_key->str, buffer->str) != 0;
 
   g_string_assign(self->partitioning.last_key, buffer->str);
 
@@ -499,7 +499,7 @@ _perform_inserts(LogThreadedDestWorker *self)
   LogThreadedResult result;
   LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
 
-  if (self->batch_size == 0)
+  if (log_threaded_dest_worker_get_current_batch_size(self) == 0)
     {
       /* first message in the batch sets the last_flush_time, so we
        * won't expedite the flush even if the previous one was a long
@@ -550,7 +550,7 @@ _perform_inserts(LogThreadedDestWorker *self)
 
       _process_result(self, result);
 
-      if (self->enable_batching && self->batch_size >= self->owner->batch_lines)
+      if (self->enable_batching && log_threaded_dest_worker_get_current_batch_size(self) >= self->owner->batch_lines)
         _perform_flush(self);
 
       log_msg_unref(msg);
@@ -90,6 +90,10 @@ struct _LogThreadedDestWorker
   gint worker_index;
   gboolean connected;
   gint batch_size;
+  /* the part of batch_size that was already submitted by the worker and is
+   * waiting for an explicit ack/rewind (LTR_EXPLICIT_ACK_MGMT), these do not
+   * count towards filling up the current batch */
+  gint inflight_batch_size;
   gint rewound_batch_size;
   gint retries_on_error_counter;
   guint retries_counter;
@@ -255,6 +259,13 @@ log_threaded_dest_worker_disconnect(LogThreadedDestWorker *self)
   self->connected = FALSE;
 }
 
+/* number of messages in the batch that is being assembled right now */
+static inline gint
+log_threaded_dest_worker_get_current_batch_size(LogThreadedDestWorker *self)
+{
+  return self->batch_size - self->inflight_batch_size;
+}
+
 static inline void
 log_threaded_dest_worker_update_message_latency(LogThreadedDestWorker *self, LogMessage *msg)
 {
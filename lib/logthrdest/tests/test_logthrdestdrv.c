@@ -806,6 +806,59 @@ Test(logthrdestdrv, test_explicit_ack_accept)
   cr_assert(dd->super.shared_seq_num == 11, "%d", dd->super.shared_seq_num);
 }
 
+/* full batches are kept in flight, only every second one is acked right away */
+static LogThreadedResult
+_insert_inflight_batches_message_success(LogThreadedDestDriver *s, LogMessage *msg)
+{
+  TestThreadedDestDriver *self = (TestThreadedDestDriver *) s;
+  LogThreadedDestWorker *worker = &s->worker.instance;
+
+  self->insert_counter++;
+  gint current_batch_size = log_threaded_dest_worker_get_current_batch_size(worker);
+  if (current_batch_size < s->batch_lines)
+    return LTR_QUEUED;
+
+  self->flush_size += current_batch_size;
+  worker->inflight_batch_size += current_batch_size;
+  if (worker->inflight_batch_size >= 2 * s->batch_lines)
+    {
+      worker->inflight_batch_size -= s->batch_lines;
+      log_threaded_dest_worker_ack_messages(worker, s->batch_lines);
+    }
+  return LTR_EXPLICIT_ACK_MGMT;
+}
+
+static LogThreadedResult
+_flush_inflight_batches_message_success(LogThreadedDestDriver *s)
+{
+  TestThreadedDestDriver *self = (TestThreadedDestDriver *) s;
+  LogThreadedDestWorker *worker = &s->worker.instance;
+
+  self->flush_counter++;
+  self->flush_size += log_threaded_dest_worker_get_current_batch_size(worker);
+  worker->inflight_batch_size = 0;
+  return LTR_SUCCESS;
+}
+
+Test(logthrdestdrv, test_inflight_batches_do_not_count_towards_the_current_batch)
+{
+  dd->super.worker.insert = _insert_inflight_batches_message_success;
+  dd->super.worker.flush = _flush_inflight_batches_message_success;
+  dd->super.batch_lines = 5;
+  dd->super.batch_timeout = 1000;
+
+  /* the last batch stays in flight until the batch timeout, in-flight
+   * messages should not trigger flushes before that */
+  _generate_messages_and_wait_for_processing(dd, 20, dd->super.metrics.written_messages);
+  cr_assert(dd->insert_counter == 20, "%d", dd->insert_counter);
+  cr_assert(dd->flush_counter == 1, "%d", dd->flush_counter);
+  cr_assert(dd->flush_size == 20, "%d", dd->flush_size);
+
+  cr_assert(stats_counter_get(dd->super.metrics.written_messages) == 20);
+  cr_assert(stats_counter_get(dd->super.worker.instance.queue->metrics.shared.queued_messages) == 0);
+  cr_assert(stats_counter_get(dd->super.worker.instance.queue->metrics.shared.memory_usage) == 0);
+}
+
 MainLoopOptions main_loop_options = {0};
 
 static void
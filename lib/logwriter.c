@@ -1106,18 +1106,10 @@ log_writer_format_log(LogWriter *self, LogMessage *lm, GString *result)
           log_writer_do_padding(self, result);
         }
     }
-  if (self->options->options & LWO_NO_MULTI_LINE)
+  if ((self->options->options & LWO_NO_MULTI_LINE) && result->len > 0)
     {
-      gchar *p;
-
-      p = result->str;
       /* NOTE: the size is calculated to leave trailing new line */
-      while ((p = (gchar *) find_cr_or_lf_or_nul(p, result->str + result->len - p - 1)))
-        {
-          *p = ' ';
-          p++;
-        }
-
+      replace_cr_or_lf_or_nul(result->str, result->len - 1, ' ');
     }
 
   if (self->options->truncate_size != -1 && result->len > self->options->truncate_size)
@@ -25,6 +25,10 @@
 #include "mainloop-call.h"
 #include "logqueue.h"
 #include "apphook.h"
+#include "messages.h"
+
+#include <sched.h>
+#include <stdlib.h>
 
 /************************************************************************************
  * I/O worker threads
@@ -32,6 +36,8 @@
 
 static struct iv_work_pool main_loop_io_workers[MLIOJ_MAX];
 static gint max_threads;
+static gchar *worker_cpu_lists[MLIOJ_MAX];
+static GArray *worker_cpus[MLIOJ_MAX];
 
 static void
 _release(MainLoopIOWorkerJob *self)
@@ -146,9 +152,77 @@ get_processor_count(void)
 #endif
 }
 
+/*
+ * Parses a CPU list in the same format as the kernel uses in
+ * /sys/devices/system/cpu/online or taskset -c does, e.g.  "0-3,8,10-11".
+ * The CPU indexes are appended to the array of gints in cpus.
+ */
+gboolean
+main_loop_io_worker_parse_cpu_list(const gchar *cpu_list, GArray *cpus)
+{
+  const gchar *p = cpu_list;
+
+  while (*p)
+    {
+      gchar *end;
+      gint64 first, last;
+
+      first = last = g_ascii_strtoll(p, &end, 10);
+      if (end == p || first < 0)
+        return FALSE;
+      p = end;
+
+      if (*p == '-')
+        {
+          p++;
+          last = g_ascii_strtoll(p, &end, 10);
+          if (end == p || last < first)
+            return FALSE;
+          p = end;
+        }
+
+      if (last >= MAIN_LOOP_MAX_WORKER_THREADS)
+        return FALSE;
+
+      for (gint cpu = first; cpu <= last; cpu++)
+        g_array_append_val(cpus, cpu);
+
+      if (*p == ',')
+        p++;
+      else if (*p)
+        return FALSE;
+    }
+  return cpus->len > 0;
+}
+
+/* NOTE: runs in the worker thread, before any of the per-thread state is
+ * allocated, so that state ends up on the NUMA node of the assigned CPUs
+ * due to the kernel's first-touch policy */
+static void
+_pin_thread_to_cpus(GArray *cpus)
+{
+#ifdef __linux__
+  cpu_set_t cpu_set;
+
+  CPU_ZERO(&cpu_set);
+  for (gint i = 0; i < cpus->len; i++)
+    CPU_SET(g_array_index(cpus, gint, i), &cpu_set);
+
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) < 0)
+    {
+      msg_warning("Error pinning I/O worker thread to its CPU set",
+                  evt_tag_error("error"));
+    }
+#endif
+}
+
 static void
 main_loop_io_worker_thread_start(void *cookie)
 {
+  GArray *cpus = (GArray *) cookie;
+
+  if (cpus)
+    _pin_thread_to_cpus(cpus);
   main_loop_worker_thread_start(MLW_ASYNC_WORKER);
 }
 
@@ -167,6 +241,40 @@ __pre_pre_init_hook(gint type, gpointer user_data)
     }
 }
 
+static const gchar *
+_get_pool_name(gint type)
+{
+  switch (type)
+    {
+    case MLIOJ_SOURCE:
+      return "source";
+    case MLIOJ_DESTINATION:
+      return "destination";
+    case MLIOJ_PROCESSING:
+      return "processing";
+    default:
+      g_assert_not_reached();
+    }
+}
+
+static GArray *
+_resolve_worker_cpus(gint type)
+{
+  if (!worker_cpu_lists[type])
+    return NULL;
+
+  GArray *cpus = g_array_new(FALSE, FALSE, sizeof(gint));
+  if (!main_loop_io_worker_parse_cpu_list(worker_cpu_lists[type], cpus))
+    {
+      msg_error("Error parsing I/O worker CPU list, worker threads of this pool are not pinned",
+                evt_tag_str("pool", _get_pool_name(type)),
+                evt_tag_str("cpus", worker_cpu_lists[type]));
+      g_array_free(cpus, TRUE);
+      return NULL;
+    }
+  return cpus;
+}
+
 void
 main_loop_io_worker_init(void)
 {
@@ -178,17 +286,34 @@ main_loop_io_worker_init(void)
 
   for (gint i = 0; i < MLIOJ_MAX; i++)
     {
-      /* NOTE: we are oversubscribe the number of CPUs, as each work pool
-       * takes the same max_threads value. This will ultimately be
-       * resolved by the kernel scheduler.
+      /* NOTE: unless CPU sets are specified, we are oversubscribe the
+       * number of CPUs, as each work pool takes the same max_threads value.
+       * This will ultimately be resolved by the kernel scheduler.
        *
        * Scaling would probably collapse once we actually execute in more
        * threads than available CPUs, but normally threads are only
        * allocated on-demand and the ratio between
        * source/destination/processing would automatically form based on
        * traffic patterns.
+       *
+       * With a CPU set, the pool is sized to the set, so pools with
+       * disjoint sets never compete for the same CPUs.
        */
-      main_loop_io_workers[i].max_threads = max_threads;
+      worker_cpus[i] = _resolve_worker_cpus(i);
+      if (worker_cpus[i])
+        {
+          main_loop_io_workers[i].max_threads = MIN(MAX(MAIN_LOOP_MIN_WORKER_THREADS, worker_cpus[i]->len),
+                                                    max_threads);
+          msg_debug("Pinning I/O worker pool to CPU set",
+                    evt_tag_str("pool", _get_pool_name(i)),
+                    evt_tag_str("cpus", worker_cpu_lists[i]),
+                    evt_tag_int("max_threads", main_loop_io_workers[i].max_threads));
+        }
+      else
+        {
+          main_loop_io_workers[i].max_threads = max_threads;
+        }
+      main_loop_io_workers[i].cookie = worker_cpus[i];
       main_loop_io_workers[i].thread_start = main_loop_io_worker_thread_start;
       main_loop_io_workers[i].thread_stop = main_loop_io_worker_thread_stop;
       iv_work_pool_create(&main_loop_io_workers[i]);
@@ -203,12 +328,20 @@ main_loop_io_worker_deinit(void)
   for (gint i = 0; i < MLIOJ_MAX; i++)
     {
       iv_work_pool_put(&main_loop_io_workers[i]);
+      if (worker_cpus[i])
+        {
+          g_array_free(worker_cpus[i], TRUE);
+          worker_cpus[i] = NULL;
+        }
     }
 }
 
 static GOptionEntry main_loop_io_worker_options[] =
 {
   { "worker-threads",      0,         0, G_OPTION_ARG_INT, &max_threads, "Set the number of I/O worker threads", "<max>" },
+  { "source-worker-cpus",      0, 0, G_OPTION_ARG_STRING, &worker_cpu_lists[MLIOJ_SOURCE],      "Pin source I/O worker threads to these CPUs", "<cpu-list>" },
+  { "destination-worker-cpus", 0, 0, G_OPTION_ARG_STRING, &worker_cpu_lists[MLIOJ_DESTINATION], "Pin destination I/O worker threads to these CPUs", "<cpu-list>" },
+  { "processing-worker-cpus",  0, 0, G_OPTION_ARG_STRING, &worker_cpu_lists[MLIOJ_PROCESSING],  "Pin processing worker threads to these CPUs", "<cpu-list>" },
   { NULL },
 };
 
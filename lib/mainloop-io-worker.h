@@ -57,6 +57,7 @@ gboolean main_loop_io_worker_job_force_submit(MainLoopIOWorkerJob *self, gpointe
 void main_loop_io_worker_job_submit_continuation(MainLoopIOWorkerJob *self, gpointer arg);
 #endif
 
+gboolean main_loop_io_worker_parse_cpu_list(const gchar *cpu_list, GArray *cpus);
 void main_loop_io_worker_add_options(GOptionContext *ctx);
 
 void main_loop_io_worker_init(void);
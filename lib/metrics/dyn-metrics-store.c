@@ -34,30 +34,20 @@ struct _DynMetricsStore
   GArray *label_buffers;
 };
 
+/* dynamic counters are (un)registered without stats_lock(), see stats-registry.c */
 static StatsCluster *
-_register_single_cluster_locked(StatsClusterKey *key, gint stats_level)
+_register_single_cluster(StatsClusterKey *key, gint stats_level)
 {
-  StatsCluster *cluster;
+  StatsCounterItem *counter;
 
-  stats_lock();
-  {
-    StatsCounterItem *counter;
-    cluster = stats_register_dynamic_counter(stats_level, key, SC_TYPE_SINGLE_VALUE, &counter);
-  }
-  stats_unlock();
-
-  return cluster;
+  return stats_register_dynamic_counter(stats_level, key, SC_TYPE_SINGLE_VALUE, &counter);
 }
 
 static void
-_unregister_single_cluster_locked(StatsCluster *cluster)
+_unregister_single_cluster(StatsCluster *cluster)
 {
-  stats_lock();
-  {
-    StatsCounterItem *counter = stats_cluster_single_get_counter(cluster);
-    stats_unregister_dynamic_counter(cluster, SC_TYPE_SINGLE_VALUE, &counter);
-  }
-  stats_unlock();
+  StatsCounterItem *counter = stats_cluster_single_get_counter(cluster);
+  stats_unregister_dynamic_counter(cluster, SC_TYPE_SINGLE_VALUE, &counter);
 }
 
 DynMetricsStore *
@@ -68,7 +58,7 @@ dyn_metrics_store_new(void)
   self->clusters = g_hash_table_new_full((GHashFunc) stats_cluster_key_hash,
                                          (GEqualFunc) stats_cluster_key_equal,
                                          NULL,
-                                         (GDestroyNotify) _unregister_single_cluster_locked);
+                                         (GDestroyNotify) _unregister_single_cluster);
   self->label_buffers = g_array_new(FALSE, FALSE, sizeof(StatsClusterLabel));
 
   return self;
@@ -88,7 +78,7 @@ dyn_metrics_store_retrieve_counter(DynMetricsStore *self, StatsClusterKey *key,
   StatsCluster *cluster = g_hash_table_lookup(self->clusters, key);
   if (!cluster)
     {
-      cluster = _register_single_cluster_locked(key, level);
+      cluster = _register_single_cluster(key, level);
       if (cluster)
         g_hash_table_insert(self->clusters, &cluster->key, cluster);
     }
@@ -130,11 +120,9 @@ dyn_metrics_store_merge(DynMetricsStore *self, DynMetricsStore *other)
   gpointer key, value;
   while (g_hash_table_iter_next(&iter, &key, &value))
     {
-      stats_lock();
-      {
-        stats_cluster_track_counter(value, SC_TYPE_SINGLE_VALUE);
-      }
-      stats_unlock();
+      StatsCounterItem *counter;
+
+      stats_register_associated_counter(value, SC_TYPE_SINGLE_VALUE, &counter);
       g_hash_table_insert(self->clusters, key, value);
     }
 }
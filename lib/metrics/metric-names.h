@@ -42,7 +42,15 @@
   M(disk_queue_processed_events_total) \
   M(event_processing_latency_seconds) \
   M(events_allocated_bytes) \
+  M(events_allocator_allocations_total) \
+  M(events_allocator_cached_bytes) \
+  M(events_allocator_frees_total) \
+  M(events_allocator_system_allocations_total) \
+  M(events_allocator_used_bytes) \
   M(filtered_events_total) \
+  M(filterx_jit_cache_hits_total) \
+  M(filterx_jit_cache_misses_total) \
+  M(filterx_jit_compile_time_seconds) \
   M(fx_xxx_evals_total) \
   M(input_event_bytes_total) \
   M(input_events_total) \
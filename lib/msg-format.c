@@ -97,14 +97,9 @@ msg_format_postprocess_message(MsgFormatOptions *options, LogMessage *msg,
     {
       gssize msg_len;
       gchar *msg_text;
-      gchar *p;
 
-      p = msg_text = (gchar *) log_msg_get_value(msg, LM_V_MESSAGE, &msg_len);
-      while ((p = (gchar *) find_cr_or_lf_or_nul(p, msg_text + msg_len - p)))
-        {
-          *p = ' ';
-          p++;
-        }
+      msg_text = (gchar *) log_msg_get_value(msg, LM_V_MESSAGE, &msg_len);
+      replace_cr_or_lf_or_nul(msg_text, msg_len, ' ');
     }
   if (options->flags & LP_LOCAL)
     msg->flags |= LF_LOCAL;
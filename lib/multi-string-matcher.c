@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "multi-string-matcher.h"
+
+#include <string.h>
+
+#define MSM_NO_NODE G_MAXUINT32
+#define MSM_ROOT 0
+
+enum
+{
+  /* a pattern ends at this node */
+  MSM_NODE_FINAL = 0x01,
+  /* a pattern ends at this node or at one reachable via failure links */
+  MSM_NODE_OUTPUT = 0x02,
+};
+
+typedef struct _MultiStringPattern
+{
+  guint32 offset;
+  guint32 len;
+} MultiStringPattern;
+
+/*
+ * The trie is stored in breadth-first order: the outgoing edges of a node
+ * are contiguous and sorted by their label, edges of node N are
+ * [first_edge[N], first_edge[N + 1]).  Transitions from the root are also
+ * available via a direct lookup table, as that is where a substring search
+ * spends most of its time.
+ */
+struct _MultiStringMatcher
+{
+  gboolean icase;
+  gboolean substring;
+
+  /* patterns collected until multi_string_matcher_compile() */
+  GString *pattern_data;
+  GArray *patterns;
+
+  guint32 num_nodes;
+  guint32 *first_edge;
+  guint32 *fail;
+  guint8 *flags;
+  guint8 *edge_labels;
+  guint32 *edge_targets;
+  guint32 root_next[256];
+};
+
+static inline guchar
+_fold(const MultiStringMatcher *self, guchar c)
+{
+  return self->icase ? g_ascii_tolower(c) : c;
+}
+
+static inline guint32
+_find_edge(const MultiStringMatcher *self, guint32 node, guchar c)
+{
+  guint32 lo = self->first_edge[node];
+  guint32 hi = self->first_edge[node + 1];
+
+  while (lo < hi)
+    {
+      guint32 mid = lo + (hi - lo) / 2;
+
+      if (self->edge_labels[mid] < c)
+        lo = mid + 1;
+      else if (self->edge_labels[mid] > c)
+        hi = mid;
+      else
+        return self->edge_targets[mid];
+    }
+  return MSM_NO_NODE;
+}
+
+static inline guint32
+_walk(const MultiStringMatcher *self, guint32 node, guchar c)
+{
+  if (node == MSM_ROOT)
+    return self->root_next[c] ? : MSM_NO_NODE;
+  return _find_edge(self, node, c);
+}
+
+void
+multi_string_matcher_add_pattern(MultiStringMatcher *self, const gchar *pattern, gssize pattern_len)
+{
+  g_assert(self->patterns);
+
+  if (pattern_len < 0)
+    pattern_len = strlen(pattern);
+
+  MultiStringPattern p = { .offset = self->pattern_data->len, .len = pattern_len };
+
+  if (self->icase)
+    {
+      for (gssize i = 0; i < pattern_len; i++)
+        g_string_append_c(self->pattern_data, g_ascii_tolower(pattern[i]));
+    }
+  else
+    {
+      g_string_append_len(self->pattern_data, pattern, pattern_len);
+    }
+  g_array_append_val(self->patterns, p);
+}
+
+static gint
+_compare_patterns(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  const MultiStringPattern *p1 = (const MultiStringPattern *) a;
+  const MultiStringPattern *p2 = (const MultiStringPattern *) b;
+  const gchar *data = (const gchar *) user_data;
+  gint r = memcmp(data + p1->offset, data + p2->offset, MIN(p1->len, p2->len));
+
+  if (r != 0)
+    return r;
+  return (p1->len > p2->len) - (p1->len < p2->len);
+}
+
+typedef struct _MultiStringNodeRange
+{
+  guint32 lo, hi;
+  guint32 depth;
+} MultiStringNodeRange;
+
+/*
+ * Builds the trie from the sorted list of patterns.  Every node corresponds
+ * to a range of patterns sharing the same prefix, nodes are numbered in
+ * the order they are queued, which yields the breadth-first layout.
+ */
+static void
+_build_trie(MultiStringMatcher *self)
+{
+  const guchar *data = (const guchar *) self->pattern_data->str;
+  MultiStringPattern *patterns = (MultiStringPattern *) self->patterns->data;
+  GArray *queue = g_array_new(FALSE, FALSE, sizeof(MultiStringNodeRange));
+  GArray *first_edge = g_array_new(FALSE, FALSE, sizeof(guint32));
+  GArray *flags = g_array_new(FALSE, FALSE, sizeof(guint8));
+  GArray *edge_labels = g_array_new(FALSE, FALSE, sizeof(guint8));
+  GArray *edge_targets = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+  MultiStringNodeRange root = { .lo = 0, .hi = self->patterns->len, .depth = 0 };
+  g_array_append_val(queue, root);
+
+  for (guint32 node = 0; node < queue->len; node++)
+    {
+      MultiStringNodeRange range = g_array_index(queue, MultiStringNodeRange, node);
+      guint32 edge = edge_labels->len;
+      guint8 node_flags = 0;
+
+      g_array_append_val(first_edge, edge);
+
+      /* shorter patterns sort first, skip the ones ending here (including duplicates) */
+      while (range.lo < range.hi && patterns[range.lo].len == range.depth)
+        {
+          node_flags = MSM_NODE_FINAL | MSM_NODE_OUTPUT;
+          range.lo++;
+        }
+      g_array_append_val(flags, node_flags);
+
+      while (range.lo < range.hi)
+        {
+          guint8 label = data[patterns[range.lo].offset + range.depth];
+          MultiStringNodeRange child = { .lo = range.lo, .hi = range.lo, .depth = range.depth + 1 };
+
+          while (child.hi < range.hi && data[patterns[child.hi].offset + range.depth] == label)
+            child.hi++;
+
+          guint32 target = queue->len;
+          g_array_append_val(edge_labels, label);
+          g_array_append_val(edge_targets, target);
+          g_array_append_val(queue, child);
+          range.lo = child.hi;
+        }
+    }
+
+  guint32 num_edges = edge_labels->len;
+  g_array_append_val(first_edge, num_edges);
+
+  self->num_nodes = queue->len;
+  self->first_edge = (guint32 *) g_array_free(first_edge, FALSE);
+  self->flags = (guint8 *) g_array_free(flags, FALSE);
+  self->edge_labels = (guint8 *) g_array_free(edge_labels, FALSE);
+  self->edge_targets = (guint32 *) g_array_free(edge_targets, FALSE);
+  g_array_free(queue, TRUE);
+}
+
+static void
+_build_root_table(MultiStringMatcher *self)
+{
+  memset(self->root_next, 0, sizeof(self->root_next));
+  for (guint32 edge = self->first_edge[MSM_ROOT]; edge < self->first_edge[MSM_ROOT + 1]; edge++)
+    self->root_next[self->edge_labels[edge]] = self->edge_targets[edge];
+}
+
+/*
+ * Nodes are processed in breadth-first order, so by the time we get to a
+ * node, the failure links (and outputs) of all shallower nodes are final.
+ */
+static void
+_build_failure_links(MultiStringMatcher *self)
+{
+  self->fail = g_new0(guint32, self->num_nodes);
+
+  for (guint32 node = 0; node < self->num_nodes; node++)
+    {
+      for (guint32 edge = self->first_edge[node]; edge < self->first_edge[node + 1]; edge++)
+        {
+          guchar label = self->edge_labels[edge];
+          guint32 child = self->edge_targets[edge];
+          guint32 fail = MSM_ROOT;
+
+          if (node != MSM_ROOT)
+            {
+              guint32 state = self->fail[node];
+              guint32 next;
+
+              while ((next = _walk(self, state, label)) == MSM_NO_NODE && state != MSM_ROOT)
+                state = self->fail[state];
+              if (next != MSM_NO_NODE)
+                fail = next;
+            }
+
+          self->fail[child] = fail;
+          self->flags[child] |= self->flags[fail] & MSM_NODE_OUTPUT;
+        }
+    }
+}
+
+void
+multi_string_matcher_compile(MultiStringMatcher *self)
+{
+  g_assert(self->patterns);
+
+  g_array_sort_with_data(self->patterns, _compare_patterns, self->pattern_data->str);
+  _build_trie(self);
+  _build_root_table(self);
+  if (self->substring)
+    _build_failure_links(self);
+
+  g_array_free(self->patterns, TRUE);
+  self->patterns = NULL;
+  g_string_free(self->pattern_data, TRUE);
+  self->pattern_data = NULL;
+}
+
+gboolean
+multi_string_matcher_match_exact(const MultiStringMatcher *self, const gchar *value, gsize value_len)
+{
+  guint32 node = MSM_ROOT;
+
+  for (gsize i = 0; i < value_len; i++)
+    {
+      node = _walk(self, node, _fold(self, value[i]));
+      if (node == MSM_NO_NODE)
+        return FALSE;
+    }
+  return !!(self->flags[node] & MSM_NODE_FINAL);
+}
+
+gboolean
+multi_string_matcher_match_prefix(const MultiStringMatcher *self, const gchar *value, gsize value_len)
+{
+  guint32 node = MSM_ROOT;
+
+  for (gsize i = 0; i < value_len; i++)
+    {
+      if (self->flags[node] & MSM_NODE_FINAL)
+        return TRUE;
+
+      node = _walk(self, node, _fold(self, value[i]));
+      if (node == MSM_NO_NODE)
+        return FALSE;
+    }
+  return !!(self->flags[node] & MSM_NODE_FINAL);
+}
+
+gboolean
+multi_string_matcher_match_substring(const MultiStringMatcher *self, const gchar *value, gsize value_len)
+{
+  guint32 node = MSM_ROOT;
+
+  g_assert(self->fail);
+
+  if (self->flags[MSM_ROOT] & MSM_NODE_OUTPUT)
+    return TRUE;
+
+  for (gsize i = 0; i < value_len; i++)
+    {
+      guchar c = _fold(self, value[i]);
+      guint32 next;
+
+      while ((next = _walk(self, node, c)) == MSM_NO_NODE && node != MSM_ROOT)
+        node = self->fail[node];
+      node = (next != MSM_NO_NODE) ? next : MSM_ROOT;
+
+      if (self->flags[node] & MSM_NODE_OUTPUT)
+        return TRUE;
+    }
+  return FALSE;
+}
+
+MultiStringMatcher *
+multi_string_matcher_new(guint32 flags)
+{
+  MultiStringMatcher *self = g_new0(MultiStringMatcher, 1);
+
+  self->icase = !!(flags & MSM_ICASE);
+  self->substring = !!(flags & MSM_SUBSTRING);
+  self->pattern_data = g_string_new(NULL);
+  self->patterns = g_array_new(FALSE, FALSE, sizeof(MultiStringPattern));
+  return self;
+}
+
+void
+multi_string_matcher_free(MultiStringMatcher *self)
+{
+  if (self->patterns)
+    g_array_free(self->patterns, TRUE);
+  if (self->pattern_data)
+    g_string_free(self->pattern_data, TRUE);
+  g_free(self->first_edge);
+  g_free(self->fail);
+  g_free(self->flags);
+  g_free(self->edge_labels);
+  g_free(self->edge_targets);
+  g_free(self);
+}
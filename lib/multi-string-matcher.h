@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef MULTI_STRING_MATCHER_H_INCLUDED
+#define MULTI_STRING_MATCHER_H_INCLUDED
+
+#include "syslog-ng.h"
+
+/*
+ * Matches a value against a set of literal strings at once.  Patterns are
+ * added first, then compiled into a trie, which can answer exact and prefix
+ * lookups in time proportional to the length of the value, regardless of
+ * the number of patterns.  Substring lookups also need Aho-Corasick failure
+ * links, these are only built if MSM_SUBSTRING is requested.
+ */
+typedef struct _MultiStringMatcher MultiStringMatcher;
+
+enum
+{
+  MSM_ICASE = 0x01,
+  /* allow multi_string_matcher_match_substring() */
+  MSM_SUBSTRING = 0x02,
+};
+
+MultiStringMatcher *multi_string_matcher_new(guint32 flags);
+void multi_string_matcher_free(MultiStringMatcher *self);
+
+void multi_string_matcher_add_pattern(MultiStringMatcher *self, const gchar *pattern, gssize pattern_len);
+void multi_string_matcher_compile(MultiStringMatcher *self);
+
+gboolean multi_string_matcher_match_exact(const MultiStringMatcher *self, const gchar *value, gsize value_len);
+gboolean multi_string_matcher_match_prefix(const MultiStringMatcher *self, const gchar *value, gsize value_len);
+gboolean multi_string_matcher_match_substring(const MultiStringMatcher *self, const gchar *value, gsize value_len);
+
+#endif
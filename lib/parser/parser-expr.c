@@ -116,6 +116,102 @@ log_parser_queue_method(LogPipe *s, LogMessage *msg, const LogPathOptions *path_
     }
 }
 
+static void
+_process_batch_one_by_one(LogParser *self, LogMessage **pmsgs, const LogPathOptions **path_options,
+                          const gchar **inputs, const gsize *input_lens, gboolean *results, gint num_msgs)
+{
+  for (gint i = 0; i < num_msgs; i++)
+    results[i] = self->process(self, &pmsgs[i], path_options[i], inputs[i], input_lens[i]);
+}
+
+/* same as log_parser_process_message() for each message, without a template */
+static void
+_process_message_batch(LogParser *self, LogMessage **pmsgs, const LogPathOptions **path_options,
+                       gboolean *results, gint num_msgs)
+{
+  LogMessage *pinned_msgs[LOG_PIPE_MAX_BATCH_SIZE];
+  LogMessagePin pins[LOG_PIPE_MAX_BATCH_SIZE];
+  const gchar *inputs[LOG_PIPE_MAX_BATCH_SIZE];
+  gsize input_lens[LOG_PIPE_MAX_BATCH_SIZE];
+
+  /* NOTE: see log_parser_process_message() on why pinning is needed */
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      gssize value_len;
+
+      pinned_msgs[i] = pmsgs[i];
+      pins[i] = log_msg_pin_payload(pmsgs[i]);
+      inputs[i] = log_msg_get_value(pmsgs[i], LM_V_MESSAGE, &value_len);
+      input_lens[i] = value_len;
+    }
+
+  if (self->process_batch)
+    self->process_batch(self, pmsgs, path_options, inputs, input_lens, results, num_msgs);
+  else
+    _process_batch_one_by_one(self, pmsgs, path_options, inputs, input_lens, results, num_msgs);
+
+  gint num_succeeded = 0;
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      log_msg_unpin_payload(pinned_msgs[i], pins[i]);
+      if (results[i])
+        num_succeeded++;
+    }
+
+  stats_counter_add(self->super.discarded_messages, num_msgs - num_succeeded);
+  stats_counter_add(self->processed_messages, num_succeeded);
+}
+
+void
+log_parser_queue_batch_method(LogPipe *s, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs)
+{
+  LogParser *self = (LogParser *) s;
+  gboolean results[LOG_PIPE_MAX_BATCH_SIZE];
+  LogMessage *accepted_msgs[LOG_PIPE_MAX_BATCH_SIZE];
+  const LogPathOptions *accepted_path_options[LOG_PIPE_MAX_BATCH_SIZE];
+  gint num_accepted = 0;
+
+  msg_trace(">>>>>> parser rule batch evaluation begin",
+            evt_tag_str("rule", self->name),
+            log_pipe_location_tag(s),
+            evt_tag_int("messages", num_msgs));
+
+  if (G_LIKELY(!self->template_obj))
+    {
+      _process_message_batch(self, msgs, path_options, results, num_msgs);
+    }
+  else
+    {
+      for (gint i = 0; i < num_msgs; i++)
+        results[i] = log_parser_process_message(self, &msgs[i], path_options[i]);
+    }
+
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      msg_trace("<<<<<< parser rule evaluation result",
+                evt_tag_str("result", results[i] ? "accepted" : "rejected"),
+                evt_tag_str("rule", self->name),
+                log_pipe_location_tag(s),
+                evt_tag_msg_reference(msgs[i]));
+
+      if (results[i])
+        {
+          accepted_msgs[num_accepted] = msgs[i];
+          accepted_path_options[num_accepted] = path_options[i];
+          num_accepted++;
+        }
+      else
+        {
+          if (path_options[i]->matched)
+            (*path_options[i]->matched) = FALSE;
+          log_msg_drop(msgs[i], path_options[i], AT_PROCESSED);
+        }
+    }
+
+  if (num_accepted > 0)
+    log_pipe_forward_batch(s, accepted_msgs, accepted_path_options, num_accepted);
+}
+
 static void
 _register_counters(LogParser *self)
 {
@@ -187,4 +283,5 @@ log_parser_init_instance(LogParser *self, GlobalConfig *cfg)
   self->super.deinit = log_parser_deinit_method;
   self->super.free_fn = log_parser_free_method;
   self->super.queue = log_parser_queue_method;
+  self->super.queue_batch = log_parser_queue_batch_method;
 }
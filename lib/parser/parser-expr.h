@@ -40,11 +40,15 @@ struct _LogParser
   StatsCounterItem *processed_messages;
   gboolean (*process)(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_options, const gchar *input,
                       gsize input_len);
+  /* optional, processes num_msgs messages in one go, storing the result of each in results */
+  void (*process_batch)(LogParser *s, LogMessage **pmsgs, const LogPathOptions **path_options,
+                        const gchar **inputs, const gsize *input_lens, gboolean *results, gint num_msgs);
   gchar *name;
 };
 
 gboolean log_parser_deinit_method(LogPipe *s);
 void log_parser_queue_method(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options);
+void log_parser_queue_batch_method(LogPipe *s, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs);
 gboolean log_parser_init_method(LogPipe *s);
 void log_parser_set_template(LogParser *self, LogTemplate *template_obj);
 void log_parser_clone_settings(LogParser *self, LogParser *cloned);
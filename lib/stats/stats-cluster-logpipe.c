@@ -65,6 +65,8 @@ _counter_group_logpipe_init(StatsCounterGroupInit *self, StatsCounterGroup *coun
   counter_group->counters = g_new0(StatsCounterItem, SC_TYPE_MAX);
   counter_group->capacity = SC_TYPE_MAX;
   counter_group->counter_names = self->counter.names;
+  counter_group->sharded_types = (1 << SC_TYPE_DROPPED) | (1 << SC_TYPE_PROCESSED) | (1 << SC_TYPE_DISCARDED)
+                                 | (1 << SC_TYPE_MATCHED) | (1 << SC_TYPE_NOT_MATCHED) | (1 << SC_TYPE_WRITTEN);
   counter_group->get_type_label = _counter_group_logpipe_get_type_label;
   counter_group->free_fn = _counter_group_logpipe_free;
 }
@@ -340,7 +340,8 @@ stats_cluster_track_counter(StatsCluster *self, gint type)
 {
   gint type_mask = 1 << type;
 
-  g_assert(is_stats_locked());
+  /* dynamic clusters are protected by the lock of their registry stripe instead */
+  g_assert(self->dynamic || is_stats_locked());
   g_assert(type < self->counter_group.capacity);
 
   self->live_mask |= type_mask;
@@ -364,7 +365,7 @@ stats_cluster_get_counter(StatsCluster *self, gint type)
 void
 stats_cluster_untrack_counter(StatsCluster *self, gint type, StatsCounterItem **counter)
 {
-  g_assert(is_stats_locked());
+  g_assert(self && (self->dynamic || is_stats_locked()));
   g_assert(self && (self->live_mask & (1 << type)) && &self->counter_group.counters[type] == (*counter));
   g_assert(self->use_count > 0);
   self->use_count--;
@@ -475,6 +476,12 @@ void
 stats_cluster_free(StatsCluster *self)
 {
   stats_cluster_foreach_counter(self, stats_cluster_free_counter, NULL);
+  if (self->prometheus_series)
+    {
+      for (gint i = 0; i < self->counter_group.capacity; i++)
+        g_free(self->prometheus_series[i]);
+      g_free(self->prometheus_series);
+    }
   stats_cluster_key_cloned_free(&self->key);
   g_free(self->query_key);
   stats_counter_group_free(&self->counter_group);
@@ -71,6 +71,9 @@ struct _StatsCounterGroup
   StatsCounterItem *counters;
   gchar **counter_names;
   guint16 capacity;
+  /* bitmask of counter types that are bumped for every message, these are
+   * sharded per worker thread, see stats_counter_enable_sharding() */
+  guint32 sharded_types;
   gboolean (*get_type_label)(StatsCounterGroup *self, StatsCluster *cluster, gint type, StatsClusterLabel *label);
   void (*get_type_formatting)(StatsCounterGroup *self, StatsCluster *cluster, gint type,
                               StatsClusterUnit *stored_unit);
@@ -166,6 +169,8 @@ struct _StatsCluster
   guint32 live_mask;
   guint32 use_count;
   gchar *query_key;
+  /* per counter type, the rendered Prometheus metric name and labels, filled on first scrape */
+  gchar **prometheus_series;
   guint8 dynamic:1;
 };
 
@@ -217,6 +222,12 @@ stats_cluster_get_type_formatting(StatsCluster *self, gint type,
     self->counter_group.get_type_formatting(&self->counter_group, self, type, stored_unit);
 }
 
+static inline gboolean
+stats_cluster_is_counter_sharded(StatsCluster *self, gint type)
+{
+  return !!(self->counter_group.sharded_types & (1 << type));
+}
+
 static inline const gchar *
 stats_cluster_get_type_name_suffix(StatsCluster *self, gint type)
 {
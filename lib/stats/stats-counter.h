@@ -25,8 +25,18 @@
 
 #include "syslog-ng.h"
 #include "atomic-gssize.h"
+#include "mainloop-worker.h"
 
 #define STATS_COUNTER_MAX_VALUE G_MAXSIZE
+#define STATS_COUNTER_SHARD_SIZE 64
+
+/* A per-worker-thread slot of a sharded counter, padded to a cache line so
+ * that threads incrementing the same counter do not share cache lines. */
+typedef union _StatsCounterShard
+{
+  atomic_gssize value;
+  gchar _pad[STATS_COUNTER_SHARD_SIZE];
+} StatsCounterShard;
 
 typedef struct _StatsCounterItem
 {
@@ -35,6 +45,10 @@ typedef struct _StatsCounterItem
     atomic_gssize value;
     atomic_gssize *value_ref;
   };
+  /* per-thread slots, added to value when the counter is read. External
+   * (alias) counters borrow the shards of the counter they refer to. */
+  StatsCounterShard *shards;
+  gint num_shards;
   gchar *name;
   gint type;
   gboolean external;
@@ -47,13 +61,38 @@ stats_counter_read_only(StatsCounterItem *counter)
   return counter->external;
 }
 
+/* Threads without a worker index (or with one allocated after the counter
+ * was sharded) fall back to the shared slot. */
+static inline atomic_gssize *
+_stats_counter_get_slot(StatsCounterItem *counter)
+{
+  if (counter->shards)
+    {
+      gint thread_index = main_loop_worker_get_thread_index();
+
+      if (thread_index >= 0 && thread_index < counter->num_shards)
+        return &counter->shards[thread_index].value;
+    }
+  return &counter->value;
+}
+
+static inline gsize
+_stats_counter_sum_shards(StatsCounterItem *counter)
+{
+  gsize result = 0;
+
+  for (gint i = 0; i < counter->num_shards; i++)
+    result += atomic_gssize_get_unsigned(&counter->shards[i].value);
+  return result;
+}
+
 static inline void
 stats_counter_add(StatsCounterItem *counter, gssize add)
 {
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_add(&counter->value, add);
+      atomic_gssize_add(_stats_counter_get_slot(counter), add);
     }
 }
 
@@ -63,7 +102,7 @@ stats_counter_sub(StatsCounterItem *counter, gssize sub)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_sub(&counter->value, sub);
+      atomic_gssize_sub(_stats_counter_get_slot(counter), sub);
     }
 }
 
@@ -73,7 +112,7 @@ stats_counter_inc(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_inc(&counter->value);
+      atomic_gssize_inc(_stats_counter_get_slot(counter));
     }
 }
 
@@ -83,15 +122,19 @@ stats_counter_dec(StatsCounterItem *counter)
   if (counter)
     {
       g_assert(!stats_counter_read_only(counter));
-      atomic_gssize_dec(&counter->value);
+      atomic_gssize_dec(_stats_counter_get_slot(counter));
     }
 }
 
+/* NOTE: on a sharded counter this is not atomic with respect to concurrent
+ * increments, which is fine for resets and for gauges that are only set. */
 static inline void
 stats_counter_set(StatsCounterItem *counter, gsize value)
 {
   if (counter && !stats_counter_read_only(counter))
     {
+      for (gint i = 0; i < counter->num_shards; i++)
+        atomic_gssize_set(&counter->shards[i].value, 0);
       atomic_gssize_set(&counter->value, value);
     }
 }
@@ -107,6 +150,7 @@ stats_counter_get(StatsCounterItem *counter)
         result = atomic_gssize_get_unsigned(&counter->value);
       else
         result = atomic_gssize_get_unsigned(counter->value_ref);
+      result += _stats_counter_sum_shards(counter);
     }
   return result;
 }
@@ -126,9 +170,30 @@ stats_counter_get_name(StatsCounterItem *counter)
   return NULL;
 }
 
+/* Spread increments of a hot counter over @num_shards per-thread slots,
+ * normally main_loop_worker_get_max_number_of_threads().  Must be called
+ * before the counter is used from worker threads. */
+static inline void
+stats_counter_enable_sharding(StatsCounterItem *counter, gint num_shards)
+{
+  gpointer shards;
+
+  if (counter->external || counter->shards || num_shards <= 0)
+    return;
+
+  if (posix_memalign(&shards, STATS_COUNTER_SHARD_SIZE, num_shards * sizeof(StatsCounterShard)) != 0)
+    return;
+
+  memset(shards, 0, num_shards * sizeof(StatsCounterShard));
+  counter->shards = shards;
+  counter->num_shards = num_shards;
+}
+
 static inline void
 stats_counter_clear(StatsCounterItem *counter)
 {
+  if (!counter->external)
+    free(counter->shards);
   g_free(counter->name);
   memset(counter, 0, sizeof(*counter));
 }
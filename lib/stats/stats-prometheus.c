@@ -222,7 +222,7 @@ _format_labels(StatsCluster *sc, gint type)
 }
 
 static GString *
-_format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
+_format_legacy_series(StatsCluster *sc, gint type)
 {
   GString *record = scratch_buffers_alloc();
   GString *labels = scratch_buffers_alloc();
@@ -259,32 +259,66 @@ _format_legacy(StatsCluster *sc, gint type, StatsCounterItem *counter)
   if (labels->len != 0)
     g_string_append_printf(record, "{%s}", labels->str);
 
-  const gchar *metric_value = stats_format_prometheus_format_counter_value(sc, type);
-  g_string_append_printf(record, " %s\n", metric_value);
-
   return record;
 }
 
-GString *
-stats_prometheus_format_counter(StatsCluster *sc, gint type, StatsCounterItem *counter)
+/* the metric name with its labels, without the value */
+static const gchar *
+_format_series(StatsCluster *sc, gint type)
 {
-  if (_is_timestamp(sc, type))
-    return NULL;
-
   if (!sc->key.name)
-    return _format_legacy(sc, type, counter);
+    return _format_legacy_series(sc, type)->str;
 
-  GString *record = scratch_buffers_alloc();
-  g_string_append_printf(record, METRIC_PREFIX "%s%s",
+  GString *series = scratch_buffers_alloc();
+  g_string_append_printf(series, METRIC_PREFIX "%s%s",
                          stats_format_prometheus_sanitize_name(sc->key.name, -1),
                          stats_cluster_get_type_name_suffix(sc, type) ? : "");
 
   const gchar *labels = _format_labels(sc, type);
   if (labels)
-    g_string_append_printf(record, "{%s}", labels);
+    g_string_append_printf(series, "{%s}", labels);
+
+  return series->str;
+}
+
+/* The key of a cluster never changes, so its series are sanitized and
+ * formatted only once and cached in the cluster until it is freed.
+ * Concurrent scrapes may race to fill the cache, the loser frees its copy.
+ */
+static const gchar *
+_get_series(StatsCluster *sc, gint type)
+{
+  gchar **cache = g_atomic_pointer_get(&sc->prometheus_series);
+  if (!cache)
+    {
+      gchar **new_cache = g_new0(gchar *, sc->counter_group.capacity);
+      if (!g_atomic_pointer_compare_and_exchange(&sc->prometheus_series, NULL, new_cache))
+        g_free(new_cache);
+      cache = g_atomic_pointer_get(&sc->prometheus_series);
+    }
 
-  const gchar *metric_value = stats_format_prometheus_format_counter_value(sc, type);
-  g_string_append_printf(record, " %s\n", metric_value);
+  gchar *series = g_atomic_pointer_get(&cache[type]);
+  if (!series)
+    {
+      gchar *formatted = g_strdup(_format_series(sc, type));
+      if (!g_atomic_pointer_compare_and_exchange(&cache[type], NULL, formatted))
+        g_free(formatted);
+      series = g_atomic_pointer_get(&cache[type]);
+    }
+  return series;
+}
+
+GString *
+stats_prometheus_format_counter(StatsCluster *sc, gint type, StatsCounterItem *counter)
+{
+  if (_is_timestamp(sc, type))
+    return NULL;
+
+  GString *record = scratch_buffers_alloc();
+  g_string_append(record, _get_series(sc, type));
+  g_string_append_c(record, ' ');
+  g_string_append(record, stats_format_prometheus_format_counter_value(sc, type));
+  g_string_append_c(record, '\n');
 
   return record;
 }
@@ -304,10 +338,8 @@ stats_format_prometheus(StatsCluster *sc, gint type, StatsCounterItem *counter,
   scratch_buffers_mark(&marker);
 
   GString *record = stats_prometheus_format_counter(sc, type, counter);
-  if (!record)
-    return;
-
-  process_record(record->str, process_record_arg);
+  if (record)
+    process_record(record->str, process_record_arg);
   scratch_buffers_reclaim_marked(marker);
 }
 
@@ -334,7 +366,7 @@ stats_generate_prometheus(StatsPrometheusRecordFunc process_record, gpointer use
                           gboolean *cancelled)
 {
   gpointer format_prometheus_args[] = {process_record, user_data, GINT_TO_POINTER(with_legacy)};
-  stats_lock();
-  stats_foreach_counter(stats_format_prometheus, format_prometheus_args, cancelled);
-  stats_unlock();
+
+  /* large registries are scraped in chunks, so registrations are not blocked for the whole scrape */
+  stats_foreach_counter_in_chunks(stats_format_prometheus, format_prometheus_args, cancelled);
 }
@@ -25,10 +25,30 @@
 #include "cfg.h"
 #include <string.h>
 
+#define STATS_REGISTRY_DYNAMIC_STRIPES 16
+
+typedef struct _StatsClusterStripe
+{
+  GMutex lock;
+  GHashTable *clusters;
+} StatsClusterStripe;
+
+/* Static clusters are registered at configuration (re)load, under
+ * stats_lock().  Dynamic clusters are registered on the fly from worker
+ * threads (e.g.  metrics-probe(), update_metric()), so they are split into
+ * stripes by key, each with its own lock: registering, tracking and
+ * untracking dynamic counters only locks the stripe of the cluster and
+ * does not need stats_lock().
+ *
+ * Dynamic clusters are only removed under stats_lock(), so their pointers
+ * remain valid while it is held.  Lock ordering: stats_lock() first, the
+ * stripe lock second.
+ */
 typedef struct _StatsClusterContainer
 {
   GHashTable *static_clusters;
-  GHashTable *dynamic_clusters;
+  StatsClusterStripe dynamic_clusters[STATS_REGISTRY_DYNAMIC_STRIPES];
+  gint number_of_dynamic_clusters;
 } StatsClusterContainer;
 
 static StatsClusterContainer stats_cluster_container;
@@ -36,17 +56,44 @@ static StatsClusterContainer stats_cluster_container;
 static guint
 _number_of_dynamic_clusters(void)
 {
-  return g_hash_table_size(stats_cluster_container.dynamic_clusters);
+  return g_atomic_int_get(&stats_cluster_container.number_of_dynamic_clusters);
 }
 
 static GMutex stats_mutex;
 gboolean stats_locked;
 
+static StatsClusterStripe *
+_get_dynamic_stripe(const StatsClusterKey *sc_key)
+{
+  guint hash = stats_cluster_key_hash(sc_key);
+
+  /* the low bits select the bucket within the stripe's hash table, use the high ones here */
+  return &stats_cluster_container.dynamic_clusters[(hash >> 16) % STATS_REGISTRY_DYNAMIC_STRIPES];
+}
+
+static StatsClusterStripe *
+_lock_dynamic_stripe(const StatsClusterKey *sc_key)
+{
+  StatsClusterStripe *stripe = _get_dynamic_stripe(sc_key);
+
+  g_mutex_lock(&stripe->lock);
+  return stripe;
+}
+
+static void
+_unlock_dynamic_stripe(StatsClusterStripe *stripe)
+{
+  g_mutex_unlock(&stripe->lock);
+}
+
 static void
 _insert_cluster(StatsCluster *sc)
 {
   if (sc->dynamic)
-    g_hash_table_insert(stats_cluster_container.dynamic_clusters, &sc->key, sc);
+    {
+      g_hash_table_insert(_get_dynamic_stripe(&sc->key)->clusters, &sc->key, sc);
+      g_atomic_int_inc(&stats_cluster_container.number_of_dynamic_clusters);
+    }
   else
     g_hash_table_insert(stats_cluster_container.static_clusters, &sc->key, sc);
 }
@@ -71,12 +118,13 @@ is_stats_locked(void)
   return stats_locked;
 }
 
+/* must be called with the stripe of @sc_key locked */
 static StatsCluster *
 _grab_dynamic_cluster(const StatsClusterKey *sc_key)
 {
   StatsCluster *sc;
 
-  sc = g_hash_table_lookup(stats_cluster_container.dynamic_clusters, sc_key);
+  sc = g_hash_table_lookup(_get_dynamic_stripe(sc_key)->clusters, sc_key);
   if (!sc)
     {
       if (!stats_check_dynamic_clusters_limit(_number_of_dynamic_clusters()))
@@ -148,13 +196,11 @@ _update_counter_name_if_needed(StatsCounterItem *counter, StatsCluster *sc, gint
 }
 
 static StatsCluster *
-_register_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
-                  gboolean dynamic, StatsCounterItem **counter)
+_register_counter_locked(gint stats_level, const StatsClusterKey *sc_key, gint type,
+                         gboolean dynamic, StatsCounterItem **counter)
 {
   StatsCluster *sc;
 
-  g_assert(stats_locked);
-
   sc = _grab_cluster(stats_level, sc_key, dynamic);
   if (sc)
     {
@@ -165,6 +211,10 @@ _register_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
       (*counter)->external = FALSE;
       (*counter)->type = type;
       _update_counter_name_if_needed(*counter, sc, type);
+
+      /* dynamic clusters can be numerous, keep those compact */
+      if (!dynamic && stats_cluster_is_counter_sharded(sc, type))
+        stats_counter_enable_sharding(*counter, main_loop_worker_get_max_number_of_threads());
     }
   else
     {
@@ -173,6 +223,24 @@ _register_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
   return sc;
 }
 
+static StatsCluster *
+_register_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
+                  gboolean dynamic, StatsCounterItem **counter)
+{
+  StatsCluster *sc;
+
+  if (!dynamic)
+    {
+      g_assert(stats_locked);
+      return _register_counter_locked(stats_level, sc_key, type, dynamic, counter);
+    }
+
+  StatsClusterStripe *stripe = _lock_dynamic_stripe(sc_key);
+  sc = _register_counter_locked(stats_level, sc_key, type, dynamic, counter);
+  _unlock_dynamic_stripe(stripe);
+  return sc;
+}
+
 static void
 _assert_when_internal_or_stores_different_ref(StatsCluster *sc, gint type, atomic_gssize *external_counter)
 {
@@ -185,7 +253,7 @@ _assert_when_internal_or_stores_different_ref(StatsCluster *sc, gint type, atomi
 
 static StatsCluster *
 _register_external_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
-                           gboolean dynamic, atomic_gssize *external_counter)
+                           atomic_gssize *external_counter)
 {
   StatsCluster *sc;
 
@@ -194,7 +262,7 @@ _register_external_counter(gint stats_level, const StatsClusterKey *sc_key, gint
 
   g_assert(stats_locked);
 
-  sc = _grab_cluster(stats_level, sc_key, dynamic);
+  sc = _grab_cluster(stats_level, sc_key, FALSE);
   if (sc)
     {
       _assert_when_internal_or_stores_different_ref(sc, type, external_counter);
@@ -237,13 +305,21 @@ StatsCluster *
 stats_register_external_counter(gint stats_level, const StatsClusterKey *sc_key, gint type,
                                 atomic_gssize *external_counter)
 {
-  return _register_external_counter(stats_level, sc_key, type, FALSE, external_counter);
+  return _register_external_counter(stats_level, sc_key, type, external_counter);
 }
 
 StatsCluster *
 stats_register_alias_counter(gint level, const StatsClusterKey *sc_key, gint type, StatsCounterItem *aliased_counter)
 {
-  return stats_register_external_counter(level, sc_key, type, &aliased_counter->value);
+  StatsCluster *sc = stats_register_external_counter(level, sc_key, type, &aliased_counter->value);
+
+  if (sc)
+    {
+      StatsCounterItem *ctr = stats_cluster_get_counter(sc, type);
+      ctr->shards = aliased_counter->shards;
+      ctr->num_shards = aliased_counter->num_shards;
+    }
+  return sc;
 }
 
 StatsCluster *
@@ -266,7 +342,6 @@ stats_register_and_increment_dynamic_counter(gint stats_level, const StatsCluste
   StatsCounterItem *counter, *stamp;
   StatsCluster *handle;
 
-  g_assert(stats_locked);
   handle = stats_register_dynamic_counter(stats_level, sc_key, SC_TYPE_PROCESSED, &counter);
   if (!handle)
     return;
@@ -288,19 +363,22 @@ stats_register_and_increment_dynamic_counter(gint stats_level, const StatsCluste
  *
  * This function registers another counter type in the same StatsCounter
  * instance in order to avoid an unnecessary lookup.
+ *
+ * Like the rest of the dynamic counter functions, this does not need
+ * stats_lock().
  **/
 void
 stats_register_associated_counter(StatsCluster *sc, gint type, StatsCounterItem **counter)
 {
-  g_assert(stats_locked);
-
   *counter = NULL;
   if (!sc)
     return;
   g_assert(sc->dynamic);
 
+  StatsClusterStripe *stripe = _lock_dynamic_stripe(&sc->key);
   *counter = stats_cluster_track_counter(sc, type);
   _update_counter_name_if_needed(*counter, sc, type);
+  _unlock_dynamic_stripe(stripe);
 }
 
 void
@@ -346,10 +424,22 @@ stats_unregister_alias_counter(const StatsClusterKey *sc_key, gint type, StatsCo
 void
 stats_unregister_dynamic_counter(StatsCluster *sc, gint type, StatsCounterItem **counter)
 {
-  g_assert(stats_locked);
   if (!sc)
     return;
+
+  StatsClusterStripe *stripe = _lock_dynamic_stripe(&sc->key);
   stats_cluster_untrack_counter(sc, type, counter);
+  _unlock_dynamic_stripe(stripe);
+}
+
+static StatsCluster *
+_lookup_dynamic_cluster(const StatsClusterKey *sc_key)
+{
+  StatsClusterStripe *stripe = _lock_dynamic_stripe(sc_key);
+  StatsCluster *sc = g_hash_table_lookup(stripe->clusters, sc_key);
+  _unlock_dynamic_stripe(stripe);
+
+  return sc;
 }
 
 StatsCluster *
@@ -360,24 +450,39 @@ stats_get_cluster(const StatsClusterKey *sc_key)
   StatsCluster *sc = g_hash_table_lookup(stats_cluster_container.static_clusters, sc_key);
 
   if (!sc)
-    sc = g_hash_table_lookup(stats_cluster_container.dynamic_clusters, sc_key);
+    sc = _lookup_dynamic_cluster(sc_key);
 
   return sc;
 }
 
+static gboolean
+_remove_dynamic_cluster(const StatsClusterKey *sc_key, gboolean *found)
+{
+  StatsClusterStripe *stripe = _lock_dynamic_stripe(sc_key);
+  StatsCluster *sc = g_hash_table_lookup(stripe->clusters, sc_key);
+  gboolean removed = FALSE;
+
+  *found = (sc != NULL);
+  if (sc && stats_cluster_is_orphaned(sc))
+    {
+      removed = g_hash_table_remove(stripe->clusters, sc_key);
+      g_atomic_int_add(&stats_cluster_container.number_of_dynamic_clusters, -1);
+    }
+  _unlock_dynamic_stripe(stripe);
+
+  return removed;
+}
+
 gboolean
 stats_remove_cluster(const StatsClusterKey *sc_key)
 {
   g_assert(stats_locked);
   StatsCluster *sc;
+  gboolean found;
 
-  sc = g_hash_table_lookup(stats_cluster_container.dynamic_clusters, sc_key);
-  if (sc)
-    {
-      if (stats_cluster_is_orphaned(sc))
-        return g_hash_table_remove(stats_cluster_container.dynamic_clusters, sc_key);
-      return FALSE;
-    }
+  gboolean removed = _remove_dynamic_cluster(sc_key, &found);
+  if (found)
+    return removed;
 
   sc = g_hash_table_lookup(stats_cluster_container.static_clusters, sc_key);
   if (sc)
@@ -442,6 +547,30 @@ _foreach_cluster(GHashTable *clusters, gpointer *args, gboolean *cancelled)
     }
 }
 
+/* the callbacks are invoked without holding the stripe lock, clusters are not removed as stats_lock() is held */
+static void
+_foreach_dynamic_cluster(StatsClusterStripe *stripe, gpointer *args, gboolean *cancelled)
+{
+  GPtrArray *clusters;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_mutex_lock(&stripe->lock);
+  clusters = g_ptr_array_sized_new(g_hash_table_size(stripe->clusters));
+  g_hash_table_iter_init(&iter, stripe->clusters);
+  while (g_hash_table_iter_next(&iter, &key, &value))
+    g_ptr_array_add(clusters, value);
+  g_mutex_unlock(&stripe->lock);
+
+  for (guint i = 0; i < clusters->len; i++)
+    {
+      if (cancelled && *cancelled)
+        break;
+      _foreach_cluster_helper(NULL, g_ptr_array_index(clusters, i), args);
+    }
+  g_ptr_array_free(clusters, TRUE);
+}
+
 void
 stats_foreach_cluster(StatsForeachClusterFunc func, gpointer user_data, gboolean *cancelled)
 {
@@ -449,7 +578,8 @@ stats_foreach_cluster(StatsForeachClusterFunc func, gpointer user_data, gboolean
 
   g_assert(stats_locked);
   _foreach_cluster(stats_cluster_container.static_clusters, args, cancelled);
-  _foreach_cluster(stats_cluster_container.dynamic_clusters, args, cancelled);
+  for (gint i = 0; i < STATS_REGISTRY_DYNAMIC_STRIPES; i++)
+    _foreach_dynamic_cluster(&stats_cluster_container.dynamic_clusters[i], args, cancelled);
 }
 
 static gboolean
@@ -469,7 +599,16 @@ stats_foreach_cluster_remove(StatsForeachClusterRemoveFunc func, gpointer user_d
 {
   gpointer args[] = { func, user_data };
   g_hash_table_foreach_remove(stats_cluster_container.static_clusters, _foreach_cluster_remove_helper, args);
-  g_hash_table_foreach_remove(stats_cluster_container.dynamic_clusters, _foreach_cluster_remove_helper, args);
+
+  for (gint i = 0; i < STATS_REGISTRY_DYNAMIC_STRIPES; i++)
+    {
+      StatsClusterStripe *stripe = &stats_cluster_container.dynamic_clusters[i];
+
+      g_mutex_lock(&stripe->lock);
+      guint removed = g_hash_table_foreach_remove(stripe->clusters, _foreach_cluster_remove_helper, args);
+      g_atomic_int_add(&stats_cluster_container.number_of_dynamic_clusters, -(gint) removed);
+      g_mutex_unlock(&stripe->lock);
+    }
 }
 
 static void
@@ -498,6 +637,34 @@ stats_foreach_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean
   stats_foreach_cluster(_foreach_counter_helper, args, cancelled);
 }
 
+/*
+ * Like stats_foreach_counter(), but takes stats_lock() on its own and only
+ * holds it while processing a chunk of clusters: the static clusters form
+ * one chunk and each dynamic stripe another.  Clusters registered or
+ * removed while the lock is released may or may not be visited, but none
+ * of them is visited twice.
+ */
+void
+stats_foreach_counter_in_chunks(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled)
+{
+  gpointer counter_args[] = { func, user_data };
+  gpointer args[] = { _foreach_counter_helper, counter_args };
+
+  stats_lock();
+  _foreach_cluster(stats_cluster_container.static_clusters, args, cancelled);
+  stats_unlock();
+
+  for (gint i = 0; i < STATS_REGISTRY_DYNAMIC_STRIPES; i++)
+    {
+      if (cancelled && *cancelled)
+        break;
+
+      stats_lock();
+      _foreach_dynamic_cluster(&stats_cluster_container.dynamic_clusters[i], args, cancelled);
+      stats_unlock();
+    }
+}
+
 void
 stats_foreach_legacy_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled)
 {
@@ -513,9 +680,16 @@ stats_registry_init(void)
   stats_cluster_container.static_clusters = g_hash_table_new_full((GHashFunc) stats_cluster_key_hash,
                                             (GEqualFunc) stats_cluster_key_equal, NULL,
                                             (GDestroyNotify) stats_cluster_free);
-  stats_cluster_container.dynamic_clusters = g_hash_table_new_full((GHashFunc) stats_cluster_key_hash,
-                                             (GEqualFunc) stats_cluster_key_equal, NULL,
-                                             (GDestroyNotify) stats_cluster_free);
+  for (gint i = 0; i < STATS_REGISTRY_DYNAMIC_STRIPES; i++)
+    {
+      StatsClusterStripe *stripe = &stats_cluster_container.dynamic_clusters[i];
+
+      g_mutex_init(&stripe->lock);
+      stripe->clusters = g_hash_table_new_full((GHashFunc) stats_cluster_key_hash,
+                                               (GEqualFunc) stats_cluster_key_equal, NULL,
+                                               (GDestroyNotify) stats_cluster_free);
+    }
+  stats_cluster_container.number_of_dynamic_clusters = 0;
 
   g_mutex_init(&stats_mutex);
 }
@@ -524,8 +698,14 @@ void
 stats_registry_deinit(void)
 {
   g_hash_table_destroy(stats_cluster_container.static_clusters);
-  g_hash_table_destroy(stats_cluster_container.dynamic_clusters);
   stats_cluster_container.static_clusters = NULL;
-  stats_cluster_container.dynamic_clusters = NULL;
+  for (gint i = 0; i < STATS_REGISTRY_DYNAMIC_STRIPES; i++)
+    {
+      StatsClusterStripe *stripe = &stats_cluster_container.dynamic_clusters[i];
+
+      g_hash_table_destroy(stripe->clusters);
+      stripe->clusters = NULL;
+      g_mutex_clear(&stripe->lock);
+    }
   g_mutex_clear(&stats_mutex);
 }
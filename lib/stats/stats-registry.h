@@ -59,6 +59,7 @@ StatsCluster *stats_get_cluster(const StatsClusterKey *sc_key);
 gboolean stats_remove_cluster(const StatsClusterKey *sc_key);
 
 void stats_foreach_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled);
+void stats_foreach_counter_in_chunks(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled);
 void stats_foreach_legacy_counter(StatsForeachCounterFunc func, gpointer user_data, gboolean *cancelled);
 void stats_foreach_cluster(StatsForeachClusterFunc func, gpointer user_data, gboolean *cancelled);
 void stats_foreach_cluster_remove(StatsForeachClusterRemoveFunc func, gpointer user_data);
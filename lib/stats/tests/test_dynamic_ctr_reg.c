@@ -30,7 +30,9 @@
 #include "stats/stats-counter.h"
 #include "stats/stats-query.h"
 #include "stats/stats-registry.h"
+#include "timeutils/misc.h"
 #include <limits.h>
+#include <stdio.h>
 #include <time.h>
 
 TestSuite(stats_dynamic_clusters, .init = app_startup, .fini = app_shutdown);
@@ -82,3 +84,95 @@ Test(stats_dynamic_clusters, register_limited)
   stats_unlock();
 }
 
+
+#define CONCURRENT_THREADS 8
+#define CONCURRENT_KEYS 64
+#define CONCURRENT_ITERATIONS 2000
+
+static void
+_format_concurrent_key(StatsClusterKey *sc_key, StatsClusterLabel *label, gchar *buf, gsize buf_len, gint key_index)
+{
+  g_snprintf(buf, buf_len, "%d", key_index);
+  *label = stats_cluster_label("key", buf);
+  stats_cluster_single_key_set(sc_key, "test_concurrent", label, 1);
+}
+
+/* the same way dyn-metrics-store does, without stats_lock() */
+static gpointer
+_register_and_increment_concurrently(gpointer user_data)
+{
+  gint thread_index = GPOINTER_TO_INT(user_data);
+
+  for (gint i = 0; i < CONCURRENT_ITERATIONS; i++)
+    {
+      StatsClusterKey sc_key;
+      StatsClusterLabel label;
+      StatsCounterItem *counter;
+      gchar buf[16];
+
+      _format_concurrent_key(&sc_key, &label, buf, sizeof(buf), (i + thread_index) % CONCURRENT_KEYS);
+      StatsCluster *sc = stats_register_dynamic_counter(STATS_LEVEL1, &sc_key, SC_TYPE_SINGLE_VALUE, &counter);
+      stats_counter_inc(counter);
+      stats_unregister_dynamic_counter(sc, SC_TYPE_SINGLE_VALUE, &counter);
+    }
+  return NULL;
+}
+
+static gdouble
+_run_concurrent_registrations(gint num_threads)
+{
+  GThread *threads[CONCURRENT_THREADS];
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (gint i = 0; i < num_threads; i++)
+    threads[i] = g_thread_new(NULL, _register_and_increment_concurrently, GINT_TO_POINTER(i));
+  for (gint i = 0; i < num_threads; i++)
+    g_thread_join(threads[i]);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return num_threads * CONCURRENT_ITERATIONS * 1e6 / timespec_diff_usec(&end, &start);
+}
+
+Test(stats_dynamic_clusters, concurrent_registration_without_stats_lock)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 1;
+  stats_reinit(&stats_opts);
+
+  _run_concurrent_registrations(CONCURRENT_THREADS);
+
+  gsize total = 0;
+  stats_lock();
+  for (gint i = 0; i < CONCURRENT_KEYS; i++)
+    {
+      StatsClusterKey sc_key;
+      StatsClusterLabel label;
+      gchar buf[16];
+
+      _format_concurrent_key(&sc_key, &label, buf, sizeof(buf), i);
+      StatsCounterItem *counter = stats_get_counter(&sc_key, SC_TYPE_SINGLE_VALUE);
+      cr_assert_not_null(counter);
+      total += stats_counter_get(counter);
+
+      StatsCluster *sc = stats_get_cluster(&sc_key);
+      cr_assert_eq(sc->use_count, 0, "all registrations should have been released, key=%d", i);
+      cr_assert(stats_remove_cluster(&sc_key));
+    }
+  stats_unlock();
+
+  cr_assert_eq(total, CONCURRENT_THREADS * CONCURRENT_ITERATIONS);
+}
+
+Test(stats_dynamic_clusters, registration_contention_benchmark)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 1;
+  stats_reinit(&stats_opts);
+
+  for (gint num_threads = 1; num_threads <= CONCURRENT_THREADS; num_threads *= 2)
+    printf("Dynamic counter registration with %d threads: %12.3f registrations/sec\n",
+           num_threads, _run_concurrent_registrations(num_threads));
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "apphook.h"
+#include "mainloop-worker.h"
+#include "stats/stats-cluster.h"
+#include "stats/stats-cluster-single.h"
+#include "stats/stats-counter.h"
+#include "stats/stats-registry.h"
+
+#define NUM_WORKERS 4
+#define NUM_INCREMENTS 100000
+
+static void
+_setup(void)
+{
+  app_startup();
+  main_loop_worker_allocate_thread_space(NUM_WORKERS);
+  main_loop_worker_finalize_thread_space();
+}
+
+TestSuite(stats_sharded_counter, .init = _setup, .fini = app_shutdown);
+
+static StatsCounterItem *
+_register_logpipe_counter(const gchar *id, gint type)
+{
+  StatsCounterItem *counter = NULL;
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_GLOBAL, id, NULL);
+  stats_register_counter(0, &sc_key, type, &counter);
+  stats_unlock();
+  return counter;
+}
+
+static gpointer
+_increment_thread(gpointer user_data)
+{
+  StatsCounterItem *counter = (StatsCounterItem *) user_data;
+
+  main_loop_worker_thread_start(MLW_THREADED_INPUT_WORKER);
+  for (gint i = 0; i < NUM_INCREMENTS; i++)
+    stats_counter_inc(counter);
+  stats_counter_add(counter, 10);
+  stats_counter_sub(counter, 5);
+  main_loop_worker_thread_stop();
+  return NULL;
+}
+
+static void
+_run_increment_threads(StatsCounterItem *counter)
+{
+  GThread *threads[NUM_WORKERS];
+
+  for (gint i = 0; i < NUM_WORKERS; i++)
+    threads[i] = g_thread_new(NULL, _increment_thread, counter);
+  for (gint i = 0; i < NUM_WORKERS; i++)
+    g_thread_join(threads[i]);
+}
+
+Test(stats_sharded_counter, per_message_logpipe_counters_are_sharded)
+{
+  StatsCounterItem *processed = _register_logpipe_counter("sharded", SC_TYPE_PROCESSED);
+  StatsCounterItem *stamp = _register_logpipe_counter("sharded", SC_TYPE_STAMP);
+  StatsCounterItem *queued = _register_logpipe_counter("sharded", SC_TYPE_QUEUED);
+
+  cr_assert_not_null(processed->shards);
+  cr_assert_eq(processed->num_shards, NUM_WORKERS);
+  cr_assert_eq((gsize) processed->shards % STATS_COUNTER_SHARD_SIZE, 0);
+  cr_assert_null(stamp->shards);
+  cr_assert_null(queued->shards);
+}
+
+Test(stats_sharded_counter, dynamic_counters_are_not_sharded)
+{
+  StatsCounterItem *counter = NULL;
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_HOST | SCS_SOURCE, NULL, "dynamic");
+  StatsCluster *sc = stats_register_dynamic_counter(0, &sc_key, SC_TYPE_PROCESSED, &counter);
+  cr_assert_not_null(sc);
+  cr_assert_null(counter->shards);
+  stats_unregister_dynamic_counter(sc, SC_TYPE_PROCESSED, &counter);
+  stats_unlock();
+}
+
+Test(stats_sharded_counter, increments_from_workers_are_summed_on_read)
+{
+  StatsCounterItem *counter = _register_logpipe_counter("sharded", SC_TYPE_PROCESSED);
+
+  /* the main thread has no worker index and uses the shared slot */
+  stats_counter_add(counter, 3);
+  _run_increment_threads(counter);
+
+  cr_assert_eq(stats_counter_get(counter), 3 + NUM_WORKERS * (NUM_INCREMENTS + 5));
+  cr_assert_eq(atomic_gssize_get(&counter->value), 3);
+
+  stats_counter_set(counter, 42);
+  cr_assert_eq(stats_counter_get(counter), 42);
+}
+
+Test(stats_sharded_counter, alias_counters_see_the_shards)
+{
+  StatsCounterItem *counter = _register_logpipe_counter("sharded", SC_TYPE_WRITTEN);
+  StatsCounterItem *alias_counter;
+  StatsClusterKey sc_key;
+
+  stats_lock();
+  stats_cluster_logpipe_key_legacy_set(&sc_key, SCS_GLOBAL, "sharded.alias", NULL);
+  StatsCluster *sc = stats_register_alias_counter(0, &sc_key, SC_TYPE_WRITTEN, counter);
+  alias_counter = stats_cluster_get_counter(sc, SC_TYPE_WRITTEN);
+  stats_unlock();
+
+  _run_increment_threads(counter);
+  cr_assert_eq(stats_counter_get(alias_counter), NUM_WORKERS * (NUM_INCREMENTS + 5));
+
+  stats_lock();
+  stats_unregister_alias_counter(&sc_key, SC_TYPE_WRITTEN, counter);
+  stats_unlock();
+
+  cr_assert_not_null(counter->shards);
+  cr_assert_eq(stats_counter_get(counter), NUM_WORKERS * (NUM_INCREMENTS + 5));
+}
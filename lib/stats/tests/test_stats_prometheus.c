@@ -37,6 +37,7 @@
 
 #include <float.h>
 #include <limits.h>
+#include <string.h>
 
 static void
 setup(void)
@@ -266,3 +267,64 @@ Test(stats_prometheus, test_prometheus_format_legacy_alias_is_ignored)
   assert_prometheus_format(cluster, SC_TYPE_SINGLE_VALUE, "syslogng_name 0\n");
   stats_cluster_free(cluster);
 }
+
+Test(stats_prometheus, test_prometheus_format_caches_series)
+{
+  StatsClusterLabel labels[] = { stats_cluster_label("app", "cisco\"") };
+  StatsCluster *cluster = test_logpipe_cluster("test_name", labels, G_N_ELEMENTS(labels));
+  StatsCounterItem *counter = _track_counter_locked(cluster, SC_TYPE_PROCESSED);
+
+  assert_prometheus_format(cluster, SC_TYPE_PROCESSED,
+                           "syslogng_test_name{app=\"cisco\\\"\",result=\"processed\"} 0\n");
+  const gchar *series = cluster->prometheus_series[SC_TYPE_PROCESSED];
+  cr_assert_str_eq(series, "syslogng_test_name{app=\"cisco\\\"\",result=\"processed\"}");
+
+  stats_counter_add(counter, 42);
+  assert_prometheus_format(cluster, SC_TYPE_PROCESSED,
+                           "syslogng_test_name{app=\"cisco\\\"\",result=\"processed\"} 42\n");
+  cr_assert_eq(cluster->prometheus_series[SC_TYPE_PROCESSED], series, "series should be rendered only once");
+  cr_assert_null(cluster->prometheus_series[SC_TYPE_DROPPED]);
+
+  stats_cluster_free(cluster);
+}
+
+static void
+_collect_records(const gchar *record, gpointer user_data)
+{
+  GString *output = (GString *) user_data;
+  g_string_append(output, record);
+}
+
+Test(stats_prometheus, test_prometheus_generate_visits_static_and_dynamic_clusters)
+{
+  StatsOptions stats_opts;
+  stats_options_defaults(&stats_opts);
+  stats_opts.level = 1;
+  stats_reinit(&stats_opts);
+
+  StatsClusterKey key;
+  StatsCounterItem *static_counter, *dynamic_counter;
+  StatsClusterLabel labels[] = { stats_cluster_label("label", "dynamic") };
+  StatsCluster *dynamic_cluster;
+
+  stats_lock();
+  stats_cluster_single_key_set(&key, "static_metric", NULL, 0);
+  stats_register_counter(STATS_LEVEL0, &key, SC_TYPE_SINGLE_VALUE, &static_counter);
+  stats_unlock();
+
+  stats_cluster_single_key_set(&key, "dynamic_metric", labels, G_N_ELEMENTS(labels));
+  dynamic_cluster = stats_register_dynamic_counter(STATS_LEVEL1, &key, SC_TYPE_SINGLE_VALUE, &dynamic_counter);
+  stats_counter_set(dynamic_counter, 5);
+
+  GString *output = g_string_new("");
+  stats_generate_prometheus(_collect_records, output, FALSE, NULL);
+  cr_assert(strstr(output->str, "syslogng_static_metric 0\n"), "%s", output->str);
+  cr_assert(strstr(output->str, "syslogng_dynamic_metric{label=\"dynamic\"} 5\n"), "%s", output->str);
+  g_string_free(output, TRUE);
+
+  stats_unregister_dynamic_counter(dynamic_cluster, SC_TYPE_SINGLE_VALUE, &dynamic_counter);
+  stats_lock();
+  stats_cluster_single_key_set(&key, "static_metric", NULL, 0);
+  stats_unregister_counter(&key, SC_TYPE_SINGLE_VALUE, &static_counter);
+  stats_unlock();
+}
@@ -22,7 +22,7 @@
  */
 
 #include "eval.h"
-#include "repr.h"
+#include "program.h"
 #include "macros.h"
 #include "escaping.h"
 #include "cfg.h"
@@ -55,7 +55,7 @@ _should_render(const gchar *value, LogMessageValueType value_type, LogMessageVal
 }
 
 static void
-log_template_append_elem_value(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
+log_template_append_elem_value(LogTemplate *self, const LogTemplateInstr *e, LogTemplateEvalOptions *options,
                                LogMessage *msg, LogMessageValueType *type, GString *result)
 {
   const gchar *value = NULL;
@@ -84,23 +84,34 @@ log_template_append_elem_value(LogTemplate *self, LogTemplateElem *e, LogTemplat
 }
 
 static void
-log_template_append_elem_macro(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
+log_template_append_elem_macro(LogTemplate *self, const LogTemplateInstr *e, LogTemplateEvalOptions *options,
                                LogMessage *msg, LogMessageValueType *type, GString *result)
 {
   gint len = result->len;
   LogMessageValueType value_type = LM_VT_NONE;
 
-  if (e->macro)
-    {
-      log_macro_expand(e->macro, options, msg, result, &value_type);
-      if (len == result->len && e->default_value)
-        g_string_append(result, e->default_value);
-      *type = _propagate_type(*type, value_type);
-    }
+  log_macro_expand(e->macro, options, msg, result, &value_type);
+  if (len == result->len && e->default_value)
+    g_string_append(result, e->default_value);
+  *type = _propagate_type(*type, value_type);
 }
 
+/* same as log_template_append_elem_macro(), without dispatching on the macro id first */
 static void
-log_template_append_elem_func(LogTemplate *self, LogTemplateElem *e, LogTemplateEvalOptions *options,
+log_template_append_elem_date_macro(LogTemplate *self, const LogTemplateInstr *e, LogTemplateEvalOptions *options,
+                                    LogMessage *msg, LogMessageValueType *type, GString *result)
+{
+  gint len = result->len;
+  LogMessageValueType value_type = LM_VT_STRING;
+
+  log_macro_expand_date_time(e->macro, options, msg, result, &value_type);
+  if (len == result->len && e->default_value)
+    g_string_append(result, e->default_value);
+  *type = _propagate_type(*type, value_type);
+}
+
+static void
+log_template_append_elem_func(LogTemplate *self, const LogTemplateInstr *e, LogTemplateEvalOptions *options,
                               LogMessage **messages, gint num_messages, gint msg_ndx,
                               LogMessageValueType *type, GString *result)
 {
@@ -125,15 +136,149 @@ log_template_append_elem_func(LogTemplate *self, LogTemplateElem *e, LogTemplate
   *type = _propagate_type(*type, value_type);
 }
 
+static inline void
+_exec_text(LogTemplateEvalState *state, const gchar *text, gsize text_len)
+{
+  /* concatenating literal text */
+  g_string_append_len(state->result, text, text_len);
+  state->type = LM_VT_STRING;
+}
+
+static inline void
+_exec_elem(LogTemplateEvalState *state, const LogTemplateInstr *e, guint8 op)
+{
+  gint msg_ndx;
+
+  if (op == LTI_LITERAL)
+    {
+      /* escaping an empty value still makes the result a string */
+      if (state->escape)
+        state->type = LM_VT_STRING;
+      return;
+    }
+
+  /* NOTE: msg_ref is 1 larger than the index specified by the user in
+   * order to make it distinguishable from the zero value.  Therefore
+   * the '>' instead of '>='
+   *
+   * msg_ref == 0 means that the user didn't specify msg_ref
+   * msg_ref >= 1 means that the user supplied the given msg_ref, 1 is equal to @0 */
+  if (e->msg_ref > state->num_messages)
+    {
+      /* msg_ref out of range, we expand to empty string without evaluating the element */
+      state->type = LM_VT_STRING;
+      return;
+    }
+  msg_ndx = state->num_messages - e->msg_ref;
+
+  /* value and macro can't understand a context, assume that no msg_ref means @0 */
+  if (e->msg_ref == 0)
+    msg_ndx--;
+
+  if (state->escape)
+    g_string_truncate(state->target_buffer, 0);
+
+  switch (op)
+    {
+    case LTI_VALUE:
+      log_template_append_elem_value(state->template, e, state->options, state->messages[msg_ndx],
+                                     &state->type, state->target_buffer);
+      break;
+    case LTI_MACRO:
+      log_template_append_elem_macro(state->template, e, state->options, state->messages[msg_ndx],
+                                     &state->type, state->target_buffer);
+      break;
+    case LTI_DATE_MACRO:
+      log_template_append_elem_date_macro(state->template, e, state->options, state->messages[msg_ndx],
+                                          &state->type, state->target_buffer);
+      break;
+    case LTI_FUNC:
+      log_template_append_elem_func(state->template, e, state->options, state->messages, state->num_messages, msg_ndx,
+                                    &state->type, state->target_buffer);
+      break;
+    default:
+      g_assert_not_reached();
+      break;
+    }
+
+  if (state->escape)
+    {
+      if (state->options->escape)
+        state->options->escape(state->result, state->target_buffer->str, state->target_buffer->len);
+      else
+        log_template_default_escape_method(state->result, state->target_buffer->str, state->target_buffer->len);
+      state->type = LM_VT_STRING;
+    }
+}
+
+static inline void
+_exec_instr(LogTemplateEvalState *state, const LogTemplateInstr *e, guint8 op)
+{
+  if (e->text_len)
+    _exec_text(state, e->text, e->text_len);
+  _exec_elem(state, e, op);
+}
+
+/*
+ * Entry points of JIT compiled templates.  eval.c is part of the FilterX
+ * JIT bitcode, so these are inlined into the generated code, where the
+ * arguments other than the state are constants.
+ */
+void
+log_template_jit_exec_text(LogTemplateEvalState *state, const gchar *text, gsize text_len)
+{
+  _exec_text(state, text, text_len);
+}
+
+/* $NAME without @ref: the value is looked up and appended without going
+ * through the target buffer, unless the result needs escaping */
+void
+log_template_jit_exec_value(LogTemplateEvalState *state, const LogTemplateInstr *instr, NVHandle value_handle)
+{
+  const gchar *value;
+  gssize value_len = -1;
+  LogMessageValueType value_type = LM_VT_NONE;
+
+  if (G_UNLIKELY(state->escape))
+    {
+      _exec_elem(state, instr, LTI_VALUE);
+      return;
+    }
+
+  value = log_msg_get_value_with_type(state->messages[state->num_messages - 1], value_handle, &value_len, &value_type);
+  if (G_LIKELY(value && _should_render(value, value_type, state->template->type_hint)))
+    {
+      g_string_append_len(state->result, value, value_len);
+      state->type = _propagate_type(state->type, value_type);
+      return;
+    }
+
+  /* defaults and binary values */
+  _exec_elem(state, instr, LTI_VALUE);
+}
+
+void
+log_template_jit_exec_elem(LogTemplateEvalState *state, const LogTemplateInstr *instr, guint8 op)
+{
+  _exec_elem(state, instr, op);
+}
+
 void
 log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMessage **messages, gint num_messages,
                                                        LogTemplateEvalOptions *options,
                                                        GString *result, LogMessageValueType *type)
 {
-  LogTemplateElem *e;
-  LogMessageValueType t = LM_VT_NONE;
-  gboolean first_elem = TRUE;
-  GString *target_buffer = result;
+  LogTemplateProgram *program = self->program;
+  LogTemplateEvalState state =
+  {
+    .template = self,
+    .messages = messages,
+    .num_messages = num_messages,
+    .options = options,
+    .result = result,
+    .target_buffer = result,
+    .type = LM_VT_NONE,
+  };
 
   if (!options->opts)
     {
@@ -145,80 +290,36 @@ log_template_append_format_value_and_type_with_context(LogTemplate *self, LogMes
         options->opts = log_template_get_global_template_options();
     }
 
-  gboolean escape = (self->escape || (self->top_level && options->opts->escape));
-  if (escape)
-    target_buffer = scratch_buffers_alloc();
+  state.escape = (self->escape || (self->top_level && options->opts->escape));
+  if (state.escape)
+    state.target_buffer = scratch_buffers_alloc();
 
-  for (GList *p = self->compiled_template; p; p = g_list_next(p), first_elem = FALSE)
+  if (program && program->n_elems > 1)
     {
-      gint msg_ndx;
-
-      if (!first_elem)
-        {
-          /* this is the 2nd elem in the compiled template, we are
-           * concatenating multiple elements, convert the value to string */
-
-          t = LM_VT_STRING;
-        }
-
-      e = (LogTemplateElem *) p->data;
-      if (e->text)
-        {
-          g_string_append_len(result, e->text, e->text_len);
-          /* concatenating literal text */
-          if (e->text_len)
-            t = LM_VT_STRING;
-        }
-
-      /* NOTE: msg_ref is 1 larger than the index specified by the user in
-       * order to make it distinguishable from the zero value.  Therefore
-       * the '>' instead of '>='
-       *
-       * msg_ref == 0 means that the user didn't specify msg_ref
-       * msg_ref >= 1 means that the user supplied the given msg_ref, 1 is equal to @0 */
-      if (e->msg_ref > num_messages)
-        {
-          /* msg_ref out of range, we expand to empty string without evaluating the element */
-          t = LM_VT_STRING;
-          continue;
-        }
-      msg_ndx = num_messages - e->msg_ref;
-
-      /* value and macro can't understand a context, assume that no msg_ref means @0 */
-      if (e->msg_ref == 0)
-        msg_ndx--;
-
-      if (escape)
-        g_string_truncate(target_buffer, 0);
+      /* we are concatenating multiple elements, the value is a string */
+      state.type = LM_VT_STRING;
+    }
 
-      switch (e->type)
+  gint n_instrs = program ? program->n_instrs : 0;
+  if (self->jit_exec)
+    {
+      self->jit_exec(&state);
+    }
+  else
+    {
+      for (gint i = 0; i < n_instrs; i++)
         {
-        case LTE_VALUE:
-          log_template_append_elem_value(self, e, options, messages[msg_ndx], &t, target_buffer);
-          break;
-        case LTE_MACRO:
-          log_template_append_elem_macro(self, e, options, messages[msg_ndx], &t, target_buffer);
-          break;
-        case LTE_FUNC:
-          log_template_append_elem_func(self, e, options, messages, num_messages, msg_ndx, &t, target_buffer);
-          break;
-        default:
-          g_assert_not_reached();
-          break;
-        }
+          const LogTemplateInstr *e = &program->instrs[i];
 
-      if (escape)
-        {
-          if (options->escape)
-            options->escape(result, target_buffer->str, target_buffer->len);
-          else
-            log_template_default_escape_method(result, target_buffer->str, target_buffer->len);
-          t = LM_VT_STRING;
+          _exec_instr(&state, e, e->op);
         }
     }
+
   if (type)
     {
-      if (first_elem && t == LM_VT_NONE)
+      LogMessageValueType t = state.type;
+
+      if (n_instrs == 0 && t == LM_VT_NONE)
         {
           /* empty template string, use LM_VT_STRING before applying the type-cast */
           t = LM_VT_STRING;
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "template/jit.h"
+#include "template/program.h"
+#include "filterx/jit/ffi.h"
+#include "messages.h"
+#include "cfg.h"
+
+#define MODULE_CONFIG_KEY "template-jit"
+
+#if SYSLOG_NG_ENABLE_JIT
+
+/*
+ * Blocks are named after the registration order of the templates, so the
+ * per-block metrics and cache entries are the same for the same
+ * configuration, in every process.
+ */
+static const gchar *
+_block_name(gpointer registration, gchar *buf, gsize buf_len)
+{
+  g_snprintf(buf, buf_len, "template_%u", GPOINTER_TO_UINT(registration));
+  return buf;
+}
+
+static void
+_emit_exec_text(FilterXJIT *jit, FilterXIRValue state, const LogTemplateInstr *instr)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRType size_ty = LLVMIntTypeInContext(LLVMGetTypeContext(ffi->ptr_ty), sizeof(gsize) * 8);
+
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, size_ty };
+  FilterXIRValue args[] =
+  {
+    state,
+    fx_jit_emit_const_ptr(jit, instr->text),
+    LLVMConstInt(size_ty, instr->text_len, FALSE),
+  };
+  fx_jit_emit_extern_call(jit, "log_template_jit_exec_text", ffi->void_ty, param_tys, args, G_N_ELEMENTS(args));
+}
+
+static void
+_emit_exec_value(FilterXJIT *jit, FilterXIRValue state, const LogTemplateInstr *instr)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, ffi->i32_ty };
+  FilterXIRValue args[] =
+  {
+    state,
+    fx_jit_emit_const_ptr(jit, instr),
+    LLVMConstInt(ffi->i32_ty, instr->value_handle, FALSE),
+  };
+  fx_jit_emit_extern_call(jit, "log_template_jit_exec_value", ffi->void_ty, param_tys, args, G_N_ELEMENTS(args));
+}
+
+static void
+_emit_exec_elem(FilterXJIT *jit, FilterXIRValue state, const LogTemplateInstr *instr)
+{
+  FilterXJITFFI *ffi = filterx_jit_get_ffi(jit);
+  FilterXIRType op_ty = LLVMInt8TypeInContext(LLVMGetTypeContext(ffi->ptr_ty));
+
+  FilterXIRType param_tys[] = { ffi->ptr_ty, ffi->ptr_ty, op_ty };
+  FilterXIRValue args[] =
+  {
+    state,
+    fx_jit_emit_const_ptr(jit, instr),
+    LLVMConstInt(op_ty, instr->op, FALSE),
+  };
+  fx_jit_emit_extern_call(jit, "log_template_jit_exec_elem", ffi->void_ty, param_tys, args, G_N_ELEMENTS(args));
+}
+
+/*
+ * The single parameter of the block is the LogTemplateEvalState.
+ *
+ * Everything that is known at compile time is resolved here instead of
+ * at evaluation time: empty literal prefixes are not emitted at all, the
+ * literal text, its length, the opcode and the NVHandle of $NAME lookups
+ * are passed as constants.  The entry points are defined in the bitcode
+ * linked into the JIT module, so after inlining the opcode dispatch folds
+ * away and a literal becomes a single g_string_append_len() of a constant
+ * string, a $NAME reference a direct NVTable lookup followed by an append.
+ */
+static void
+_compile_template(FilterXJIT *jit, LogTemplate *template, gpointer registration)
+{
+  LogTemplateProgram *program = template->program;
+  gchar block_name[64];
+
+  filterx_jit_ir_add_new_void_block(jit, _block_name(registration, block_name, sizeof(block_name)), NULL);
+  FilterXIRValue state = filterx_jit_ir_get_eval_context(jit);
+
+  for (gint i = 0; i < program->n_instrs; i++)
+    {
+      const LogTemplateInstr *instr = &program->instrs[i];
+
+      if (instr->text_len)
+        _emit_exec_text(jit, state, instr);
+
+      if (instr->op == LTI_LITERAL && instr->text_len)
+        {
+          /* the text already made the result a string, escaping has nothing to add */
+          continue;
+        }
+
+      if (instr->op == LTI_VALUE && instr->msg_ref == 0)
+        _emit_exec_value(jit, state, instr);
+      else
+        _emit_exec_elem(jit, state, instr);
+    }
+
+  filterx_jit_ir_finish_current_block(jit, NULL);
+}
+
+static gboolean
+_is_jit_candidate(LogTemplate *template)
+{
+  /* literal and trivial templates are mostly evaluated through their own fast paths */
+  return template->program && template->program->n_instrs > 0 && !template->literal && !template->trivial;
+}
+
+static void
+_setup_exec_func(FilterXJIT *jit, LogTemplate *template, gpointer registration)
+{
+  GError *error = NULL;
+  gchar block_name[64];
+
+  FilterXJITAddress addr = filterx_jit_lookup(jit, _block_name(registration, block_name, sizeof(block_name)), &error);
+  if (!addr)
+    {
+      msg_warning("Template JIT symbol lookup failed, falling back to interpreted evaluation",
+                  evt_tag_str("template", template->template_str),
+                  evt_tag_str("error", error ? error->message : "unknown"));
+      g_clear_error(&error);
+      return;
+    }
+
+  template->jit_exec = (LogTemplateJITExecFunc) addr;
+}
+
+static gboolean
+_compile_templates(LogTemplateJITConfig *self)
+{
+  GError *error = NULL;
+  GHashTableIter iter;
+  LogTemplate *template;
+  gpointer registration;
+
+  self->jit = filterx_jit_new(LOG_TEMPLATE_JIT_MODULE_NAME, FILTERX_JIT_DEBUG_INFO_FILTERX, &error);
+  if (!self->jit)
+    goto error;
+
+  g_hash_table_iter_init(&iter, self->templates);
+  while (g_hash_table_iter_next(&iter, (gpointer *) &template, &registration))
+    {
+      if (_is_jit_candidate(template))
+        _compile_template(self->jit, template, registration);
+    }
+
+  if (!filterx_jit_finalize(self->jit, &error))
+    goto error;
+
+  g_hash_table_iter_init(&iter, self->templates);
+  while (g_hash_table_iter_next(&iter, (gpointer *) &template, &registration))
+    {
+      if (_is_jit_candidate(template))
+        _setup_exec_func(self->jit, template, registration);
+    }
+
+  msg_debug("Templates compiled by the template JIT",
+            evt_tag_int("templates", g_hash_table_size(self->templates)));
+  return TRUE;
+
+error:
+  msg_warning("Template JIT compilation failed, falling back to interpreted evaluation",
+              evt_tag_str("error", error ? error->message : "unknown"));
+  g_clear_error(&error);
+  filterx_jit_free(self->jit);
+  self->jit = NULL;
+  return FALSE;
+}
+
+#endif
+
+static gboolean
+log_template_jit_config_init(ModuleConfig *s, GlobalConfig *cfg)
+{
+  LogTemplateJITConfig *self = (LogTemplateJITConfig *) s;
+
+  /* templates compiled from now on (e.g. by the init() of drivers) are
+   * evaluated by the interpreter */
+  self->registration_closed = TRUE;
+
+  /* the whole configuration is parsed by now, so the position of
+   * template-jit() relative to the templates does not matter */
+  if (!self->enable)
+    {
+      g_hash_table_remove_all(self->templates);
+      return TRUE;
+    }
+
+  if (g_hash_table_size(self->templates) == 0)
+    return TRUE;
+
+#if SYSLOG_NG_ENABLE_JIT
+  _compile_templates(self);
+  return TRUE;
+#else
+  msg_error("Error enabling template-jit(), AxoSyslog was compiled without JIT support");
+  return FALSE;
+#endif
+}
+
+static void
+log_template_jit_config_deinit(ModuleConfig *s, GlobalConfig *cfg)
+{
+  LogTemplateJITConfig *self = (LogTemplateJITConfig *) s;
+  GHashTableIter iter;
+  LogTemplate *template;
+
+  /* the templates may outlive the JIT module, so we drop our native code from them */
+  g_hash_table_iter_init(&iter, self->templates);
+  while (g_hash_table_iter_next(&iter, (gpointer *) &template, NULL))
+    template->jit_exec = NULL;
+  g_hash_table_remove_all(self->templates);
+
+  filterx_jit_free(self->jit);
+  self->jit = NULL;
+}
+
+static void
+log_template_jit_config_free(ModuleConfig *s)
+{
+  LogTemplateJITConfig *self = (LogTemplateJITConfig *) s;
+
+  g_hash_table_unref(self->templates);
+  module_config_free_method(s);
+}
+
+static LogTemplateJITConfig *
+log_template_jit_config_new(GlobalConfig *cfg)
+{
+  LogTemplateJITConfig *self = g_new0(LogTemplateJITConfig, 1);
+
+  self->super.init = log_template_jit_config_init;
+  self->super.deinit = log_template_jit_config_deinit;
+  self->super.free_fn = log_template_jit_config_free;
+  self->templates = g_hash_table_new_full(g_direct_hash, g_direct_equal, (GDestroyNotify) log_template_unref, NULL);
+  return self;
+}
+
+LogTemplateJITConfig *
+log_template_jit_config_get(GlobalConfig *cfg)
+{
+  LogTemplateJITConfig *tjc = g_hash_table_lookup(cfg->module_config, MODULE_CONFIG_KEY);
+  if (!tjc)
+    {
+      tjc = log_template_jit_config_new(cfg);
+      g_hash_table_insert(cfg->module_config, g_strdup(MODULE_CONFIG_KEY), tjc);
+    }
+  return tjc;
+}
+
+/*
+ * Templates are registered regardless of template-jit(), as the option may
+ * come later in the configuration than the templates.  Whether they are
+ * compiled is decided in log_template_jit_config_init().
+ */
+void
+log_template_jit_register(LogTemplate *template)
+{
+  if (!template->cfg)
+    return;
+
+  LogTemplateJITConfig *self = log_template_jit_config_get(template->cfg);
+  if (!self || self->registration_closed || g_hash_table_contains(self->templates, template))
+    return;
+
+  guint registration = g_hash_table_size(self->templates) + 1;
+  g_hash_table_insert(self->templates, log_template_ref(template), GUINT_TO_POINTER(registration));
+}
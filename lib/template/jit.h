@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef TEMPLATE_JIT_H_INCLUDED
+#define TEMPLATE_JIT_H_INCLUDED
+
+#include "module-config.h"
+#include "template/templates.h"
+#include "filterx/jit/jit.h"
+
+#define LOG_TEMPLATE_JIT_MODULE_NAME "template::jit"
+
+/*
+ * Template JIT:
+ *
+ * The templates compiled while the configuration is parsed are registered
+ * here.  When the configuration is initialized and template-jit() is
+ * enabled, the program of each registered template is turned into a
+ * native function using the FilterX JIT infrastructure: the loop over the
+ * instructions is unrolled, and each instruction is specialized on its
+ * opcode, literal text and NVHandle.  The native functions and the
+ * registrations are dropped when the configuration is deinitialized.
+ */
+typedef struct _LogTemplateJITConfig
+{
+  ModuleConfig super;
+  gboolean enable;
+  /* the registered templates, each holding a reference, mapped to their
+   * 1-based registration index */
+  GHashTable *templates;
+  gboolean registration_closed;
+  FilterXJIT *jit;
+} LogTemplateJITConfig;
+
+LogTemplateJITConfig *log_template_jit_config_get(GlobalConfig *cfg);
+void log_template_jit_register(LogTemplate *template);
+
+static inline void
+log_template_jit_config_enable(LogTemplateJITConfig *self, gboolean enable)
+{
+  self->enable = enable;
+}
+
+#endif
@@ -305,7 +305,7 @@ _get_protocol_name(gint proto)
     }
 }
 
-static void
+void
 log_macro_expand_date_time(gint id,
                            LogTemplateEvalOptions *options, const LogMessage *msg,
                            GString *result, LogMessageValueType *type)
@@ -128,6 +128,16 @@ gboolean log_macro_expand(gint id, LogTemplateEvalOptions *options,
                           GString *result, LogMessageValueType *type);
 gboolean log_macro_expand_simple(gint id, const LogMessage *msg,
                                  GString *result, LogMessageValueType *type);
+void log_macro_expand_date_time(gint id, LogTemplateEvalOptions *options,
+                                const LogMessage *msg,
+                                GString *result, LogMessageValueType *type);
+
+/* the date related macros of all timestamps, expanded by log_macro_expand_date_time() */
+static inline gboolean
+log_macro_is_date_time(gint id)
+{
+  return id >= M_TIME_FIRST && id <= M_TIME_LAST + M_PROCESSED_OFS;
+}
 
 void log_macros_global_init(void);
 void log_macros_global_deinit(void);
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "template/program.h"
+#include "template/repr.h"
+#include "template/macros.h"
+
+#include <string.h>
+
+static inline gsize
+_elem_text_len(const LogTemplateElem *e)
+{
+  return e->text ? e->text_len : 0;
+}
+
+static gint
+_count_instrs(GList *compiled_template)
+{
+  gint n_instrs = 0;
+  gboolean pending_literal = FALSE;
+
+  for (GList *l = compiled_template; l; l = l->next)
+    {
+      const LogTemplateElem *e = (const LogTemplateElem *) l->data;
+
+      if (log_template_elem_is_literal_string(e))
+        {
+          pending_literal = TRUE;
+          continue;
+        }
+      pending_literal = FALSE;
+      n_instrs++;
+    }
+  return n_instrs + (pending_literal ? 1 : 0);
+}
+
+static void
+_set_instr_operation(LogTemplateInstr *instr, const LogTemplateElem *e)
+{
+  instr->default_value = e->default_value;
+  instr->msg_ref = e->msg_ref;
+
+  switch (e->type)
+    {
+    case LTE_VALUE:
+      instr->op = LTI_VALUE;
+      instr->value_handle = e->value_handle;
+      break;
+    case LTE_MACRO:
+      instr->op = log_macro_is_date_time(e->macro) ? LTI_DATE_MACRO : LTI_MACRO;
+      instr->macro = e->macro;
+      break;
+    case LTE_FUNC:
+      instr->op = LTI_FUNC;
+      instr->func.ops = e->func.ops;
+      instr->func.state = e->func.state;
+      break;
+    default:
+      g_assert_not_reached();
+    }
+}
+
+LogTemplateProgram *
+log_template_program_new(GList *compiled_template)
+{
+  gint n_instrs = _count_instrs(compiled_template);
+  LogTemplateProgram *self = g_malloc0(sizeof(LogTemplateProgram) + n_instrs * sizeof(LogTemplateInstr));
+  gsize pool_len = 0;
+
+  for (GList *l = compiled_template; l; l = l->next)
+    {
+      pool_len += _elem_text_len((const LogTemplateElem *) l->data);
+      self->n_elems++;
+    }
+
+  /* all literal text is kept in a single allocation, right next to each
+   * other in evaluation order */
+  self->text_pool = g_malloc(pool_len + 1);
+  self->n_instrs = n_instrs;
+
+  gchar *pool_pos = self->text_pool;
+  gint i = 0;
+  for (GList *l = compiled_template; l; l = l->next)
+    {
+      const LogTemplateElem *e = (const LogTemplateElem *) l->data;
+      LogTemplateInstr *instr = &self->instrs[i];
+      gsize text_len = _elem_text_len(e);
+
+      /* the first element contributing to an instruction, instrs[] is
+       * zero initialized, so the op defaults to LTI_LITERAL */
+      if (!instr->text)
+        instr->text = pool_pos;
+
+      if (text_len)
+        {
+          memcpy(pool_pos, e->text, text_len);
+          pool_pos += text_len;
+          instr->text_len += text_len;
+        }
+
+      if (log_template_elem_is_literal_string(e))
+        continue;
+
+      _set_instr_operation(instr, e);
+      i++;
+    }
+  *pool_pos = 0;
+
+  return self;
+}
+
+void
+log_template_program_free(LogTemplateProgram *self)
+{
+  if (!self)
+    return;
+
+  g_free(self->text_pool);
+  g_free(self);
+}
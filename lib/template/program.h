@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef TEMPLATE_PROGRAM_H_INCLUDED
+#define TEMPLATE_PROGRAM_H_INCLUDED
+
+#include "template/function.h"
+#include "template/eval.h"
+#include "logmsg/logmsg.h"
+
+/* opcodes of the flattened template representation */
+enum
+{
+  LTI_LITERAL,
+  LTI_VALUE,
+  LTI_MACRO,
+  LTI_DATE_MACRO,
+  LTI_FUNC,
+};
+
+typedef struct _LogTemplateInstr
+{
+  /* literal text emitted before the element, points into the text pool
+   * of the program */
+  const gchar *text;
+  gsize text_len;
+  const gchar *default_value;
+  guint16 msg_ref;
+  guint8 op;
+  union
+  {
+    guint macro;
+    NVHandle value_handle;
+    struct
+    {
+      LogTemplateFunction *ops;
+      gpointer state;
+    } func;
+  };
+} LogTemplateInstr;
+
+/*
+ * The compiled list of LogTemplateElem instances converted into a
+ * contiguous array, with adjacent literal elements merged into the text
+ * prefix of the instruction that follows them.  The program borrows the
+ * default values and function states from the element list, so it has to
+ * be freed together with that.
+ */
+struct _LogTemplateProgram
+{
+  gchar *text_pool;
+  /* the number of elements the program was built from, the type of a
+   * template that consists of more than one element is always a string */
+  gint n_elems;
+  gint n_instrs;
+  LogTemplateInstr instrs[];
+};
+
+/* the state of a single template evaluation, passed to each instruction */
+struct _LogTemplateEvalState
+{
+  LogTemplate *template;
+  LogMessage **messages;
+  gint num_messages;
+  LogTemplateEvalOptions *options;
+  GString *result;
+  GString *target_buffer;
+  gboolean escape;
+  LogMessageValueType type;
+};
+
+LogTemplateProgram *log_template_program_new(GList *compiled_template);
+void log_template_program_free(LogTemplateProgram *self);
+
+/* entry points of JIT compiled templates, see template/jit.h */
+void log_template_jit_exec_text(LogTemplateEvalState *state, const gchar *text, gsize text_len);
+void log_template_jit_exec_value(LogTemplateEvalState *state, const LogTemplateInstr *instr, NVHandle value_handle);
+void log_template_jit_exec_elem(LogTemplateEvalState *state, const LogTemplateInstr *instr, guint8 op);
+
+#endif
@@ -43,6 +43,9 @@ enum LogTemplateError
 };
 
 
+/* native code generated for a template by the template JIT, see template/jit.h */
+typedef void (*LogTemplateJITExecFunc)(LogTemplateEvalState *state);
+
 /* structure that represents an expandable syslog-ng template */
 struct _LogTemplate
 {
@@ -50,6 +53,9 @@ struct _LogTemplate
   gchar *name;
   gchar *template_str;
   GList *compiled_template;
+  /* flattened form of compiled_template, this is what gets evaluated */
+  LogTemplateProgram *program;
+  LogTemplateJITExecFunc jit_exec;
   GlobalConfig *cfg;
   guint top_level:1, escape:1, def_inline:1, trivial:1, literal:1;
 
@@ -26,6 +26,7 @@
 #include "libtest/grab-logging.h"
 
 #include "template/templates.c"
+#include "template/program.h"
 #include "template/simple-function.h"
 #include "template/globals.h"
 #include "logmsg/logmsg.h"
@@ -376,6 +377,59 @@ Test(template_compile, test_unknown_function)
                            type = LTE_MACRO, msg_ref = 0);
 }
 
+#define assert_program_instr(program, ndx, expected_op, expected_text) \
+  do { \
+    const LogTemplateInstr *instr = &(program)->instrs[ndx]; \
+    cr_assert_eq(instr->op, (expected_op), "Bad program opcode at %d", ndx); \
+    cr_assert_eq(instr->text_len, strlen(expected_text), "Bad program text length at %d", ndx); \
+    cr_assert(strncmp(instr->text, (expected_text), instr->text_len) == 0, "Bad program text at %d", ndx); \
+  } while (0)
+
+Test(template_compile, test_program_is_built_from_compiled_template)
+{
+  assert_template_compile("$MSGHDR literal $DATE ${PROGRAM}tail");
+
+  LogTemplateProgram *program = template->program;
+  cr_assert_not_null(program);
+  cr_assert_eq(program->n_elems, 4);
+  cr_assert_eq(program->n_instrs, 4);
+  assert_program_instr(program, 0, LTI_MACRO, "");
+  cr_assert_eq(program->instrs[0].macro, M_MSGHDR);
+  assert_program_instr(program, 1, LTI_DATE_MACRO, " literal ");
+  cr_assert_eq(program->instrs[1].macro, M_DATE);
+  assert_program_instr(program, 2, LTI_VALUE, " ");
+  cr_assert_eq(program->instrs[2].value_handle, log_msg_get_value_handle("PROGRAM"));
+  assert_program_instr(program, 3, LTI_LITERAL, "tail");
+}
+
+Test(template_compile, test_program_merges_adjacent_literals_into_the_next_instruction)
+{
+  gchar value_name[] = "PROGRAM";
+  GList *elems = NULL;
+
+  elems = g_list_append(elems, log_template_elem_new_macro("foo", M_NONE, NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_macro("bar", M_NONE, NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_macro(" ", M_STAMP_OFS + M_ISODATE, NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_value("", value_name, NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_macro("baz", M_NONE, NULL, 0));
+  elems = g_list_append(elems, log_template_elem_new_macro("!", M_NONE, NULL, 0));
+
+  LogTemplateProgram *program = log_template_program_new(elems);
+  cr_assert_eq(program->n_elems, 6);
+  cr_assert_eq(program->n_instrs, 3);
+  assert_program_instr(program, 0, LTI_DATE_MACRO, "foobar ");
+  assert_program_instr(program, 1, LTI_VALUE, "");
+  assert_program_instr(program, 2, LTI_LITERAL, "baz!");
+  log_template_program_free(program);
+
+  program = log_template_program_new(NULL);
+  cr_assert_eq(program->n_elems, 0);
+  cr_assert_eq(program->n_instrs, 0);
+  log_template_program_free(program);
+
+  log_template_elem_free_list(elems);
+}
+
 static void
 setup(void)
 {
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/cr_template.h"
+
+#include "template/templates.h"
+#include "template/jit.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "scratch-buffers.h"
+
+static const gchar *templates[] =
+{
+  "$HOST $PROGRAM[$PID]: $MSG",
+  "${APP.VALUE}${APP.VALUE2} ${APP.STRIP1}|${UNSET:-default}|${UNSET}|",
+  "$FACILITY.$SEVERITY $ISODATE $R_UNIXTIME",
+  "$(echo $HOST) $(if ('$PROGRAM' == 'syslog-ng') 'yes' 'no') ${HOST}@1",
+  NULL
+};
+
+static void
+_assert_jit_matches_interpreter(LogTemplate *template, LogMessage *msg)
+{
+  LogTemplateEvalOptions options = {NULL, LTZ_SEND, 5555, NULL, LM_VT_STRING};
+  GString *compiled = g_string_new("");
+  GString *interpreted = g_string_new("");
+  LogMessageValueType compiled_type, interpreted_type;
+
+  cr_assert(template->jit_exec, "template was not JIT compiled: %s", template->template_str);
+  log_template_format_value_and_type(template, msg, &options, compiled, &compiled_type);
+
+  LogTemplateJITExecFunc jit_exec = template->jit_exec;
+  template->jit_exec = NULL;
+  log_template_format_value_and_type(template, msg, &options, interpreted, &interpreted_type);
+  template->jit_exec = jit_exec;
+
+  cr_assert_str_eq(compiled->str, interpreted->str, "JIT and interpreter output differ for template: %s",
+                   template->template_str);
+  cr_assert_eq(compiled_type, interpreted_type, "JIT and interpreter type differ for template: %s",
+               template->template_str);
+
+  g_string_free(compiled, TRUE);
+  g_string_free(interpreted, TRUE);
+}
+
+Test(template_jit, disabled_jit_does_not_compile_templates)
+{
+  LogTemplateJITConfig *tjc = log_template_jit_config_get(configuration);
+  LogTemplate *template = compile_template("$HOST $MSG");
+
+  cr_assert_eq(g_hash_table_size(tjc->templates), 1);
+  cr_assert(module_config_init(&tjc->super, configuration));
+  cr_assert_null(template->jit_exec);
+  cr_assert_eq(g_hash_table_size(tjc->templates), 0);
+  module_config_deinit(&tjc->super, configuration);
+
+  log_template_unref(template);
+}
+
+#if SYSLOG_NG_ENABLE_JIT
+
+Test(template_jit, compiled_templates_match_the_interpreter)
+{
+  LogTemplateJITConfig *tjc = log_template_jit_config_get(configuration);
+  LogMessage *msg = create_sample_message();
+  GPtrArray *compiled = g_ptr_array_new_with_free_func((GDestroyNotify) log_template_unref);
+
+  log_template_jit_config_enable(tjc, TRUE);
+  for (gint i = 0; templates[i]; i++)
+    g_ptr_array_add(compiled, compile_template(templates[i]));
+  g_ptr_array_add(compiled, compile_escaped_template("$MSG \"$HOST\" ${APP.VALUE}"));
+
+  cr_assert(module_config_init(&tjc->super, configuration));
+  for (gint i = 0; i < compiled->len; i++)
+    _assert_jit_matches_interpreter(g_ptr_array_index(compiled, i), msg);
+
+  module_config_deinit(&tjc->super, configuration);
+  for (gint i = 0; i < compiled->len; i++)
+    cr_assert_null(((LogTemplate *) g_ptr_array_index(compiled, i))->jit_exec);
+  cr_assert_eq(g_hash_table_size(tjc->templates), 0);
+
+  g_ptr_array_free(compiled, TRUE);
+  log_msg_unref(msg);
+}
+
+Test(template_jit, templates_preceding_the_option_are_compiled)
+{
+  LogTemplateJITConfig *tjc = log_template_jit_config_get(configuration);
+  LogMessage *msg = create_sample_message();
+
+  LogTemplate *template = compile_template("$HOST $PROGRAM[$PID]: $MSG");
+  log_template_jit_config_enable(tjc, TRUE);
+
+  cr_assert(module_config_init(&tjc->super, configuration));
+  _assert_jit_matches_interpreter(template, msg);
+  module_config_deinit(&tjc->super, configuration);
+
+  log_template_unref(template);
+  log_msg_unref(msg);
+}
+
+Test(template_jit, templates_compiled_after_init_fall_back_to_the_interpreter)
+{
+  LogTemplateJITConfig *tjc = log_template_jit_config_get(configuration);
+  LogMessage *msg = create_sample_message();
+  LogTemplateEvalOptions options = {NULL, LTZ_SEND, 5555, NULL, LM_VT_STRING};
+  GString *result = g_string_new("");
+
+  log_template_jit_config_enable(tjc, TRUE);
+  LogTemplate *recompiled = compile_template("$HOST $MSG");
+  cr_assert(module_config_init(&tjc->super, configuration));
+  cr_assert(recompiled->jit_exec);
+
+  LogTemplate *late = compile_template("$HOST $PROGRAM");
+  cr_assert_null(late->jit_exec);
+  log_template_format(late, msg, &options, result);
+  cr_assert_str_eq(result->str, "bzorp syslog-ng");
+
+  cr_assert(log_template_compile(recompiled, "$PROGRAM $HOST", NULL));
+  cr_assert_null(recompiled->jit_exec);
+  log_template_format(recompiled, msg, &options, result);
+  cr_assert_str_eq(result->str, "syslog-ng bzorp");
+
+  module_config_deinit(&tjc->super, configuration);
+
+  g_string_free(result, TRUE);
+  log_template_unref(late);
+  log_template_unref(recompiled);
+  log_msg_unref(msg);
+}
+
+#endif
+
+static void
+setup(void)
+{
+  app_startup();
+  init_template_tests();
+  cfg_load_module(configuration, "basicfuncs");
+}
+
+static void
+teardown(void)
+{
+  scratch_buffers_explicit_gc();
+  deinit_template_tests();
+  app_shutdown();
+}
+
+TestSuite(template_jit, .init = setup, .fini = teardown);
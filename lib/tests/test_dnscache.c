@@ -24,6 +24,7 @@
 #include <criterion/criterion.h>
 
 #include "dnscache.h"
+#include "host-resolve.h"
 #include "apphook.h"
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
@@ -239,3 +240,168 @@ Test(dnscache, test_lru_lists)
   _fill_dns_cache(cache, cache_size);
   dns_cache_free(cache);
 }
+
+Test(dnscache, test_shared_cache_is_visible_from_all_threads)
+{
+  guint32 ni = htonl(0x0a000001);
+  gchar hn[16];
+  gsize hn_len;
+  gboolean positive;
+
+  cr_assert_not(dns_caching_lookup(AF_INET, (void *) &ni, hn, sizeof(hn), &hn_len, &positive));
+
+  dns_caching_store(AF_INET, (void *) &ni, "very-long-hostname.example.com", TRUE);
+  cr_assert(dns_caching_lookup(AF_INET, (void *) &ni, hn, sizeof(hn), &hn_len, &positive));
+  cr_assert(positive);
+  cr_assert_str_eq(hn, "very-long-hostn", "cached name should be truncated to the buffer size");
+  cr_assert_eq(hn_len, strlen(hn));
+}
+
+static gint notifications;
+
+static void
+_count_notifications(gpointer user_data)
+{
+  gint *order = (gint *) user_data;
+
+  notifications++;
+  cr_assert_eq(*order, notifications, "waiters should be notified in the order they registered");
+}
+
+Test(dnscache, test_concurrent_misses_are_resolved_once)
+{
+  guint32 ni = htonl(0x0a000002);
+  gint first = 1, second = 2;
+
+  notifications = 0;
+  cr_assert_eq(dns_caching_lookup_or_wait(AF_INET, (void *) &ni, _count_notifications, &first),
+               DNS_CACHING_LOOKUP_STARTED);
+  cr_assert_eq(dns_caching_lookup_or_wait(AF_INET, (void *) &ni, _count_notifications, &second),
+               DNS_CACHING_LOOKUP_PENDING);
+  cr_assert_eq(dns_caching_lookup_or_wait(AF_INET, (void *) &ni, NULL, NULL), DNS_CACHING_LOOKUP_PENDING);
+  cr_assert_eq(notifications, 0);
+
+  dns_caching_store_and_notify(AF_INET, (void *) &ni, "hostname", TRUE);
+  cr_assert_eq(notifications, 2);
+
+  cr_assert_eq(dns_caching_lookup_or_wait(AF_INET, (void *) &ni, _count_notifications, &first), DNS_CACHING_HIT);
+  cr_assert_eq(notifications, 2);
+}
+
+/* stand-in for the system resolver: blocks until released, names 10.0.0.x as host-x */
+static GMutex resolver_lock;
+static GCond resolver_cond;
+static gboolean resolver_released;
+static gint resolver_calls;
+static gint resolved_notifications;
+
+static const gchar *
+_fake_reverse_lookup(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+  guint32 addr = ntohl(((struct sockaddr_in *) &saddr->sa)->sin_addr.s_addr);
+
+  g_mutex_lock(&resolver_lock);
+  resolver_calls++;
+  while (!resolver_released)
+    g_cond_wait(&resolver_cond, &resolver_lock);
+  g_mutex_unlock(&resolver_lock);
+
+  if ((addr & 0xff) == 0)
+    return NULL;
+  g_snprintf(buf, buf_len, "host-%d.example.com", addr & 0xff);
+  return buf;
+}
+
+static void
+_hostname_resolved(gpointer user_data)
+{
+  g_mutex_lock(&resolver_lock);
+  resolved_notifications++;
+  g_cond_broadcast(&resolver_cond);
+  g_mutex_unlock(&resolver_lock);
+}
+
+static void
+_release_resolver_and_wait_for_notifications(gint expected)
+{
+  g_mutex_lock(&resolver_lock);
+  resolver_released = TRUE;
+  g_cond_broadcast(&resolver_cond);
+  while (resolved_notifications < expected)
+    g_cond_wait(&resolver_cond, &resolver_lock);
+  g_mutex_unlock(&resolver_lock);
+}
+
+static void
+_async_resolve_options(HostResolveOptions *options)
+{
+  host_resolve_options_defaults(options);
+  options->use_dns = HOST_RESOLVE_USE_DNS_ASYNC;
+  options->use_fqdn = TRUE;
+  options->use_dns_cache = TRUE;
+  options->normalize_hostnames = FALSE;
+}
+
+static void
+setup_async_resolver(void)
+{
+  resolver_released = FALSE;
+  resolver_calls = 0;
+  resolved_notifications = 0;
+  host_resolve_set_reverse_lookup_func(_fake_reverse_lookup);
+}
+
+static void
+teardown_async_resolver(void)
+{
+  host_resolve_set_reverse_lookup_func(NULL);
+}
+
+Test(dnscache, test_background_lookup_does_not_block_and_fills_the_cache,
+     .init = setup_async_resolver, .fini = teardown_async_resolver)
+{
+  HostResolveOptions options;
+  GSockAddr *saddr = g_sockaddr_inet_new("10.0.0.3", 514);
+  const gchar *hname;
+  gsize hname_len;
+
+  _async_resolve_options(&options);
+
+  cr_assert(resolve_sockaddr_to_hostname_in_background(saddr, &options, _hostname_resolved, NULL));
+  cr_assert(resolve_sockaddr_to_hostname_in_background(saddr, &options, _hostname_resolved, NULL));
+
+  /* while the lookup is in progress, the address is used */
+  hname = resolve_sockaddr_to_hostname(&hname_len, saddr, &options);
+  cr_assert_str_eq(hname, "10.0.0.3");
+
+  _release_resolver_and_wait_for_notifications(2);
+  cr_assert_eq(resolver_calls, 1, "concurrent lookups of the same address should be deduplicated");
+
+  cr_assert_not(resolve_sockaddr_to_hostname_in_background(saddr, &options, _hostname_resolved, NULL));
+  hname = resolve_sockaddr_to_hostname(&hname_len, saddr, &options);
+  cr_assert_str_eq(hname, "host-3.example.com");
+  cr_assert_eq(hname_len, strlen(hname));
+
+  g_sockaddr_unref(saddr);
+}
+
+Test(dnscache, test_failed_background_lookup_is_cached_negatively,
+     .init = setup_async_resolver, .fini = teardown_async_resolver)
+{
+  HostResolveOptions options;
+  GSockAddr *saddr = g_sockaddr_inet_new("10.0.0.0", 514);
+  const gchar *hname;
+  gsize hname_len;
+
+  _async_resolve_options(&options);
+
+  cr_assert(resolve_sockaddr_to_hostname_in_background(saddr, &options, _hostname_resolved, NULL));
+  _release_resolver_and_wait_for_notifications(1);
+
+  cr_assert_not(resolve_sockaddr_to_hostname_in_background(saddr, &options, _hostname_resolved, NULL));
+  hname = resolve_sockaddr_to_hostname(&hname_len, saddr, &options);
+  cr_assert_str_eq(hname, "10.0.0.0");
+  cr_assert_eq(resolver_calls, 1);
+
+  g_sockaddr_unref(saddr);
+}
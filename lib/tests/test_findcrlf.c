@@ -24,8 +24,34 @@
 #include <criterion/parameterized.h>
 
 #include "find-crlf.h"
+#include "libtest/stopwatch.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+static struct
+{
+  FindCRLFKernelType type;
+  const gchar *name;
+} kernels[] =
+{
+  { FIND_CRLF_KERNEL_SCALAR, "scalar" },
+  { FIND_CRLF_KERNEL_SSE2, "sse2" },
+  { FIND_CRLF_KERNEL_AVX2, "avx2" },
+};
+
+/* kernels not available in this build or on this CPU are skipped */
+#define foreach_kernel(i) \
+  for (gint i = 0; i < G_N_ELEMENTS(kernels); i++) \
+    if (find_crlf_set_kernel(kernels[i].type))
+
+static void
+_restore_kernel(void)
+{
+  find_crlf_set_kernel(FIND_CRLF_KERNEL_AUTO);
+}
+
+TestSuite(findcrlf, .fini = _restore_kernel);
 
 struct findcrlf_params
 {
@@ -152,16 +178,153 @@ ParameterizedTestParameters(findcrlf, test)
 
 ParameterizedTest(struct findcrlf_params *params, findcrlf, test)
 {
-  const gchar *eom = find_cr_or_lf_or_nul(params->msg, params->msg_len);
+  foreach_kernel(k)
+  {
+    const gchar *eom = find_cr_or_lf_or_nul(params->msg, params->msg_len);
+
+    cr_expect_not(params->eom_ofs == -1 && eom != NULL,
+                  "EOM returned is not NULL, which was expected. kernel=%s, eom_ofs=%d, eom=%s\n",
+                  kernels[k].name, (gint) params->eom_ofs, eom);
+
+    if (params->eom_ofs == -1)
+      continue;
+
+    cr_expect_not(eom - params->msg != params->eom_ofs,
+                  "EOM is at wrong location. kernel=%s, msg=%s, eom_ofs=%d, eom=%s\n",
+                  kernels[k].name, params->msg, (gint) params->eom_ofs, eom);
+  }
+}
+
+/* random buffer with a terminator in roughly every 40 bytes, at random alignments */
+static void
+_fill_random_buffer(gchar *buf, gsize len, GRand *rand)
+{
+  for (gsize i = 0; i < len; i++)
+    {
+      gint r = g_rand_int_range(rand, 0, 120);
+      buf[i] = r == 0 ? '\n' : r == 1 ? '\r' : r == 2 ? '\0' : 'a' + r % 26;
+    }
+}
+
+static const gchar *
+_find_reference(const gchar *s, gsize n, gchar c1, gchar c2)
+{
+  for (gsize i = 0; i < n; i++)
+    {
+      if (s[i] == c1 || s[i] == c2 || s[i] == '\0')
+        return &s[i];
+    }
+  return NULL;
+}
+
+Test(findcrlf, test_kernels_match_the_reference_implementation)
+{
+  foreach_kernel(k)
+  {
+    GRand *rand = g_rand_new_with_seed(1);
+    gchar buf[256];
 
-  cr_expect_not(params->eom_ofs == -1 && eom != NULL,
-                "EOM returned is not NULL, which was expected. eom_ofs=%d, eom=%s\n",
-                (gint) params->eom_ofs, eom);
+    for (gint i = 0; i < 20000; i++)
+      {
+        gsize ofs = g_rand_int_range(rand, 0, 32);
+        gsize len = g_rand_int_range(rand, 0, sizeof(buf) - ofs);
+        _fill_random_buffer(buf, sizeof(buf), rand);
+
+        cr_assert_eq(find_cr_or_lf_or_nul(buf + ofs, len), _find_reference(buf + ofs, len, '\r', '\n'),
+                     "find_cr_or_lf_or_nul() mismatch, kernel=%s, ofs=%d, len=%d",
+                     kernels[k].name, (gint) ofs, (gint) len);
+        cr_assert_eq(find_lf_or_nul(buf + ofs, len), _find_reference(buf + ofs, len, '\n', '\n'),
+                     "find_lf_or_nul() mismatch, kernel=%s, ofs=%d, len=%d", kernels[k].name, (gint) ofs, (gint) len);
+      }
+    g_rand_free(rand);
+  }
+}
+
+Test(findcrlf, test_find_does_not_look_past_the_end_of_the_buffer)
+{
+  const gchar buf[] = "0123456789abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz\n";
+
+  foreach_kernel(k)
+  {
+    for (gsize len = 0; len < sizeof(buf) - 2; len++)
+      {
+        cr_assert_null(find_cr_or_lf_or_nul(buf, len), "kernel=%s, len=%d", kernels[k].name, (gint) len);
+        cr_assert_null(find_lf_or_nul(buf, len), "kernel=%s, len=%d", kernels[k].name, (gint) len);
+      }
+    cr_assert_eq(find_lf_or_nul(buf, sizeof(buf) - 1), &buf[sizeof(buf) - 2], "kernel=%s", kernels[k].name);
+  }
+}
+
+Test(findcrlf, test_replace_cr_or_lf_or_nul)
+{
+  foreach_kernel(k)
+  {
+    GRand *rand = g_rand_new_with_seed(2);
+    gchar buf[256];
+    gchar orig[256];
+
+    for (gint i = 0; i < 5000; i++)
+      {
+        gsize ofs = g_rand_int_range(rand, 0, 32);
+        gsize len = g_rand_int_range(rand, 0, sizeof(buf) - ofs);
+        _fill_random_buffer(buf, sizeof(buf), rand);
+        memcpy(orig, buf, sizeof(buf));
+
+        replace_cr_or_lf_or_nul(buf + ofs, len, ' ');
+
+        for (gsize j = 0; j < sizeof(buf); j++)
+          {
+            gboolean in_range = j >= ofs && j < ofs + len;
+            gboolean terminator = orig[j] == '\r' || orig[j] == '\n' || orig[j] == '\0';
+            cr_assert_eq(buf[j], in_range && terminator ? ' ' : orig[j], "kernel=%s, ofs=%d, len=%d, j=%d",
+                         kernels[k].name, (gint) ofs, (gint) len, (gint) j);
+          }
+      }
+    g_rand_free(rand);
+  }
+}
+
+#define PERF_BUFFER_SIZE (1024 * 1024)
+#define PERF_ITERATIONS 1000
+
+static void
+_perftest(const gchar *name, const gchar *kernel_name, const gchar *(*find)(const gchar *s, gsize n), const gchar *buf,
+          gsize line_len)
+{
+  gsize lines = 0;
+
+  start_stopwatch();
+  for (gint i = 0; i < PERF_ITERATIONS; i++)
+    {
+      const gchar *p = buf;
+      const gchar *eol;
+
+      while ((eol = find(p, buf + PERF_BUFFER_SIZE - p)))
+        {
+          p = eol + 1;
+          lines++;
+        }
+    }
+  stop_stopwatch_and_display_result(PERF_ITERATIONS, "%-20s kernel=%-6s line_len=%-6d lines=%" G_GSIZE_FORMAT,
+                                    name, kernel_name, (gint) line_len, lines);
+}
+
+Test(findcrlf, test_performance)
+{
+  gchar *buf = g_malloc(PERF_BUFFER_SIZE);
+  gsize line_lens[] = { 80, 400, 4096 };
 
-  if (params->eom_ofs == -1)
-    return;
+  for (gint i = 0; i < G_N_ELEMENTS(line_lens); i++)
+    {
+      memset(buf, 'a', PERF_BUFFER_SIZE);
+      for (gsize pos = line_lens[i] - 1; pos < PERF_BUFFER_SIZE; pos += line_lens[i])
+        buf[pos] = '\n';
 
-  cr_expect_not(eom - params->msg != params->eom_ofs,
-                "EOM is at wrong location. msg=%s, eom_ofs=%d, eom=%s\n",
-                params->msg, (gint) params->eom_ofs, eom);
+      foreach_kernel(k)
+      {
+        _perftest("find_cr_or_lf_or_nul", kernels[k].name, find_cr_or_lf_or_nul, buf, line_lens[i]);
+        _perftest("find_lf_or_nul", kernels[k].name, find_lf_or_nul, buf, line_lens[i]);
+      }
+    }
+  g_free(buf);
 }
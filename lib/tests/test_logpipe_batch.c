@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "logmpx.h"
+#include "parser/parser-expr.h"
+#include "logmsg/logmsg.h"
+#include "stats/stats-registry.h"
+#include "apphook.h"
+#include "cfg.h"
+
+#include <stdlib.h>
+
+#define NUM_TEST_MSGS 6
+
+/* every delivery is appended here as "<pipe name><SEQ> " */
+static GString *delivery_log;
+
+static gint
+_get_seq(LogMessage *msg)
+{
+  return atoi(log_msg_get_value_by_name(msg, "SEQ", NULL));
+}
+
+typedef struct _TestBranch
+{
+  LogPipe super;
+  const gchar *name;
+  gboolean reject_odd;
+  gint num_batches;
+} TestBranch;
+
+static void
+_test_branch_process(TestBranch *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  if (self->reject_odd && _get_seq(msg) % 2 != 0)
+    {
+      if (path_options->matched)
+        *path_options->matched = FALSE;
+      log_msg_drop(msg, path_options, AT_PROCESSED);
+      return;
+    }
+
+  g_string_append_printf(delivery_log, "%s%d ", self->name, _get_seq(msg));
+  log_pipe_forward_msg(&self->super, msg, path_options);
+}
+
+static void
+_test_branch_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
+{
+  _test_branch_process((TestBranch *) s, msg, path_options);
+}
+
+static void
+_test_branch_queue_batch(LogPipe *s, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs)
+{
+  TestBranch *self = (TestBranch *) s;
+
+  self->num_batches++;
+  for (gint i = 0; i < num_msgs; i++)
+    _test_branch_process(self, msgs[i], path_options[i]);
+}
+
+static TestBranch *
+_test_branch_new(const gchar *name, gint flags)
+{
+  TestBranch *self = g_new0(TestBranch, 1);
+
+  log_pipe_init_instance(&self->super, configuration);
+  self->super.queue = _test_branch_queue;
+  self->super.queue_batch = _test_branch_queue_batch;
+  self->super.flags |= flags;
+  self->name = name;
+  cr_assert(log_pipe_init(&self->super));
+  return self;
+}
+
+static void
+_test_branch_free(TestBranch *self)
+{
+  log_pipe_deinit(&self->super);
+  log_pipe_unref(&self->super);
+}
+
+typedef struct _TestMessages
+{
+  LogMessage *msgs[NUM_TEST_MSGS];
+  LogPathOptions path_options[NUM_TEST_MSGS];
+  const LogPathOptions *path_options_refs[NUM_TEST_MSGS];
+  gboolean matched[NUM_TEST_MSGS];
+} TestMessages;
+
+static void
+_test_messages_init(TestMessages *self)
+{
+  for (gint i = 0; i < NUM_TEST_MSGS; i++)
+    {
+      gchar seq[16];
+
+      g_snprintf(seq, sizeof(seq), "%d", i);
+      self->msgs[i] = log_msg_new_empty();
+      log_msg_set_value_by_name(self->msgs[i], "SEQ", seq, -1);
+      self->path_options[i] = (LogPathOptions) LOG_PATH_OPTIONS_INIT;
+      self->path_options[i].matched = &self->matched[i];
+      self->path_options_refs[i] = &self->path_options[i];
+      self->matched[i] = TRUE;
+    }
+}
+
+static void
+_queue_one_by_one(LogPipe *pipe, TestMessages *messages)
+{
+  for (gint i = 0; i < NUM_TEST_MSGS; i++)
+    log_pipe_queue(pipe, messages->msgs[i], messages->path_options_refs[i]);
+}
+
+static void
+_queue_as_batch(LogPipe *pipe, TestMessages *messages)
+{
+  log_pipe_queue_batch(pipe, messages->msgs, messages->path_options_refs, NUM_TEST_MSGS);
+}
+
+static LogMultiplexer *
+_construct_multiplexer(TestBranch **branches, gint num_branches)
+{
+  LogMultiplexer *mpx = log_multiplexer_new(configuration);
+
+  for (gint i = 0; i < num_branches; i++)
+    log_multiplexer_add_next_hop(mpx, &branches[i]->super);
+  cr_assert(log_pipe_init(&mpx->super));
+  return mpx;
+}
+
+static void
+_destroy_multiplexer(LogMultiplexer *mpx)
+{
+  log_pipe_deinit(&mpx->super);
+  log_pipe_unref(&mpx->super);
+}
+
+Test(logpipe_batch, multiplexer_keeps_the_order_of_messages_within_a_branch)
+{
+  TestBranch *branches[] = { _test_branch_new("A", 0), _test_branch_new("B", 0) };
+  LogMultiplexer *mpx = _construct_multiplexer(branches, G_N_ELEMENTS(branches));
+  TestMessages messages;
+
+  _test_messages_init(&messages);
+  _queue_one_by_one(&mpx->super, &messages);
+  cr_assert_str_eq(delivery_log->str, "A0 B0 A1 B1 A2 B2 A3 B3 A4 B4 A5 B5 ");
+
+  /* deliveries are interleaved branch by branch instead of message by message */
+  g_string_truncate(delivery_log, 0);
+  _test_messages_init(&messages);
+  _queue_as_batch(&mpx->super, &messages);
+  cr_assert_str_eq(delivery_log->str, "A0 A1 A2 A3 A4 A5 B0 B1 B2 B3 B4 B5 ");
+  cr_assert_eq(branches[0]->num_batches, 1);
+  cr_assert_eq(branches[1]->num_batches, 1);
+
+  _destroy_multiplexer(mpx);
+  for (gint i = 0; i < G_N_ELEMENTS(branches); i++)
+    _test_branch_free(branches[i]);
+}
+
+Test(logpipe_batch, multiplexer_sends_only_undelivered_messages_to_fallback_branches)
+{
+  TestBranch *branches[] = { _test_branch_new("A", 0), _test_branch_new("F", PIF_BRANCH_FALLBACK) };
+  branches[0]->reject_odd = TRUE;
+  LogMultiplexer *mpx = _construct_multiplexer(branches, G_N_ELEMENTS(branches));
+  TestMessages messages;
+
+  _test_messages_init(&messages);
+  _queue_as_batch(&mpx->super, &messages);
+
+  cr_assert_str_eq(delivery_log->str, "A0 A2 A4 F1 F3 F5 ");
+  for (gint i = 0; i < NUM_TEST_MSGS; i++)
+    cr_assert(messages.matched[i], "message %d should have been delivered", i);
+
+  _destroy_multiplexer(mpx);
+  for (gint i = 0; i < G_N_ELEMENTS(branches); i++)
+    _test_branch_free(branches[i]);
+}
+
+Test(logpipe_batch, multiplexer_stops_at_final_branch_per_message)
+{
+  TestBranch *branches[] = { _test_branch_new("A", PIF_BRANCH_FINAL), _test_branch_new("B", 0) };
+  branches[0]->reject_odd = TRUE;
+  LogMultiplexer *mpx = _construct_multiplexer(branches, G_N_ELEMENTS(branches));
+  TestMessages messages;
+
+  _test_messages_init(&messages);
+  _queue_as_batch(&mpx->super, &messages);
+
+  cr_assert_str_eq(delivery_log->str, "A0 A2 A4 B1 B3 B5 ");
+
+  _destroy_multiplexer(mpx);
+  for (gint i = 0; i < G_N_ELEMENTS(branches); i++)
+    _test_branch_free(branches[i]);
+}
+
+Test(logpipe_batch, multiplexer_propagates_undelivered_messages_as_not_matched)
+{
+  TestBranch *branches[] = { _test_branch_new("A", 0) };
+  branches[0]->reject_odd = TRUE;
+  LogMultiplexer *mpx = _construct_multiplexer(branches, G_N_ELEMENTS(branches));
+  TestMessages messages;
+
+  _test_messages_init(&messages);
+  _queue_as_batch(&mpx->super, &messages);
+
+  cr_assert_str_eq(delivery_log->str, "A0 A2 A4 ");
+  for (gint i = 0; i < NUM_TEST_MSGS; i++)
+    cr_assert_eq(messages.matched[i], i % 2 == 0, "unexpected matched value for message %d", i);
+
+  _destroy_multiplexer(mpx);
+  _test_branch_free(branches[0]);
+}
+
+typedef struct _TestParser
+{
+  LogParser super;
+  gint num_batches;
+} TestParser;
+
+static gboolean
+_test_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_options, const gchar *input,
+                     gsize input_len)
+{
+  return _get_seq(*pmsg) % 2 == 0;
+}
+
+static void
+_test_parser_process_batch(LogParser *s, LogMessage **pmsgs, const LogPathOptions **path_options,
+                           const gchar **inputs, const gsize *input_lens, gboolean *results, gint num_msgs)
+{
+  TestParser *self = (TestParser *) s;
+
+  self->num_batches++;
+  for (gint i = 0; i < num_msgs; i++)
+    results[i] = _test_parser_process(s, &pmsgs[i], path_options[i], inputs[i], input_lens[i]);
+}
+
+static TestParser *
+_construct_parser(gboolean with_process_batch, TestBranch *next)
+{
+  TestParser *self = g_new0(TestParser, 1);
+
+  log_parser_init_instance(&self->super, configuration);
+  self->super.process = _test_parser_process;
+  if (with_process_batch)
+    self->super.process_batch = _test_parser_process_batch;
+  self->super.name = g_strdup("test_parser");
+  log_pipe_append(&self->super.super, &next->super);
+  cr_assert(log_pipe_init(&self->super.super));
+  return self;
+}
+
+static void
+_destroy_parser(TestParser *self)
+{
+  log_pipe_deinit(&self->super.super);
+  log_pipe_unref(&self->super.super);
+}
+
+static void
+_assert_parser_batch_results(TestParser *parser, TestMessages *messages)
+{
+  cr_assert_str_eq(delivery_log->str, "N0 N2 N4 ");
+  for (gint i = 0; i < NUM_TEST_MSGS; i++)
+    cr_assert_eq(messages->matched[i], i % 2 == 0, "unexpected matched value for message %d", i);
+
+  cr_assert_eq(stats_counter_get(parser->super.processed_messages), 3);
+  cr_assert_eq(stats_counter_get(parser->super.super.discarded_messages), 3);
+}
+
+Test(logpipe_batch, parser_forwards_accepted_and_drops_rejected_messages)
+{
+  TestBranch *next = _test_branch_new("N", 0);
+  TestParser *parser = _construct_parser(FALSE, next);
+  TestMessages messages;
+
+  _test_messages_init(&messages);
+  _queue_as_batch(&parser->super.super, &messages);
+
+  _assert_parser_batch_results(parser, &messages);
+  cr_assert_eq(next->num_batches, 1);
+
+  _destroy_parser(parser);
+  _test_branch_free(next);
+}
+
+Test(logpipe_batch, parser_hands_the_whole_chunk_to_process_batch)
+{
+  TestBranch *next = _test_branch_new("N", 0);
+  TestParser *parser = _construct_parser(TRUE, next);
+  TestMessages messages;
+
+  _test_messages_init(&messages);
+  _queue_as_batch(&parser->super.super, &messages);
+
+  _assert_parser_batch_results(parser, &messages);
+  cr_assert_eq(parser->num_batches, 1);
+
+  _destroy_parser(parser);
+  _test_branch_free(next);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  configuration->stats_options.level = 1;
+  cr_assert(cfg_init(configuration));
+  delivery_log = g_string_new("");
+}
+
+static void
+teardown(void)
+{
+  g_string_free(delivery_log, TRUE);
+  cfg_deinit(configuration);
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(logpipe_batch, .init = setup, .fini = teardown);
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+#include "libtest/queue_utils_lib.h"
+
+#include "logqueue.h"
+#include "logqueue-ring.h"
+#include "apphook.h"
+#include "mainloop.h"
+#include "mainloop-worker.h"
+
+#include <iv.h>
+
+#define OVERFLOW_SIZE 10000
+#define FEEDERS 8
+#define MESSAGES_PER_FEEDER 20000
+#define MESSAGES_SUM (FEEDERS * MESSAGES_PER_FEEDER)
+
+static LogQueue *
+_create_queue(gint fifo_size)
+{
+  StatsClusterKeyBuilder *driver_sck_builder = stats_cluster_key_builder_new();
+  StatsClusterKeyBuilder *queue_sck_builder = stats_cluster_key_builder_new();
+  LogQueue *q = log_queue_ring_new(fifo_size, NULL, STATS_LEVEL0, driver_sck_builder, queue_sck_builder);
+  stats_cluster_key_builder_free(driver_sck_builder);
+  stats_cluster_key_builder_free(queue_sck_builder);
+
+  return q;
+}
+
+Test(logqueue_ring, test_normal_acks)
+{
+  LogQueue *q = _create_queue(OVERFLOW_SIZE);
+
+  cr_assert(log_queue_has_type(q, log_queue_ring_get_type()));
+
+  fed_messages = 0;
+  acked_messages = 0;
+  feed_some_messages(q, 1);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.queued_messages), 1);
+  cr_assert_neq(stats_counter_get(q->metrics.shared.memory_usage), 0);
+  gint size_when_single_msg = stats_counter_get(q->metrics.shared.memory_usage);
+
+  for (gint i = 0; i < 10; i++)
+    feed_some_messages(q, 10);
+
+  cr_assert_eq(log_queue_get_length(q), 101);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.queued_messages), 101);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.memory_usage), 101*size_when_single_msg);
+
+  send_some_messages(q, fed_messages, TRUE);
+
+  cr_assert_eq(fed_messages, acked_messages,
+               "did not receive enough acknowledgements: fed_messages=%d, acked_messages=%d",
+               fed_messages, acked_messages);
+  cr_assert_eq(log_queue_get_length(q), 0);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.memory_usage), 0);
+
+  log_queue_unref(q);
+}
+
+Test(logqueue_ring, test_rewind_and_ack_backlog)
+{
+  LogQueue *q = _create_queue(OVERFLOW_SIZE);
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msgs[10];
+
+  fed_messages = 0;
+  acked_messages = 0;
+  feed_some_messages(q, 10);
+  gint size_of_all_msgs = stats_counter_get(q->metrics.shared.memory_usage);
+
+  for (gint i = 0; i < 10; i++)
+    {
+      msgs[i] = log_queue_pop_head(q, &path_options);
+      cr_assert_not_null(msgs[i]);
+    }
+  cr_assert_null(log_queue_pop_head(q, &path_options));
+
+  /* messages are still in the backlog */
+  cr_assert_eq(stats_counter_get(q->metrics.shared.memory_usage), size_of_all_msgs);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.queued_messages), 0);
+
+  for (gint i = 0; i < 10; i++)
+    {
+      LogMessage *msg = log_queue_peek_backlog(q, i);
+      cr_assert_eq(msg, msgs[i]);
+      log_msg_unref(msg);
+    }
+  cr_assert_null(log_queue_peek_backlog(q, 10));
+
+  /* ack the first 2, rewind the last 3 */
+  log_queue_ack_backlog(q, 2);
+  cr_assert_eq(acked_messages, 2);
+  log_queue_rewind_backlog(q, 3);
+  cr_assert_eq(log_queue_get_length(q), 3);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.queued_messages), 3);
+
+  for (gint i = 7; i < 10; i++)
+    {
+      LogMessage *msg = log_queue_pop_head(q, &path_options);
+      cr_assert_eq(msg, msgs[i], "rewound messages are not in order, i=%d", i);
+      log_msg_unref(msg);
+    }
+
+  log_queue_rewind_backlog_all(q);
+  cr_assert_eq(log_queue_get_length(q), 8);
+
+  for (gint i = 2; i < 10; i++)
+    {
+      LogMessage *msg = log_queue_peek_head(q);
+      cr_assert_eq(msg, msgs[i], "rewound messages are not in order, i=%d", i);
+      log_msg_unref(msg);
+
+      msg = log_queue_pop_head(q, &path_options);
+      cr_assert_eq(msg, msgs[i], "rewound messages are not in order, i=%d", i);
+      log_msg_unref(msg);
+    }
+  log_queue_ack_backlog(q, 8);
+
+  for (gint i = 0; i < 10; i++)
+    log_msg_unref(msgs[i]);
+
+  cr_assert_eq(fed_messages, acked_messages);
+  cr_assert_eq(stats_counter_get(q->metrics.shared.memory_usage), 0);
+  log_queue_unref(q);
+}
+
+Test(logqueue_ring, test_should_drop_only_non_flow_controlled_messages,
+     .description = "Flow-controlled messages should never be dropped")
+{
+  LogPathOptions flow_controlled_path = LOG_PATH_OPTIONS_INIT;
+  flow_controlled_path.flow_control_requested = TRUE;
+
+  LogPathOptions non_flow_controlled_path = LOG_PATH_OPTIONS_INIT;
+  non_flow_controlled_path.flow_control_requested = FALSE;
+
+  gint fifo_size = 5;
+  LogQueue *q = _create_queue(fifo_size);
+
+  fed_messages = 0;
+  acked_messages = 0;
+  feed_empty_messages(q, &flow_controlled_path, fifo_size);
+  feed_empty_messages(q, &non_flow_controlled_path, fifo_size);
+
+  feed_empty_messages(q, &non_flow_controlled_path, 1);
+  feed_empty_messages(q, &flow_controlled_path, fifo_size);
+  feed_empty_messages(q, &non_flow_controlled_path, 2);
+  feed_empty_messages(q, &flow_controlled_path, fifo_size);
+
+  cr_assert_eq(stats_counter_get(q->metrics.shared.dropped_messages), 3);
+
+  gint queued_messages = stats_counter_get(q->metrics.shared.queued_messages);
+  send_some_messages(q, queued_messages, TRUE);
+
+  cr_assert_eq(fed_messages, acked_messages,
+               "did not receive enough acknowledgements: fed_messages=%d, acked_messages=%d",
+               fed_messages, acked_messages);
+
+  log_queue_unref(q);
+}
+
+Test(logqueue_ring, test_overflow_keeps_ordering,
+     .description = "Flow-controlled messages beyond the ring capacity are kept in order")
+{
+  LogQueue *q = _create_queue(1);
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  path_options.flow_control_requested = TRUE;
+  const gint num_messages = 1000;
+
+  for (gint i = 0; i < num_messages; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      msg->rcptid = i;
+      log_queue_push_tail(q, msg, &path_options);
+    }
+  cr_assert_eq(log_queue_get_length(q), num_messages);
+
+  for (gint i = 0; i < num_messages; i++)
+    {
+      LogMessage *msg = log_queue_pop_head(q, &path_options);
+      cr_assert_not_null(msg);
+      cr_assert_eq(msg->rcptid, i);
+      log_msg_unref(msg);
+
+      /* interleave pushes while the overflow list is being drained */
+      if (i == num_messages / 2)
+        {
+          LogMessage *extra = log_msg_new_empty();
+          extra->rcptid = num_messages;
+          log_queue_push_tail(q, extra, &path_options);
+        }
+    }
+
+  LogMessage *msg = log_queue_pop_head(q, &path_options);
+  cr_assert_eq(msg->rcptid, num_messages);
+  log_msg_unref(msg);
+
+  log_queue_ack_backlog(q, num_messages + 1);
+  cr_assert_eq(log_queue_get_length(q), 0);
+  log_queue_unref(q);
+}
+
+static gpointer
+_threaded_feed(gpointer args)
+{
+  LogQueue *q = args;
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  path_options.flow_control_requested = TRUE;
+
+  iv_init();
+  main_loop_worker_thread_start(MLW_ASYNC_WORKER);
+
+  for (gint i = 0; i < MESSAGES_PER_FEEDER; i++)
+    {
+      LogMessage *msg = log_msg_new_empty();
+      msg->rcptid = i;
+      log_queue_push_tail(q, msg, &path_options);
+    }
+
+  main_loop_worker_thread_stop();
+  iv_deinit();
+  return NULL;
+}
+
+Test(logqueue_ring, test_with_threads)
+{
+  GThread *thread_feed[FEEDERS];
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  main_loop_worker_allocate_thread_space(FEEDERS);
+  main_loop_worker_finalize_thread_space();
+
+  LogQueue *q = _create_queue(1024);
+
+  for (gint j = 0; j < FEEDERS; j++)
+    thread_feed[j] = g_thread_new(NULL, _threaded_feed, q);
+
+  gint msg_count = 0;
+  gint slept = 0;
+  while (msg_count < MESSAGES_SUM)
+    {
+      LogMessage *msg = log_queue_pop_head(q, &path_options);
+      if (!msg)
+        {
+          g_usleep(1000);
+          cr_assert_lt(slept++, 10000, "The wait for messages took too much time, msg_count=%d", msg_count);
+          continue;
+        }
+
+      log_msg_unref(msg);
+      log_queue_ack_backlog(q, 1);
+      msg_count++;
+    }
+
+  for (gint j = 0; j < FEEDERS; j++)
+    g_thread_join(thread_feed[j]);
+
+  cr_assert_eq(log_queue_get_length(q), 0);
+  cr_assert_null(log_queue_pop_head(q, &path_options));
+  log_queue_unref(q);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  configuration->stats_options.level = 1;
+  cr_assert(cfg_init(configuration), "cfg_init failed!");
+}
+
+static void
+teardown(void)
+{
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(logqueue_ring, .init = setup, .fini = teardown);
@@ -22,7 +22,7 @@
 #include <criterion/criterion.h>
 #include "libtest/cr_template.h"
 
-#include "logscheduler.h"
+#include "logscheduler.c"
 #include "apphook.h"
 
 typedef struct TestPipe
@@ -31,6 +31,7 @@ typedef struct TestPipe
   GMutex lock;
   GQueue *messages;
   gsize messages_count;
+  GArray *batch_sizes;
 } TestPipe;
 
 static void
@@ -44,11 +45,22 @@ test_pipe_queue(LogPipe *s, LogMessage *msg, const LogPathOptions *path_options)
   g_mutex_unlock(&self->lock);
 }
 
+static void
+test_pipe_queue_batch(LogPipe *s, LogMessage **msgs, const LogPathOptions **path_options, gint num_msgs)
+{
+  TestPipe *self = (TestPipe *) s;
+
+  g_array_append_val(self->batch_sizes, num_msgs);
+  for (gint i = 0; i < num_msgs; i++)
+    test_pipe_queue(s, msgs[i], path_options[i]);
+}
+
 static void
 test_pipe_free(LogPipe *s)
 {
   TestPipe *self = (TestPipe *) s;
 
+  g_array_free(self->batch_sizes, TRUE);
   g_queue_free_full(self->messages, (GDestroyNotify) log_msg_unref);
   g_mutex_clear(&self->lock);
   log_pipe_free_method(s);
@@ -61,8 +73,10 @@ test_pipe_new(GlobalConfig *cfg)
 
   log_pipe_init_instance(&self->super, cfg);
   self->super.queue = test_pipe_queue;
+  self->super.queue_batch = test_pipe_queue_batch;
   self->super.free_fn = test_pipe_free;
   self->messages = g_queue_new();
+  self->batch_sizes = g_array_new(FALSE, FALSE, sizeof(gint));
   g_mutex_init(&self->lock);
   return self;
 }
@@ -105,6 +119,59 @@ Test(logscheduler, test_log_scheduler_can_be_constructed)
   _destroy_test_pipe(test_pipe);
 }
 
+#if SYSLOG_NG_HAVE_IV_WORK_POOL_SUBMIT_CONTINUATION
+
+Test(logscheduler, test_partition_reinjects_messages_in_chunks_of_max_batch_size)
+{
+  const gint num_msgs = 2 * LOG_PIPE_MAX_BATCH_SIZE + 10;
+  TestPipe *test_pipe = _construct_test_pipe();
+  LogSchedulerPartition partition = { 0 };
+  struct iv_list_head elements = IV_LIST_HEAD_INIT(elements);
+
+  partition.front_pipe = &test_pipe->super;
+  INIT_IV_LIST_HEAD(&partition.batches);
+  g_mutex_init(&partition.batches_lock);
+
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      LogMessage *msg = create_sample_message();
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      gchar seq[16];
+
+      g_snprintf(seq, sizeof(seq), "%d", i);
+      log_msg_set_value_by_name(msg, "SEQ", seq, -1);
+
+      LogMessageQueueNode *node = log_msg_alloc_queue_node(msg, &path_options);
+      iv_list_add_tail(&node->list, &elements);
+      log_msg_unref(msg);
+    }
+  LogSchedulerBatch *batch = _batch_new(&elements);
+  iv_list_add_tail(&batch->list, &partition.batches);
+
+  _work(&partition, NULL);
+
+  cr_assert(iv_list_empty(&partition.batches));
+  cr_assert_eq(test_pipe->messages_count, num_msgs);
+  cr_assert_eq(test_pipe->batch_sizes->len, 3);
+  cr_assert_eq(g_array_index(test_pipe->batch_sizes, gint, 0), LOG_PIPE_MAX_BATCH_SIZE);
+  cr_assert_eq(g_array_index(test_pipe->batch_sizes, gint, 1), LOG_PIPE_MAX_BATCH_SIZE);
+  cr_assert_eq(g_array_index(test_pipe->batch_sizes, gint, 2), 10);
+
+  gint i = 0;
+  for (GList *l = test_pipe->messages->head; l; l = l->next, i++)
+    {
+      gchar seq[16];
+
+      g_snprintf(seq, sizeof(seq), "%d", i);
+      cr_assert_str_eq(log_msg_get_value_by_name((LogMessage *) l->data, "SEQ", NULL), seq);
+    }
+
+  g_mutex_clear(&partition.batches_lock);
+  _destroy_test_pipe(test_pipe);
+}
+
+#endif
+
 static void
 setup(void)
 {
@@ -31,6 +31,7 @@
 #include "cfg.h"
 #include "apphook.h"
 #include "dynamic-window-pool.h"
+#include "host-resolve.h"
 
 #include <syslog.h>
 #include <string.h>
@@ -52,6 +53,7 @@ setup(void)
 void
 teardown(void)
 {
+  host_resolve_set_reverse_lookup_func(NULL);
   app_shutdown();
   log_source_options_destroy(&source_options);
   cfg_free(cfg);
@@ -477,4 +479,175 @@ Test(log_source, test_dynamic_window_reclaim)
   test_source_destroy(source);
 }
 
+/* use-dns(async): the resolver blocks until released */
+static GMutex resolver_lock;
+static GCond resolver_cond;
+static gboolean resolver_released;
+static gint parked_flushes_scheduled;
+
+static const gchar *
+_blocking_reverse_lookup(GSockAddr *saddr, gchar *buf, gsize buf_len)
+{
+  g_mutex_lock(&resolver_lock);
+  while (!resolver_released)
+    g_cond_wait(&resolver_cond, &resolver_lock);
+  g_mutex_unlock(&resolver_lock);
+
+  g_strlcpy(buf, "resolved-test-host", buf_len);
+  return buf;
+}
+
+static void
+_count_scheduled_parked_flushes(LogSource *s)
+{
+  g_mutex_lock(&resolver_lock);
+  parked_flushes_scheduled++;
+  g_cond_broadcast(&resolver_cond);
+  g_mutex_unlock(&resolver_lock);
+}
+
+static void
+_release_resolver(void)
+{
+  g_mutex_lock(&resolver_lock);
+  resolver_released = TRUE;
+  g_cond_broadcast(&resolver_cond);
+  g_mutex_unlock(&resolver_lock);
+}
+
+static void
+_wait_for_scheduled_parked_flush(void)
+{
+  g_mutex_lock(&resolver_lock);
+  while (parked_flushes_scheduled == 0)
+    g_cond_wait(&resolver_cond, &resolver_lock);
+  g_mutex_unlock(&resolver_lock);
+}
+
+/* the pending lookup holds a reference to the source until its callback returns */
+static void
+_wait_for_lookup_callbacks(LogSource *source)
+{
+  while (g_atomic_counter_get(&source->super.ref_cnt) > 1)
+    g_usleep(1000);
+}
+
+static LogSource *
+_async_dns_source_init(void)
+{
+  resolver_released = FALSE;
+  parked_flushes_scheduled = 0;
+  host_resolve_set_reverse_lookup_func(_blocking_reverse_lookup);
+
+  source_options.host_resolve_options.use_dns = HOST_RESOLVE_USE_DNS_ASYNC;
+  LogSource *source = test_source_init(&source_options);
+  source->schedule_parked_flush = _count_scheduled_parked_flushes;
+  return source;
+}
+
+/* a NULL sender is local, its name is readily available */
+static void
+_post_message_from(LogSource *source, const gchar *sender, const gchar *message)
+{
+  LogMessage *msg = log_msg_new_empty();
+
+  if (sender)
+    {
+      GSockAddr *saddr = g_sockaddr_inet_new(sender, 514);
+      log_msg_set_saddr(msg, saddr);
+      g_sockaddr_unref(saddr);
+    }
+  log_msg_set_value(msg, LM_V_MESSAGE, message, -1);
+  log_source_post(source, msg);
+}
+
+static void
+_assert_forwarded_messages(TestPipe *pipe, const gchar *expected[], gsize expected_count)
+{
+  cr_assert_eq(pipe->messages_count, expected_count);
+
+  GList *l = pipe->messages->head;
+  for (gsize i = 0; i < expected_count; i++, l = l->next)
+    cr_assert_str_eq(log_msg_get_value((LogMessage *) l->data, LM_V_MESSAGE, NULL), expected[i]);
+}
+
+Test(log_source, test_messages_are_parked_until_their_sender_is_resolved)
+{
+  LogSource *source = _async_dns_source_init();
+  TestPipe *next_pipe = test_pipe_init();
+  log_pipe_append(&source->super, &next_pipe->super);
+
+  _post_message_from(source, "10.1.0.1", "1");
+  cr_assert_eq(next_pipe->messages_count, 0);
+
+  /* parked behind the first one to keep their order, even if known */
+  _post_message_from(source, NULL, "2");
+  cr_assert_eq(next_pipe->messages_count, 0);
+
+  _release_resolver();
+  _wait_for_scheduled_parked_flush();
+  cr_assert_eq(next_pipe->messages_count, 0, "parked messages should not be forwarded by the resolver thread");
+
+  log_source_flush_parked_messages(source);
+  _assert_forwarded_messages(next_pipe, (const gchar *[]) { "1", "2" }, 2);
+
+  /* nothing is parked anymore, forwarded right away */
+  _post_message_from(source, NULL, "3");
+  _assert_forwarded_messages(next_pipe, (const gchar *[]) { "1", "2", "3" }, 3);
+
+  test_pipe_ack_messages(next_pipe, 3);
+  _wait_for_lookup_callbacks(source);
+  test_pipe_destroy(next_pipe);
+  test_source_destroy(source);
+}
+
+Test(log_source, test_messages_arriving_before_the_parked_flush_are_forwarded_after_the_resolved_ones)
+{
+  LogSource *source = _async_dns_source_init();
+  TestPipe *next_pipe = test_pipe_init();
+  log_pipe_append(&source->super, &next_pipe->super);
+
+  _post_message_from(source, "10.1.0.2", "1");
+  _release_resolver();
+  _wait_for_scheduled_parked_flush();
+
+  /* the resolved message is waiting for the flush, this one has to queue behind it */
+  _post_message_from(source, NULL, "2");
+  cr_assert_eq(next_pipe->messages_count, 0);
+
+  log_source_flush_parked_messages(source);
+  _assert_forwarded_messages(next_pipe, (const gchar *[]) { "1", "2" }, 2);
+  cr_assert_eq(parked_flushes_scheduled, 1);
+
+  test_pipe_ack_messages(next_pipe, 2);
+  _wait_for_lookup_callbacks(source);
+  test_pipe_destroy(next_pipe);
+  test_source_destroy(source);
+}
+
+Test(log_source, test_parked_messages_are_not_forwarded_at_deinit)
+{
+  source_options.init_window_size = 2;
+  LogSource *source = _async_dns_source_init();
+  TestPipe *next_pipe = test_pipe_init();
+  log_pipe_append(&source->super, &next_pipe->super);
+
+  _post_message_from(source, "10.1.0.3", "1");
+  _post_message_from(source, NULL, "2");
+  cr_assert_not(log_source_free_to_send(source));
+
+  log_pipe_deinit(&source->super);
+  cr_assert_eq(next_pipe->messages_count, 0);
+  cr_assert(log_source_free_to_send(source), "dropped messages should be acked, returning their window");
+
+  /* the lookup finishing after deinit does not forward anything */
+  _release_resolver();
+  _wait_for_lookup_callbacks(source);
+  cr_assert_eq(parked_flushes_scheduled, 0);
+  cr_assert_eq(next_pipe->messages_count, 0);
+
+  test_pipe_destroy(next_pipe);
+  log_pipe_unref(&source->super);
+}
+
 TestSuite(log_source, .init = setup, .fini = teardown);
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "mainloop-io-worker.h"
+
+static void
+_assert_cpu_list(const gchar *cpu_list, const gint *expected_cpus, gint num_expected_cpus)
+{
+  GArray *cpus = g_array_new(FALSE, FALSE, sizeof(gint));
+
+  cr_assert(main_loop_io_worker_parse_cpu_list(cpu_list, cpus), "failed to parse CPU list: %s", cpu_list);
+  cr_assert_eq(cpus->len, num_expected_cpus, "unexpected number of CPUs in %s", cpu_list);
+  for (gint i = 0; i < num_expected_cpus; i++)
+    cr_assert_eq(g_array_index(cpus, gint, i), expected_cpus[i], "unexpected CPU at index %d in %s", i, cpu_list);
+
+  g_array_free(cpus, TRUE);
+}
+
+static void
+_assert_invalid_cpu_list(const gchar *cpu_list)
+{
+  GArray *cpus = g_array_new(FALSE, FALSE, sizeof(gint));
+
+  cr_assert_not(main_loop_io_worker_parse_cpu_list(cpu_list, cpus), "CPU list should have been rejected: %s",
+                cpu_list);
+  g_array_free(cpus, TRUE);
+}
+
+Test(mainloop_io_worker, cpu_list_single_cpus_and_ranges)
+{
+  _assert_cpu_list("3", (gint []) { 3 }, 1);
+  _assert_cpu_list("0,2", (gint []) { 0, 2 }, 2);
+  _assert_cpu_list("0-3", (gint []) { 0, 1, 2, 3 }, 4);
+  _assert_cpu_list("0-1,8,10-11", (gint []) { 0, 1, 8, 10, 11 }, 5);
+}
+
+Test(mainloop_io_worker, invalid_cpu_lists_are_rejected)
+{
+  _assert_invalid_cpu_list("");
+  _assert_invalid_cpu_list("foo");
+  _assert_invalid_cpu_list("3-1");
+  _assert_invalid_cpu_list("0-");
+  _assert_invalid_cpu_list("1,,2");
+  _assert_invalid_cpu_list("1;2");
+  _assert_invalid_cpu_list("-1");
+  _assert_invalid_cpu_list("0-100000");
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "multi-string-matcher.h"
+
+#include <string.h>
+
+static MultiStringMatcher *
+_compile_matcher(gboolean icase, const gchar *patterns[])
+{
+  MultiStringMatcher *matcher = multi_string_matcher_new((icase ? MSM_ICASE : 0) | MSM_SUBSTRING);
+
+  for (gint i = 0; patterns[i]; i++)
+    multi_string_matcher_add_pattern(matcher, patterns[i], -1);
+  multi_string_matcher_compile(matcher);
+  return matcher;
+}
+
+#define assert_match(func, matcher, value) \
+  cr_assert(func(matcher, value, strlen(value)), #func "() expected to match: %s", value)
+#define assert_no_match(func, matcher, value) \
+  cr_assert_not(func(matcher, value, strlen(value)), #func "() expected not to match: %s", value)
+
+Test(multi_string_matcher, exact)
+{
+  const gchar *patterns[] = { "foo", "foobar", "bar", "foo", NULL };
+  MultiStringMatcher *matcher = _compile_matcher(FALSE, patterns);
+
+  assert_match(multi_string_matcher_match_exact, matcher, "foo");
+  assert_match(multi_string_matcher_match_exact, matcher, "foobar");
+  assert_match(multi_string_matcher_match_exact, matcher, "bar");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "fo");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "foob");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "FOO");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "foobarbaz");
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, prefix)
+{
+  const gchar *patterns[] = { "foobar", "baz", NULL };
+  MultiStringMatcher *matcher = _compile_matcher(FALSE, patterns);
+
+  assert_match(multi_string_matcher_match_prefix, matcher, "foobar");
+  assert_match(multi_string_matcher_match_prefix, matcher, "foobarbaz");
+  assert_match(multi_string_matcher_match_prefix, matcher, "bazfoo");
+  assert_no_match(multi_string_matcher_match_prefix, matcher, "foo");
+  assert_no_match(multi_string_matcher_match_prefix, matcher, "xbaz");
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, substring)
+{
+  const gchar *patterns[] = { "he", "she", "his", "hers", NULL };
+  MultiStringMatcher *matcher = _compile_matcher(FALSE, patterns);
+
+  assert_match(multi_string_matcher_match_substring, matcher, "ushers");
+  assert_match(multi_string_matcher_match_substring, matcher, "xxhis");
+  assert_match(multi_string_matcher_match_substring, matcher, "xshe");
+  assert_match(multi_string_matcher_match_substring, matcher, "hhe");
+  assert_no_match(multi_string_matcher_match_substring, matcher, "hxsxi");
+  assert_no_match(multi_string_matcher_match_substring, matcher, "");
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, matches_found_via_failure_links)
+{
+  const gchar *patterns[] = { "abcd", "bc", NULL };
+  MultiStringMatcher *matcher = _compile_matcher(FALSE, patterns);
+
+  assert_match(multi_string_matcher_match_substring, matcher, "abce");
+  assert_no_match(multi_string_matcher_match_substring, matcher, "abd");
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, icase)
+{
+  const gchar *patterns[] = { "Foo", "BAR", NULL };
+  MultiStringMatcher *matcher = _compile_matcher(TRUE, patterns);
+
+  assert_match(multi_string_matcher_match_exact, matcher, "foo");
+  assert_match(multi_string_matcher_match_exact, matcher, "bAr");
+  assert_match(multi_string_matcher_match_prefix, matcher, "FOOBAR");
+  assert_match(multi_string_matcher_match_substring, matcher, "xxBaRxx");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "foobar");
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, binary_values)
+{
+  MultiStringMatcher *matcher = multi_string_matcher_new(MSM_SUBSTRING);
+
+  multi_string_matcher_add_pattern(matcher, "a\0b", 3);
+  multi_string_matcher_add_pattern(matcher, "\xff\xfe", -1);
+  multi_string_matcher_compile(matcher);
+
+  cr_assert(multi_string_matcher_match_exact(matcher, "a\0b", 3));
+  cr_assert_not(multi_string_matcher_match_exact(matcher, "a", 1));
+  cr_assert(multi_string_matcher_match_substring(matcher, "xx\xff\xfexx", 6));
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, empty_set_matches_nothing)
+{
+  const gchar *patterns[] = { NULL };
+  MultiStringMatcher *matcher = _compile_matcher(FALSE, patterns);
+
+  assert_no_match(multi_string_matcher_match_exact, matcher, "");
+  assert_no_match(multi_string_matcher_match_prefix, matcher, "foo");
+  assert_no_match(multi_string_matcher_match_substring, matcher, "foo");
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, empty_pattern_matches_everything_as_substring)
+{
+  const gchar *patterns[] = { "", NULL };
+  MultiStringMatcher *matcher = _compile_matcher(FALSE, patterns);
+
+  assert_match(multi_string_matcher_match_exact, matcher, "");
+  assert_match(multi_string_matcher_match_prefix, matcher, "foo");
+  assert_match(multi_string_matcher_match_substring, matcher, "foo");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "foo");
+  multi_string_matcher_free(matcher);
+}
+
+Test(multi_string_matcher, exact_and_prefix_lookups_without_substring_support)
+{
+  const gchar *patterns[] = { "foo", "foobar", "ba", NULL };
+  MultiStringMatcher *matcher = multi_string_matcher_new(MSM_ICASE);
+
+  for (gint i = 0; patterns[i]; i++)
+    multi_string_matcher_add_pattern(matcher, patterns[i], -1);
+  multi_string_matcher_compile(matcher);
+
+  assert_match(multi_string_matcher_match_exact, matcher, "FOO");
+  assert_match(multi_string_matcher_match_exact, matcher, "foobar");
+  assert_no_match(multi_string_matcher_match_exact, matcher, "foob");
+  assert_match(multi_string_matcher_match_prefix, matcher, "bar");
+  assert_no_match(multi_string_matcher_match_prefix, matcher, "xfoo");
+  multi_string_matcher_free(matcher);
+}
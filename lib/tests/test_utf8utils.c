@@ -26,6 +26,30 @@
 
 #include "utf8utils.h"
 
+static struct
+{
+  UTF8EscapeKernelType type;
+  const gchar *name;
+} kernels[] =
+{
+  { UTF8_ESCAPE_KERNEL_SCALAR, "scalar" },
+  { UTF8_ESCAPE_KERNEL_SSE2, "sse2" },
+  { UTF8_ESCAPE_KERNEL_AVX2, "avx2" },
+};
+
+/* kernels not available in this build or on this CPU are skipped */
+#define foreach_kernel(i) \
+  for (gint i = 0; i < G_N_ELEMENTS(kernels); i++) \
+    if (utf8_escape_set_kernel(kernels[i].type))
+
+static void
+_restore_kernel(void)
+{
+  utf8_escape_set_kernel(UTF8_ESCAPE_KERNEL_AUTO);
+}
+
+TestSuite(test_utf8utils, .fini = _restore_kernel);
+
 typedef struct _StringValueList
 {
   const gchar *str;
@@ -64,10 +88,15 @@ ParameterizedTest(StringValueList *string_value_list, test_utf8utils, test_escap
 {
   GString *escaped_str = g_string_sized_new(64);
 
-  append_unsafe_utf8_as_escaped_binary(escaped_str, string_value_list->str, string_value_list->str_len,
-                                       string_value_list->unsafe_flags);
+  foreach_kernel(k)
+  {
+    g_string_truncate(escaped_str, 0);
+    append_unsafe_utf8_as_escaped_binary(escaped_str, string_value_list->str, string_value_list->str_len,
+                                         string_value_list->unsafe_flags);
 
-  cr_assert_str_eq(escaped_str->str, string_value_list->expected_escaped_str, "Escaped UTF-8 string is not as expected");
+    cr_assert_str_eq(escaped_str->str, string_value_list->expected_escaped_str,
+                     "Escaped UTF-8 string is not as expected, kernel: %s", kernels[k].name);
+  }
   g_string_free(escaped_str, TRUE);
 }
 
@@ -96,13 +125,75 @@ ParameterizedTestParameters(test_utf8utils, test_escaped_text)
 
 ParameterizedTest(StringValueList *string_value_list, test_utf8utils, test_escaped_text)
 {
-  gchar *escaped_str = convert_unsafe_utf8_to_escaped_text(string_value_list->str, string_value_list->str_len,
-                                                           string_value_list->unsafe_flags);
+  foreach_kernel(k)
+  {
+    gchar *escaped_str = convert_unsafe_utf8_to_escaped_text(string_value_list->str, string_value_list->str_len,
+                                                             string_value_list->unsafe_flags);
+
+    cr_assert_str_eq(escaped_str, string_value_list->expected_escaped_str,
+                     "Escaped UTF-8 string is not as expected, kernel: %s", kernels[k].name);
 
-  cr_assert_str_eq(escaped_str, string_value_list->expected_escaped_str, "Escaped UTF-8 string is not as expected");
+    gboolean escaping_was_applied = strcmp(escaped_str, string_value_list->str) != 0;
+    cr_assert_eq(unsafe_utf8_is_escaping_needed(string_value_list->str, string_value_list->str_len,
+                                                string_value_list->unsafe_flags), escaping_was_applied);
+    g_free(escaped_str);
+  }
+}
 
-  gboolean escaping_was_applied = strcmp(escaped_str, string_value_list->str) != 0;
-  cr_assert_eq(unsafe_utf8_is_escaping_needed(string_value_list->str, string_value_list->str_len,
-                                              string_value_list->unsafe_flags), escaping_was_applied);
-  g_free(escaped_str);
+typedef struct _SpecialCharacter
+{
+  const gchar *chr;
+  const gchar *escaped;
+  guint32 unsafe_flags;
+} SpecialCharacter;
+
+/* the kernels scan 8, 16 or 32 bytes at a time, try every position around those boundaries */
+Test(test_utf8utils, test_special_characters_are_found_at_every_offset)
+{
+  static const SpecialCharacter special_characters[] =
+  {
+    {"\n", "\\n", 0},
+    {"\x01", "\\x01", 0},
+    {"\x7f", "\x7f", 0},
+    {"\\", "\\\\", 0},
+    {"\"", "\"", 0},
+    {"\"", "\\\"", AUTF8_UNSAFE_QUOTE},
+    {"'", "'", AUTF8_UNSAFE_QUOTE},
+    {"'", "\\'", AUTF8_UNSAFE_APOSTROPHE},
+    {"\xad", "\\xad", 0},
+    {"á", "á", 0},
+  };
+  GString *input = g_string_new("");
+  GString *expected = g_string_new("");
+  GString *escaped_str = g_string_new("");
+
+  for (gint c = 0; c < G_N_ELEMENTS(special_characters); c++)
+    {
+      const SpecialCharacter *special = &special_characters[c];
+
+      for (gint offset = 0; offset < 70; offset++)
+        {
+          g_string_truncate(input, 0);
+          g_string_truncate(expected, 0);
+          for (gint i = 0; i < offset; i++)
+            g_string_append_c(input, 'a' + i % 26);
+          g_string_append(expected, input->str);
+          g_string_append(input, special->chr);
+          g_string_append(expected, special->escaped);
+          g_string_append(input, "0123456789abcdefghijklmnopqrstuvwxyz");
+          g_string_append(expected, "0123456789abcdefghijklmnopqrstuvwxyz");
+
+          foreach_kernel(k)
+          {
+            g_string_truncate(escaped_str, 0);
+            append_unsafe_utf8_as_escaped_binary(escaped_str, input->str, input->len, special->unsafe_flags);
+            cr_assert_str_eq(escaped_str->str, expected->str, "Escaped string mismatch, kernel: %s, offset: %d",
+                             kernels[k].name, offset);
+          }
+        }
+    }
+
+  g_string_free(escaped_str, TRUE);
+  g_string_free(expected, TRUE);
+  g_string_free(input, TRUE);
 }
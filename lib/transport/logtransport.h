@@ -67,6 +67,8 @@ struct _LogTransport
   gssize (*write)(LogTransport *self, const gpointer buf, gsize count);
   gssize (*writev)(LogTransport *self, struct iovec *iov, gint iov_count);
   void (*shutdown)(LogTransport *self);
+  /* returns TRUE if the transport has input buffered in userspace, that poll() would not report */
+  gboolean (*has_pending_input)(LogTransport *self);
   void (*free_fn)(LogTransport *self);
   void (*register_stats)(LogTransport *self, StatsClusterKeyBuilder *kb);
 
@@ -109,6 +111,9 @@ log_transport_poll_prepare(LogTransport *self, GIOCondition *cond)
   if (self->ra.buf_len != self->ra.pos)
     return TRUE;
 
+  if (self->has_pending_input && self->has_pending_input(self))
+    return TRUE;
+
   return FALSE;
 }
 
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+#include <criterion/criterion.h>
+
+#include "transport/transport-udp-socket.h"
+#include "transport/transport-aux-data.h"
+#include "apphook.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define NUM_DATAGRAMS 20
+
+static gint server_fd;
+static gint client_fd;
+
+static gint
+_create_bound_udp_socket(void)
+{
+  struct sockaddr_in sin = { 0 };
+  gint fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+  cr_assert_geq(fd, 0);
+  sin.sin_family = AF_INET;
+  sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  cr_assert_eq(bind(fd, (struct sockaddr *) &sin, sizeof(sin)), 0);
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+static void
+_send_datagrams(gint n)
+{
+  struct sockaddr_in sin;
+  socklen_t len = sizeof(sin);
+
+  cr_assert_eq(getsockname(server_fd, (struct sockaddr *) &sin, &len), 0);
+  for (gint i = 0; i < n; i++)
+    {
+      gchar buf[32];
+      gint buf_len = g_snprintf(buf, sizeof(buf), "datagram %d", i);
+
+      cr_assert_eq(sendto(client_fd, buf, buf_len, 0, (struct sockaddr *) &sin, len), buf_len);
+    }
+}
+
+static void
+_assert_datagrams_can_be_read(LogTransport *transport, gint first, gint end)
+{
+  LogTransportAuxData aux;
+  gchar buf[1024];
+  struct sockaddr_in client_sin;
+  socklen_t len = sizeof(client_sin);
+
+  cr_assert_eq(getsockname(client_fd, (struct sockaddr *) &client_sin, &len), 0);
+
+  log_transport_aux_data_init(&aux);
+  for (gint i = first; i < end; i++)
+    {
+      gchar expected[32];
+      gint expected_len = g_snprintf(expected, sizeof(expected), "datagram %d", i);
+
+      log_transport_aux_data_reinit(&aux);
+      gssize rc = log_transport_read(transport, buf, sizeof(buf), &aux);
+      cr_assert_eq(rc, expected_len, "unexpected datagram length, i=%d, rc=%" G_GSSIZE_FORMAT, i, rc);
+      cr_assert_arr_eq(buf, expected, expected_len);
+
+      cr_assert_not_null(aux.peer_addr);
+      cr_assert_eq(g_sockaddr_get_port(aux.peer_addr), ntohs(client_sin.sin_port));
+      cr_assert_not_null(aux.local_addr, "IP_PKTINFO should be available for each datagram");
+    }
+
+  log_transport_aux_data_destroy(&aux);
+}
+
+Test(transport_udp, test_single_datagram_reads)
+{
+  LogTransport *transport = log_transport_udp_socket_new(server_fd);
+
+  _send_datagrams(NUM_DATAGRAMS);
+  _assert_datagrams_can_be_read(transport, 0, NUM_DATAGRAMS);
+
+  log_transport_free(transport);
+}
+
+Test(transport_udp, test_batched_reads_retain_order_and_aux_data)
+{
+  LogTransport *transport = log_transport_udp_socket_new(server_fd);
+
+  if (!log_transport_udp_socket_set_recv_batch_size(transport, 8))
+    {
+      log_transport_free(transport);
+      cr_skip_test("recvmmsg() is not supported on this platform");
+    }
+
+  _send_datagrams(NUM_DATAGRAMS);
+
+  /* the first read receives a full batch, the rest of it is pending in userspace */
+  _assert_datagrams_can_be_read(transport, 0, 1);
+  cr_assert(transport->has_pending_input(transport));
+
+  GIOCondition cond;
+  cr_assert(log_transport_poll_prepare(transport, &cond),
+            "datagrams buffered in userspace should trigger a fetch without poll()");
+
+  _assert_datagrams_can_be_read(transport, 1, NUM_DATAGRAMS);
+  log_transport_free(transport);
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  server_fd = _create_bound_udp_socket();
+  client_fd = _create_bound_udp_socket();
+}
+
+static void
+teardown(void)
+{
+  close(server_fd);
+  close(client_fd);
+  app_shutdown();
+}
+
+TestSuite(transport_udp, .init = setup, .fini = teardown);
@@ -149,8 +149,8 @@ _parse_cmsg_to_aux(LogTransportSocket *self, struct msghdr *msg, LogTransportAux
 #define _parse_cmsg_to_aux(s, m, a)
 #endif
 
-static void
-_extract_from_msghdr_method(LogTransportSocket *self, struct msghdr *msg, LogTransportAuxData *aux)
+void
+log_transport_socket_extract_from_msghdr(LogTransportSocket *self, struct msghdr *msg, LogTransportAuxData *aux)
 {
   if (msg->msg_namelen && aux)
     log_transport_aux_data_set_peer_addr_ref(aux, g_sockaddr_new((struct sockaddr *) msg->msg_name, msg->msg_namelen));
@@ -187,7 +187,7 @@ log_transport_socket_read_method(LogTransport *s, gpointer buf, gsize buflen, Lo
   while (rc == -1 && errno == EINTR);
 
   if (rc > 0)
-    _extract_from_msghdr_method(self, &msg, aux);
+    log_transport_socket_extract_from_msghdr(self, &msg, aux);
 
   return rc;
 }
@@ -25,6 +25,7 @@
 #include "gsocket.h"
 #include "scratch-buffers.h"
 #include "str-format.h"
+#include "messages.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -33,11 +34,36 @@
 #include <errno.h>
 #include <string.h>
 
+#define LOG_TRANSPORT_UDP_CTLBUF_SIZE 256
+
+/*
+ * Datagrams received by a single recvmmsg() call. The payload of each
+ * datagram is stored in a preallocated slab, they are handed out one-by-one
+ * by subsequent read() calls, each with its own aux data.
+ */
+typedef struct _LogTransportUDPBatch
+{
+  gint size;
+  gsize datagram_size;
+
+  gint count;
+  gint pos;
+
+#if SYSLOG_NG_HAVE_RECVMMSG
+  struct mmsghdr *msgs;
+  struct iovec *iovs;
+  struct sockaddr_storage *addrs;
+  gchar *ctlbufs;
+  gchar *slab;
+#endif
+} LogTransportUDPBatch;
+
 typedef struct _LogTransportUDP LogTransportUDP;
 struct _LogTransportUDP
 {
   LogTransportSocket super;
   GSockAddr *bind_addr;
+  LogTransportUDPBatch batch;
 };
 
 #if defined(__FreeBSD__) || defined(__OpenBSD__)
@@ -158,11 +184,163 @@ _setup_fd(LogTransportUDP *self, gint fd)
 
 }
 
+#if SYSLOG_NG_HAVE_RECVMMSG
+
+static void
+_batch_alloc(LogTransportUDPBatch *batch, gsize datagram_size)
+{
+  batch->datagram_size = datagram_size;
+  batch->msgs = g_new0(struct mmsghdr, batch->size);
+  batch->iovs = g_new0(struct iovec, batch->size);
+  batch->addrs = g_new0(struct sockaddr_storage, batch->size);
+  batch->ctlbufs = g_malloc0(batch->size * LOG_TRANSPORT_UDP_CTLBUF_SIZE);
+  batch->slab = g_malloc(batch->size * datagram_size);
+
+  for (gint i = 0; i < batch->size; i++)
+    {
+      struct msghdr *msg = &batch->msgs[i].msg_hdr;
+
+      batch->iovs[i].iov_base = batch->slab + i * datagram_size;
+      msg->msg_iov = &batch->iovs[i];
+      msg->msg_iovlen = 1;
+      msg->msg_name = &batch->addrs[i];
+#if SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR
+      msg->msg_control = batch->ctlbufs + i * LOG_TRANSPORT_UDP_CTLBUF_SIZE;
+#endif
+    }
+}
+
+static void
+_batch_free(LogTransportUDPBatch *batch)
+{
+  g_free(batch->msgs);
+  g_free(batch->iovs);
+  g_free(batch->addrs);
+  g_free(batch->ctlbufs);
+  g_free(batch->slab);
+}
+
+static void
+_batch_reset_headers(LogTransportUDPBatch *batch)
+{
+  /* recvmmsg() overwrites the lengths with the actual values */
+  for (gint i = 0; i < batch->size; i++)
+    {
+      struct msghdr *msg = &batch->msgs[i].msg_hdr;
+
+      batch->iovs[i].iov_len = batch->datagram_size;
+      msg->msg_namelen = sizeof(struct sockaddr_storage);
+#if SYSLOG_NG_HAVE_CTRLBUF_IN_MSGHDR
+      msg->msg_controllen = LOG_TRANSPORT_UDP_CTLBUF_SIZE;
+#endif
+      msg->msg_flags = 0;
+    }
+}
+
+static gint
+_batch_fill(LogTransportUDP *self, gsize buflen)
+{
+  LogTransportUDPBatch *batch = &self->batch;
+  gint rc;
+
+  /* the slab is sized according to the largest buffer of our LogProto,
+   * which mirrors the truncation semantics of a simple recvmsg() */
+  if (batch->datagram_size < buflen)
+    {
+      _batch_free(batch);
+      _batch_alloc(batch, buflen);
+    }
+
+  _batch_reset_headers(batch);
+  do
+    {
+      rc = recvmmsg(self->super.super.fd, batch->msgs, batch->size, 0, NULL);
+    }
+  while (rc == -1 && errno == EINTR);
+
+  batch->pos = 0;
+  batch->count = MAX(rc, 0);
+  return rc;
+}
+
+static gssize
+log_transport_udp_socket_read_batched_method(LogTransport *s, gpointer buf, gsize buflen, LogTransportAuxData *aux)
+{
+  LogTransportUDP *self = (LogTransportUDP *) s;
+  LogTransportUDPBatch *batch = &self->batch;
+
+  if (batch->pos == batch->count && _batch_fill(self, buflen) < 0)
+    return -1;
+
+  if (batch->count == 0)
+    {
+      /* DGRAM sockets should never return EOF, they just need to be read again */
+      errno = EAGAIN;
+      return -1;
+    }
+
+  struct mmsghdr *mmsg = &batch->msgs[batch->pos++];
+  gsize len = MIN(mmsg->msg_len, buflen);
+
+  if (len == 0)
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+
+  memcpy(buf, mmsg->msg_hdr.msg_iov[0].iov_base, len);
+  log_transport_socket_extract_from_msghdr(&self->super, &mmsg->msg_hdr, aux);
+  return len;
+}
+
+static gboolean
+log_transport_udp_socket_has_pending_input(LogTransport *s)
+{
+  LogTransportUDP *self = (LogTransportUDP *) s;
+
+  return self->batch.pos < self->batch.count;
+}
+
+gboolean
+log_transport_udp_socket_set_recv_batch_size(LogTransport *s, gint recv_batch_size)
+{
+  LogTransportUDP *self = (LogTransportUDP *) s;
+
+  g_assert(self->batch.size == 0);
+
+  if (recv_batch_size <= 1)
+    return TRUE;
+
+  self->batch.size = recv_batch_size;
+  self->super.super.read = log_transport_udp_socket_read_batched_method;
+  self->super.super.has_pending_input = log_transport_udp_socket_has_pending_input;
+  return TRUE;
+}
+
+#else
+
+#define _batch_free(batch)
+
+gboolean
+log_transport_udp_socket_set_recv_batch_size(LogTransport *s, gint recv_batch_size)
+{
+  if (recv_batch_size <= 1)
+    return TRUE;
+
+  msg_warning_once("WARNING: recvmmsg() is not supported on this platform, udp() sources fall back to reading "
+                   "a single datagram per syscall",
+                   evt_tag_int("recv_batch_size", recv_batch_size));
+  return FALSE;
+}
+
+#endif
+
 static void
 log_transport_udp_socket_free(LogTransport *s)
 {
   LogTransportUDP *self = (LogTransportUDP *)s;
   g_sockaddr_unref(self->bind_addr);
+  _batch_free(&self->batch);
   log_transport_free_method(s);
 }
 
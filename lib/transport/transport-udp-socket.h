@@ -27,5 +27,8 @@
 
 LogTransport *log_transport_udp_socket_new(gint fd);
 
+/* returns FALSE if batching is not available, the transport then reads a single datagram per recvmsg() */
+gboolean log_transport_udp_socket_set_recv_batch_size(LogTransport *s, gint recv_batch_size);
+
 
 #endif
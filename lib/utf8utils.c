@@ -23,6 +23,15 @@
 #include "utf8utils.h"
 #include "str-utils.h"
 
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define UTF8_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+typedef gsize (*UTF8EscapeScanKernel)(const gchar *raw, gsize raw_len, guint32 unsafe_flags);
+
 static inline gboolean
 _is_character_unsafe(gunichar uchar, guint32 unsafe_flags)
 {
@@ -156,6 +165,227 @@ _append_escaped_utf8_character(GString *escaped_output, const gchar **raw,
                                                     invalid_format);
 }
 
+#define SWAR_ONES  G_GUINT64_CONSTANT(0x0101010101010101)
+#define SWAR_HIGHS G_GUINT64_CONSTANT(0x8080808080808080)
+
+/* non-zero if any of the bytes in w is zero */
+static inline guint64
+_swar_has_zero_byte(guint64 w)
+{
+  return (w - SWAR_ONES) & ~w & SWAR_HIGHS;
+}
+
+/* non-zero if any of the bytes in w equals to c */
+static inline guint64
+_swar_has_byte(guint64 w, guchar c)
+{
+  return _swar_has_zero_byte(w ^ (SWAR_ONES * c));
+}
+
+/* non-zero if any of the bytes in w needs escaping or is not ASCII */
+static inline guint64
+_swar_needs_attention(guint64 w, guint32 unsafe_flags)
+{
+  guint64 result = w & SWAR_HIGHS;
+
+  /* bytes below 0x20, this only works for bytes without their high bit set, see above */
+  result |= (w - SWAR_ONES * 0x20) & ~w & SWAR_HIGHS;
+  result |= _swar_has_byte(w, '\\');
+  if (unsafe_flags & AUTF8_UNSAFE_QUOTE)
+    result |= _swar_has_byte(w, '"');
+  if (unsafe_flags & AUTF8_UNSAFE_APOSTROPHE)
+    result |= _swar_has_byte(w, '\'');
+  return result;
+}
+
+static inline gboolean
+_is_safe_ascii_character(guchar c, guint32 unsafe_flags)
+{
+  return c >= 32 && c <= 127 && c != '\\' && !_is_character_unsafe(c, unsafe_flags);
+}
+
+/*
+ * Returns the length of the run of ASCII characters at the start of raw
+ * that are reproduced as is.  Most of our input is plain ASCII, so we
+ * check 8 bytes at a time and only fall back to the per-character path
+ * for the rest.
+ */
+static gsize
+_find_safe_ascii_run_scalar(const gchar *raw, gsize raw_len, guint32 unsafe_flags)
+{
+  gsize i = 0;
+
+  for (; i + sizeof(guint64) <= raw_len; i += sizeof(guint64))
+    {
+      guint64 w;
+
+      memcpy(&w, raw + i, sizeof(w));
+      if (_swar_needs_attention(w, unsafe_flags))
+        break;
+    }
+
+  while (i < raw_len && _is_safe_ascii_character(raw[i], unsafe_flags))
+    i++;
+  return i;
+}
+
+#if UTF8_X86_SIMD
+
+/*
+ * The SIMD kernels compare bytes as signed values, so a single "less than
+ * 0x20" comparison catches both control characters and non-ASCII bytes.
+ * Quote characters not in unsafe_flags are replaced by a backslash, which
+ * we look for anyway.
+ */
+static inline gchar
+_quote_to_scan_for(guint32 unsafe_flags, guint32 flag, gchar c)
+{
+  return (unsafe_flags & flag) ? c : '\\';
+}
+
+static inline __m128i
+_sse2_needs_attention(__m128i chunk, __m128i controls, __m128i backslashes, __m128i quotes, __m128i apostrophes)
+{
+  return _mm_or_si128(_mm_or_si128(_mm_cmplt_epi8(chunk, controls), _mm_cmpeq_epi8(chunk, backslashes)),
+                      _mm_or_si128(_mm_cmpeq_epi8(chunk, quotes), _mm_cmpeq_epi8(chunk, apostrophes)));
+}
+
+static gsize
+_find_safe_ascii_run_sse2(const gchar *raw, gsize raw_len, guint32 unsafe_flags)
+{
+  const __m128i controls = _mm_set1_epi8(0x20);
+  const __m128i backslashes = _mm_set1_epi8('\\');
+  const __m128i quotes = _mm_set1_epi8(_quote_to_scan_for(unsafe_flags, AUTF8_UNSAFE_QUOTE, '"'));
+  const __m128i apostrophes = _mm_set1_epi8(_quote_to_scan_for(unsafe_flags, AUTF8_UNSAFE_APOSTROPHE, '\''));
+  gsize i = 0;
+
+  for (; i + sizeof(__m128i) <= raw_len; i += sizeof(__m128i))
+    {
+      __m128i chunk = _mm_loadu_si128((const __m128i *) (raw + i));
+      guint mask = _mm_movemask_epi8(_sse2_needs_attention(chunk, controls, backslashes, quotes, apostrophes));
+
+      if (mask)
+        return i + __builtin_ctz(mask);
+    }
+  return i + _find_safe_ascii_run_scalar(raw + i, raw_len - i, unsafe_flags);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i
+_avx2_needs_attention(__m256i chunk, __m256i controls, __m256i backslashes, __m256i quotes, __m256i apostrophes)
+{
+  return _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi8(controls, chunk), _mm256_cmpeq_epi8(chunk, backslashes)),
+                         _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quotes), _mm256_cmpeq_epi8(chunk, apostrophes)));
+}
+
+__attribute__((target("avx2")))
+static gsize
+_find_safe_ascii_run_avx2(const gchar *raw, gsize raw_len, guint32 unsafe_flags)
+{
+  const __m256i controls = _mm256_set1_epi8(0x20);
+  const __m256i backslashes = _mm256_set1_epi8('\\');
+  const __m256i quotes = _mm256_set1_epi8(_quote_to_scan_for(unsafe_flags, AUTF8_UNSAFE_QUOTE, '"'));
+  const __m256i apostrophes = _mm256_set1_epi8(_quote_to_scan_for(unsafe_flags, AUTF8_UNSAFE_APOSTROPHE, '\''));
+  gsize i = 0;
+
+  for (; i + sizeof(__m256i) <= raw_len; i += sizeof(__m256i))
+    {
+      __m256i chunk = _mm256_loadu_si256((const __m256i *) (raw + i));
+      guint32 mask = (guint32) _mm256_movemask_epi8(_avx2_needs_attention(chunk, controls, backslashes, quotes,
+                                                    apostrophes));
+
+      if (mask)
+        return i + __builtin_ctz(mask);
+    }
+  return i + _find_safe_ascii_run_sse2(raw + i, raw_len - i, unsafe_flags);
+}
+
+static gboolean
+_cpu_supports_avx2(void)
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+static UTF8EscapeScanKernel escape_scan_kernel;
+
+static UTF8EscapeKernelType
+_detect_kernel(void)
+{
+#if UTF8_X86_SIMD
+  if (_cpu_supports_avx2())
+    return UTF8_ESCAPE_KERNEL_AVX2;
+  return UTF8_ESCAPE_KERNEL_SSE2;
+#else
+  return UTF8_ESCAPE_KERNEL_SCALAR;
+#endif
+}
+
+static gboolean
+_lookup_kernel(UTF8EscapeKernelType type, UTF8EscapeScanKernel *kernel)
+{
+  switch (type)
+    {
+    case UTF8_ESCAPE_KERNEL_SCALAR:
+      *kernel = _find_safe_ascii_run_scalar;
+      return TRUE;
+#if UTF8_X86_SIMD
+    case UTF8_ESCAPE_KERNEL_SSE2:
+      *kernel = _find_safe_ascii_run_sse2;
+      return TRUE;
+    case UTF8_ESCAPE_KERNEL_AVX2:
+      if (!_cpu_supports_avx2())
+        return FALSE;
+      *kernel = _find_safe_ascii_run_avx2;
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+    }
+}
+
+/*
+ * The scanning kernel is selected by the CPU features on first use,
+ * UTF8_ESCAPE_KERNEL_AUTO.  The unit tests override this to exercise all
+ * kernels available on the host.  Returns FALSE if the kernel is not
+ * available.
+ */
+gboolean
+utf8_escape_set_kernel(UTF8EscapeKernelType type)
+{
+  UTF8EscapeScanKernel selected;
+
+  if (type == UTF8_ESCAPE_KERNEL_AUTO)
+    type = _detect_kernel();
+
+  if (!_lookup_kernel(type, &selected))
+    return FALSE;
+
+  g_atomic_pointer_set(&escape_scan_kernel, selected);
+  return TRUE;
+}
+
+static inline UTF8EscapeScanKernel
+_get_scan_kernel(void)
+{
+  UTF8EscapeScanKernel kernel = g_atomic_pointer_get(&escape_scan_kernel);
+
+  if (G_UNLIKELY(!kernel))
+    {
+      utf8_escape_set_kernel(UTF8_ESCAPE_KERNEL_AUTO);
+      kernel = g_atomic_pointer_get(&escape_scan_kernel);
+    }
+  return kernel;
+}
+
+static inline gsize
+_find_safe_ascii_run(const gchar *raw, gsize raw_len, guint32 unsafe_flags)
+{
+  return _get_scan_kernel()(raw, raw_len, unsafe_flags);
+}
+
 static inline void
 _append_unsafe_utf8_as_escaped_with_specific_length(GString *escaped_output, const gchar *raw,
                                                     gsize raw_len,
@@ -166,8 +396,19 @@ _append_unsafe_utf8_as_escaped_with_specific_length(GString *escaped_output, con
   const gchar *raw_end = raw + raw_len;
 
   while (raw < raw_end)
-    _append_escaped_utf8_character(escaped_output, &raw, raw_end - raw, unsafe_flags,
-                                   control_format, invalid_format);
+    {
+      gsize safe_len = _find_safe_ascii_run(raw, raw_end - raw, unsafe_flags);
+
+      if (safe_len)
+        {
+          g_string_append_len(escaped_output, raw, safe_len);
+          raw += safe_len;
+          if (raw == raw_end)
+            break;
+        }
+      _append_escaped_utf8_character(escaped_output, &raw, raw_end - raw, unsafe_flags,
+                                     control_format, invalid_format);
+    }
 }
 
 static inline void
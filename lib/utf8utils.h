@@ -46,6 +46,17 @@ void append_unsafe_utf8_as_escaped(GString *escaped_output, const gchar *raw,
 
 gboolean unsafe_utf8_is_escaping_needed(const gchar *str, gssize str_len, guint32 unsafe_flags);
 
+typedef enum
+{
+  UTF8_ESCAPE_KERNEL_AUTO,
+  UTF8_ESCAPE_KERNEL_SCALAR,
+  UTF8_ESCAPE_KERNEL_SSE2,
+  UTF8_ESCAPE_KERNEL_AVX2,
+} UTF8EscapeKernelType;
+
+/* for the unit tests, the kernel is selected automatically otherwise */
+gboolean utf8_escape_set_kernel(UTF8EscapeKernelType type);
+
 /* for performance-critical use only */
 
 #define SANITIZE_UTF8_BUFFER_SIZE(l) (l * 6 + 1)
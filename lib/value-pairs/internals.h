@@ -27,6 +27,10 @@
 #include "syslog-ng.h"
 #include "atomic.h"
 
+/* include/exclude decisions of name-value pairs, cached per NVHandle */
+#define VP_HANDLE_DECISIONS_CHUNK_SIZE 4096
+#define VP_HANDLE_DECISIONS_MAX_CHUNKS 256
+
 struct _ValuePairs
 {
   GAtomicCounter ref_cnt;
@@ -42,6 +46,9 @@ struct _ValuePairs
   /* guint32 as CfgFlagHandler only supports 32 bit integers */
   guint32 scopes;
 
+  /* two bits per handle (known, included), chunks are allocated on demand */
+  guint *handle_decisions[VP_HANDLE_DECISIONS_MAX_CHUNKS];
+
   /* for compatibility with 3.x versions, apply automatic conversion to
    * strings to avoid leaking type information to callers */
   gboolean cast_to_strings;
@@ -509,6 +509,66 @@ Test(value_pairs, test_include_bytes_v3)
   value_pairs_unref(vp);
 }
 
+static gboolean
+_append_name(const gchar *name, LogMessageValueType type, const gchar *value,
+             gsize value_len, gpointer user_data)
+{
+  GString *names = (GString *) user_data;
+
+  cat_keys_foreach(name, names);
+  return FALSE;
+}
+
+static void
+assert_foreach_names(ValuePairs *vp, LogMessage *msg, gboolean sorted, const gchar *expected)
+{
+  LogTemplateEvalOptions options = {&template_options, LTZ_LOCAL, 11, NULL, LM_VT_STRING};
+  GString *names = g_string_new("");
+
+  if (sorted)
+    value_pairs_foreach(vp, _append_name, msg, &options, names);
+  else
+    value_pairs_foreach_unsorted(vp, _append_name, msg, &options, names);
+  cr_assert_str_eq(names->str, expected);
+  g_string_free(names, TRUE);
+}
+
+Test(value_pairs, test_handle_decisions_are_reused_and_invalidated)
+{
+  ValuePairs *vp = value_pairs_new(configuration);
+  value_pairs_add_scope(vp, "sdata");
+  value_pairs_add_glob_pattern(vp, ".SDATA.meta.*", FALSE);
+
+  for (gint i = 0; i < 2; i++)
+    {
+      LogMessage *msg = create_message();
+      assert_foreach_names(vp, msg, TRUE,
+                           ".SDATA.EventData@18372.4.Data,.SDATA.Keywords@18372.4.Keyword,.SDATA.origin.ip");
+      log_msg_unref(msg);
+    }
+
+  value_pairs_add_glob_pattern(vp, ".SDATA.meta.sysUpTime", TRUE);
+
+  LogMessage *msg = create_message();
+  assert_foreach_names(vp, msg, TRUE,
+                       ".SDATA.EventData@18372.4.Data,.SDATA.Keywords@18372.4.Keyword,"
+                       ".SDATA.meta.sysUpTime,.SDATA.origin.ip");
+  log_msg_unref(msg);
+  value_pairs_unref(vp);
+}
+
+Test(value_pairs, test_foreach_unsorted)
+{
+  ValuePairs *vp = value_pairs_new(configuration);
+  value_pairs_add_scope(vp, "rfc3164");
+
+  LogMessage *msg = create_message();
+  assert_foreach_names(vp, msg, TRUE, "DATE,FACILITY,HOST,MESSAGE,PID,PRIORITY,PROGRAM");
+  assert_foreach_names(vp, msg, FALSE, "FACILITY,PRIORITY,HOST,PROGRAM,PID,MESSAGE,DATE");
+  log_msg_unref(msg);
+  value_pairs_unref(vp);
+}
+
 void
 setup(void)
 {
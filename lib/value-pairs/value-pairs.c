@@ -188,18 +188,22 @@ vp_result_value_init(VPResultValue *rv, GString *name, LogMessageValueType type_
   rv->value = value;
 }
 
+/* without a compare_func, results are kept in the order they were inserted */
 static void
 vp_results_init(VPResults *results, GCompareFunc compare_func)
 {
   results->values = g_array_sized_new(FALSE, FALSE, sizeof(VPResultValue), 16);
-  results->result_tree = g_tree_new_full((GCompareDataFunc) compare_func, NULL,
-                                         NULL, NULL);
+  results->result_tree = NULL;
+  if (compare_func)
+    results->result_tree = g_tree_new_full((GCompareDataFunc) compare_func, NULL,
+                                           NULL, NULL);
 }
 
 static void
 vp_results_deinit(VPResults *results)
 {
-  g_tree_destroy(results->result_tree);
+  if (results->result_tree)
+    g_tree_destroy(results->result_tree);
   g_array_free(results->values, TRUE);
 }
 
@@ -213,7 +217,8 @@ vp_results_insert(VPResults *results, GString *name, LogMessageValueType type_hi
   rv = &g_array_index(results->values, VPResultValue, ndx);
   vp_result_value_init(rv, name, type_hint, value);
   /* GTree takes over ownership of name */
-  g_tree_insert(results->result_tree, name->str, GINT_TO_POINTER(ndx));
+  if (results->result_tree)
+    g_tree_insert(results->result_tree, name->str, GINT_TO_POINTER(ndx));
 }
 
 static GString *
@@ -260,6 +265,85 @@ vp_pairs_foreach(gpointer data, gpointer user_data)
   vp_results_insert(results, vp_transform_apply(vp, vpc->name), type, sb);
 }
 
+static gboolean
+vp_eval_nvpair_scope_and_patterns(ValuePairs *vp, NVHandle handle, const gchar *name)
+{
+  gboolean inc;
+  guint j;
+
+  inc = (name[0] == '.' && (vp->scopes & VPS_DOT_NV_PAIRS)) ||
+        (name[0] != '.' && (vp->scopes & VPS_NV_PAIRS)) ||
+        (log_msg_is_handle_sdata(handle) && (vp->scopes & (VPS_SDATA + VPS_RFC5424)));
+
+  for (j = 0; j < vp->patterns->len; j++)
+    {
+      VPPatternSpec *vps = (VPPatternSpec *) g_ptr_array_index(vp->patterns, j);
+      if (vp_pattern_spec_eval(vps, name))
+        inc = vps->include;
+    }
+
+  return inc;
+}
+
+/*
+ * The name behind an NVHandle never changes, neither do the scopes and
+ * patterns once the configuration is parsed, so the glob patterns are only
+ * evaluated the first time a handle is encountered.  The decisions are
+ * published without locking, threads racing on the same handle compute
+ * the same bits.
+ */
+#define VP_HANDLE_DECISIONS_PER_WORD (sizeof(guint) * 8 / 2)
+#define VP_HANDLE_DECISION_KNOWN     0x1
+#define VP_HANDLE_DECISION_INCLUDED  0x2
+
+static guint *
+vp_handle_decisions_get_chunk(ValuePairs *vp, guint chunk_ndx)
+{
+  guint *chunk = g_atomic_pointer_get(&vp->handle_decisions[chunk_ndx]);
+
+  if (chunk)
+    return chunk;
+
+  chunk = g_new0(guint, VP_HANDLE_DECISIONS_CHUNK_SIZE / VP_HANDLE_DECISIONS_PER_WORD);
+  if (!g_atomic_pointer_compare_and_exchange(&vp->handle_decisions[chunk_ndx], NULL, chunk))
+    {
+      g_free(chunk);
+      chunk = g_atomic_pointer_get(&vp->handle_decisions[chunk_ndx]);
+    }
+  return chunk;
+}
+
+static void
+vp_handle_decisions_clear(ValuePairs *vp)
+{
+  for (gint i = 0; i < VP_HANDLE_DECISIONS_MAX_CHUNKS; i++)
+    g_clear_pointer(&vp->handle_decisions[i], g_free);
+}
+
+static gboolean
+vp_is_nvpair_included(ValuePairs *vp, NVHandle handle, const gchar *name)
+{
+  guint chunk_ndx = handle / VP_HANDLE_DECISIONS_CHUNK_SIZE;
+
+  if (chunk_ndx >= VP_HANDLE_DECISIONS_MAX_CHUNKS)
+    return vp_eval_nvpair_scope_and_patterns(vp, handle, name);
+
+  guint *chunk = vp_handle_decisions_get_chunk(vp, chunk_ndx);
+  guint ofs = handle % VP_HANDLE_DECISIONS_CHUNK_SIZE;
+  guint *word = &chunk[ofs / VP_HANDLE_DECISIONS_PER_WORD];
+  guint shift = (ofs % VP_HANDLE_DECISIONS_PER_WORD) * 2;
+
+  guint decision = ((guint) g_atomic_int_get(word) >> shift) & 0x3;
+  if (decision & VP_HANDLE_DECISION_KNOWN)
+    return !!(decision & VP_HANDLE_DECISION_INCLUDED);
+
+  gboolean inc = vp_eval_nvpair_scope_and_patterns(vp, handle, name);
+
+  decision = VP_HANDLE_DECISION_KNOWN | (inc ? VP_HANDLE_DECISION_INCLUDED : 0);
+  g_atomic_int_or(word, decision << shift);
+  return inc;
+}
+
 /* runs over the LogMessage nv-pairs, and inserts them unless excluded */
 static gboolean
 vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
@@ -268,8 +352,6 @@ vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
 {
   ValuePairs *vp = ((gpointer *)user_data)[0];
   VPResults *results = ((gpointer *)user_data)[5];
-  guint j;
-  gboolean inc;
   GString *sb;
 
   if (vp->omit_empty_values && value_len == 0)
@@ -278,18 +360,7 @@ vp_msg_nvpairs_foreach(NVHandle handle, const gchar *name,
   if ((type == LM_VT_BYTES || type == LM_VT_PROTOBUF) && !vp->include_bytes)
     return FALSE;
 
-  inc = (name[0] == '.' && (vp->scopes & VPS_DOT_NV_PAIRS)) ||
-        (name[0] != '.' && (vp->scopes & VPS_NV_PAIRS)) ||
-        (log_msg_is_handle_sdata(handle) && (vp->scopes & (VPS_SDATA + VPS_RFC5424)));
-
-  for (j = 0; j < vp->patterns->len; j++)
-    {
-      VPPatternSpec *vps = (VPPatternSpec *) g_ptr_array_index(vp->patterns, j);
-      if (vp_pattern_spec_eval(vps, name))
-        inc = vps->include;
-    }
-
-  if (!inc)
+  if (!vp_is_nvpair_included(vp, handle, name))
     return FALSE;
 
   sb = scratch_buffers_alloc();
@@ -353,6 +424,7 @@ vp_merge_set(ValuePairs *vp, ValuePairSpec *set)
 static void
 vp_update_builtin_list_of_values(ValuePairs *vp)
 {
+  vp_handle_decisions_clear(vp);
   g_ptr_array_set_size(vp->builtins, 0);
 
   if (vp->patterns->len > 0)
@@ -470,13 +542,40 @@ value_pairs_foreach_sorted (ValuePairs *vp, VPForeachFunc func,
   g_ptr_array_foreach(vp->vpairs, (GFunc)vp_pairs_foreach, args);
 
   /* Aaand we run it through the callback! */
-  g_tree_foreach(results.result_tree, (GTraverseFunc)vp_foreach_helper, helper_args);
+  if (results.result_tree)
+    {
+      g_tree_foreach(results.result_tree, (GTraverseFunc)vp_foreach_helper, helper_args);
+    }
+  else
+    {
+      for (gint i = 0; i < results.values->len; i++)
+        {
+          VPResultValue *rv = &g_array_index(results.values, VPResultValue, i);
+
+          if (vp_foreach_helper(rv->name->str, GINT_TO_POINTER(i), helper_args))
+            break;
+        }
+    }
   vp_results_deinit(&results);
   scratch_buffers_reclaim_marked(mark);
 
   return result;
 }
 
+/*
+ * Skips sorting the results: name-value pairs are reported in the order
+ * they are stored in the message, followed by the macros and the
+ * explicitly added pairs.  A name may be reported more than once, the last
+ * occurrence is the one value_pairs_foreach() would report.
+ */
+gboolean
+value_pairs_foreach_unsorted(ValuePairs *vp, VPForeachFunc func,
+                             LogMessage *msg, LogTemplateEvalOptions *options,
+                             gpointer user_data)
+{
+  return value_pairs_foreach_sorted(vp, func, NULL, msg, options, user_data);
+}
+
 gboolean
 value_pairs_foreach(ValuePairs *vp, VPForeachFunc func,
                     LogMessage *msg, LogTemplateEvalOptions *options,
@@ -661,111 +760,107 @@ vp_walker_skip_sdata_enterprise_id(const gchar *name)
   return name;
 }
 
-static void
-_extract_token(vp_walk_state_t *state, const gchar *token_start, gsize token_len)
+static gboolean
+_extract_token(ValuePairsNameTokenizer *self, const gchar **token, gsize *token_len)
 {
-  g_ptr_array_add(state->tokens, g_strndup(token_start, token_len));
+  *token = self->token_start;
+  *token_len = self->token_end - self->token_start;
+
+  /* skip the delimiter and start a new token */
+  self->token_end++;
+  self->token_start = self->token_end;
+  return TRUE;
 }
 
-static void
-_start_new_token(vp_walk_state_t *state, const gchar **token_start, const gchar **token_end)
+static gboolean
+_extract_last_token(ValuePairsNameTokenizer *self, const gchar **token, gsize *token_len)
 {
-  ++(*token_end);
-  *token_start = *token_end;
+  if (self->token_start == self->token_end)
+    return FALSE;
+
+  *token = self->token_start;
+  *token_len = self->token_end - self->token_start;
+  self->token_start = self->token_end;
+  return TRUE;
 }
 
-static void
-_extract_and_find_next_token(vp_walk_state_t *state, const gchar **token_start_p, const gchar **token_end_p)
+static gboolean
+_next_token_with_default_delimiter(ValuePairsNameTokenizer *self, const gchar **token, gsize *token_len)
 {
-  const gchar *token_start = *token_start_p;
-  const gchar *token_end = *token_end_p;
-
-  switch (*token_end)
+  while (*self->token_end)
     {
-    case '@':
-      token_end = vp_walker_skip_sdata_enterprise_id(token_end);
-      break;
-    case '.':
-      if (token_start != token_end)
+      switch (*self->token_end)
         {
-          _extract_token(state, token_start, token_end - token_start);
-          _start_new_token(state, &token_start, &token_end);
+        case '@':
+          self->token_end = vp_walker_skip_sdata_enterprise_id(self->token_end);
+          break;
+        case '.':
+          if (self->token_start != self->token_end)
+            return _extract_token(self, token, token_len);
+        /* fall through, zero length token is not considered a separate token */
+        default:
+          self->token_end++;
+          self->token_end += strcspn(self->token_end, "@.");
           break;
         }
-    /* fall through, zero length token is not considered a separate token */
-    default:
-      token_end++;
-      token_end += strcspn(token_end, "@.");
-      break;
     }
-  *token_start_p = token_start;
-  *token_end_p = token_end;
+
+  return _extract_last_token(self, token, token_len);
 }
 
-static void
-_extract_and_find_next_token_with_custom_delimiter(vp_walk_state_t *state, const gchar **token_start_p,
-                                                   const gchar **token_end_p)
+static gboolean
+_next_token_with_custom_delimiter(ValuePairsNameTokenizer *self, const gchar **token, gsize *token_len)
 {
-  const gchar *token_start = *token_start_p;
-  const gchar *token_end = *token_end_p;
-
-  if (*token_end == state->key_delimiter && token_start != token_end)
-    {
-      _extract_token(state, token_start, token_end - token_start);
-      _start_new_token(state, &token_start, &token_end);
-    }
-  else
+  while (*self->token_end)
     {
-      const gchar *sep = strchr(token_end + 1, state->key_delimiter);
+      if (*self->token_end == self->key_delimiter && self->token_start != self->token_end)
+        return _extract_token(self, token, token_len);
+
+      const gchar *sep = strchr(self->token_end + 1, self->key_delimiter);
 
       /* position to end of the string if sep is unset */
       if (sep)
-        token_end = sep;
+        self->token_end = sep;
       else
-        token_end += strlen(token_end);
+        self->token_end += strlen(self->token_end);
     }
 
-  *token_start_p = token_start;
-  *token_end_p = token_end;
+  return _extract_last_token(self, token, token_len);
 }
 
-static void
-_extract_tokens_with_default_delimiter(vp_walk_state_t *state, const gchar *name)
+void
+value_pairs_name_tokenizer_init(ValuePairsNameTokenizer *self, const gchar *name, gchar key_delimiter)
 {
-  const gchar *token_start = name;
-  const gchar *token_end = name;
-
-  while (*token_end)
-    _extract_and_find_next_token(state, &token_start, &token_end);
-
-  /* extract last token at the end */
-  if (token_start != token_end)
-    _extract_token(state, token_start, token_end - token_start);
+  self->token_start = name;
+  self->token_end = name;
+  self->key_delimiter = key_delimiter ? : '.';
 }
 
-static void
-_extract_tokens_with_custom_delimiter(vp_walk_state_t *state, const gchar *name)
+/*
+ * Returns the next key token of the name, the same way value_pairs_walk()
+ * splits names into containers.  Tokens point into the original name and
+ * are not NUL terminated.
+ */
+gboolean
+value_pairs_name_tokenizer_next(ValuePairsNameTokenizer *self, const gchar **token, gsize *token_len)
 {
-  const gchar *token_start = name;
-  const gchar *token_end = name;
-
-  while (*token_end)
-    _extract_and_find_next_token_with_custom_delimiter(state, &token_start, &token_end);
-
-  /* extract last token at the end */
-  if (token_start != token_end)
-    _extract_token(state, token_start, token_end - token_start);
+  if (self->key_delimiter == '.')
+    return _next_token_with_default_delimiter(self, token, token_len);
+  return _next_token_with_custom_delimiter(self, token, token_len);
 }
 
 static GPtrArray *
 vp_walker_split_name_to_tokens(vp_walk_state_t *state, const gchar *name)
 {
+  ValuePairsNameTokenizer tokenizer;
+  const gchar *token;
+  gsize token_len;
+
   state->tokens = g_ptr_array_sized_new(VP_STACK_INITIAL_SIZE);
 
-  if (state->key_delimiter == '.')
-    _extract_tokens_with_default_delimiter(state, name);
-  else
-    _extract_tokens_with_custom_delimiter(state, name);
+  value_pairs_name_tokenizer_init(&tokenizer, name, state->key_delimiter);
+  while (value_pairs_name_tokenizer_next(&tokenizer, &token, &token_len))
+    g_ptr_array_add(state->tokens, g_strndup(token, token_len));
 
   if (state->tokens->len == 0)
     {
@@ -1045,6 +1140,7 @@ value_pairs_free (ValuePairs *vp)
     }
   g_ptr_array_free(vp->transforms, TRUE);
   g_ptr_array_free(vp->builtins, TRUE);
+  vp_handle_decisions_clear(vp);
   g_free(vp);
 }
 
@@ -65,6 +65,19 @@ gboolean value_pairs_foreach_sorted(ValuePairs *vp, VPForeachFunc func,
 gboolean value_pairs_foreach(ValuePairs *vp, VPForeachFunc func,
                              LogMessage *msg, LogTemplateEvalOptions *options,
                              gpointer user_data);
+gboolean value_pairs_foreach_unsorted(ValuePairs *vp, VPForeachFunc func,
+                                      LogMessage *msg, LogTemplateEvalOptions *options,
+                                      gpointer user_data);
+
+typedef struct _ValuePairsNameTokenizer
+{
+  const gchar *token_start;
+  const gchar *token_end;
+  gchar key_delimiter;
+} ValuePairsNameTokenizer;
+
+void value_pairs_name_tokenizer_init(ValuePairsNameTokenizer *self, const gchar *name, gchar key_delimiter);
+gboolean value_pairs_name_tokenizer_next(ValuePairsNameTokenizer *self, const gchar **token, gsize *token_len);
 
 gboolean value_pairs_walk(ValuePairs *vp,
                           VPWalkCallbackFunc obj_start_func,
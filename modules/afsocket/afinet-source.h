@@ -47,5 +47,6 @@ AFInetSourceDriver *afinet_sd_new_network(GlobalConfig *cfg);
 
 void afinet_sd_set_localport(LogDriver *self, gchar *service);
 void afinet_sd_set_localip(LogDriver *self, gchar *ip);
+void afinet_sd_set_recv_batch_size(LogDriver *self, gint recv_batch_size);
 
 #endif
@@ -75,12 +75,27 @@ transport_mapper_inet_apply_transport_method(TransportMapper *s, GlobalConfig *c
   return transport_mapper_inet_validate_tls_options(self);
 }
 
+static LogTransport *
+_construct_udp_socket_transport(TransportMapperInet *self, gint fd)
+{
+  LogTransport *transport = log_transport_udp_socket_new(fd);
+
+  if (!log_transport_udp_socket_set_recv_batch_size(transport, self->recv_batch_size))
+    {
+      /* the transport keeps using its single datagram read method */
+      msg_debug("Batched datagram receive is not available, reading one datagram per syscall",
+                evt_tag_int("fd", fd),
+                evt_tag_int("recv_batch_size", self->recv_batch_size));
+    }
+  return transport;
+}
+
 static gboolean
 _setup_socket_transport(TransportMapperInet *self, LogTransportStack *stack)
 {
   log_transport_stack_add_transport(stack, LOG_TRANSPORT_SOCKET,
                                     self->super.sock_type == SOCK_DGRAM
-                                    ? log_transport_udp_socket_new(stack->fd)
+                                    ? _construct_udp_socket_transport(self, stack->fd)
                                     : log_transport_stream_socket_new(stack->fd));
   return TRUE;
 }
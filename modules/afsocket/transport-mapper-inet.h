@@ -60,6 +60,9 @@ typedef struct _TransportMapperInet
   TLSContext *tls_context;
   TLSVerifier *tls_verifier;
   gpointer secret_store_cb_data;
+
+  /* number of datagrams to receive with a single recvmmsg() call */
+  gint recv_batch_size;
 } TransportMapperInet;
 
 static inline gint
@@ -88,6 +91,12 @@ transport_mapper_inet_set_tls_context(TransportMapperInet *self, TLSContext *tls
   self->tls_context = tls_context;
 }
 
+static inline void
+transport_mapper_inet_set_recv_batch_size(TransportMapperInet *self, gint recv_batch_size)
+{
+  self->recv_batch_size = recv_batch_size;
+}
+
 static inline void
 transport_mapper_inet_set_tls_verifier(TransportMapperInet *self, TLSVerifier *tls_verifier)
 {
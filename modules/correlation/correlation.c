@@ -26,43 +26,73 @@
 #include "timeutils/cache.h"
 #include "timeutils/misc.h"
 
+static inline CorrelationStateShard *
+_get_shard(CorrelationState *self, const CorrelationKey *key)
+{
+  if (self->num_shards == 1)
+    return &self->shards[0];
+
+  /* the hash tables of the shards use the low bits of the same hash, so
+   * mix it and pick the shard based on the high bits */
+  guint hash = correlation_key_hash(key) * 0x9E3779B1U;
+  return &self->shards[(hash >> 16) % self->num_shards];
+}
+
 void
 correlation_state_tx_begin(CorrelationState *self)
 {
-  g_mutex_lock(&self->lock);
+  for (gint i = 0; i < self->num_shards; i++)
+    g_mutex_lock(&self->shards[i].lock);
 }
 
 void
 correlation_state_tx_end(CorrelationState *self)
 {
-  g_mutex_unlock(&self->lock);
+  for (gint i = self->num_shards - 1; i >= 0; i--)
+    g_mutex_unlock(&self->shards[i].lock);
+}
+
+void
+correlation_state_tx_begin_for_key(CorrelationState *self, const CorrelationKey *key)
+{
+  g_mutex_lock(&_get_shard(self, key)->lock);
+}
+
+void
+correlation_state_tx_end_for_key(CorrelationState *self, const CorrelationKey *key)
+{
+  g_mutex_unlock(&_get_shard(self, key)->lock);
 }
 
 CorrelationContext *
 correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key)
 {
-  return g_hash_table_lookup(self->state, key);
+  return g_hash_table_lookup(_get_shard(self, key)->state, key);
 }
 
 void
 correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   g_assert(context->timer == NULL);
 
-  g_hash_table_insert(self->state, &context->key, context);
-  context->timer = timer_wheel_add_timer(self->timer_wheel, timeout, self->expire_callback,
+  g_hash_table_insert(shard->state, &context->key, context);
+  context->timer = timer_wheel_add_timer(shard->timer_wheel, timeout, self->expire_callback,
                                          correlation_context_ref(context), (GDestroyNotify) correlation_context_unref);
 }
 
 void
 correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context)
 {
+  CorrelationStateShard *shard = _get_shard(self, &context->key);
+
   /* NOTE: in expire callbacks our timer is already deleted and thus it is
    * set to NULL in which case we don't need to remove it again.  */
 
   if (context->timer)
-    timer_wheel_del_timer(self->timer_wheel, context->timer);
-  g_hash_table_remove(self->state, &context->key);
+    timer_wheel_del_timer(shard->timer_wheel, context->timer);
+  g_hash_table_remove(shard->state, &context->key);
 }
 
 void
@@ -70,26 +100,60 @@ correlation_state_tx_update_context(CorrelationState *self, CorrelationContext *
 {
   g_assert(context->timer != NULL);
 
-  timer_wheel_mod_timer(self->timer_wheel, context->timer, timeout);
+  timer_wheel_mod_timer(_get_shard(self, &context->key)->timer_wheel, context->timer, timeout);
+}
+
+/* NOTE: time_lock must be held.
+ *
+ * With multiple shards and timers pending, the wheels are moved forward
+ * one second at a time, so that every shard expires the contexts of a
+ * given second before any of them moves past it.  Without timers we jump
+ * to the new time right away.  */
+static void
+_advance_time(CorrelationState *self, guint64 new_now, gpointer caller_context)
+{
+  guint64 now = correlation_state_get_time(self);
+  gboolean timers_pending = TRUE;
+
+  while (now < new_now)
+    {
+      now = (timers_pending && self->num_shards > 1) ? now + 1 : new_now;
+      timers_pending = FALSE;
+
+      for (gint i = 0; i < self->num_shards; i++)
+        {
+          CorrelationStateShard *shard = &self->shards[i];
+
+          g_mutex_lock(&shard->lock);
+          timer_wheel_set_time(shard->timer_wheel, now, caller_context);
+          timers_pending |= timer_wheel_get_num_timers(shard->timer_wheel) > 0;
+          g_mutex_unlock(&shard->lock);
+        }
+      atomic_gssize_set(&self->now, now);
+    }
 }
 
 void
 correlation_state_expire_all(CorrelationState *self, gpointer caller_context)
 {
-  g_mutex_lock(&self->lock);
-  timer_wheel_expire_all(self->timer_wheel, caller_context);
-  g_mutex_unlock(&self->lock);
+  g_mutex_lock(&self->time_lock);
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_mutex_lock(&shard->lock);
+      timer_wheel_expire_all(shard->timer_wheel, caller_context);
+      g_mutex_unlock(&shard->lock);
+    }
+  g_mutex_unlock(&self->time_lock);
 }
 
 void
 correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer caller_context)
 {
-  guint64  new_time;
-
-  g_mutex_lock(&self->lock);
-  new_time = timer_wheel_get_time(self->timer_wheel) + timeout;
-  timer_wheel_set_time(self->timer_wheel, new_time, caller_context);
-  g_mutex_unlock(&self->lock);
+  g_mutex_lock(&self->time_lock);
+  _advance_time(self, correlation_state_get_time(self) + timeout, caller_context);
+  g_mutex_unlock(&self->time_lock);
 }
 
 void
@@ -108,15 +172,19 @@ correlation_state_set_time(CorrelationState *self, guint64 sec, gpointer caller_
   if (sec < now.tv_sec)
     now.tv_sec = sec;
 
-  g_mutex_lock(&self->lock);
-  timer_wheel_set_time(self->timer_wheel, now.tv_sec, caller_context);
-  g_mutex_unlock(&self->lock);
+  /* time moves once a second, most messages don't need the lock */
+  if (now.tv_sec <= correlation_state_get_time(self))
+    return;
+
+  g_mutex_lock(&self->time_lock);
+  _advance_time(self, now.tv_sec, caller_context);
+  g_mutex_unlock(&self->time_lock);
 }
 
 guint64
 correlation_state_get_time(CorrelationState *self)
 {
-  return timer_wheel_get_time(self->timer_wheel);
+  return atomic_gssize_get_unsigned(&self->now);
 }
 
 gboolean
@@ -126,7 +194,7 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
   gint64 diff;
   gboolean updated = FALSE;
 
-  g_mutex_lock(&self->lock);
+  g_mutex_lock(&self->time_lock);
   get_cached_realtime(&now);
   diff = timespec_diff_usec(&now, &self->last_tick);
 
@@ -134,7 +202,7 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
     {
       glong diff_sec = (glong)(diff / 1e6);
 
-      timer_wheel_set_time(self->timer_wheel, timer_wheel_get_time(self->timer_wheel) + diff_sec, caller_context);
+      _advance_time(self, correlation_state_get_time(self) + diff_sec, caller_context);
       /* update last_tick, take the fraction of the seconds not calculated into this update into account */
 
       self->last_tick = now;
@@ -149,20 +217,42 @@ correlation_state_timer_tick(CorrelationState *self, gpointer caller_context)
        */
       self->last_tick = now;
     }
-  g_mutex_unlock(&self->lock);
+  g_mutex_unlock(&self->time_lock);
   return updated;
 }
 
+/* expire callbacks find their owner through timer_wheel_get_associated_data() */
+void
+correlation_state_set_associated_data(CorrelationState *self, gpointer data, GDestroyNotify data_free)
+{
+  if (self->associated_data && self->associated_data_free)
+    self->associated_data_free(self->associated_data);
+
+  self->associated_data = data;
+  self->associated_data_free = data_free;
+  for (gint i = 0; i < self->num_shards; i++)
+    timer_wheel_set_associated_data(self->shards[i].timer_wheel, data, NULL);
+}
 
 CorrelationState *
-correlation_state_new(TWCallbackFunc expire_callback)
+correlation_state_new(TWCallbackFunc expire_callback, gint num_shards)
 {
   CorrelationState *self = g_new0(CorrelationState, 1);
 
-  g_mutex_init(&self->lock);
-  self->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
-                                      (GDestroyNotify) correlation_context_unref);
-  self->timer_wheel = timer_wheel_new();
+  g_assert(num_shards > 0);
+
+  g_mutex_init(&self->time_lock);
+  self->num_shards = num_shards;
+  self->shards = g_new0(CorrelationStateShard, num_shards);
+  for (gint i = 0; i < num_shards; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_mutex_init(&shard->lock);
+      shard->state = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
+                                           (GDestroyNotify) correlation_context_unref);
+      shard->timer_wheel = timer_wheel_new();
+    }
   get_cached_realtime(&self->last_tick);
   g_atomic_counter_set(&self->ref_cnt, 1);
   self->expire_callback = expire_callback;
@@ -172,10 +262,18 @@ correlation_state_new(TWCallbackFunc expire_callback)
 void
 _free(CorrelationState *self)
 {
-  if (self->state)
-    g_hash_table_destroy(self->state);
-  timer_wheel_free(self->timer_wheel);
-  g_mutex_clear(&self->lock);
+  for (gint i = 0; i < self->num_shards; i++)
+    {
+      CorrelationStateShard *shard = &self->shards[i];
+
+      g_hash_table_destroy(shard->state);
+      timer_wheel_free(shard->timer_wheel);
+      g_mutex_clear(&shard->lock);
+    }
+  g_free(self->shards);
+  if (self->associated_data && self->associated_data_free)
+    self->associated_data_free(self->associated_data);
+  g_mutex_clear(&self->time_lock);
   g_free(self);
 }
 
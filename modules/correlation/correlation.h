@@ -28,19 +28,43 @@
 #include "correlation-context.h"
 #include "timerwheel.h"
 #include "timeutils/unixtime.h"
+#include "atomic-gssize.h"
 
-typedef struct _CorrelationState
+/*
+ * Contexts are partitioned by correlation_key_hash() into independently
+ * locked shards, each with its own timer wheel.  The wheels are advanced
+ * together under time_lock, one second at a time whenever timers are
+ * pending, so contexts expire in the order of their expiration time, ties
+ * broken by shard index.
+ */
+typedef struct _CorrelationStateShard
 {
-  GAtomicCounter ref_cnt;
   GMutex lock;
   GHashTable *state;
   TimerWheel *timer_wheel;
-  TWCallbackFunc expire_callback;
+} CorrelationStateShard;
+
+typedef struct _CorrelationState
+{
+  GAtomicCounter ref_cnt;
+  GMutex time_lock;
+  atomic_gssize now;
   struct timespec last_tick;
+  TWCallbackFunc expire_callback;
+  gpointer associated_data;
+  GDestroyNotify associated_data_free;
+  gint num_shards;
+  CorrelationStateShard *shards;
 } CorrelationState;
 
+/* exclusive transaction over all shards */
 void correlation_state_tx_begin(CorrelationState *self);
 void correlation_state_tx_end(CorrelationState *self);
+
+/* transaction that only touches contexts with the same key */
+void correlation_state_tx_begin_for_key(CorrelationState *self, const CorrelationKey *key);
+void correlation_state_tx_end_for_key(CorrelationState *self, const CorrelationKey *key);
+
 CorrelationContext *correlation_state_tx_lookup_context(CorrelationState *self, const CorrelationKey *key);
 void correlation_state_tx_store_context(CorrelationState *self, CorrelationContext *context, gint timeout);
 void correlation_state_tx_remove_context(CorrelationState *self, CorrelationContext *context);
@@ -51,10 +75,11 @@ guint64 correlation_state_get_time(CorrelationState *self);
 gboolean correlation_state_timer_tick(CorrelationState *self, gpointer caller_context);
 void correlation_state_expire_all(CorrelationState *self, gpointer caller_context);
 void correlation_state_advance_time(CorrelationState *self, gint timeout, gpointer caller_context);
+void correlation_state_set_associated_data(CorrelationState *self, gpointer data, GDestroyNotify data_free);
 
 void correlation_state_init_instance(CorrelationState *self);
 void correlation_state_deinit_instance(CorrelationState *self);
-CorrelationState *correlation_state_new(TWCallbackFunc expire);
+CorrelationState *correlation_state_new(TWCallbackFunc expire, gint num_shards);
 CorrelationState *correlation_state_ref(CorrelationState *self);
 void correlation_state_unref(CorrelationState *self);
 
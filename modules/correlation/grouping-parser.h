@@ -82,7 +82,7 @@ void grouping_parser_set_timeout(LogParser *s, gint timeout);
 void grouping_parser_clone_settings(GroupingParser *self, GroupingParser *cloned);
 
 
-CorrelationContext *grouping_parser_lookup_or_create_context(GroupingParser *self, LogMessage *msg);
+CorrelationContext *grouping_parser_lookup_or_create_context(GroupingParser *self, const CorrelationKey *key);
 void grouping_parser_perform_grouping(GroupingParser *s, LogMessage *msg,
                                       StatefulParserEmittedMessages *emitted_mesages);
 
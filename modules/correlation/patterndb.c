@@ -657,8 +657,11 @@ _init_state(PatternDB *self)
 {
   self->rate_limits = g_hash_table_new_full(correlation_key_hash, correlation_key_equal, NULL,
                                             (GDestroyNotify) pdb_rate_limit_free);
-  self->correlation = correlation_state_new(pattern_db_expire_entry);
-  timer_wheel_set_associated_data(self->correlation->timer_wheel, self, NULL);
+  /* a single shard: rate limits and create-context actions (which may
+   * store a context with a different key) rely on the state being locked
+   * as a whole, see correlation_state_tx_begin() */
+  self->correlation = correlation_state_new(pattern_db_expire_entry, 1);
+  correlation_state_set_associated_data(self->correlation, self, NULL);
 }
 
 static void
@@ -89,6 +89,8 @@ stateful_parser_init_instance(StatefulParser *self, GlobalConfig *cfg)
 {
   log_parser_init_instance(&self->super, cfg);
   self->super.super.queue = _queue;
+  /* _queue() tracks the matched state per message, which the batched path doesn't do */
+  self->super.super.queue_batch = NULL;
   self->inject_mode = LDBP_IM_PASSTHROUGH;
 }
 
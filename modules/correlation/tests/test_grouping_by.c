@@ -152,6 +152,57 @@ Test(grouping_by, grouping_by_drops_original_messages_if_inject_mode_is_aggregat
   log_pipe_unref(&capture->super);
 }
 
+static void
+_process_msg_with_key_and_stamp(LogParser *parser, const gchar *key, time_t stamp)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  LogMessage *msg = log_msg_new_empty();
+  log_msg_set_value_by_name(msg, "key", key, -1);
+  msg->timestamps[LM_TS_STAMP].ut_sec = stamp;
+  log_pipe_queue(&parser->super, msg, &path_options);
+}
+
+Test(grouping_by, grouping_by_expires_contexts_in_order_across_shards)
+{
+  LogPipeMock *capture = log_pipe_mock_new(configuration);
+  LogParser *parser = _compile_grouping_by(
+                        "grouping-by(key(\"$key\")"
+                        "    aggregate("
+                        "        value(\"aggr\" \"$(context-values $key)\")"
+                        "    )"
+                        "    timeout(100)"
+                        "    inject-mode(aggregate-only)"
+                        ");");
+
+  log_pipe_append(&parser->super, &capture->super);
+  cr_assert(log_pipe_init(&capture->super) == TRUE);
+  cr_assert(log_pipe_init(&parser->super) == TRUE);
+
+  /* contexts with increasing expiration times, spread over all shards */
+  time_t base = time(NULL) - 10000;
+  gchar key[32];
+  for (gint i = 0; i < 64; i++)
+    {
+      g_snprintf(key, sizeof(key), "key%d", i);
+      _process_msg_with_key_and_stamp(parser, key, base + i);
+    }
+  cr_assert(capture->captured_messages->len == 0);
+
+  /* a single jump in time expires all of them */
+  _process_msg_with_key_and_stamp(parser, "last", base + 1000);
+
+  cr_assert(capture->captured_messages->len == 64);
+  for (gint i = 0; i < 64; i++)
+    {
+      g_snprintf(key, sizeof(key), "key%d", i);
+      assert_log_message_value_by_name(log_pipe_mock_get_message(capture, i), "aggr", key);
+    }
+
+  log_pipe_unref(&parser->super);
+  log_pipe_unref(&capture->super);
+}
+
 Test(grouping_by, cfg_persist_name_not_equal)
 {
   LogParser *parser = _compile_grouping_by("grouping-by(key(\"$TEMPLATE1\"));");
@@ -348,6 +348,12 @@ timer_wheel_get_time(TimerWheel *self)
   return self->now;
 }
 
+gint
+timer_wheel_get_num_timers(TimerWheel *self)
+{
+  return self->num_timers;
+}
+
 void
 timer_wheel_expire_all(TimerWheel *self, gpointer caller_context)
 {
@@ -38,6 +38,7 @@ guint64 timer_wheel_get_timer_expiration(TimerWheel *self, TWEntry *entry);
 
 void timer_wheel_set_time(TimerWheel *self, guint64 new_now, gpointer caller_context);
 guint64 timer_wheel_get_time(TimerWheel *self);
+gint timer_wheel_get_num_timers(TimerWheel *self);
 void timer_wheel_expire_all(TimerWheel *self, gpointer caller_context);
 void timer_wheel_set_associated_data(TimerWheel *self, gpointer assoc_data, GDestroyNotify assoc_data_free);
 gpointer timer_wheel_get_associated_data(TimerWheel *self);
@@ -26,6 +26,8 @@
 #include "messages.h"
 #include "reloc.h"
 
+#include <string.h>
+
 void
 disk_queue_options_front_cache_size_set(DiskQueueOptions *self, gint front_cache_size)
 {
@@ -83,11 +85,61 @@ disk_queue_options_set_prealloc(DiskQueueOptions *self, gboolean prealloc)
   self->prealloc = prealloc;
 }
 
+gboolean
+disk_queue_options_set_compression(DiskQueueOptions *self, const gchar *compression)
+{
+  QDiskCompression value;
+
+  if (!qdisk_compression_lookup(compression, &value))
+    return FALSE;
+
+  if (!qdisk_compression_is_supported(value))
+    {
+      msg_error("The requested disk-buffer compression is not supported by this build of syslog-ng",
+                evt_tag_str("compression", compression));
+      return FALSE;
+    }
+
+  self->compression = value;
+  return TRUE;
+}
+
+gboolean
+disk_queue_options_set_durability(DiskQueueOptions *self, const gchar *durability)
+{
+  if (strcmp(durability, "page-cache") == 0 || strcmp(durability, "page_cache") == 0)
+    self->durability = DQD_PAGE_CACHE;
+  else if (strcmp(durability, "group-commit") == 0 || strcmp(durability, "group_commit") == 0)
+    self->durability = DQD_GROUP_COMMIT;
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+void
+disk_queue_options_set_sync_interval(DiskQueueOptions *self, gint sync_interval)
+{
+  self->sync_interval = sync_interval;
+}
+
+void
+disk_queue_options_set_sync_batch_size(DiskQueueOptions *self, gint sync_batch_size)
+{
+  self->sync_batch_size = sync_batch_size;
+}
+
 void
 disk_queue_options_check_plugin_settings(DiskQueueOptions *self)
 {
   if (!self->reliable && self->flow_control_window_bytes > 0)
     msg_warning("WARNING: flow-control-window-bytes/mem-buf-size parameter was ignored as it is not compatible with non-reliable queue");
+
+  if (!self->reliable && self->durability == DQD_GROUP_COMMIT)
+    {
+      msg_warning("WARNING: durability(group-commit) was ignored as it is only supported by reliable disk-buffers");
+      self->durability = DQD_PAGE_CACHE;
+    }
 }
 
 gchar *
@@ -123,6 +175,10 @@ disk_queue_options_set_default_options(DiskQueueOptions *self)
   self->dir = g_strdup(get_installation_path_for(SYSLOG_NG_PATH_LOCALSTATEDIR));
   self->truncate_size_ratio = -1;
   self->prealloc = -1;
+  self->compression = QDISK_COMPRESSION_NONE;
+  self->durability = DQD_PAGE_CACHE;
+  self->sync_interval = 100;
+  self->sync_batch_size = 1000;
 }
 
 void
@@ -26,9 +26,16 @@
 
 #include "syslog-ng.h"
 #include "logmsg/logmsg-serialize.h"
+#include "qdisk-compression.h"
 
 #define MIN_CAPACITY_BYTES 1024*1024
 
+typedef enum
+{
+  DQD_PAGE_CACHE,
+  DQD_GROUP_COMMIT,
+} DiskQueueDurability;
+
 typedef struct _DiskQueueOptions
 {
   gint64 capacity_bytes;
@@ -40,6 +47,10 @@ typedef struct _DiskQueueOptions
   gchar *dir;
   gdouble truncate_size_ratio;
   gboolean prealloc;
+  QDiskCompression compression;
+  DiskQueueDurability durability;
+  gint sync_interval;
+  gint sync_batch_size;
 } DiskQueueOptions;
 
 void disk_queue_options_front_cache_size_set(DiskQueueOptions *self, gint front_cache_size);
@@ -52,6 +63,10 @@ void disk_queue_options_check_plugin_settings(DiskQueueOptions *self);
 void disk_queue_options_set_dir(DiskQueueOptions *self, const gchar *dir);
 void disk_queue_options_set_truncate_size_ratio(DiskQueueOptions *self, gdouble truncate_size_ratio);
 void disk_queue_options_set_prealloc(DiskQueueOptions *self, gboolean prealloc);
+gboolean disk_queue_options_set_compression(DiskQueueOptions *self, const gchar *compression);
+gboolean disk_queue_options_set_durability(DiskQueueOptions *self, const gchar *durability);
+void disk_queue_options_set_sync_interval(DiskQueueOptions *self, gint sync_interval);
+void disk_queue_options_set_sync_batch_size(DiskQueueOptions *self, gint sync_batch_size);
 void disk_queue_options_set_default_options(DiskQueueOptions *self);
 void disk_queue_options_destroy(DiskQueueOptions *self);
 
@@ -44,6 +44,10 @@ static CfgLexerKeyword diskq_keywords[] =
   { "dir",               KW_DIR },
   { "truncate_size_ratio", KW_TRUNCATE_SIZE_RATIO },
   { "prealloc",          KW_PREALLOC },
+  { "compression",       KW_COMPRESSION },
+  { "durability",        KW_DURABILITY },
+  { "sync_interval",     KW_SYNC_INTERVAL },
+  { "sync_batch_size",   KW_SYNC_BATCH_SIZE },
   { "stats",             KW_STATS },
   { "freq",              KW_FREQ },
   { NULL }
@@ -96,7 +96,13 @@ _log_internal_state(LogQueueDisk *self, const gchar *operation)
 static gboolean
 _start(LogQueueDisk *s)
 {
-  if(!qdisk_start(s->qdisk, NULL, NULL))
+  LogQueueDiskReliable *self = (LogQueueDiskReliable *) s;
+
+  g_mutex_lock(&self->sync.file_lock);
+  gboolean started = qdisk_start(s->qdisk, NULL, NULL);
+  g_mutex_unlock(&self->sync.file_lock);
+
+  if (!started)
     return FALSE;
 
   _log_internal_state(s, "load");
@@ -127,6 +133,211 @@ _empty_queue(LogQueueDiskReliable *self, GQueue *queue)
     }
 }
 
+static inline gint
+_get_pending_sync_count(LogQueueDiskReliable *self)
+{
+  return self->sync.pending->length / 2;
+}
+
+static gboolean
+_sync_qdisk(LogQueueDiskReliable *self, gint batch_size)
+{
+  g_mutex_lock(&self->sync.file_lock);
+  gint64 start = g_get_monotonic_time();
+  gboolean synced = qdisk_sync(self->super.qdisk);
+  gint64 elapsed = g_get_monotonic_time() - start;
+  g_mutex_unlock(&self->sync.file_lock);
+
+  if (synced && self->super.metrics.sync_latency)
+    {
+      stats_aggregator_add_data_point(self->super.metrics.sync_latency, elapsed / G_TIME_SPAN_MILLISECOND);
+      stats_aggregator_add_data_point(self->super.metrics.sync_batch_size, batch_size);
+    }
+
+  return synced;
+}
+
+static void
+_ack_synced_messages(GQueue *synced, AckType ack_type)
+{
+  while (!g_queue_is_empty(synced))
+    {
+      LogMessage *msg = g_queue_pop_head(synced);
+      LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+      POINTER_TO_LOG_PATH_OPTIONS(g_queue_pop_head(synced), &path_options);
+
+      log_msg_ack(msg, &path_options, ack_type);
+      log_msg_unref(msg);
+    }
+}
+
+static GQueue *
+_take_pending_sync_messages(LogQueueDiskReliable *self)
+{
+  GQueue *pending = self->sync.pending;
+  self->sync.pending = g_queue_new();
+  return pending;
+}
+
+/* puts back the messages of a failed sync in front of the ones written since */
+static void
+_return_pending_sync_messages(LogQueueDiskReliable *self, GQueue *pending)
+{
+  while (!g_queue_is_empty(pending))
+    g_queue_push_head(self->sync.pending, g_queue_pop_tail(pending));
+  g_queue_free(pending);
+}
+
+/*
+ * must be called with the queue lock held, the lock is released while syncing
+ *
+ * If the sync fails, the messages are left un-acked and the sync is retried
+ * after sync-interval(), until then their sources are held back by flow-control.
+ */
+static void
+_sync_pending_messages(LogQueueDiskReliable *self)
+{
+  LogQueue *s = &self->super.super;
+
+  if (g_queue_is_empty(self->sync.pending))
+    return;
+
+  gint batch_size = _get_pending_sync_count(self);
+  GQueue *pending = _take_pending_sync_messages(self);
+
+  g_mutex_unlock(&s->lock);
+  gboolean synced = _sync_qdisk(self, batch_size);
+  if (synced)
+    {
+      _ack_synced_messages(pending, AT_PROCESSED);
+      g_queue_free(pending);
+    }
+  g_mutex_lock(&s->lock);
+
+  self->sync.failed = !synced;
+  if (!synced)
+    {
+      msg_error("Disk-queue sync failed, messages are not acknowledged until a sync succeeds",
+                evt_tag_str("filename", qdisk_get_filename(self->super.qdisk)),
+                evt_tag_int("messages", batch_size),
+                evt_tag_int("retry_after_msec", self->sync.interval));
+      _return_pending_sync_messages(self, pending);
+      self->sync.deadline = g_get_monotonic_time() + self->sync.interval * G_TIME_SPAN_MILLISECOND;
+    }
+}
+
+/*
+ * used while stopping the queue, the queue lock is either held or the sync
+ * thread is already gone.  If the last sync fails, the messages are acked
+ * as aborted, so that their sources do not consider them delivered.
+ */
+static void
+_sync_pending_messages_on_stop(LogQueueDiskReliable *self)
+{
+  if (!self->sync.enabled || g_queue_is_empty(self->sync.pending))
+    return;
+
+  gint batch_size = _get_pending_sync_count(self);
+  GQueue *pending = _take_pending_sync_messages(self);
+
+  if (!_sync_qdisk(self, batch_size))
+    {
+      msg_error("Disk-queue sync failed while stopping, messages are acknowledged as not delivered",
+                evt_tag_str("filename", qdisk_get_filename(self->super.qdisk)),
+                evt_tag_int("messages", batch_size));
+      _ack_synced_messages(pending, AT_ABORTED);
+    }
+  else
+    {
+      _ack_synced_messages(pending, AT_PROCESSED);
+    }
+  g_queue_free(pending);
+}
+
+static gpointer
+_sync_thread_func(gpointer user_data)
+{
+  LogQueueDiskReliable *self = (LogQueueDiskReliable *) user_data;
+  LogQueue *s = &self->super.super;
+
+  g_mutex_lock(&s->lock);
+  while (!self->sync.exit_requested)
+    {
+      if (g_queue_is_empty(self->sync.pending))
+        {
+          g_cond_wait(&self->sync.cond, &s->lock);
+          continue;
+        }
+
+      gboolean batch_is_full = !self->sync.failed && _get_pending_sync_count(self) >= self->sync.batch_size;
+      if (!batch_is_full && g_get_monotonic_time() < self->sync.deadline)
+        {
+          g_cond_wait_until(&self->sync.cond, &s->lock, self->sync.deadline);
+          continue;
+        }
+
+      _sync_pending_messages(self);
+    }
+  _sync_pending_messages(self);
+  g_mutex_unlock(&s->lock);
+
+  return NULL;
+}
+
+static void
+_start_sync_thread(LogQueueDiskReliable *self)
+{
+  self->sync.pending = g_queue_new();
+  g_cond_init(&self->sync.cond);
+
+  if (!self->sync.enabled)
+    return;
+
+  self->sync.thread = g_thread_new("diskq-sync", _sync_thread_func, self);
+}
+
+static void
+_stop_sync_thread(LogQueueDiskReliable *self)
+{
+  LogQueue *s = &self->super.super;
+
+  if (!self->sync.thread)
+    return;
+
+  g_mutex_lock(&s->lock);
+  self->sync.exit_requested = TRUE;
+  g_cond_signal(&self->sync.cond);
+  g_mutex_unlock(&s->lock);
+
+  g_thread_join(self->sync.thread);
+  self->sync.thread = NULL;
+}
+
+/* must be called with the queue lock held, after the message has been written to the file */
+static void
+_ack_written_message(LogQueueDiskReliable *self, LogMessage *msg, const LogPathOptions *path_options)
+{
+  if (!self->sync.enabled || !path_options->ack_needed)
+    {
+      log_msg_ack(msg, path_options, AT_PROCESSED);
+      return;
+    }
+
+  g_queue_push_tail(self->sync.pending, log_msg_ref(msg));
+  g_queue_push_tail(self->sync.pending, LOG_PATH_OPTIONS_TO_POINTER(path_options));
+
+  gint pending_count = _get_pending_sync_count(self);
+  if (pending_count == 1)
+    {
+      self->sync.deadline = g_get_monotonic_time() + self->sync.interval * G_TIME_SPAN_MILLISECOND;
+      g_cond_signal(&self->sync.cond);
+    }
+  else if (pending_count >= self->sync.batch_size)
+    {
+      g_cond_signal(&self->sync.cond);
+    }
+}
+
 static gint64
 _get_length(LogQueue *s)
 {
@@ -423,13 +634,13 @@ _push_tail(LogQueue *s, LogMessage *msg, const LogPathOptions *path_options)
       goto exit;
     }
 
-  log_msg_ack(msg, path_options, AT_PROCESSED);
+  _ack_written_message(self, msg, path_options);
 
   if (_is_space_available_in_front_cache(self))
     {
       /*
        * Keep the message in memory for fast-path.
-       * Set its ack_needed to FALSE, because we have already acked it.
+       * Set its ack_needed to FALSE, because we have already acked it (or the sync will).
        */
       LogPathOptions local_path_options;
       log_path_options_chain(&local_path_options, path_options);
@@ -456,9 +667,16 @@ _free(LogQueue *s)
 {
   LogQueueDiskReliable *self = (LogQueueDiskReliable *)s;
 
+  _stop_sync_thread(self);
+
   gboolean persistent;
   log_queue_disk_stop(&self->super.super, &persistent);
 
+  g_assert(g_queue_is_empty(self->sync.pending));
+  g_queue_free(self->sync.pending);
+  g_cond_clear(&self->sync.cond);
+  g_mutex_clear(&self->sync.file_lock);
+
   if (self->flow_control_window)
     {
       g_assert(g_queue_is_empty(self->flow_control_window));
@@ -490,12 +708,17 @@ _stop(LogQueueDisk *s, gboolean *persistent)
 
   gboolean result = FALSE;
 
+  _sync_pending_messages_on_stop(self);
+
   _log_internal_state(s, "save");
+
+  g_mutex_lock(&self->sync.file_lock);
   if (qdisk_stop(s->qdisk, NULL, NULL))
     {
       *persistent = TRUE;
       result = TRUE;
     }
+  g_mutex_unlock(&self->sync.file_lock);
 
   _empty_queue(self, self->flow_control_window);
   _empty_queue(self, self->front_cache);
@@ -548,6 +771,13 @@ log_queue_disk_reliable_new(DiskQueueOptions *options, const gchar *filename, co
   self->backlog = g_queue_new();
   self->front_cache = g_queue_new();
   self->front_cache_size = options->front_cache_size;
+
+  g_mutex_init(&self->sync.file_lock);
+  self->sync.enabled = options->durability == DQD_GROUP_COMMIT;
+  self->sync.interval = options->sync_interval;
+  self->sync.batch_size = options->sync_batch_size;
+  _start_sync_thread(self);
+
   _set_virtual_functions(self);
   return &self->super.super;
 }
@@ -33,6 +33,23 @@ typedef struct _LogQueueDiskReliable
   GQueue *backlog;
   GQueue *front_cache;
   gint front_cache_size;
+
+  /* durability(group-commit): acks are held back until an fdatasync() covers the message */
+  struct
+  {
+    gboolean enabled;
+    gint interval;
+    gint batch_size;
+    GQueue *pending;
+    gint64 deadline;
+    GThread *thread;
+    GCond cond;
+    /* serializes qdisk_sync() with qdisk_start()/qdisk_stop() */
+    GMutex file_lock;
+    /* the last sync failed, the next one is attempted at the deadline */
+    gboolean failed;
+    gboolean exit_requested;
+  } sync;
 } LogQueueDiskReliable;
 
 LogQueue *log_queue_disk_reliable_new(DiskQueueOptions *options, const gchar *filename, const gchar *persist_name,
@@ -28,6 +28,8 @@
 #include "logmsg/logmsg-serialize.h"
 #include "stats/stats-registry.h"
 #include "stats/stats-cluster-single.h"
+#include "stats/aggregator/stats-aggregator-registry.h"
+#include "compat/pow2.h"
 #include "reloc.h"
 #include "qdisk.h"
 #include "scratch-buffers.h"
@@ -136,6 +138,17 @@ _unregister_counters(LogQueueDisk *self)
       }
   }
   stats_unlock();
+
+  if (self->metrics.sync_latency_key)
+    {
+      stats_aggregator_lock();
+      stats_unregister_aggregator(&self->metrics.sync_latency);
+      stats_unregister_aggregator(&self->metrics.sync_batch_size);
+      stats_aggregator_unlock();
+
+      stats_cluster_key_free(self->metrics.sync_latency_key);
+      stats_cluster_key_free(self->metrics.sync_batch_size_key);
+    }
 }
 
 void
@@ -375,7 +388,34 @@ log_queue_disk_restart_corrupted(LogQueueDisk *self)
 }
 
 static void
-_register_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder *builder)
+_register_sync_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder *builder)
+{
+  stats_cluster_key_builder_push(builder);
+  {
+    stats_cluster_key_builder_set_name(builder, "sync_latency_seconds");
+    stats_cluster_key_builder_set_unit(builder, SCU_MILLISECONDS);
+    self->metrics.sync_latency_key = stats_cluster_key_builder_build_hist(builder);
+  }
+  stats_cluster_key_builder_pop(builder);
+
+  stats_cluster_key_builder_push(builder);
+  {
+    stats_cluster_key_builder_set_name(builder, "sync_batch_size_events");
+    self->metrics.sync_batch_size_key = stats_cluster_key_builder_build_hist(builder);
+  }
+  stats_cluster_key_builder_pop(builder);
+
+  stats_aggregator_lock();
+  stats_register_aggregator_hist(stats_level, self->metrics.sync_latency_key, round_to_log2(1), 14,
+                                 &self->metrics.sync_latency);
+  stats_register_aggregator_hist(stats_level, self->metrics.sync_batch_size_key, round_to_log2(1), 16,
+                                 &self->metrics.sync_batch_size);
+  stats_aggregator_unlock();
+}
+
+static void
+_register_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder *builder,
+                   DiskQueueOptions *options)
 {
   if (!builder)
     return;
@@ -396,6 +436,9 @@ _register_counters(LogQueueDisk *self, gint stats_level, StatsClusterKeyBuilder
   }
   stats_cluster_key_builder_pop(builder);
 
+  if (options->reliable && options->durability == DQD_GROUP_COMMIT)
+    _register_sync_counters(self, stats_level, builder);
+
   stats_lock();
   {
     stats_register_counter(stats_level, self->metrics.capacity_sc_key, SC_TYPE_SINGLE_VALUE,
@@ -429,7 +472,7 @@ log_queue_disk_init_instance(LogQueueDisk *self, DiskQueueOptions *options, cons
   self->compaction = options->compaction;
 
   self->qdisk = qdisk_new(options, qdisk_file_id, filename);
-  _register_counters(self, stats_level, queue_sck_builder);
+  _register_counters(self, stats_level, queue_sck_builder, options);
 
   if (queue_sck_builder)
     stats_cluster_key_builder_pop(queue_sck_builder);
@@ -28,6 +28,7 @@
 #include "logqueue.h"
 #include "qdisk.h"
 #include "logmsg/logmsg-serialize.h"
+#include "stats/aggregator/stats-aggregator.h"
 
 typedef struct _LogQueueDisk LogQueueDisk;
 
@@ -50,6 +51,13 @@ struct _LogQueueDisk
     StatsCounterItem *capacity;
     StatsCounterItem *disk_usage;
     StatsCounterItem *disk_allocated;
+
+    /* only registered with durability(group-commit) */
+    StatsClusterKey *sync_latency_key;
+    StatsClusterKey *sync_batch_size_key;
+
+    StatsAggregator *sync_latency;
+    StatsAggregator *sync_batch_size;
   } metrics;
 
   gboolean compaction;
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "qdisk-compression.h"
+#include "messages.h"
+
+#include <string.h>
+
+#if SYSLOG_NG_HAVE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+#if SYSLOG_NG_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+/*
+ * Records are compressed one by one, so each of them has to carry its own
+ * statistics, which is expensive for the few hundred bytes of a typical
+ * message.  A dictionary built from the first records of the queue file
+ * provides the common parts (name-value pairs names, hosts, programs,
+ * message templates) to all of them.  zstd uses a trained dictionary,
+ * lz4 uses raw content, which is also accepted by zstd.
+ */
+struct _QDiskCodec
+{
+#if SYSLOG_NG_HAVE_ZSTD
+  ZSTD_CCtx *zstd_cctx;
+  ZSTD_DCtx *zstd_dctx;
+  ZSTD_CDict *zstd_cdict;
+  ZSTD_DDict *zstd_ddict;
+#endif
+#if SYSLOG_NG_HAVE_LZ4
+  LZ4_stream_t *lz4_stream;
+#endif
+  gchar *dictionary;
+  gsize dictionary_len;
+};
+
+static const gchar *compression_names[] =
+{
+  [QDISK_COMPRESSION_NONE] = "none",
+  [QDISK_COMPRESSION_ZSTD] = "zstd",
+  [QDISK_COMPRESSION_LZ4] = "lz4",
+};
+
+gboolean
+qdisk_compression_lookup(const gchar *name, QDiskCompression *compression)
+{
+  for (gsize i = 0; i < G_N_ELEMENTS(compression_names); i++)
+    {
+      if (strcmp(name, compression_names[i]) == 0)
+        {
+          *compression = i;
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+const gchar *
+qdisk_compression_format(QDiskCompression compression)
+{
+  if (compression >= G_N_ELEMENTS(compression_names))
+    return "unknown";
+
+  return compression_names[compression];
+}
+
+gboolean
+qdisk_compression_is_supported(QDiskCompression compression)
+{
+  switch (compression)
+    {
+    case QDISK_COMPRESSION_NONE:
+      return TRUE;
+#if SYSLOG_NG_HAVE_ZSTD
+    case QDISK_COMPRESSION_ZSTD:
+      return TRUE;
+#endif
+#if SYSLOG_NG_HAVE_LZ4
+    case QDISK_COMPRESSION_LZ4:
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+    }
+}
+
+#if SYSLOG_NG_HAVE_ZSTD
+
+static gboolean
+_zstd_compress(QDiskCodec *self, gboolean use_dictionary, const gchar *data, gsize data_len, GString *output)
+{
+  if (!self->zstd_cctx)
+    {
+      self->zstd_cctx = ZSTD_createCCtx();
+
+      /*
+       * the decompressed length is stored in the record header, whether the
+       * dictionary was used is stored in the record flags, don't repeat them
+       * in every frame
+       */
+      ZSTD_CCtx_setParameter(self->zstd_cctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+      ZSTD_CCtx_setParameter(self->zstd_cctx, ZSTD_c_contentSizeFlag, 0);
+      ZSTD_CCtx_setParameter(self->zstd_cctx, ZSTD_c_checksumFlag, 0);
+      ZSTD_CCtx_setParameter(self->zstd_cctx, ZSTD_c_dictIDFlag, 0);
+    }
+
+  ZSTD_CCtx_refCDict(self->zstd_cctx, use_dictionary ? self->zstd_cdict : NULL);
+
+  gsize output_start = output->len;
+  g_string_set_size(output, output_start + ZSTD_compressBound(data_len));
+
+  gsize result = ZSTD_compress2(self->zstd_cctx, output->str + output_start, output->len - output_start,
+                                data, data_len);
+  if (ZSTD_isError(result))
+    {
+      msg_error("Error compressing disk-queue record",
+                evt_tag_str("compression", "zstd"),
+                evt_tag_str("error", ZSTD_getErrorName(result)));
+      g_string_set_size(output, output_start);
+      return FALSE;
+    }
+
+  g_string_set_size(output, output_start + result);
+  return TRUE;
+}
+
+static gboolean
+_zstd_decompress(QDiskCodec *self, gboolean use_dictionary, const gchar *data, gsize data_len,
+                 gsize decompressed_len, GString *output)
+{
+  if (!self->zstd_dctx)
+    self->zstd_dctx = ZSTD_createDCtx();
+
+  g_string_set_size(output, decompressed_len);
+
+  gsize result;
+  if (use_dictionary)
+    result = ZSTD_decompress_usingDDict(self->zstd_dctx, output->str, decompressed_len, data, data_len,
+                                        self->zstd_ddict);
+  else
+    result = ZSTD_decompressDCtx(self->zstd_dctx, output->str, decompressed_len, data, data_len);
+
+  if (ZSTD_isError(result) || result != decompressed_len)
+    {
+      msg_error("Error decompressing disk-queue record",
+                evt_tag_str("compression", "zstd"),
+                evt_tag_str("error", ZSTD_isError(result) ? ZSTD_getErrorName(result) : "length mismatch"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gsize
+_zstd_train_dictionary(const gchar *samples, const gsize *sample_lens, guint num_samples,
+                       gchar *dictionary, gsize dictionary_capacity)
+{
+  gsize result = ZDICT_trainFromBuffer(dictionary, dictionary_capacity, samples,
+                                        (const size_t *) sample_lens, num_samples);
+
+  if (ZDICT_isError(result))
+    {
+      msg_debug("Could not train disk-queue compression dictionary, using the samples as they are",
+                evt_tag_str("error", ZDICT_getErrorName(result)));
+      return 0;
+    }
+
+  return result;
+}
+
+static void
+_zstd_set_dictionary(QDiskCodec *self)
+{
+  ZSTD_freeCDict(self->zstd_cdict);
+  ZSTD_freeDDict(self->zstd_ddict);
+  self->zstd_cdict = NULL;
+  self->zstd_ddict = NULL;
+
+  if (!self->dictionary)
+    return;
+
+  self->zstd_cdict = ZSTD_createCDict(self->dictionary, self->dictionary_len, ZSTD_CLEVEL_DEFAULT);
+  self->zstd_ddict = ZSTD_createDDict(self->dictionary, self->dictionary_len);
+}
+
+#endif
+
+#if SYSLOG_NG_HAVE_LZ4
+
+static gboolean
+_lz4_compress(QDiskCodec *self, gboolean use_dictionary, const gchar *data, gsize data_len, GString *output)
+{
+  gsize output_start = output->len;
+  g_string_set_size(output, output_start + LZ4_compressBound(data_len));
+
+  gint result;
+  if (use_dictionary)
+    {
+      if (!self->lz4_stream)
+        self->lz4_stream = LZ4_createStream();
+
+      LZ4_loadDict(self->lz4_stream, self->dictionary, self->dictionary_len);
+      result = LZ4_compress_fast_continue(self->lz4_stream, data, output->str + output_start, data_len,
+                                          output->len - output_start, 1);
+    }
+  else
+    {
+      result = LZ4_compress_default(data, output->str + output_start, data_len, output->len - output_start);
+    }
+
+  if (result <= 0)
+    {
+      msg_error("Error compressing disk-queue record",
+                evt_tag_str("compression", "lz4"));
+      g_string_set_size(output, output_start);
+      return FALSE;
+    }
+
+  g_string_set_size(output, output_start + result);
+  return TRUE;
+}
+
+static gboolean
+_lz4_decompress(QDiskCodec *self, gboolean use_dictionary, const gchar *data, gsize data_len,
+                gsize decompressed_len, GString *output)
+{
+  g_string_set_size(output, decompressed_len);
+
+  gint result;
+  if (use_dictionary)
+    result = LZ4_decompress_safe_usingDict(data, output->str, data_len, decompressed_len,
+                                           self->dictionary, self->dictionary_len);
+  else
+    result = LZ4_decompress_safe(data, output->str, data_len, decompressed_len);
+
+  if (result < 0 || result != decompressed_len)
+    {
+      msg_error("Error decompressing disk-queue record",
+                evt_tag_str("compression", "lz4"),
+                evt_tag_str("error", result < 0 ? "malformed input" : "length mismatch"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+#endif
+
+/* appends the compressed form of data to output */
+gboolean
+qdisk_codec_compress(QDiskCodec *self, QDiskCompression compression, gboolean use_dictionary,
+                     const gchar *data, gsize data_len, GString *output)
+{
+  if (use_dictionary && !self->dictionary)
+    return FALSE;
+
+  switch (compression)
+    {
+#if SYSLOG_NG_HAVE_ZSTD
+    case QDISK_COMPRESSION_ZSTD:
+      return _zstd_compress(self, use_dictionary, data, data_len, output);
+#endif
+#if SYSLOG_NG_HAVE_LZ4
+    case QDISK_COMPRESSION_LZ4:
+      return _lz4_compress(self, use_dictionary, data, data_len, output);
+#endif
+    default:
+      return FALSE;
+    }
+}
+
+/* replaces the content of output with the decompressed data */
+gboolean
+qdisk_codec_decompress(QDiskCodec *self, QDiskCompression compression, gboolean use_dictionary,
+                       const gchar *data, gsize data_len, gsize decompressed_len, GString *output)
+{
+  if (use_dictionary && !self->dictionary)
+    {
+      msg_error("Disk-queue record is compressed with a dictionary, but the file has none");
+      return FALSE;
+    }
+
+  switch (compression)
+    {
+#if SYSLOG_NG_HAVE_ZSTD
+    case QDISK_COMPRESSION_ZSTD:
+      return _zstd_decompress(self, use_dictionary, data, data_len, decompressed_len, output);
+#endif
+#if SYSLOG_NG_HAVE_LZ4
+    case QDISK_COMPRESSION_LZ4:
+      return _lz4_decompress(self, use_dictionary, data, data_len, decompressed_len, output);
+#endif
+    default:
+      msg_error("Disk-queue record is compressed with an unsupported algorithm",
+                evt_tag_str("compression", qdisk_compression_format(compression)));
+      return FALSE;
+    }
+}
+
+/*
+ * Builds a dictionary of at most dictionary_capacity bytes from the samples
+ * (sample_lens tells where each of them ends) and returns its length.  If
+ * the dictionary cannot be trained, the most recent samples are used as raw
+ * content.
+ */
+gsize
+qdisk_codec_train_dictionary(QDiskCompression compression, const gchar *samples, const gsize *sample_lens,
+                             guint num_samples, gchar *dictionary, gsize dictionary_capacity)
+{
+  gsize samples_len = 0;
+  for (guint i = 0; i < num_samples; i++)
+    samples_len += sample_lens[i];
+
+#if SYSLOG_NG_HAVE_ZSTD
+  if (compression == QDISK_COMPRESSION_ZSTD)
+    {
+      gsize dictionary_len = _zstd_train_dictionary(samples, sample_lens, num_samples, dictionary, dictionary_capacity);
+      if (dictionary_len > 0)
+        return dictionary_len;
+    }
+#endif
+
+  /* the end of the dictionary is the closest to the data, which is where the latest samples go */
+  gsize dictionary_len = MIN(samples_len, dictionary_capacity);
+  memcpy(dictionary, samples + samples_len - dictionary_len, dictionary_len);
+  return dictionary_len;
+}
+
+/* dictionary_len == 0 drops the current dictionary */
+void
+qdisk_codec_set_dictionary(QDiskCodec *self, const gchar *dictionary, gsize dictionary_len)
+{
+  g_free(self->dictionary);
+  self->dictionary = dictionary_len ? g_memdup2(dictionary, dictionary_len) : NULL;
+  self->dictionary_len = dictionary_len;
+
+#if SYSLOG_NG_HAVE_ZSTD
+  _zstd_set_dictionary(self);
+#endif
+}
+
+gboolean
+qdisk_codec_has_dictionary(QDiskCodec *self)
+{
+  return self->dictionary != NULL;
+}
+
+QDiskCodec *
+qdisk_codec_new(void)
+{
+  return g_new0(QDiskCodec, 1);
+}
+
+void
+qdisk_codec_free(QDiskCodec *self)
+{
+#if SYSLOG_NG_HAVE_ZSTD
+  ZSTD_freeCCtx(self->zstd_cctx);
+  ZSTD_freeDCtx(self->zstd_dctx);
+  ZSTD_freeCDict(self->zstd_cdict);
+  ZSTD_freeDDict(self->zstd_ddict);
+#endif
+#if SYSLOG_NG_HAVE_LZ4
+  LZ4_freeStream(self->lz4_stream);
+#endif
+  g_free(self->dictionary);
+  g_free(self);
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef QDISK_COMPRESSION_H_
+#define QDISK_COMPRESSION_H_
+
+#include "syslog-ng.h"
+
+/* the values are stored in the disk-buffer file, do not renumber them */
+typedef enum
+{
+  QDISK_COMPRESSION_NONE = 0,
+  QDISK_COMPRESSION_ZSTD = 1,
+  QDISK_COMPRESSION_LZ4 = 2,
+} QDiskCompression;
+
+typedef struct _QDiskCodec QDiskCodec;
+
+QDiskCodec *qdisk_codec_new(void);
+void qdisk_codec_free(QDiskCodec *self);
+
+gboolean qdisk_codec_compress(QDiskCodec *self, QDiskCompression compression, gboolean use_dictionary,
+                              const gchar *data, gsize data_len, GString *output);
+gboolean qdisk_codec_decompress(QDiskCodec *self, QDiskCompression compression, gboolean use_dictionary,
+                                const gchar *data, gsize data_len, gsize decompressed_len, GString *output);
+
+gsize qdisk_codec_train_dictionary(QDiskCompression compression, const gchar *samples, const gsize *sample_lens,
+                                   guint num_samples, gchar *dictionary, gsize dictionary_capacity);
+void qdisk_codec_set_dictionary(QDiskCodec *self, const gchar *dictionary, gsize dictionary_len);
+gboolean qdisk_codec_has_dictionary(QDiskCodec *self);
+
+gboolean qdisk_compression_lookup(const gchar *name, QDiskCompression *compression);
+const gchar *qdisk_compression_format(QDiskCompression compression);
+gboolean qdisk_compression_is_supported(QDiskCompression compression);
+
+#endif /* QDISK_COMPRESSION_H_ */
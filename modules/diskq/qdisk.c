@@ -22,6 +22,7 @@
  */
 
 #include "qdisk.h"
+#include "qdisk-compression.h"
 #include "logpipe.h"
 #include "messages.h"
 #include "serialize.h"
@@ -48,8 +49,45 @@
 #define MADV_RANDOM 1
 #endif
 
+#if !SYSLOG_NG_HAVE_FDATASYNC
+#define fdatasync fsync
+#endif
+
 #define MAX_RECORD_LENGTH 100 * 1024 * 1024
 
+/*
+ * Compressed records have the highest bit of their record-length set, the
+ * record itself is:
+ *
+ *   [u8 compression|flags][u32 BE decompressed length][compressed payload]
+ *
+ * Older versions reject such records as having an invalid record-length.
+ */
+#define QDISK_RECORD_COMPRESSED 0x80000000
+#define QDISK_RECORD_LENGTH_MASK (~QDISK_RECORD_COMPRESSED)
+#define QDISK_COMPRESSED_RECORD_HEADER_LEN (sizeof(guint8) + sizeof(guint32))
+
+/* the record was compressed using the dictionary in the file header */
+#define QDISK_RECORD_USES_DICTIONARY 0x80
+#define QDISK_RECORD_COMPRESSION_MASK 0x7F
+
+/*
+ * Records are compressed one by one: the reliable backlog acks and rewinds
+ * by record positions, so a record has to be readable on its own.  Records
+ * this short cannot win back the header and the frame overhead of the
+ * codec, they are stored as is without trying.
+ */
+#define QDISK_MIN_COMPRESSIBLE_RECORD_LEN 128
+
+/*
+ * To compress records as if they were compressed together, the first
+ * records written to the file are used to build a dictionary that is
+ * shared by all subsequent records.  It is stored in the file header and
+ * kept for the lifetime of the file, so records written with it remain
+ * readable after restarts and by dqtool.
+ */
+#define QDISK_COMPRESSION_DICT_TRAINING_LEN (16 * 1024)
+
 #define PATH_QDISK              PATH_LOCALSTATEDIR
 
 #define QDISK_HDR_VERSION_CURRENT 3
@@ -78,6 +116,11 @@ struct _QDisk
   gint64 cached_file_size;
   QDiskFileHeader *hdr;
   DiskQueueOptions *options;
+  QDiskCodec *codec;
+  GString *write_buffer;
+  GString *read_buffer;
+  GString *dict_samples;
+  GArray *dict_sample_lens;
 };
 
 #define QDISK_ERROR qdisk_error_quark()
@@ -664,12 +707,82 @@ qdisk_get_next_tail_position(QDisk *self)
   return self->hdr->write_head;
 }
 
+static void
+_drop_dictionary_samples(QDisk *self)
+{
+  g_string_truncate(self->dict_samples, 0);
+  g_array_set_size(self->dict_sample_lens, 0);
+}
+
+static void
+_collect_dictionary_sample(QDisk *self, const gchar *sample, gsize sample_len)
+{
+  g_string_append_len(self->dict_samples, sample, sample_len);
+  g_array_append_val(self->dict_sample_lens, sample_len);
+
+  if (self->dict_samples->len < QDISK_COMPRESSION_DICT_TRAINING_LEN)
+    return;
+
+  gsize dict_len = qdisk_codec_train_dictionary(self->options->compression, self->dict_samples->str,
+                                                (const gsize *) self->dict_sample_lens->data,
+                                                self->dict_sample_lens->len,
+                                                self->hdr->compression_dict, sizeof(self->hdr->compression_dict));
+  self->hdr->compression_dict_len = dict_len;
+  qdisk_codec_set_dictionary(self->codec, self->hdr->compression_dict, dict_len);
+  _drop_dictionary_samples(self);
+
+  msg_debug("Disk-queue compression dictionary built",
+            evt_tag_str("filename", self->filename),
+            evt_tag_str("compression", qdisk_compression_format(self->options->compression)),
+            evt_tag_long("dict_len", dict_len));
+}
+
+static GString *
+_compress_record(QDisk *self, GString *record)
+{
+  if (self->options->compression == QDISK_COMPRESSION_NONE)
+    return record;
+
+  const gchar *payload = record->str + sizeof(guint32);
+  gsize payload_len = record->len - sizeof(guint32);
+
+  if (payload_len < QDISK_MIN_COMPRESSIBLE_RECORD_LEN)
+    return record;
+
+  if (!qdisk_codec_has_dictionary(self->codec))
+    _collect_dictionary_sample(self, payload, payload_len);
+
+  gboolean use_dictionary = qdisk_codec_has_dictionary(self->codec);
+  guint8 compression = self->options->compression | (use_dictionary ? QDISK_RECORD_USES_DICTIONARY : 0);
+
+  g_string_set_size(self->write_buffer, sizeof(guint32));
+  g_string_append_c(self->write_buffer, (gchar) compression);
+
+  guint32 decompressed_len = GUINT32_TO_BE(payload_len);
+  g_string_append_len(self->write_buffer, (const gchar *) &decompressed_len, sizeof(decompressed_len));
+
+  if (!qdisk_codec_compress(self->codec, self->options->compression, use_dictionary, payload, payload_len,
+                            self->write_buffer))
+    return record;
+
+  /* not worth it, store the record as is */
+  if (self->write_buffer->len >= record->len)
+    return record;
+
+  guint32 record_length = GUINT32_TO_BE((self->write_buffer->len - sizeof(guint32)) | QDISK_RECORD_COMPRESSED);
+  memcpy(self->write_buffer->str, &record_length, sizeof(record_length));
+
+  return self->write_buffer;
+}
+
 gboolean
 qdisk_push_tail(QDisk *self, GString *record)
 {
   if (!qdisk_started(self))
     return FALSE;
 
+  record = _compress_record(self, record);
+
   if (_could_not_wrap_write_head_last_push_but_now_can(self))
     {
       /*
@@ -758,7 +871,7 @@ _read_record_length_from_disk(QDisk *self, gint64 position, guint32 *record_leng
 static inline gboolean
 _is_record_length_reached_hard_limit(guint32 record_length)
 {
-  return record_length > MAX_RECORD_LENGTH;
+  return (record_length & QDISK_RECORD_LENGTH_MASK) > MAX_RECORD_LENGTH;
 }
 
 static inline gssize
@@ -782,7 +895,7 @@ _is_record_length_valid(QDisk *self, gssize bytes_read, guint32 record_length, g
       return FALSE;
     }
 
-  if (record_length == 0)
+  if ((record_length & QDISK_RECORD_LENGTH_MASK) == 0)
     {
       msg_error("Disk-queue file contains empty record",
                 evt_tag_int("rec_length", record_length),
@@ -795,7 +908,7 @@ _is_record_length_valid(QDisk *self, gssize bytes_read, guint32 record_length, g
 }
 
 static inline gboolean
-_try_reading_record_length(QDisk *self, gint64 position, guint32 *record_length)
+_try_reading_record_length(QDisk *self, gint64 position, guint32 *record_length, gboolean *compressed)
 {
   guint32 read_record_length;
   gssize bytes_read = _read_record_length_from_disk(self, position, &read_record_length);
@@ -803,7 +916,9 @@ _try_reading_record_length(QDisk *self, gint64 position, guint32 *record_length)
   if (!_is_record_length_valid(self, bytes_read, read_record_length, position))
     return FALSE;
 
-  *record_length = read_record_length;
+  *record_length = read_record_length & QDISK_RECORD_LENGTH_MASK;
+  if (compressed)
+    *compressed = !!(read_record_length & QDISK_RECORD_COMPRESSED);
   return TRUE;
 }
 
@@ -826,6 +941,54 @@ _read_record_from_disk(QDisk *self, GString *record, guint32 record_length)
   return TRUE;
 }
 
+static gboolean
+_decompress_record(QDisk *self, GString *compressed_record, GString *record)
+{
+  if (compressed_record->len <= QDISK_COMPRESSED_RECORD_HEADER_LEN)
+    goto error;
+
+  guint8 flags = (guint8) compressed_record->str[0];
+  QDiskCompression compression = flags & QDISK_RECORD_COMPRESSION_MASK;
+  gboolean use_dictionary = !!(flags & QDISK_RECORD_USES_DICTIONARY);
+
+  guint32 decompressed_len;
+  memcpy(&decompressed_len, compressed_record->str + sizeof(guint8), sizeof(decompressed_len));
+  decompressed_len = GUINT32_FROM_BE(decompressed_len);
+
+  if (decompressed_len == 0 || _is_record_length_reached_hard_limit(decompressed_len))
+    goto error;
+
+  if (!qdisk_codec_decompress(self->codec, compression, use_dictionary,
+                              compressed_record->str + QDISK_COMPRESSED_RECORD_HEADER_LEN,
+                              compressed_record->len - QDISK_COMPRESSED_RECORD_HEADER_LEN,
+                              decompressed_len, record))
+    goto error;
+
+  return TRUE;
+
+error:
+  msg_error("Error reading disk-queue file, cannot decompress record",
+            evt_tag_str("filename", self->filename),
+            evt_tag_long("offset", self->hdr->read_head));
+  return FALSE;
+}
+
+static gboolean
+_read_record(QDisk *self, GString *record, guint32 *record_length)
+{
+  gboolean compressed;
+  if (!_try_reading_record_length(self, self->hdr->read_head, record_length, &compressed))
+    return FALSE;
+
+  if (!compressed)
+    return _read_record_from_disk(self, record, *record_length);
+
+  if (!_read_record_from_disk(self, self->read_buffer, *record_length))
+    return FALSE;
+
+  return _decompress_record(self, self->read_buffer, record);
+}
+
 static inline void
 _maybe_apply_non_reliable_corrections(QDisk *self)
 {
@@ -869,10 +1032,7 @@ qdisk_peek_head(QDisk *self, GString *record)
     self->hdr->read_head = _correct_position_if_max_size_is_reached(self, self->hdr->read_head);
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
-    return FALSE;
-
-  if (!_read_record_from_disk(self, record, record_length))
+  if (!_read_record(self, record, &record_length))
     return FALSE;
 
   return TRUE;
@@ -888,10 +1048,7 @@ qdisk_pop_head(QDisk *self, GString *record)
     self->hdr->read_head = _correct_position_if_max_size_is_reached(self, self->hdr->read_head);
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, self->hdr->read_head, &record_length))
-    return FALSE;
-
-  if (!_read_record_from_disk(self, record, record_length))
+  if (!_read_record(self, record, &record_length))
     return FALSE;
 
   _update_position_after_read(self, record_length, &self->hdr->read_head);
@@ -914,7 +1071,7 @@ _skip_record(QDisk *self, gint64 position, gint64 *new_position)
   *new_position = position;
 
   guint32 record_length;
-  if (!_try_reading_record_length(self, *new_position, &record_length))
+  if (!_try_reading_record_length(self, *new_position, &record_length, NULL))
     return FALSE;
 
   _update_position_after_read(self, record_length, new_position);
@@ -1304,6 +1461,9 @@ _close_file(QDisk *self)
     }
 
   self->cached_file_size = 0;
+
+  qdisk_codec_set_dictionary(self->codec, NULL, 0);
+  _drop_dictionary_samples(self);
 }
 
 static void
@@ -1327,6 +1487,7 @@ _ensure_header_byte_order(QDisk *self)
       self->hdr->backlog_head = GUINT64_SWAP_LE_BE(self->hdr->backlog_head);
       self->hdr->backlog_len = GUINT64_SWAP_LE_BE(self->hdr->backlog_len);
       self->hdr->capacity_bytes = GUINT64_SWAP_LE_BE(self->hdr->capacity_bytes);
+      self->hdr->compression_dict_len = GUINT16_SWAP_LE_BE(self->hdr->compression_dict_len);
       self->hdr->big_endian = (G_BYTE_ORDER == G_BIG_ENDIAN);
     }
 }
@@ -1479,6 +1640,15 @@ _load_header(QDisk *self)
       return FALSE;
     }
 
+  if (self->hdr->compression_dict_len > sizeof(self->hdr->compression_dict))
+    {
+      msg_error("Invalid compression dictionary length in disk-queue file header",
+                evt_tag_str("filename", self->filename),
+                evt_tag_int("dict_len", self->hdr->compression_dict_len));
+      return FALSE;
+    }
+  qdisk_codec_set_dictionary(self->codec, self->hdr->compression_dict, self->hdr->compression_dict_len);
+
   return TRUE;
 }
 
@@ -1801,10 +1971,36 @@ qdisk_is_read_only(QDisk *self)
   return self->options->read_only;
 }
 
+/*
+ * Makes the records written so far durable. The header is mapped with
+ * MAP_SHARED, its dirty page is written back along with the records.
+ */
+gboolean
+qdisk_sync(QDisk *self)
+{
+  if (!qdisk_started(self) || self->options->read_only)
+    return TRUE;
+
+  if (fdatasync(self->fd) < 0)
+    {
+      msg_error("Error syncing disk-queue file",
+                evt_tag_str("filename", self->filename),
+                evt_tag_error("error"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 void
 qdisk_free(QDisk *self)
 {
   self->options = NULL;
+  qdisk_codec_free(self->codec);
+  g_string_free(self->write_buffer, TRUE);
+  g_string_free(self->read_buffer, TRUE);
+  g_string_free(self->dict_samples, TRUE);
+  g_array_free(self->dict_sample_lens, TRUE);
   g_free(self->filename);
   g_free(self);
 }
@@ -1820,7 +2016,10 @@ qdisk_is_compatible(QDisk *self, DiskQueueOptions *options)
 {
   return (self->options->front_cache_size == options->front_cache_size &&
           self->options->reliable == options->reliable &&
-          self->options->flow_control_window_bytes == options->flow_control_window_bytes);
+          self->options->flow_control_window_bytes == options->flow_control_window_bytes &&
+          self->options->durability == options->durability &&
+          self->options->sync_interval == options->sync_interval &&
+          self->options->sync_batch_size == options->sync_batch_size);
 }
 
 QDisk *
@@ -1835,5 +2034,11 @@ qdisk_new(DiskQueueOptions *options, const gchar *file_id, const gchar *filename
   self->file_id = file_id;
   self->filename = g_strdup(filename);
 
+  self->codec = qdisk_codec_new();
+  self->write_buffer = g_string_sized_new(1024);
+  self->read_buffer = g_string_sized_new(1024);
+  self->dict_samples = g_string_new(NULL);
+  self->dict_sample_lens = g_array_new(FALSE, FALSE, sizeof(gsize));
+
   return self;
 }
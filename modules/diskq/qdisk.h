@@ -29,6 +29,9 @@
 
 #define QDISK_RESERVED_SPACE 4096
 
+/* the compression dictionary is stored in the otherwise unused part of the header */
+#define QDISK_COMPRESSION_DICT_MAX_LEN 3072
+
 typedef enum
 {
   QDISK_MQ_FRONT_CACHE,
@@ -64,6 +67,9 @@ typedef union _QDiskFileHeader
 
     guint8 use_v1_wrap_condition;
     gint64 capacity_bytes;
+
+    guint16 compression_dict_len;
+    gchar compression_dict[QDISK_COMPRESSION_DICT_MAX_LEN];
   };
   gchar _pad2[QDISK_RESERVED_SPACE];
 } QDiskFileHeader;
@@ -95,6 +101,7 @@ gboolean qdisk_unload_hdr(QDisk *self);
 gboolean qdisk_start(QDisk *self, QDiskMemQLoadFunc func, gpointer user_data);
 gboolean qdisk_stop(QDisk *self, QDiskMemQSaveFunc func, gpointer user_data);
 void qdisk_reset_file_if_empty(QDisk *self);
+gboolean qdisk_sync(QDisk *self);
 gboolean qdisk_started(QDisk *self);
 void qdisk_free(QDisk *self);
 void qdisk_set_options(QDisk *self, DiskQueueOptions *options);
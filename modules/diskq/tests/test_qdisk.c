@@ -27,6 +27,8 @@
 #include "apphook.h"
 #include "qdisk.h"
 #include "scratch-buffers.h"
+#include "logmsg/logmsg.h"
+#include "logmsg/logmsg-serialize.h"
 
 #include <unistd.h>
 #include <sys/stat.h>
@@ -261,6 +263,248 @@ Test(qdisk, qdisk_basic_ack_rewind)
   cleanup_qdisk(filename, qdisk);
 }
 
+static void
+assert_compressed_push_pop_ack_rewind(QDiskCompression compression)
+{
+  if (!qdisk_compression_is_supported(compression))
+    cr_skip_test("compression(%s) is not supported by this build", qdisk_compression_format(compression));
+
+  const gchar *filename = "test_qdisk_compressed_push_pop.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  cr_assert(disk_queue_options_set_compression(qdisk_get_options(qdisk), qdisk_compression_format(compression)));
+  qdisk_start(qdisk, NULL, NULL);
+
+  guint record_len = 4096;
+  gsize num_of_records = 10;
+
+  for (gsize i = 0; i < num_of_records; ++i)
+    cr_assert(push_dummy_record(qdisk, record_len));
+
+  cr_assert_lt(qdisk_get_writer_head(qdisk) - QDISK_RESERVED_SPACE, num_of_records * (record_len + FRAME_LENGTH),
+               "Records should have been stored compressed");
+
+  GString *popped_data = g_string_new(NULL);
+  for (gsize i = 0; i < num_of_records; ++i)
+    {
+      cr_assert(qdisk_pop_head(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len);
+    }
+  cr_assert_not(qdisk_pop_head(qdisk, popped_data));
+
+  cr_assert(qdisk_ack_backlog(qdisk));
+  cr_assert(qdisk_rewind_backlog(qdisk, num_of_records - 1));
+  cr_assert_eq(qdisk_get_length(qdisk), num_of_records - 1);
+
+  for (gsize i = 1; i < num_of_records; ++i)
+    {
+      cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+      assert_dummy_record(popped_data, record_len);
+    }
+  cr_assert_eq(qdisk_get_length(qdisk), 0);
+
+  g_string_free(popped_data, TRUE);
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+Test(qdisk, qdisk_compressed_push_pop_zstd)
+{
+  assert_compressed_push_pop_ack_rewind(QDISK_COMPRESSION_ZSTD);
+}
+
+Test(qdisk, qdisk_compressed_push_pop_lz4)
+{
+  assert_compressed_push_pop_ack_rewind(QDISK_COMPRESSION_LZ4);
+}
+
+Test(qdisk, qdisk_compressed_records_are_readable_without_compression_option)
+{
+  if (!qdisk_compression_is_supported(QDISK_COMPRESSION_ZSTD))
+    cr_skip_test("compression(zstd) is not supported by this build");
+
+  const gchar *filename = "test_qdisk_compressed_records_are_readable.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(1));
+  cr_assert(disk_queue_options_set_compression(qdisk_get_options(qdisk), "zstd"));
+  qdisk_start(qdisk, NULL, NULL);
+
+  cr_assert(push_dummy_record(qdisk, 4096));
+  disk_queue_options_set_compression(qdisk_get_options(qdisk), "none");
+  cr_assert(push_dummy_record(qdisk, 128));
+
+  GString *popped_data = g_string_new(NULL);
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, 4096);
+  cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+  assert_dummy_record(popped_data, 128);
+  g_string_free(popped_data, TRUE);
+
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+static LogMessage *
+create_realistic_message(gint seq)
+{
+  LogMessage *msg = log_msg_new_empty();
+  gchar buf[512];
+
+  g_snprintf(buf, sizeof(buf), "fw-edge-%02d.dc1.example.com", seq % 4);
+  log_msg_set_value(msg, LM_V_HOST, buf, -1);
+  log_msg_set_value(msg, LM_V_PROGRAM, "filterlog", -1);
+  g_snprintf(buf, sizeof(buf), "%d", 21000 + seq % 16);
+  log_msg_set_value(msg, LM_V_PID, buf, -1);
+  g_snprintf(buf, sizeof(buf),
+             "action=%s proto=tcp src=10.%d.%d.%d dst=192.168.%d.%d sport=%d dport=%d "
+             "rule=\"allow-outbound-web\" iface=eth%d bytes_sent=%d bytes_received=%d "
+             "session_id=%08x policy=\"default-corp-policy\" user=\"user%03d@example.com\"",
+             seq % 3 ? "accept" : "drop", seq % 7, seq % 13, seq % 251, seq % 5, seq % 97,
+             32768 + seq * 7 % 28000, seq % 2 ? 443 : 80, seq % 2, 512 + seq * 31 % 4096,
+             1024 + seq * 97 % 65536, 0x5eed0000 + seq, seq % 50);
+  log_msg_set_value(msg, LM_V_MESSAGE, buf, -1);
+  g_snprintf(buf, sizeof(buf), "%d", seq);
+  log_msg_set_value_by_name(msg, ".SDATA.meta.sequenceId", buf, -1);
+  return msg;
+}
+
+static void
+_string_free(GString *s)
+{
+  g_string_free(s, TRUE);
+}
+
+static gboolean
+serialize_message(SerializeArchive *sa, gpointer user_data)
+{
+  return log_msg_serialize((LogMessage *) user_data, sa, 0);
+}
+
+static gint64
+push_realistic_messages(QDiskCompression compression, gsize num_of_messages)
+{
+  const gchar *filename = "test_qdisk_compression_ratio.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(4));
+  cr_assert(disk_queue_options_set_compression(qdisk_get_options(qdisk), qdisk_compression_format(compression)));
+  qdisk_start(qdisk, NULL, NULL);
+
+  GString *data = g_string_new(NULL);
+  for (gsize i = 0; i < num_of_messages; ++i)
+    {
+      LogMessage *msg = create_realistic_message(i);
+      GError *error = NULL;
+
+      g_string_truncate(data, 0);
+      cr_assert(qdisk_serialize(data, serialize_message, msg, &error));
+      cr_assert(qdisk_push_tail(qdisk, data));
+      log_msg_unref(msg);
+    }
+
+  for (gsize i = 0; i < num_of_messages; ++i)
+    cr_assert(reliable_pop_record_without_backlog(qdisk, data));
+  g_string_free(data, TRUE);
+
+  gint64 stored_bytes = qdisk_get_writer_head(qdisk) - QDISK_RESERVED_SPACE;
+
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+  return stored_bytes;
+}
+
+static void
+assert_compression_ratio(QDiskCompression compression, gdouble max_ratio)
+{
+  if (!qdisk_compression_is_supported(compression))
+    cr_skip_test("compression(%s) is not supported by this build", qdisk_compression_format(compression));
+
+  const gsize num_of_messages = 500;
+  gint64 uncompressed_bytes = push_realistic_messages(QDISK_COMPRESSION_NONE, num_of_messages);
+  gint64 compressed_bytes = push_realistic_messages(compression, num_of_messages);
+  gdouble ratio = (gdouble) compressed_bytes / uncompressed_bytes;
+
+  cr_log_info("compression(%s) stored %" G_GINT64_FORMAT " bytes instead of %" G_GINT64_FORMAT ", ratio: %.3f",
+              qdisk_compression_format(compression), compressed_bytes, uncompressed_bytes, ratio);
+  cr_assert_leq(ratio, max_ratio, "compression(%s) ratio %.3f is above %.3f on realistic messages",
+                qdisk_compression_format(compression), ratio, max_ratio);
+}
+
+Test(qdisk, qdisk_compression_ratio_zstd)
+{
+  assert_compression_ratio(QDISK_COMPRESSION_ZSTD, 0.4);
+}
+
+Test(qdisk, qdisk_compression_ratio_lz4)
+{
+  assert_compression_ratio(QDISK_COMPRESSION_LZ4, 0.5);
+}
+
+static void
+assert_compression_dictionary_survives_restart(QDiskCompression compression)
+{
+  if (!qdisk_compression_is_supported(compression))
+    cr_skip_test("compression(%s) is not supported by this build", qdisk_compression_format(compression));
+
+  const gchar *filename = "test_qdisk_compression_dictionary_restart.rqf";
+  QDisk *qdisk = create_qdisk(TDISKQ_RELIABLE, filename, MiB(4));
+  cr_assert(disk_queue_options_set_compression(qdisk_get_options(qdisk), qdisk_compression_format(compression)));
+  qdisk_start(qdisk, NULL, NULL);
+
+  /* enough messages for the dictionary to be built while pushing them */
+  const gsize num_of_messages = 100;
+  GPtrArray *pushed = g_ptr_array_new_with_free_func((GDestroyNotify) _string_free);
+  for (gsize i = 0; i < num_of_messages; ++i)
+    {
+      LogMessage *msg = create_realistic_message(i);
+      GString *data = g_string_new(NULL);
+      GError *error = NULL;
+
+      cr_assert(qdisk_serialize(data, serialize_message, msg, &error));
+      cr_assert(qdisk_push_tail(qdisk, data));
+      g_ptr_array_add(pushed, data);
+      log_msg_unref(msg);
+    }
+
+  cr_assert(qdisk_stop(qdisk, NULL, NULL));
+  cr_assert(qdisk_start(qdisk, NULL, NULL));
+  cr_assert_eq(qdisk_get_length(qdisk), num_of_messages);
+
+  GString *popped_data = g_string_new(NULL);
+  for (gsize i = 0; i < num_of_messages; ++i)
+    {
+      GString *expected = g_ptr_array_index(pushed, i);
+
+      cr_assert(reliable_pop_record_without_backlog(qdisk, popped_data));
+      cr_assert_eq(popped_data->len, expected->len - sizeof(guint32), "record %" G_GSIZE_FORMAT " length mismatch", i);
+      cr_assert_arr_eq(popped_data->str, expected->str + sizeof(guint32), popped_data->len,
+                       "record %" G_GSIZE_FORMAT " content mismatch", i);
+    }
+
+  g_string_free(popped_data, TRUE);
+  g_ptr_array_free(pushed, TRUE);
+  qdisk_stop(qdisk, NULL, NULL);
+  cleanup_qdisk(filename, qdisk);
+}
+
+Test(qdisk, qdisk_compression_dictionary_survives_restart_zstd)
+{
+  assert_compression_dictionary_survives_restart(QDISK_COMPRESSION_ZSTD);
+}
+
+Test(qdisk, qdisk_compression_dictionary_survives_restart_lz4)
+{
+  assert_compression_dictionary_survives_restart(QDISK_COMPRESSION_LZ4);
+}
+
+Test(qdisk, qdisk_invalid_compression_option)
+{
+  DiskQueueOptions *opts = construct_diskq_options(TDISKQ_RELIABLE, MiB(1));
+
+  cr_assert_not(disk_queue_options_set_compression(opts, "gzip"));
+  cr_assert(disk_queue_options_set_compression(opts, "none"));
+  cr_assert_eq(opts->compression, QDISK_COMPRESSION_NONE);
+
+  disk_queue_options_destroy(opts);
+  g_free(opts);
+}
+
 Test(qdisk, qdisk_empty_backlog)
 {
   const gchar *filename = "test_qdisk_empty_backlog.rqf";
@@ -376,6 +376,97 @@ Test(diskq_reliable, test_rewind_backlog)
   _common_cleanup(dq, file_name);
 }
 
+static gint num_of_synced_acks;
+
+static void
+_counting_ack(LogMessage *lm, AckType ack_type)
+{
+  g_atomic_int_inc(&num_of_synced_acks);
+}
+
+static LogQueue *
+_init_group_commit_diskq_for_test(const gchar *filename, gint sync_interval, gint sync_batch_size)
+{
+  _construct_options(&options, MIN_CAPACITY_BYTES, 0, TRUE);
+  options.durability = DQD_GROUP_COMMIT;
+  options.sync_interval = sync_interval;
+  options.sync_batch_size = sync_batch_size;
+
+  num_of_synced_acks = 0;
+  unlink(filename);
+
+  LogQueue *q = log_queue_disk_reliable_new(&options, filename, NULL, STATS_LEVEL0, NULL, NULL);
+  cr_assert(log_queue_disk_start(q));
+  return q;
+}
+
+static void
+_push_message_with_ack(LogQueue *q)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+  LogMessage *msg = log_msg_new_mark();
+
+  msg->ack_func = _counting_ack;
+  log_msg_add_ack(msg, &path_options);
+  log_queue_push_tail(q, msg, &path_options);
+}
+
+static gint
+_wait_for_synced_acks(gint expected)
+{
+  for (gint i = 0; i < 5000 && g_atomic_int_get(&num_of_synced_acks) < expected; i++)
+    g_usleep(1000);
+
+  return g_atomic_int_get(&num_of_synced_acks);
+}
+
+Test(diskq_reliable, test_group_commit_acks_when_batch_is_full)
+{
+  const gchar *file_name = "test_group_commit_batch.rqf";
+  LogQueue *q = _init_group_commit_diskq_for_test(file_name, 3600 * 1000, 3);
+
+  _push_message_with_ack(q);
+  _push_message_with_ack(q);
+  g_usleep(20000);
+  cr_assert_eq(g_atomic_int_get(&num_of_synced_acks), 0, "Messages must not be acked before they are synced");
+
+  _push_message_with_ack(q);
+  cr_assert_eq(_wait_for_synced_acks(3), 3, "Messages must be acked once the sync batch is full");
+
+  log_queue_unref(q);
+  unlink(file_name);
+  disk_queue_options_destroy(&options);
+}
+
+Test(diskq_reliable, test_group_commit_acks_after_sync_interval)
+{
+  const gchar *file_name = "test_group_commit_interval.rqf";
+  LogQueue *q = _init_group_commit_diskq_for_test(file_name, 10, 1000);
+
+  _push_message_with_ack(q);
+  cr_assert_eq(_wait_for_synced_acks(1), 1, "Messages must be acked once the sync interval elapses");
+
+  log_queue_unref(q);
+  unlink(file_name);
+  disk_queue_options_destroy(&options);
+}
+
+Test(diskq_reliable, test_group_commit_acks_pending_messages_on_free)
+{
+  const gchar *file_name = "test_group_commit_free.rqf";
+  LogQueue *q = _init_group_commit_diskq_for_test(file_name, 3600 * 1000, 1000);
+
+  _push_message_with_ack(q);
+  _push_message_with_ack(q);
+  cr_assert_eq(g_atomic_int_get(&num_of_synced_acks), 0, "Messages must not be acked before they are synced");
+
+  log_queue_unref(q);
+  cr_assert_eq(g_atomic_int_get(&num_of_synced_acks), 2, "Pending messages must be synced and acked on shutdown");
+
+  unlink(file_name);
+  disk_queue_options_destroy(&options);
+}
+
 static void
 setup(void)
 {
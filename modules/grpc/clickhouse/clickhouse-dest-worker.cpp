@@ -248,15 +248,9 @@ DestWorker::prepare_batch()
 }
 
 LogThreadedResult
-DestWorker::flush(LogThreadedFlushMode mode)
+DestWorker::evaluate_query_result(const ::grpc::Status &status, const ::clickhouse::grpc::Result &query_result_,
+                                  size_t batch_bytes)
 {
-  if (this->batch_size == 0)
-    return LTR_SUCCESS;
-
-  this->prepare_query_info();
-
-  ::grpc::Status status = this->stub->ExecuteQuery(this->client_context.get(), *this->query_info, this->query_result);
-
   LogThreadedResult result;
   if (owner.handle_response(status, &result))
     {
@@ -269,9 +263,9 @@ DestWorker::flush(LogThreadedFlushMode mode)
   if (result != LTR_SUCCESS)
     goto error;
 
-  if (this->query_result->has_exception())
+  if (query_result_.has_exception())
     {
-      const ::clickhouse::grpc::Exception &exception = this->query_result->exception();
+      const ::clickhouse::grpc::Exception &exception = query_result_.exception();
       ErrorAction action = classify_clickhouse_error((ClickHouseErrorCode)exception.code());
       msg_error("ClickHouse server responded with an exception",
                 evt_tag_int("code", exception.code()),
@@ -283,13 +277,53 @@ DestWorker::flush(LogThreadedFlushMode mode)
     }
 
 success:
-  log_threaded_dest_worker_written_bytes_add(&this->super->super, this->current_batch_bytes);
-  log_threaded_dest_driver_insert_batch_length_stats(this->super->super.owner, this->current_batch_bytes);
+  log_threaded_dest_worker_written_bytes_add(&this->super->super, batch_bytes);
+  log_threaded_dest_driver_insert_batch_length_stats(this->super->super.owner, batch_bytes);
 
   msg_debug("ClickHouse batch delivered", log_pipe_location_tag(&this->super->super.owner->super.super.super));
 
 error:
   this->get_owner()->metrics.insert_grpc_request_stats(status);
+  return result;
+}
+
+void
+DestWorker::submit_batch(InflightBatch &batch, ::grpc::CompletionQueue *cq)
+{
+  if (this->batch_size == 0)
+    return;
+
+  this->prepare_query_info();
+
+  batch.add_call(std::move(this->client_context), this->query_result, this->current_batch_bytes, cq,
+                 [this](::grpc::ClientContext *context, ::grpc::CompletionQueue *cq_)
+  {
+    return this->stub->AsyncExecuteQuery(context, *this->query_info, cq_);
+  });
+}
+
+LogThreadedResult
+DestWorker::evaluate_call(InflightCall &call)
+{
+  return this->evaluate_query_result(call.status, *static_cast<::clickhouse::grpc::Result *>(call.response),
+                                     call.bytes);
+}
+
+LogThreadedResult
+DestWorker::flush(LogThreadedFlushMode mode)
+{
+  /* batch_size only covers the batch being assembled, not the ones in flight */
+  if (this->is_pipelining_enabled())
+    return this->flush_pipelined(mode);
+
+  if (this->batch_size == 0)
+    return LTR_SUCCESS;
+
+  this->prepare_query_info();
+
+  ::grpc::Status status = this->stub->ExecuteQuery(this->client_context.get(), *this->query_info, this->query_result);
+  LogThreadedResult result = this->evaluate_query_result(status, *this->query_result, this->current_batch_bytes);
+
   this->prepare_batch();
   return result;
 }
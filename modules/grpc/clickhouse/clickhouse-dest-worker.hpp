@@ -48,13 +48,23 @@ protected:
   bool init() override;
   void deinit() override;
 
+  bool supports_pipelining() override
+  {
+    return true;
+  }
+
+  void prepare_batch() override;
+  void submit_batch(InflightBatch &batch, ::grpc::CompletionQueue *cq) override;
+  LogThreadedResult evaluate_call(InflightCall &call) override;
+
 private:
   bool insert_query_data_from_protovar(LogMessage *msg);
   bool insert_query_data_from_jsonvar(LogMessage *msg);
   bool insert_query_data_from_schema(LogMessage *msg);
   bool should_initiate_flush();
   void prepare_query_info();
-  void prepare_batch();
+  LogThreadedResult evaluate_query_result(const ::grpc::Status &status, const ::clickhouse::grpc::Result &result,
+                                          size_t batch_bytes);
   DestDriver *get_owner();
 
 private:
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "grpc-dest-inflight.hpp"
+
+#include "compat/cpp-start.h"
+#include "syslog-ng.h"
+#include "compat/cpp-end.h"
+
+using namespace syslogng::grpc;
+
+InflightCall *
+InflightBatch::new_call(std::unique_ptr<::grpc::ClientContext> context, google::protobuf::Message *response,
+                        size_t bytes)
+{
+  std::unique_ptr<InflightCall> call = std::make_unique<InflightCall>();
+
+  if (!context)
+    context = std::make_unique<::grpc::ClientContext>();
+
+  call->batch = this;
+  call->context = std::move(context);
+  call->response = response;
+  call->bytes = bytes;
+
+  this->running_calls++;
+  this->calls.push_back(std::move(call));
+  return this->calls.back().get();
+}
+
+void
+InflightBatch::clear()
+{
+  g_assert(this->is_completed());
+
+  this->calls.clear();
+  this->batch_size = 0;
+}
+
+InflightWindow::InflightWindow(size_t max_batches_)
+  : max_batches(max_batches_)
+{
+}
+
+InflightWindow::~InflightWindow()
+{
+  this->cancel_all();
+  this->cq.Shutdown();
+
+  void *tag;
+  bool ok;
+  while (this->cq.Next(&tag, &ok))
+    ;
+}
+
+std::unique_ptr<InflightBatch>
+InflightWindow::acquire_batch()
+{
+  if (this->idle_batches.empty())
+    return std::make_unique<InflightBatch>();
+
+  std::unique_ptr<InflightBatch> batch = std::move(this->idle_batches.back());
+  this->idle_batches.pop_back();
+  return batch;
+}
+
+void
+InflightWindow::push(std::unique_ptr<InflightBatch> batch)
+{
+  this->running_calls += batch->running_calls;
+  this->batches.push_back(std::move(batch));
+}
+
+std::unique_ptr<InflightBatch>
+InflightWindow::pop_head()
+{
+  std::unique_ptr<InflightBatch> batch = std::move(this->batches.front());
+  this->batches.pop_front();
+  return batch;
+}
+
+void
+InflightWindow::recycle(std::unique_ptr<InflightBatch> batch)
+{
+  batch->clear();
+  this->idle_batches.push_back(std::move(batch));
+}
+
+bool
+InflightWindow::process_next_event(gpr_timespec deadline)
+{
+  void *tag;
+  bool ok;
+
+  if (this->cq.AsyncNext(&tag, &ok, deadline) != ::grpc::CompletionQueue::GOT_EVENT)
+    return false;
+
+  /* Finish() always reports ok, the outcome of the RPC is in the status */
+  InflightCall *call = static_cast<InflightCall *>(tag);
+  call->batch->running_calls--;
+  this->running_calls--;
+  return true;
+}
+
+void
+InflightWindow::poll()
+{
+  while (this->running_calls > 0 && this->process_next_event(gpr_time_0(GPR_CLOCK_MONOTONIC)))
+    ;
+}
+
+void
+InflightWindow::wait_for_any()
+{
+  if (this->running_calls > 0)
+    this->process_next_event(gpr_inf_future(GPR_CLOCK_MONOTONIC));
+  this->poll();
+}
+
+void
+InflightWindow::wait_for_head()
+{
+  InflightBatch *head = this->peek_head();
+
+  while (head && !head->is_completed())
+    this->process_next_event(gpr_inf_future(GPR_CLOCK_MONOTONIC));
+  this->poll();
+}
+
+void
+InflightWindow::wait_for_all()
+{
+  this->wait_for_all(gpr_inf_future(GPR_CLOCK_MONOTONIC));
+}
+
+/* returns false if there are calls still running at the deadline */
+bool
+InflightWindow::wait_for_all(gpr_timespec deadline)
+{
+  while (this->running_calls > 0)
+    {
+      if (!this->process_next_event(deadline))
+        return false;
+    }
+  return true;
+}
+
+/* the messages of the cancelled batches are left for LogThreadedDestWorker to rewind */
+void
+InflightWindow::cancel_all()
+{
+  for (auto &batch : this->batches)
+    {
+      for (auto &call : batch->calls)
+        call->context->TryCancel();
+    }
+
+  this->wait_for_all();
+
+  while (!this->batches.empty())
+    this->recycle(this->pop_head());
+}
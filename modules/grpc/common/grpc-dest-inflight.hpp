@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#ifndef GRPC_DEST_INFLIGHT_HPP
+#define GRPC_DEST_INFLIGHT_HPP
+
+#include <grpc/support/time.h>
+#include <grpcpp/client_context.h>
+#include <grpcpp/completion_queue.h>
+#include <grpcpp/support/async_unary_call.h>
+#include <grpcpp/support/status.h>
+#include <google/protobuf/message.h>
+
+#include "protobuf-arena.hpp"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace syslogng {
+namespace grpc {
+
+class InflightBatch;
+
+/* A single unary RPC of a pipelined batch, its address is the completion queue tag. */
+struct InflightCall
+{
+  InflightBatch *batch;
+  std::unique_ptr<::grpc::ClientContext> context;
+  /* ClientAsyncResponseReader<T>, it lives in the arena of the call, so it has to go before context */
+  std::shared_ptr<void> reader;
+  ::grpc::Status status;
+  google::protobuf::Message *response;
+  size_t bytes;
+};
+
+/*
+ * A batch that has been handed over to gRPC.  It owns the arena holding the
+ * request and response messages of its calls, the arena is reused by the
+ * worker once the batch is recycled.
+ */
+class InflightBatch
+{
+public:
+  template <typename Response, typename StartCall>
+  void add_call(std::unique_ptr<::grpc::ClientContext> context, Response *response, size_t bytes,
+                ::grpc::CompletionQueue *cq, StartCall start_call)
+  {
+    InflightCall *call = this->new_call(std::move(context), response, bytes);
+
+    std::unique_ptr<::grpc::ClientAsyncResponseReader<Response>> reader = start_call(call->context.get(), cq);
+    reader->Finish(response, &call->status, call);
+    call->reader = std::move(reader);
+  }
+
+  /* registers a call that is reported as completed when its address is returned by the completion queue */
+  InflightCall *new_call(std::unique_ptr<::grpc::ClientContext> context, google::protobuf::Message *response,
+                         size_t bytes);
+
+  bool is_completed() const
+  {
+    return this->running_calls == 0;
+  }
+
+  void clear();
+
+public:
+  SmartArena arena;
+  std::vector<std::unique_ptr<InflightCall>> calls;
+  size_t running_calls = 0;
+  int batch_size = 0;
+};
+
+/*
+ * The outstanding batches of a worker in submission order.  Calls may
+ * complete in any order, batches are retired from the head only.
+ */
+class InflightWindow
+{
+public:
+  InflightWindow(size_t max_batches);
+  ~InflightWindow();
+
+  ::grpc::CompletionQueue *get_completion_queue()
+  {
+    return &this->cq;
+  }
+
+  bool is_full() const
+  {
+    return this->batches.size() >= this->max_batches;
+  }
+
+  bool is_empty() const
+  {
+    return this->batches.empty();
+  }
+
+  InflightBatch *peek_head()
+  {
+    return this->batches.empty() ? nullptr : this->batches.front().get();
+  }
+
+  std::unique_ptr<InflightBatch> acquire_batch();
+  void push(std::unique_ptr<InflightBatch> batch);
+  std::unique_ptr<InflightBatch> pop_head();
+  void recycle(std::unique_ptr<InflightBatch> batch);
+
+  void poll();
+  void wait_for_any();
+  void wait_for_head();
+  void wait_for_all();
+  bool wait_for_all(gpr_timespec deadline);
+  void cancel_all();
+
+private:
+  bool process_next_event(gpr_timespec deadline);
+
+private:
+  ::grpc::CompletionQueue cq;
+  size_t max_batches;
+  size_t running_calls = 0;
+  std::deque<std::unique_ptr<InflightBatch>> batches;
+  std::vector<std::unique_ptr<InflightBatch>> idle_batches;
+};
+
+}
+}
+
+#endif
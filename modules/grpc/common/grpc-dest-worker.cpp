@@ -104,12 +104,22 @@ DestWorker::init()
   this->channel = this->create_channel();
   if (!this->channel)
     return false;
+
+  if (this->owner.get_max_inflight_requests() > 1 && this->supports_pipelining())
+    this->inflight = std::make_unique<InflightWindow>(this->owner.get_max_inflight_requests());
+
   return log_threaded_dest_worker_init_method(&super->super);
 }
 
 void
 DestWorker::deinit()
 {
+  if (this->inflight)
+    {
+      /* the final flush has drained the batches in flight */
+      g_assert(this->inflight->is_empty());
+      this->inflight.reset();
+    }
   this->channel.reset();
   log_threaded_dest_worker_deinit_method(&super->super);
 }
@@ -171,6 +181,177 @@ DestWorker::prepare_context_dynamic(::grpc::ClientContext &context, LogMessage *
   scratch_buffers_reclaim_marked(marker);
 }
 
+/* drops every batch in flight along with the batch being assembled, the
+ * whole batch_size is left for LogThreadedDestWorker to rewind */
+void
+DestWorker::abort_all_batches()
+{
+  this->inflight->cancel_all();
+  this->super->super.inflight_batch_size = 0;
+  this->prepare_batch();
+}
+
+LogThreadedResult
+DestWorker::process_completed_batches()
+{
+  LogThreadedDestWorker *s = &this->super->super;
+  InflightBatch *batch;
+
+  while ((batch = this->inflight->peek_head()) && batch->is_completed())
+    {
+      int batch_size = batch->batch_size;
+      LogThreadedResult result = LTR_SUCCESS;
+
+      /* every call is evaluated for the sake of the stats, the first failure decides */
+      for (auto &call : batch->calls)
+        {
+          LogThreadedResult call_result = this->evaluate_call(*call);
+          if (result == LTR_SUCCESS)
+            result = call_result;
+        }
+
+      this->inflight->recycle(this->inflight->pop_head());
+      s->inflight_batch_size -= batch_size;
+
+      if (result == LTR_SUCCESS)
+        {
+          log_threaded_dest_worker_ack_messages(s, batch_size);
+          continue;
+        }
+
+      /* the failed batch is at the head of the backlog, everything after
+       * it is rewound, the failed batch itself is handled by our caller
+       * using the result */
+      this->abort_all_batches();
+      int later_batches_size = s->batch_size - batch_size;
+      if (later_batches_size > 0)
+        log_threaded_dest_worker_rewind_messages(s, later_batches_size);
+      return result;
+    }
+
+  return LTR_EXPLICIT_ACK_MGMT;
+}
+
+int
+DestWorker::get_drain_timeout() const
+{
+  return this->owner.get_timeout() > 0 ? this->owner.get_timeout() : DRAIN_TIMEOUT_DEFAULT_SECONDS;
+}
+
+/*
+ * Used on reload and shutdown: the batches in flight are given timeout()
+ * seconds to complete, the ones that were delivered are acked, everything
+ * else (failed calls, calls still running at the deadline and the batch
+ * that was not submitted yet) is rewound.  As the backlog is acked in
+ * order, a batch delivered after one that was not is rewound as well.
+ */
+LogThreadedResult
+DestWorker::drain_inflight_batches()
+{
+  LogThreadedDestWorker *s = &this->super->super;
+  InflightBatch *batch;
+
+  this->prepare_batch();
+
+  gpr_timespec deadline = gpr_time_add(gpr_now(GPR_CLOCK_MONOTONIC),
+                                       gpr_time_from_seconds(this->get_drain_timeout(), GPR_TIMESPAN));
+  this->inflight->wait_for_all(deadline);
+
+  while ((batch = this->inflight->peek_head()) && batch->is_completed())
+    {
+      int batch_size = batch->batch_size;
+      bool delivered = true;
+
+      for (auto &call : batch->calls)
+        delivered = (this->evaluate_call(*call) == LTR_SUCCESS) && delivered;
+
+      if (!delivered)
+        break;
+
+      this->inflight->recycle(this->inflight->pop_head());
+      s->inflight_batch_size -= batch_size;
+      log_threaded_dest_worker_ack_messages(s, batch_size);
+    }
+
+  if (!this->inflight->is_empty())
+    {
+      msg_warning("Batches were not delivered while draining, they will be resent",
+                  evt_tag_int("worker_index", s->worker_index),
+                  evt_tag_int("batch_size", s->inflight_batch_size),
+                  log_pipe_location_tag((LogPipe *) s->owner));
+    }
+
+  this->inflight->cancel_all();
+  s->inflight_batch_size = 0;
+  if (s->batch_size > 0)
+    log_threaded_dest_worker_rewind_messages(s, s->batch_size);
+
+  return LTR_EXPLICIT_ACK_MGMT;
+}
+
+/*
+ * Hands the current batch over to gRPC and returns without waiting for the
+ * response, as long as there are less than max-inflight-requests() batches
+ * outstanding.  Batches are acked in order as they complete.
+ */
+LogThreadedResult
+DestWorker::flush_pipelined(LogThreadedFlushMode mode)
+{
+  LogThreadedDestWorker *s = &this->super->super;
+  LogThreadedResult result;
+
+  if (s->batch_size == 0)
+    return LTR_SUCCESS;
+
+  if (mode == LTF_FLUSH_EXPEDITE)
+    return this->drain_inflight_batches();
+
+  bool submitted = false;
+  if (log_threaded_dest_worker_get_current_batch_size(s) > 0)
+    {
+      /* completed batches also count until they are acked, so a slow
+       * batch at the head limits how far we get ahead of it */
+      while (this->inflight->is_full())
+        {
+          this->inflight->wait_for_head();
+          result = this->process_completed_batches();
+          if (result != LTR_EXPLICIT_ACK_MGMT)
+            return result;
+        }
+
+      std::unique_ptr<InflightBatch> batch = this->inflight->acquire_batch();
+      batch->batch_size = log_threaded_dest_worker_get_current_batch_size(s);
+
+      /* the batch takes over the arena of the current batch, the worker
+       * continues with the arena of a previously recycled batch */
+      std::swap(this->arena, batch->arena);
+      this->submit_batch(*batch, this->inflight->get_completion_queue());
+
+      s->inflight_batch_size += batch->batch_size;
+      this->inflight->push(std::move(batch));
+      this->prepare_batch();
+      submitted = true;
+    }
+
+  if (s->owner->under_termination)
+    {
+      /* we are shutting down, deliver everything we have */
+      return this->drain_inflight_batches();
+    }
+  else if (!submitted)
+    {
+      /* we were called to flush batches that are already in flight, wait
+       * for one of them instead of getting called again right away */
+      this->inflight->wait_for_any();
+    }
+  else
+    {
+      this->inflight->poll();
+    }
+
+  return this->process_completed_batches();
+}
+
 /* C Wrappers */
 
 static gboolean
@@ -29,6 +29,7 @@
 #include <grpcpp/create_channel.h>
 #include <grpcpp/security/credentials.h>
 #include "grpc-dest.hpp"
+#include "grpc-dest-inflight.hpp"
 #include "protobuf-arena.hpp"
 
 typedef struct GrpcDestWorker_ GrpcDestWorker;
@@ -56,12 +57,41 @@ protected:
   ::grpc::ChannelArguments create_channel_args();
   std::shared_ptr<::grpc::Channel>create_channel();
 
+  /* pipelining, see max-inflight-requests() */
+  virtual bool supports_pipelining()
+  {
+    return false;
+  }
+
+  bool is_pipelining_enabled() const
+  {
+    return this->inflight.get() != nullptr;
+  }
+
+  virtual void prepare_batch() {}
+  virtual void submit_batch(InflightBatch &batch, ::grpc::CompletionQueue *cq) {}
+  virtual LogThreadedResult evaluate_call(InflightCall &call)
+  {
+    return LTR_SUCCESS;
+  }
+  LogThreadedResult flush_pipelined(LogThreadedFlushMode mode);
+
+private:
+  LogThreadedResult process_completed_batches();
+  LogThreadedResult drain_inflight_batches();
+  void abort_all_batches();
+
+  int get_drain_timeout() const;
+
+  static const int DRAIN_TIMEOUT_DEFAULT_SECONDS = 10;
+
 protected:
   GrpcDestWorker *super;
   DestDriver &owner;
   bool connected;
   SmartArena arena;
   std::shared_ptr<::grpc::Channel> channel;
+  std::unique_ptr<InflightWindow> inflight;
 };
 
 }
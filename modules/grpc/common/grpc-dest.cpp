@@ -51,8 +51,8 @@ static const std::map<GrpcDestResponse, ::grpc::StatusCode> GRD_TO_GRPC_STATUSCO
 /* C++ Implementations */
 
 DestDriver::DestDriver(GrpcDestDriver *s)
-  : super(s), compression(false), batch_bytes(4 * 1000 * 1000),
-    keepalive_time(-1), keepalive_timeout(-1), keepalive_max_pings_without_data(-1),
+  : super(s), compression(false), batch_bytes(4 * 1000 * 1000), max_inflight_requests(1),
+    timeout(0), keepalive_time(-1), keepalive_timeout(-1), keepalive_max_pings_without_data(-1),
     flush_on_key_change(false), dynamic_headers_enabled(false),
     response_actions({ GDRA_UNSET })
 {
@@ -227,6 +227,20 @@ grpc_dd_set_batch_bytes(LogDriver *s, glong b)
   self->cpp->set_batch_bytes((size_t) b);
 }
 
+void
+grpc_dd_set_max_inflight_requests(LogDriver *s, gint m)
+{
+  GrpcDestDriver *self = (GrpcDestDriver *) s;
+  self->cpp->set_max_inflight_requests(m);
+}
+
+void
+grpc_dd_set_timeout(LogDriver *s, gint t)
+{
+  GrpcDestDriver *self = (GrpcDestDriver *) s;
+  self->cpp->set_timeout(t);
+}
+
 void
 grpc_dd_set_keepalive_time(LogDriver *s, gint t)
 {
@@ -67,6 +67,8 @@ typedef struct GrpcDestDriver_ GrpcDestDriver;
 void grpc_dd_set_url(LogDriver *s, const gchar *url);
 void grpc_dd_set_compression(LogDriver *s, gboolean enable);
 void grpc_dd_set_batch_bytes(LogDriver *s, glong b);
+void grpc_dd_set_max_inflight_requests(LogDriver *s, gint m);
+void grpc_dd_set_timeout(LogDriver *s, gint t);
 void grpc_dd_set_keepalive_time(LogDriver *s, gint t);
 void grpc_dd_set_keepalive_timeout(LogDriver *s, gint t);
 void grpc_dd_set_keepalive_max_pings(LogDriver *s, gint p);
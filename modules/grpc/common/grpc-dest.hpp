@@ -88,6 +88,26 @@ public:
     return this->batch_bytes;
   }
 
+  void set_max_inflight_requests(int m)
+  {
+    this->max_inflight_requests = m;
+  }
+
+  int get_max_inflight_requests() const
+  {
+    return this->max_inflight_requests;
+  }
+
+  void set_timeout(int t)
+  {
+    this->timeout = t;
+  }
+
+  int get_timeout() const
+  {
+    return this->timeout;
+  }
+
   void set_keepalive_time(int t)
   {
     this->keepalive_time = t;
@@ -221,6 +241,9 @@ protected:
 
   bool compression;
   size_t batch_bytes;
+  int max_inflight_requests;
+  /* seconds, bounds draining the requests in flight, 0 means the default */
+  int timeout;
 
   int keepalive_time;
   int keepalive_timeout;
@@ -41,6 +41,7 @@
   { "token_validity_duration",   KW_TOKEN_VALIDITY_DURATION }, \
   { "compression",               KW_COMPRESSION }, \
   { "batch_bytes",               KW_BATCH_BYTES }, \
+  { "max_inflight_requests",     KW_MAX_INFLIGHT_REQUESTS }, \
   { "channel_args",              KW_CHANNEL_ARGS }, \
   { "headers",                   KW_HEADERS }, \
   { "schema",                    KW_SCHEMA }, \
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include "grpc-dest-inflight.hpp"
+
+#include <grpcpp/alarm.h>
+
+#include "compat/cpp-start.h"
+#include "apphook.h"
+#include "compat/cpp-end.h"
+
+#include <criterion/criterion.h>
+
+using namespace syslogng::grpc;
+
+/* calls are completed by alarms posting their tag to the completion queue, as if Finish() was done */
+static std::vector<std::unique_ptr<::grpc::Alarm>> alarms;
+
+static InflightBatch *
+_submit_batch(InflightWindow &window, int batch_size, int num_calls, std::vector<InflightCall *> &calls)
+{
+  std::unique_ptr<InflightBatch> batch = window.acquire_batch();
+
+  batch->batch_size = batch_size;
+  for (int i = 0; i < num_calls; i++)
+    calls.push_back(batch->new_call(nullptr, nullptr, 0));
+
+  InflightBatch *result = batch.get();
+  window.push(std::move(batch));
+  return result;
+}
+
+static void
+_complete_call(InflightWindow &window, InflightCall *call, ::grpc::Status status)
+{
+  call->status = status;
+
+  std::unique_ptr<::grpc::Alarm> alarm = std::make_unique<::grpc::Alarm>();
+  alarm->Set(window.get_completion_queue(), gpr_now(GPR_CLOCK_MONOTONIC), call);
+  alarms.push_back(std::move(alarm));
+}
+
+static gpr_timespec
+_deadline_in_msec(int msec)
+{
+  return gpr_time_add(gpr_now(GPR_CLOCK_MONOTONIC), gpr_time_from_millis(msec, GPR_TIMESPAN));
+}
+
+Test(grpc_dest_inflight, batches_are_retired_in_submission_order_even_if_completed_out_of_order)
+{
+  InflightWindow window(3);
+  std::vector<InflightCall *> calls;
+
+  InflightBatch *first = _submit_batch(window, 10, 1, calls);
+  InflightBatch *second = _submit_batch(window, 20, 1, calls);
+  _submit_batch(window, 30, 1, calls);
+  cr_assert(window.is_full());
+
+  _complete_call(window, calls[1], ::grpc::Status::OK);
+  _complete_call(window, calls[2], ::grpc::Status::OK);
+  window.wait_for_any();
+  cr_assert(window.wait_for_all(_deadline_in_msec(100)) == false);
+
+  cr_assert_not(first->is_completed());
+  cr_assert(second->is_completed());
+  cr_assert_eq(window.peek_head(), first);
+
+  _complete_call(window, calls[0], ::grpc::Status::OK);
+  window.wait_for_head();
+  cr_assert(first->is_completed());
+
+  int batch_sizes[] = { 10, 20, 30 };
+  for (int expected_batch_size : batch_sizes)
+    {
+      std::unique_ptr<InflightBatch> batch = window.pop_head();
+      cr_assert_eq(batch->batch_size, expected_batch_size);
+      cr_assert(batch->is_completed());
+      window.recycle(std::move(batch));
+    }
+  cr_assert(window.is_empty());
+
+  /* recycled batches are reused, but start empty */
+  std::unique_ptr<InflightBatch> reused = window.acquire_batch();
+  cr_assert_eq(reused->calls.size(), 0);
+  cr_assert_eq(reused->batch_size, 0);
+}
+
+Test(grpc_dest_inflight, batch_is_completed_only_when_all_of_its_calls_completed)
+{
+  InflightWindow window(2);
+  std::vector<InflightCall *> calls;
+
+  InflightBatch *batch = _submit_batch(window, 10, 3, calls);
+
+  _complete_call(window, calls[0], ::grpc::Status::OK);
+  _complete_call(window, calls[2], ::grpc::Status(::grpc::StatusCode::UNAVAILABLE, "unavailable"));
+  cr_assert_not(window.wait_for_all(_deadline_in_msec(100)));
+  cr_assert_eq(batch->running_calls, 1);
+  cr_assert_not(batch->is_completed());
+
+  _complete_call(window, calls[1], ::grpc::Status::OK);
+  cr_assert(window.wait_for_all(_deadline_in_msec(1000)));
+  cr_assert(batch->is_completed());
+
+  /* the failed status is kept with its call for the worker to evaluate */
+  cr_assert(calls[0]->status.ok());
+  cr_assert(calls[1]->status.ok());
+  cr_assert_eq(calls[2]->status.error_code(), ::grpc::StatusCode::UNAVAILABLE);
+
+  window.recycle(window.pop_head());
+}
+
+Test(grpc_dest_inflight, draining_at_shutdown_stops_at_the_deadline)
+{
+  InflightWindow window(3);
+  std::vector<InflightCall *> calls;
+
+  InflightBatch *first = _submit_batch(window, 10, 1, calls);
+  InflightBatch *second = _submit_batch(window, 20, 1, calls);
+  InflightBatch *third = _submit_batch(window, 30, 1, calls);
+
+  _complete_call(window, calls[0], ::grpc::Status::OK);
+  _complete_call(window, calls[2], ::grpc::Status::OK);
+  cr_assert_not(window.wait_for_all(_deadline_in_msec(100)));
+
+  /* only the delivered prefix of the window may be acked */
+  cr_assert(first->is_completed());
+  cr_assert_not(second->is_completed());
+  cr_assert(third->is_completed());
+
+  window.recycle(window.pop_head());
+  cr_assert_eq(window.peek_head(), second);
+
+  _complete_call(window, calls[1], ::grpc::Status(::grpc::StatusCode::CANCELLED, "cancelled"));
+  window.cancel_all();
+  cr_assert(window.is_empty());
+}
+
+static void
+setup(void)
+{
+  app_startup();
+}
+
+static void
+teardown(void)
+{
+  alarms.clear();
+  app_shutdown();
+}
+
+TestSuite(grpc_dest_inflight, .init = setup, .fini = teardown);
@@ -208,23 +208,18 @@ DestinationWorker::insert(LogMessage *msg)
 }
 
 LogThreadedResult
-DestinationWorker::flush(LogThreadedFlushMode mode)
+DestinationWorker::evaluate_push_status(const ::grpc::Status &status, size_t batch_bytes)
 {
   DestinationDriver *owner_ = this->get_owner();
-
-  if (this->super->super.batch_size == 0)
-    return LTR_SUCCESS;
-
   LogThreadedResult result;
 
-  ::grpc::Status status = this->stub->Push(client_context.get(), *this->current_batch, this->response);
-  this->get_owner()->metrics.insert_grpc_request_stats(status);
+  owner_->metrics.insert_grpc_request_stats(status);
 
-  if (this->get_owner()->handle_response(status, &result))
+  if (owner_->handle_response(status, &result))
     {
       if (result == LTR_SUCCESS)
         goto success;
-      goto error;
+      return result;
     }
 
   if (!status.ok())
@@ -233,18 +228,45 @@ DestinationWorker::flush(LogThreadedFlushMode mode)
                 evt_tag_str("url", owner_->get_url().c_str()),
                 evt_tag_str("details", status.error_details().c_str()),
                 log_pipe_location_tag((LogPipe *) this->super->super.owner));
-      result = LTR_ERROR;
-      goto error;
+      return LTR_ERROR;
     }
 
 success:
-  log_threaded_dest_worker_written_bytes_add(&this->super->super, this->current_batch_bytes);
-  log_threaded_dest_driver_insert_batch_length_stats(this->super->super.owner, this->current_batch_bytes);
+  log_threaded_dest_worker_written_bytes_add(&this->super->super, batch_bytes);
+  log_threaded_dest_driver_insert_batch_length_stats(this->super->super.owner, batch_bytes);
 
   msg_debug("Loki batch delivered", log_pipe_location_tag((LogPipe *) this->super->super.owner));
-  result = LTR_SUCCESS;
+  return LTR_SUCCESS;
+}
+
+void
+DestinationWorker::submit_batch(InflightBatch &batch, ::grpc::CompletionQueue *cq)
+{
+  batch.add_call(std::move(this->client_context), this->response, this->current_batch_bytes, cq,
+                 [this](::grpc::ClientContext *context, ::grpc::CompletionQueue *cq_)
+  {
+    return this->stub->AsyncPush(context, *this->current_batch, cq_);
+  });
+}
+
+LogThreadedResult
+DestinationWorker::evaluate_call(InflightCall &call)
+{
+  return this->evaluate_push_status(call.status, call.bytes);
+}
+
+LogThreadedResult
+DestinationWorker::flush(LogThreadedFlushMode mode)
+{
+  if (this->super->super.batch_size == 0)
+    return LTR_SUCCESS;
+
+  if (this->is_pipelining_enabled())
+    return this->flush_pipelined(mode);
+
+  ::grpc::Status status = this->stub->Push(client_context.get(), *this->current_batch, this->response);
+  LogThreadedResult result = this->evaluate_push_status(status, this->current_batch_bytes);
 
-error:
   this->prepare_batch();
   return result;
 }
@@ -57,8 +57,17 @@ protected:
   void deinit() override;
   bool connect() override;
 
+  bool supports_pipelining() override
+  {
+    return true;
+  }
+
+  void prepare_batch() override;
+  void submit_batch(InflightBatch &batch, ::grpc::CompletionQueue *cq) override;
+  LogThreadedResult evaluate_call(InflightCall &call) override;
+
 private:
-  void prepare_batch();
+  LogThreadedResult evaluate_push_status(const ::grpc::Status &status, size_t batch_bytes);
   bool should_initiate_flush();
   void set_labels(LogMessage *msg);
   void set_timestamp(logproto::EntryAdapter *entry, LogMessage *msg);
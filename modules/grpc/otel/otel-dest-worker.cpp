@@ -87,6 +87,16 @@ DestWorker::DestWorker(GrpcDestWorker *s)
 {
 }
 
+void
+DestWorker::prepare_client_context(std::unique_ptr<::grpc::ClientContext> &context, LogMessage *msg)
+{
+  if (context.get())
+    return;
+
+  context = std::make_unique<::grpc::ClientContext>();
+  prepare_context_dynamic(*context, msg);
+}
+
 void
 DestWorker::clear_current_msg_metadata()
 {
@@ -350,30 +360,28 @@ DestWorker::insert(LogMessage *msg)
   switch (type)
     {
     case MessageType::LOG:
+      prepare_client_context(logs_client_context, msg);
       if (!insert_log_record_from_log_msg(msg))
         goto drop;
       break;
     case MessageType::METRIC:
+      prepare_client_context(metrics_client_context, msg);
       if (!insert_metric_from_log_msg(msg))
         goto drop;
       break;
     case MessageType::SPAN:
+      prepare_client_context(spans_client_context, msg);
       if (!insert_span_from_log_msg(msg))
         goto drop;
       break;
     case MessageType::UNKNOWN:
+      prepare_client_context(logs_client_context, msg);
       insert_fallback_log_record_from_log_msg(msg);
       break;
     default:
       g_assert_not_reached();
     }
 
-  if (!client_context.get())
-    {
-      client_context = std::make_unique<::grpc::ClientContext>();
-      prepare_context_dynamic(*client_context, msg);
-    }
-
   if (should_initiate_flush())
     return log_threaded_dest_worker_flush(&super->super, LTF_FLUSH_NORMAL);
 
@@ -436,10 +444,8 @@ permanent_error:
 }
 
 LogThreadedResult
-DestWorker::flush_log_records()
+DestWorker::evaluate_export_status(const ::grpc::Status &status, size_t batch_bytes)
 {
-  ::grpc::Status status = logs_service_stub->Export(client_context.get(), *logs_service_request,
-                                                    logs_service_response);
   owner.metrics.insert_grpc_request_stats(status);
 
   LogThreadedResult result;
@@ -448,51 +454,93 @@ DestWorker::flush_log_records()
 
   if (result == LTR_SUCCESS)
     {
-      log_threaded_dest_worker_written_bytes_add(&super->super, logs_current_batch_bytes);
-      log_threaded_dest_driver_insert_batch_length_stats(super->super.owner, logs_current_batch_bytes);
+      log_threaded_dest_worker_written_bytes_add(&super->super, batch_bytes);
+      log_threaded_dest_driver_insert_batch_length_stats(super->super.owner, batch_bytes);
     }
 
   return result;
 }
 
+LogThreadedResult
+DestWorker::flush_log_records()
+{
+  ::grpc::Status status = logs_service_stub->Export(logs_client_context.get(), *logs_service_request,
+                                                    logs_service_response);
+  return evaluate_export_status(status, logs_current_batch_bytes);
+}
+
 LogThreadedResult
 DestWorker::flush_metrics()
 {
-  ::grpc::Status status = metrics_service_stub->Export(client_context.get(), *metrics_service_request,
+  ::grpc::Status status = metrics_service_stub->Export(metrics_client_context.get(), *metrics_service_request,
                                                        metrics_service_response);
-  owner.metrics.insert_grpc_request_stats(status);
-
-  LogThreadedResult result;
-  if (!owner.handle_response(status, &result))
-    result = _map_grpc_status_to_log_threaded_result(status);
-
-  if (result == LTR_SUCCESS)
-    {
-      log_threaded_dest_worker_written_bytes_add(&super->super, metrics_current_batch_bytes);
-      log_threaded_dest_driver_insert_batch_length_stats(super->super.owner, metrics_current_batch_bytes);
-    }
-
-  return result;
+  return evaluate_export_status(status, metrics_current_batch_bytes);
 }
 
 LogThreadedResult
 DestWorker::flush_spans()
 {
-  ::grpc::Status status = trace_service_stub->Export(client_context.get(), *trace_service_request,
+  ::grpc::Status status = trace_service_stub->Export(spans_client_context.get(), *trace_service_request,
                                                      trace_service_response);
-  owner.metrics.insert_grpc_request_stats(status);
+  return evaluate_export_status(status, spans_current_batch_bytes);
+}
 
-  LogThreadedResult result;
-  if (!owner.handle_response(status, &result))
-    result = _map_grpc_status_to_log_threaded_result(status);
+void
+DestWorker::prepare_batch()
+{
+  logs_client_context.reset();
+  metrics_client_context.reset();
+  spans_client_context.reset();
+  fallback_msg_scope_logs = nullptr;
 
-  if (result == LTR_SUCCESS)
+  arena.Reset();
+
+  logs_service_request = arena.CreateMessage<ExportLogsServiceRequest>();
+  logs_service_response = arena.CreateMessage<ExportLogsServiceResponse>();
+  metrics_service_request = arena.CreateMessage<ExportMetricsServiceRequest>();
+  metrics_service_response = arena.CreateMessage<ExportMetricsServiceResponse>();
+  trace_service_request = arena.CreateMessage<ExportTraceServiceRequest>();
+  trace_service_response = arena.CreateMessage<ExportTraceServiceResponse>();
+
+  logs_current_batch_bytes = metrics_current_batch_bytes = spans_current_batch_bytes = 0;
+}
+
+/* logs, metrics and spans of the batch are exported in parallel */
+void
+DestWorker::submit_batch(InflightBatch &batch, ::grpc::CompletionQueue *cq)
+{
+  if (logs_service_request->resource_logs_size() > 0)
     {
-      log_threaded_dest_worker_written_bytes_add(&super->super, spans_current_batch_bytes);
-      log_threaded_dest_driver_insert_batch_length_stats(super->super.owner, spans_current_batch_bytes);
+      batch.add_call(std::move(logs_client_context), logs_service_response, logs_current_batch_bytes, cq,
+                     [this](::grpc::ClientContext *context, ::grpc::CompletionQueue *cq_)
+      {
+        return logs_service_stub->AsyncExport(context, *logs_service_request, cq_);
+      });
     }
 
-  return result;
+  if (metrics_service_request->resource_metrics_size() > 0)
+    {
+      batch.add_call(std::move(metrics_client_context), metrics_service_response, metrics_current_batch_bytes, cq,
+                     [this](::grpc::ClientContext *context, ::grpc::CompletionQueue *cq_)
+      {
+        return metrics_service_stub->AsyncExport(context, *metrics_service_request, cq_);
+      });
+    }
+
+  if (trace_service_request->resource_spans_size() > 0)
+    {
+      batch.add_call(std::move(spans_client_context), trace_service_response, spans_current_batch_bytes, cq,
+                     [this](::grpc::ClientContext *context, ::grpc::CompletionQueue *cq_)
+      {
+        return trace_service_stub->AsyncExport(context, *trace_service_request, cq_);
+      });
+    }
+}
+
+LogThreadedResult
+DestWorker::evaluate_call(InflightCall &call)
+{
+  return evaluate_export_status(call.status, call.bytes);
 }
 
 LogThreadedResult
@@ -500,6 +548,9 @@ DestWorker::flush(LogThreadedFlushMode mode)
 {
   LogThreadedResult result = LTR_SUCCESS;
 
+  if (is_pipelining_enabled())
+    return flush_pipelined(mode);
+
   if (mode == LTF_FLUSH_EXPEDITE)
     return LTR_RETRY;
 
@@ -525,19 +576,6 @@ DestWorker::flush(LogThreadedFlushMode mode)
     }
 
 exit:
-  client_context.reset();
-  fallback_msg_scope_logs = nullptr;
-
-  arena.Reset();
-
-  logs_service_request = arena.CreateMessage<ExportLogsServiceRequest>();
-  logs_service_response = arena.CreateMessage<ExportLogsServiceResponse>();
-  metrics_service_request = arena.CreateMessage<ExportMetricsServiceRequest>();
-  metrics_service_response = arena.CreateMessage<ExportMetricsServiceResponse>();
-  trace_service_request = arena.CreateMessage<ExportTraceServiceRequest>();
-  trace_service_response = arena.CreateMessage<ExportTraceServiceResponse>();
-
-  logs_current_batch_bytes = metrics_current_batch_bytes = spans_current_batch_bytes = 0;
-
+  prepare_batch();
   return result;
 }
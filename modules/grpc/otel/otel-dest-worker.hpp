@@ -65,6 +65,16 @@ protected:
   void deinit() override;
   bool connect() override;
 
+  bool supports_pipelining() override
+  {
+    return true;
+  }
+
+  void prepare_batch() override;
+  void submit_batch(InflightBatch &batch, ::grpc::CompletionQueue *cq) override;
+  LogThreadedResult evaluate_call(InflightCall &call) override;
+
+  void prepare_client_context(std::unique_ptr<::grpc::ClientContext> &context, LogMessage *msg);
   void clear_current_msg_metadata();
   void get_metadata_for_current_msg(LogMessage *msg);
 
@@ -80,12 +90,16 @@ protected:
   bool insert_metric_from_log_msg(LogMessage *msg);
   bool insert_span_from_log_msg(LogMessage *msg);
 
+  LogThreadedResult evaluate_export_status(const ::grpc::Status &status, size_t batch_bytes);
   LogThreadedResult flush_log_records();
   LogThreadedResult flush_metrics();
   LogThreadedResult flush_spans();
 
 protected:
-  std::unique_ptr<::grpc::ClientContext> client_context;
+  /* a ClientContext can not be reused, every Export() call has its own */
+  std::unique_ptr<::grpc::ClientContext> logs_client_context;
+  std::unique_ptr<::grpc::ClientContext> metrics_client_context;
+  std::unique_ptr<::grpc::ClientContext> spans_client_context;
   std::unique_ptr<LogsService::Stub> logs_service_stub;
   std::unique_ptr<MetricsService::Stub> metrics_service_stub;
   std::unique_ptr<TraceService::Stub> trace_service_stub;
@@ -49,6 +49,8 @@ SyslogNgDestWorker::lookup_scope_logs(LogMessage *msg)
 LogThreadedResult
 SyslogNgDestWorker::insert(LogMessage *msg)
 {
+  prepare_client_context(logs_client_context, msg);
+
   ScopeLogs *scope_logs = lookup_scope_logs(msg);
   LogRecord *log_record = scope_logs->add_log_records();
   formatter.format_syslog_ng(msg, *log_record);
@@ -57,12 +59,6 @@ SyslogNgDestWorker::insert(LogMessage *msg)
   logs_current_batch_bytes += log_record_bytes;
   log_threaded_dest_driver_insert_msg_length_stats(super->super.owner, log_record_bytes);
 
-  if (!client_context.get())
-    {
-      client_context = std::make_unique<::grpc::ClientContext>();
-      prepare_context_dynamic(*client_context, msg);
-    }
-
   if (should_initiate_flush())
     return log_threaded_dest_worker_flush(&super->super, LTF_FLUSH_NORMAL);
 
@@ -165,14 +165,14 @@ unavailable:
 static size_t
 _curl_write_function(char *ptr, size_t size, size_t nmemb, void *userdata)
 {
-  HTTPDestinationWorker *self = (HTTPDestinationWorker *) userdata;
+  GString *response_buffer = (GString *) userdata;
   gsize count = nmemb * size;
 
-  if (self->response_buffer->len >= HTTP_RESPONSE_MAX_LENGTH)
+  if (response_buffer->len >= HTTP_RESPONSE_MAX_LENGTH)
     return count;
 
-  gsize remaining = HTTP_RESPONSE_MAX_LENGTH - self->response_buffer->len;
-  g_string_append_len(self->response_buffer, (gchar *) ptr, MIN(remaining, count));
+  gsize remaining = HTTP_RESPONSE_MAX_LENGTH - response_buffer->len;
+  g_string_append_len(response_buffer, (gchar *) ptr, MIN(remaining, count));
 
   return count;
 }
@@ -188,7 +188,7 @@ _setup_static_options_in_curl(HTTPDestinationWorker *self)
   curl_easy_reset(self->curl);
 
   curl_easy_setopt(self->curl, CURLOPT_WRITEFUNCTION, _curl_write_function);
-  curl_easy_setopt(self->curl, CURLOPT_WRITEDATA, self);
+  curl_easy_setopt(self->curl, CURLOPT_WRITEDATA, self->response_buffer);
 
   curl_easy_setopt(self->curl, CURLOPT_URL, owner->url);
 
@@ -306,7 +306,7 @@ _collect_rest_headers(HTTPDestinationWorker *self, GError **error)
   self->request_signal = ((HttpRequestSignalData)
   {
     .result = HTTP_SLOT_SUCCESS,
-    .batch_size = self->super.batch_size,
+    .batch_size = log_threaded_dest_worker_get_current_batch_size(&self->super),
     .request_headers = self->request_headers,
     .request_body = self->request_body,
   });
@@ -375,7 +375,7 @@ _add_message_to_batch(HTTPDestinationWorker *self, LogMessage *msg)
 {
   HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
 
-  if (self->super.batch_size > 1)
+  if (log_threaded_dest_worker_get_current_batch_size(&self->super) > 1)
     {
       g_string_append_len(self->request_body, owner->delimiter->str, owner->delimiter->len);
     }
@@ -528,6 +528,16 @@ _reset_request_body(HTTPDestinationWorker *self)
     g_string_truncate(self->request_body_compressed, 0);
 }
 
+static void
+_reset_batch(HTTPDestinationWorker *self)
+{
+  _reset_request_headers(self);
+  _reset_request_body(self);
+
+  log_msg_unref(self->msg_for_templates);
+  self->msg_for_templates = NULL;
+}
+
 static gboolean
 _is_request_body_inited(HTTPDestinationWorker *self)
 {
@@ -558,7 +568,7 @@ _finish_request_body(HTTPDestinationWorker *self)
 }
 
 static void
-_debug_response_info(HTTPDestinationWorker *self, const gchar *url, glong http_code)
+_debug_response_info(HTTPDestinationWorker *self, const gchar *url, glong http_code, gint batch_size)
 {
   HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
 
@@ -573,7 +583,7 @@ _debug_response_info(HTTPDestinationWorker *self, const gchar *url, glong http_c
             _tag_request(self),
             evt_tag_mem("response", self->response_buffer->str, self->response_buffer->len),
             evt_tag_int("body_size", self->request_body->len),
-            evt_tag_int("batch_size", self->super.batch_size),
+            evt_tag_int("batch_size", batch_size),
             evt_tag_int("redirected", redirect_count != 0),
             evt_tag_printf("total_time", "%.3f", total_time),
             evt_tag_int("worker_index", self->super.worker_index),
@@ -647,8 +657,8 @@ _custom_map_http_result(HTTPDestinationWorker *self, const gchar *url, HttpRespo
   return LTR_MAX;
 }
 
-static gboolean
-_curl_perform_request(HTTPDestinationWorker *self, const gchar *url)
+static void
+_curl_prepare_request(HTTPDestinationWorker *self, const gchar *url)
 {
   HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
 
@@ -678,15 +688,30 @@ _curl_perform_request(HTTPDestinationWorker *self, const gchar *url)
   curl_easy_setopt(self->curl, CURLOPT_HTTPHEADER, http_curl_header_list_as_slist(self->request_headers));
 
   g_string_truncate(self->response_buffer, 0);
+}
+
+static void
+_report_curl_error(HTTPDestinationWorker *self, const gchar *url, CURLcode ret)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+
+  msg_error("http: error sending HTTP request",
+            evt_tag_str("url", url),
+            evt_tag_str("error", curl_easy_strerror(ret)),
+            evt_tag_int("worker_index", self->super.worker_index),
+            evt_tag_str("driver", owner->super.super.super.id),
+            log_pipe_location_tag(&owner->super.super.super.super));
+}
+
+static gboolean
+_curl_perform_request(HTTPDestinationWorker *self, const gchar *url)
+{
+  _curl_prepare_request(self, url);
+
   CURLcode ret = curl_easy_perform(self->curl);
   if (ret != CURLE_OK)
     {
-      msg_error("http: error sending HTTP request",
-                evt_tag_str("url", url),
-                evt_tag_str("error", curl_easy_strerror(ret)),
-                evt_tag_int("worker_index", self->super.worker_index),
-                evt_tag_str("driver", owner->super.super.super.id),
-                log_pipe_location_tag(&owner->super.super.super.super));
+      _report_curl_error(self, url, ret);
       return FALSE;
     }
 
@@ -767,21 +792,19 @@ _update_status_code_metrics(HTTPDestinationWorker *self, const gchar *url, glong
   stats_counter_inc(counter);
 }
 
+/* evaluates the response to the request that has just been performed on
+ * self->curl, batch_size is the number of messages in that request */
 static LogThreadedResult
-_flush_on_target(HTTPDestinationWorker *self, const gchar *url)
+_process_response(HTTPDestinationWorker *self, const gchar *url, gint batch_size)
 {
   HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
-
-  if (!_curl_perform_request(self, url))
-    return LTR_NOT_CONNECTED;
-
   glong http_code = 0;
 
   if (!_curl_get_status_code(self, url, &http_code))
     return LTR_NOT_CONNECTED;
 
   if (debug_flag)
-    _debug_response_info(self, url, http_code);
+    _debug_response_info(self, url, http_code, batch_size);
 
   _update_status_code_metrics(self, url, http_code);
 
@@ -789,7 +812,7 @@ _flush_on_target(HTTPDestinationWorker *self, const gchar *url)
   {
     .result = HTTP_SLOT_SUCCESS,
     .http_code = http_code,
-    .batch_size = self->super.batch_size,
+    .batch_size = batch_size,
     .request_body = self->request_body,
     .response_body = self->response_buffer,
     .offending_message = 0,
@@ -815,6 +838,15 @@ _flush_on_target(HTTPDestinationWorker *self, const gchar *url)
   return _map_http_status_code(self, url, http_code);
 }
 
+static LogThreadedResult
+_flush_on_target(HTTPDestinationWorker *self, const gchar *url)
+{
+  if (!_curl_perform_request(self, url))
+    return LTR_NOT_CONNECTED;
+
+  return _process_response(self, url, self->super.batch_size);
+}
+
 static gboolean
 _format_request_headers_error_is_critical(GError *error)
 {
@@ -929,13 +961,430 @@ _flush(LogThreadedDestWorker *s, LogThreadedFlushMode mode)
       url = alt_url;
     }
 
-  _reset_request_headers(self);
-  _reset_request_body(self);
+  _reset_batch(self);
+  return retval;
+}
 
-  log_msg_unref(self->msg_for_templates);
-  self->msg_for_templates = NULL;
+/* Asynchronous mode
+ *
+ * With max-inflight-requests() > 1, a batch is not sent synchronously,
+ * instead its request is submitted to a curl multi handle and we return
+ * to accept the next batch.  Completed requests are evaluated in
+ * submission order, as the messages of each batch follow each other in the
+ * backlog of our queue: the oldest batch is acked as soon as its request
+ * is successful.  If the oldest request fails, all later batches are
+ * rewound (their requests aborted, even if some of them succeeded) and the
+ * failed batch is reported to LogThreadedDestWorker as if it was the only
+ * one, so retries/drops work the same way as in the synchronous case.
+ *
+ * On reload and shutdown, requests in flight are not aborted but drained:
+ * we wait for them (bounded by the drain timeout) and only rewind the
+ * batches that were not delivered.
+ */
 
-  return retval;
+#define HTTP_INFLIGHT_DRAIN_TIMEOUT_DEFAULT 10
+
+typedef struct _HTTPInflightRequest
+{
+  /* these are swapped with the same fields of HTTPDestinationWorker */
+  CURL *curl;
+  GString *request_body;
+  GString *request_body_compressed;
+  List *request_headers;
+  GString *response_buffer;
+  LogMessage *msg_for_templates;
+
+  HTTPLoadBalancerTarget *target;
+  GString *url;
+  gint batch_size;
+  gboolean completed;
+  CURLcode curl_result;
+} HTTPInflightRequest;
+
+/* The request specific state of the worker is exchanged with that of an
+ * HTTPInflightRequest, so that the functions above, working on the worker,
+ * can be used to prepare and evaluate asynchronous requests as well.
+ * Calling it twice restores the original state. */
+static void
+_swap_request_state(HTTPDestinationWorker *self, HTTPInflightRequest *request)
+{
+#define SWAP_FIELD(type, field) \
+  do { type tmp = self->field; self->field = request->field; request->field = tmp; } while (0)
+
+  SWAP_FIELD(CURL *, curl);
+  SWAP_FIELD(GString *, request_body);
+  SWAP_FIELD(GString *, request_body_compressed);
+  SWAP_FIELD(List *, request_headers);
+  SWAP_FIELD(GString *, response_buffer);
+  SWAP_FIELD(LogMessage *, msg_for_templates);
+
+#undef SWAP_FIELD
+}
+
+static void
+_setup_multiplexing_options_in_curl(HTTPDestinationWorker *self)
+{
+#if LIBCURL_VERSION_NUM >= 0x072f00
+  /* use HTTP/2 for https:// if the server supports it and wait for an
+   * existing connection instead of opening a new one, so that concurrent
+   * requests are multiplexed over the same connection */
+  curl_easy_setopt(self->curl, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+  curl_easy_setopt(self->curl, CURLOPT_PIPEWAIT, 1L);
+#endif
+}
+
+static HTTPInflightRequest *
+_inflight_request_new(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  HTTPInflightRequest *request = g_new0(HTTPInflightRequest, 1);
+
+  request->curl = curl_easy_init();
+  if (!request->curl)
+    {
+      g_free(request);
+      return NULL;
+    }
+
+  request->request_body = g_string_sized_new(32768);
+  if (owner->content_compression != CURL_COMPRESSION_UNCOMPRESSED)
+    request->request_body_compressed = g_string_sized_new(32768);
+  request->request_headers = http_curl_header_list_new();
+  request->response_buffer = g_string_sized_new(1024);
+  request->url = g_string_new(NULL);
+
+  _swap_request_state(self, request);
+  _setup_static_options_in_curl(self);
+  _setup_multiplexing_options_in_curl(self);
+  _swap_request_state(self, request);
+
+  return request;
+}
+
+static void
+_inflight_request_free(HTTPInflightRequest *request)
+{
+  curl_easy_cleanup(request->curl);
+  g_string_free(request->request_body, TRUE);
+  if (request->request_body_compressed)
+    g_string_free(request->request_body_compressed, TRUE);
+  list_free(request->request_headers);
+  g_string_free(request->response_buffer, TRUE);
+  log_msg_unref(request->msg_for_templates);
+  g_string_free(request->url, TRUE);
+  g_free(request);
+}
+
+static void
+_recycle_inflight_request(HTTPDestinationWorker *self, HTTPInflightRequest *request)
+{
+  curl_multi_remove_handle(self->inflight.multi, request->curl);
+
+  list_remove_all(request->request_headers);
+  g_string_truncate(request->request_body, 0);
+  if (request->request_body_compressed)
+    g_string_truncate(request->request_body_compressed, 0);
+  log_msg_unref(request->msg_for_templates);
+  request->msg_for_templates = NULL;
+  request->target = NULL;
+  request->batch_size = 0;
+  request->completed = FALSE;
+
+  g_queue_push_tail(&self->inflight.idle_requests, request);
+}
+
+static void
+_abort_inflight_requests(HTTPDestinationWorker *self)
+{
+  HTTPInflightRequest *request;
+
+  while ((request = g_queue_pop_head(&self->inflight.requests)))
+    _recycle_inflight_request(self, request);
+
+  self->inflight.running = 0;
+  self->super.inflight_batch_size = 0;
+}
+
+/* drops every request in flight along with the batch being assembled, the
+ * whole batch_size is left for LogThreadedDestWorker to rewind */
+static void
+_abort_all_batches(HTTPDestinationWorker *self)
+{
+  _abort_inflight_requests(self);
+  _reset_batch(self);
+}
+
+static gboolean
+_submit_request(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  HTTPInflightRequest *request = g_queue_pop_head(&self->inflight.idle_requests);
+
+  if (!request && !(request = _inflight_request_new(self)))
+    {
+      msg_error("http: cannot initialize libcurl",
+                evt_tag_int("worker_index", self->super.worker_index),
+                evt_tag_str("driver", owner->super.super.super.id),
+                log_pipe_location_tag(&owner->super.super.super.super));
+      return FALSE;
+    }
+
+  request->target = http_load_balancer_choose_target(owner->load_balancer, &self->lbc);
+  g_string_assign(request->url, _get_url(self, request->target));
+  request->batch_size = log_threaded_dest_worker_get_current_batch_size(&self->super);
+
+  _curl_prepare_request(self, request->url->str);
+
+  /* the request takes over the current batch, the worker continues with
+   * the empty buffers of the request */
+  _swap_request_state(self, request);
+
+  curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request);
+  curl_multi_add_handle(self->inflight.multi, request->curl);
+
+  g_queue_push_tail(&self->inflight.requests, request);
+  self->inflight.running++;
+  self->super.inflight_batch_size += request->batch_size;
+  return TRUE;
+}
+
+/* returns the number of requests that have been completed */
+static gint
+_perform_inflight_requests(HTTPDestinationWorker *self)
+{
+  gint still_running, msgs_in_queue;
+  CURLMsg *curl_msg;
+  gint completed = 0;
+
+  curl_multi_perform(self->inflight.multi, &still_running);
+
+  while ((curl_msg = curl_multi_info_read(self->inflight.multi, &msgs_in_queue)))
+    {
+      if (curl_msg->msg != CURLMSG_DONE)
+        continue;
+
+      gchar *private_data = NULL;
+      curl_easy_getinfo(curl_msg->easy_handle, CURLINFO_PRIVATE, &private_data);
+
+      HTTPInflightRequest *request = (HTTPInflightRequest *) private_data;
+      request->completed = TRUE;
+      request->curl_result = curl_msg->data.result;
+      self->inflight.running--;
+      completed++;
+    }
+
+  return completed;
+}
+
+/* a deadline of 0 waits indefinitely, returns FALSE if the deadline expired */
+static gboolean
+_wait_for_inflight_requests_until(HTTPDestinationWorker *self, gint max_running, gint64 deadline)
+{
+  while (self->inflight.running > MAX(max_running, 0))
+    {
+      if (_perform_inflight_requests(self) > 0)
+        continue;
+
+      gint timeout_msec = 1000;
+      if (deadline)
+        {
+          gint64 remaining = deadline - g_get_monotonic_time();
+          if (remaining <= 0)
+            return FALSE;
+          timeout_msec = MIN(timeout_msec, remaining / 1000 + 1);
+        }
+      curl_multi_wait(self->inflight.multi, NULL, 0, timeout_msec, NULL);
+    }
+  return TRUE;
+}
+
+static void
+_wait_for_inflight_requests(HTTPDestinationWorker *self, gint max_running)
+{
+  _wait_for_inflight_requests_until(self, max_running, 0);
+}
+
+static LogThreadedResult
+_evaluate_inflight_request(HTTPDestinationWorker *self, HTTPInflightRequest *request)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  const gchar *url = request->url->str;
+  LogThreadedResult result;
+
+  _swap_request_state(self, request);
+
+  if (request->curl_result != CURLE_OK)
+    {
+      _report_curl_error(self, url, request->curl_result);
+      result = LTR_NOT_CONNECTED;
+    }
+  else
+    {
+      result = _process_response(self, url, request->batch_size);
+    }
+
+  if (result == LTR_SUCCESS)
+    {
+      gsize msg_length = self->request_body->len;
+      log_threaded_dest_worker_written_bytes_add(&self->super, msg_length);
+      log_threaded_dest_driver_insert_batch_length_stats(self->super.owner, msg_length);
+
+      http_load_balancer_set_target_successful(owner->load_balancer, request->target);
+    }
+  else
+    {
+      http_load_balancer_set_target_failed(owner->load_balancer, request->target);
+    }
+
+  _swap_request_state(self, request);
+  return result;
+}
+
+static LogThreadedResult
+_process_completed_requests(HTTPDestinationWorker *self)
+{
+  HTTPInflightRequest *request;
+
+  while ((request = g_queue_peek_head(&self->inflight.requests)) && request->completed)
+    {
+      g_queue_pop_head(&self->inflight.requests);
+      self->super.inflight_batch_size -= request->batch_size;
+
+      gint batch_size = request->batch_size;
+      LogThreadedResult result = _evaluate_inflight_request(self, request);
+      _recycle_inflight_request(self, request);
+
+      if (result == LTR_SUCCESS)
+        {
+          log_threaded_dest_worker_ack_messages(&self->super, batch_size);
+          continue;
+        }
+
+      /* the failed batch is at the head of the backlog, everything after
+       * it is rewound, the failed batch itself is handled by our caller
+       * using the result */
+      _abort_all_batches(self);
+      gint later_batches_size = self->super.batch_size - batch_size;
+      if (later_batches_size > 0)
+        log_threaded_dest_worker_rewind_messages(&self->super, later_batches_size);
+      return result;
+    }
+
+  return LTR_EXPLICIT_ACK_MGMT;
+}
+
+static gint64
+_get_drain_deadline(HTTPDestinationWorker *self)
+{
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) self->super.owner;
+  glong timeout = owner->timeout > 0 ? owner->timeout : HTTP_INFLIGHT_DRAIN_TIMEOUT_DEFAULT;
+
+  return g_get_monotonic_time() + timeout * G_USEC_PER_SEC;
+}
+
+/* Used on reload and shutdown: the requests in flight are given time to
+ * complete, the batches that were delivered are acked, everything else
+ * (failed transfers, requests still running at the deadline and the batch
+ * that was not submitted yet) is rewound.  As the backlog is acked in
+ * order, a batch delivered after one that was not is rewound as well. */
+static LogThreadedResult
+_drain_inflight_requests(HTTPDestinationWorker *self)
+{
+  HTTPInflightRequest *request;
+
+  _reset_batch(self);
+
+  _perform_inflight_requests(self);
+  _wait_for_inflight_requests_until(self, 0, _get_drain_deadline(self));
+
+  while ((request = g_queue_peek_head(&self->inflight.requests)) && request->completed)
+    {
+      gint batch_size = request->batch_size;
+      if (_evaluate_inflight_request(self, request) != LTR_SUCCESS)
+        break;
+
+      g_queue_pop_head(&self->inflight.requests);
+      self->super.inflight_batch_size -= batch_size;
+      _recycle_inflight_request(self, request);
+      log_threaded_dest_worker_ack_messages(&self->super, batch_size);
+    }
+
+  if (self->inflight.running > 0)
+    {
+      msg_warning("http: requests did not complete while draining, their batches will be resent",
+                  evt_tag_int("worker_index", self->super.worker_index),
+                  evt_tag_str("driver", self->super.owner->super.super.id),
+                  evt_tag_int("requests", self->inflight.running));
+    }
+
+  _abort_inflight_requests(self);
+  if (self->super.batch_size > 0)
+    log_threaded_dest_worker_rewind_messages(&self->super, self->super.batch_size);
+
+  return LTR_EXPLICIT_ACK_MGMT;
+}
+
+static LogThreadedResult
+_flush_async(LogThreadedDestWorker *s, LogThreadedFlushMode mode)
+{
+  HTTPDestinationWorker *self = (HTTPDestinationWorker *) s;
+  HTTPDestinationDriver *owner = (HTTPDestinationDriver *) s->owner;
+  LogThreadedResult result;
+  GError *error = NULL;
+
+  if (self->super.batch_size == 0)
+    return LTR_SUCCESS;
+
+  if (mode == LTF_FLUSH_EXPEDITE)
+    return _drain_inflight_requests(self);
+
+  gboolean submitted = FALSE;
+  if (log_threaded_dest_worker_get_current_batch_size(&self->super) > 0)
+    {
+      _finish_request_body(self);
+
+      if (!_try_format_request_headers(self, &error))
+        {
+          if (!_format_request_headers_catch_error(&error))
+            {
+              _abort_all_batches(self);
+              return LTR_NOT_CONNECTED;
+            }
+        }
+
+      /* completed requests also count until their batch is acked, so a
+       * slow request at the head limits how far we get ahead of it */
+      while (g_queue_get_length(&self->inflight.requests) >= owner->max_inflight_requests)
+        {
+          _wait_for_inflight_requests(self, self->inflight.running - 1);
+          result = _process_completed_requests(self);
+          if (result != LTR_EXPLICIT_ACK_MGMT)
+            return result;
+        }
+
+      if (!_submit_request(self))
+        {
+          _abort_all_batches(self);
+          return LTR_ERROR;
+        }
+      submitted = TRUE;
+    }
+
+  _perform_inflight_requests(self);
+
+  if (self->super.owner->under_termination)
+    {
+      /* we are shutting down, deliver everything we have */
+      return _drain_inflight_requests(self);
+    }
+  else if (!submitted)
+    {
+      /* we were called to flush requests that are already in flight, wait
+       * for one of them instead of getting called again right away */
+      _wait_for_inflight_requests(self, self->inflight.running - 1);
+    }
+
+  return _process_completed_requests(self);
 }
 
 static gboolean
@@ -1016,6 +1465,22 @@ _init(LogThreadedDestWorker *s)
       return FALSE;
     }
   _setup_static_options_in_curl(self);
+
+  if (owner->max_inflight_requests > 1)
+    {
+      if (!(self->inflight.multi = curl_multi_init()))
+        {
+          msg_error("http: cannot initialize libcurl multi interface",
+                    evt_tag_int("worker_index", self->super.worker_index),
+                    evt_tag_str("driver", owner->super.super.super.id),
+                    log_pipe_location_tag(&owner->super.super.super.super));
+          return FALSE;
+        }
+#ifdef CURLPIPE_MULTIPLEX
+      curl_multi_setopt(self->inflight.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+      _setup_multiplexing_options_in_curl(self);
+    }
   _reset_request_headers(self);
 
   _reset_request_body(self);
@@ -1039,6 +1504,19 @@ _deinit(LogThreadedDestWorker *s)
     compressor_free(self->compressor);
   list_free(self->request_headers);
   curl_easy_cleanup(self->curl);
+
+  if (self->inflight.multi)
+    {
+      /* the final flush has drained the requests in flight */
+      g_assert(g_queue_is_empty(&self->inflight.requests));
+
+      HTTPInflightRequest *request;
+      while ((request = g_queue_pop_head(&self->inflight.idle_requests)))
+        _inflight_request_free(request);
+
+      curl_multi_cleanup(self->inflight.multi);
+      self->inflight.multi = NULL;
+    }
   log_threaded_dest_worker_deinit_method(s);
 }
 
@@ -1062,7 +1540,7 @@ http_dw_new(LogThreadedDestDriver *o, gint worker_index)
   log_threaded_dest_worker_init_instance(&self->super, o, worker_index);
   self->super.init = _init;
   self->super.deinit = _deinit;
-  self->super.flush = _flush;
+  self->super.flush = owner->max_inflight_requests > 1 ? _flush_async : _flush;
   self->super.free_fn = http_dw_free;
 
   if (owner->super.batch_lines > 0 || owner->batch_bytes > 0)
@@ -1070,6 +1548,9 @@ http_dw_new(LogThreadedDestDriver *o, gint worker_index)
   else
     self->super.insert = _insert_single;
 
+  g_queue_init(&self->inflight.requests);
+  g_queue_init(&self->inflight.idle_requests);
+
   self->metrics.cache = dyn_metrics_store_new();
   self->response_buffer = g_string_sized_new(1024);
 
@@ -48,6 +48,16 @@ typedef struct _HTTPDestinationWorker
   HttpRequestSignalData request_signal;
   HttpResponseSignalData response_signal;
 
+  /* used when max-inflight-requests() > 1, requests are kept in the order
+   * they were submitted in, so that their batches can be acked in order */
+  struct
+  {
+    CURLM *multi;
+    GQueue requests;
+    GQueue idle_requests;
+    gint running;
+  } inflight;
+
   struct
   {
     DynMetricsStore *cache;
@@ -365,6 +365,14 @@ http_dd_set_batch_bytes(LogDriver *d, glong batch_bytes)
   self->batch_bytes = batch_bytes;
 }
 
+void
+http_dd_set_max_inflight_requests(LogDriver *d, gint max_inflight_requests)
+{
+  HTTPDestinationDriver *self = (HTTPDestinationDriver *) d;
+
+  self->max_inflight_requests = max_inflight_requests;
+}
+
 void
 http_dd_set_body_prefix(LogDriver *d, LogTemplate *body_prefix)
 {
@@ -527,6 +535,7 @@ http_dd_new(GlobalConfig *cfg)
   /* disable batching even if the global batch_lines is specified */
   self->super.batch_lines = 0;
   self->batch_bytes = 0;
+  self->max_inflight_requests = 1;
   self->body_suffix = g_string_new("");
   self->delimiter = g_string_new("\n");
   self->accept_encoding = (SYSLOG_NG_HTTP_COMPRESSION_ENABLED ? g_string_new("") : NULL);
@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2025 Axoflow
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * As an additional exemption you are allowed to compile & link against the
+ * OpenSSL libraries as published by the OpenSSL project. See the file
+ * COPYING for details.
+ *
+ */
+
+#include <criterion/criterion.h>
+
+#include "http.h"
+#include "http-worker.h"
+#include "logthrdest/logthrdestdrv.h"
+#include "logqueue-fifo.h"
+#include "apphook.h"
+#include "cfg.h"
+#include "libtest/queue_utils_lib.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+/* a minimal HTTP server, answering each request with 200 OK */
+
+typedef struct _TestHTTPServer
+{
+  gint listen_fd;
+  gint port;
+  gint response_delay_msec;
+  gint requests;
+  GThread *thread;
+} TestHTTPServer;
+
+static TestHTTPServer server;
+
+static gboolean
+_read_request(gint fd)
+{
+  GString *request = g_string_new(NULL);
+  gchar buffer[4096];
+  gsize body_start = 0;
+  gsize content_length = 0;
+  gboolean complete = FALSE;
+
+  while (!complete)
+    {
+      gssize len = recv(fd, buffer, sizeof(buffer), 0);
+      if (len <= 0)
+        break;
+      g_string_append_len(request, buffer, len);
+
+      if (!body_start)
+        {
+          const gchar *headers_end = strstr(request->str, "\r\n\r\n");
+          if (!headers_end)
+            continue;
+          body_start = headers_end - request->str + 4;
+
+          const gchar *header = strstr(request->str, "Content-Length:");
+          if (header && header < headers_end)
+            content_length = strtoul(header + strlen("Content-Length:"), NULL, 10);
+        }
+      complete = request->len >= body_start + content_length;
+    }
+
+  g_string_free(request, TRUE);
+  return complete;
+}
+
+static gpointer
+_http_server_thread(gpointer user_data)
+{
+  const gchar response[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  gint fd;
+
+  while ((fd = accept(server.listen_fd, NULL, NULL)) >= 0)
+    {
+      if (_read_request(fd))
+        {
+          g_atomic_int_inc(&server.requests);
+          if (server.response_delay_msec)
+            g_usleep(server.response_delay_msec * 1000);
+          send(fd, response, sizeof(response) - 1, MSG_NOSIGNAL);
+        }
+      close(fd);
+    }
+  return NULL;
+}
+
+static gint
+_bind_to_ephemeral_port(gint *port)
+{
+  struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+  socklen_t addr_len = sizeof(addr);
+  gint fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  cr_assert(fd >= 0);
+  cr_assert(bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+  cr_assert(getsockname(fd, (struct sockaddr *) &addr, &addr_len) == 0);
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+static void
+_start_http_server(gint response_delay_msec)
+{
+  server.listen_fd = _bind_to_ephemeral_port(&server.port);
+  server.response_delay_msec = response_delay_msec;
+  server.requests = 0;
+  cr_assert(listen(server.listen_fd, 16) == 0);
+  server.thread = g_thread_new("http-server", _http_server_thread, NULL);
+}
+
+static void
+_stop_http_server(void)
+{
+  shutdown(server.listen_fd, SHUT_RDWR);
+  g_thread_join(server.thread);
+  close(server.listen_fd);
+}
+
+static gint
+_get_closed_port(void)
+{
+  gint port;
+
+  close(_bind_to_ephemeral_port(&port));
+  return port;
+}
+
+/* the worker is driven by hand, the same way LogThreadedDestWorker does */
+
+static HTTPDestinationDriver *driver;
+static HTTPDestinationWorker *worker;
+
+static void
+_create_worker(gint port)
+{
+  gchar *url = g_strdup_printf("http://127.0.0.1:%d/", port);
+  GList *urls = g_list_append(NULL, url);
+  GError *error = NULL;
+
+  driver = (HTTPDestinationDriver *) http_dd_new(configuration);
+  cr_assert(http_dd_set_urls(&driver->super.super.super, urls, &error));
+  g_list_free_full(urls, g_free);
+
+  http_dd_set_max_inflight_requests(&driver->super.super.super, 4);
+  driver->super.batch_lines = 100;
+  driver->url = driver->load_balancer->targets[0].url_template->template_str;
+  log_template_options_init(&driver->template_options, configuration);
+
+  worker = (HTTPDestinationWorker *) http_dw_new(&driver->super, 0);
+  cr_assert(log_threaded_dest_worker_init(&worker->super));
+  worker->super.queue = log_queue_fifo_new(100, NULL, STATS_LEVEL0, NULL, NULL);
+}
+
+static void
+_free_worker(void)
+{
+  log_threaded_dest_worker_deinit(&worker->super);
+  log_queue_unref(worker->super.queue);
+  worker->super.queue = NULL;
+  log_threaded_dest_worker_free(&worker->super);
+  log_pipe_unref(&driver->super.super.super.super);
+}
+
+static void
+_insert_batch(gint num_messages)
+{
+  LogPathOptions path_options = LOG_PATH_OPTIONS_INIT;
+
+  for (gint i = 0; i < num_messages; i++)
+    {
+      LogMessage *msg = log_queue_pop_head(worker->super.queue, &path_options);
+      cr_assert_not_null(msg);
+
+      worker->super.batch_size++;
+      cr_assert_eq(log_threaded_dest_worker_insert(&worker->super, msg), LTR_QUEUED);
+      log_msg_unref(msg);
+    }
+}
+
+static LogThreadedResult
+_flush_until_done(void)
+{
+  LogThreadedResult result = LTR_EXPLICIT_ACK_MGMT;
+
+  for (gint i = 0; i < 10 && result == LTR_EXPLICIT_ACK_MGMT && worker->super.batch_size > 0; i++)
+    result = log_threaded_dest_worker_flush(&worker->super, LTF_FLUSH_NORMAL);
+  return result;
+}
+
+Test(http_async, completed_requests_are_acked_in_order)
+{
+  _start_http_server(0);
+  _create_worker(server.port);
+
+  feed_some_messages(worker->super.queue, 6);
+  _insert_batch(3);
+  cr_assert_eq(log_threaded_dest_worker_flush(&worker->super, LTF_FLUSH_NORMAL), LTR_EXPLICIT_ACK_MGMT);
+  _insert_batch(3);
+  cr_assert_eq(log_threaded_dest_worker_flush(&worker->super, LTF_FLUSH_NORMAL), LTR_EXPLICIT_ACK_MGMT);
+
+  cr_assert_eq(_flush_until_done(), LTR_EXPLICIT_ACK_MGMT);
+  cr_assert_eq(worker->super.batch_size, 0);
+  cr_assert_eq(acked_messages, 6);
+  cr_assert_eq(g_atomic_int_get(&server.requests), 2);
+
+  _free_worker();
+  _stop_http_server();
+}
+
+Test(http_async, failed_transfer_is_left_to_the_worker_to_rewind)
+{
+  _create_worker(_get_closed_port());
+
+  feed_some_messages(worker->super.queue, 3);
+  _insert_batch(3);
+
+  cr_assert_eq(_flush_until_done(), LTR_NOT_CONNECTED);
+  cr_assert_eq(worker->super.batch_size, 3);
+  cr_assert_eq(worker->super.inflight_batch_size, 0);
+  cr_assert_eq(acked_messages, 0);
+
+  log_threaded_dest_worker_rewind_messages(&worker->super, worker->super.batch_size);
+  cr_assert_eq(log_queue_get_length(worker->super.queue), 3);
+
+  _free_worker();
+}
+
+Test(http_async, reload_drains_requests_in_flight_instead_of_resending_them)
+{
+  _start_http_server(200);
+  _create_worker(server.port);
+
+  feed_some_messages(worker->super.queue, 5);
+  _insert_batch(3);
+  cr_assert_eq(log_threaded_dest_worker_flush(&worker->super, LTF_FLUSH_NORMAL), LTR_EXPLICIT_ACK_MGMT);
+  cr_assert_eq(worker->super.inflight_batch_size, 3);
+
+  /* this batch is not submitted before the reload */
+  _insert_batch(2);
+
+  cr_assert_eq(log_threaded_dest_worker_flush(&worker->super, LTF_FLUSH_EXPEDITE), LTR_EXPLICIT_ACK_MGMT);
+  cr_assert_eq(worker->super.batch_size, 0);
+  cr_assert_eq(acked_messages, 3);
+  cr_assert_eq(log_queue_get_length(worker->super.queue), 2);
+  cr_assert_eq(g_atomic_int_get(&server.requests), 1);
+
+  _free_worker();
+  _stop_http_server();
+}
+
+static void
+setup(void)
+{
+  app_startup();
+  configuration = cfg_new_snippet();
+  acked_messages = 0;
+  fed_messages = 0;
+}
+
+static void
+teardown(void)
+{
+  cfg_free(configuration);
+  app_shutdown();
+}
+
+TestSuite(http_async, .init = setup, .fini = teardown);
@@ -130,46 +130,6 @@ tf_json_append_escaped(GString *dest, const gchar *str, gssize str_len)
   append_unsafe_utf8_as_escaped(dest, str, str_len, AUTF8_UNSAFE_QUOTE, "\\u%04x", "\\\\x%02x");
 }
 
-static gboolean
-tf_json_obj_start(const gchar *name,
-                  const gchar *prefix, gpointer *prefix_data,
-                  const gchar *prev, gpointer *prev_data,
-                  gpointer user_data)
-{
-  json_state_t *state = (json_state_t *)user_data;
-
-  if (state->need_comma)
-    g_string_append_c(state->buffer, ',');
-
-  if (name)
-    {
-      g_string_append_c(state->buffer, '"');
-      tf_json_append_escaped(state->buffer, name, -1);
-      g_string_append(state->buffer, "\":{");
-    }
-  else
-    g_string_append_c(state->buffer, '{');
-
-  state->need_comma = FALSE;
-
-  return FALSE;
-}
-
-static gboolean
-tf_json_obj_end(const gchar *name,
-                const gchar *prefix, gpointer *prefix_data,
-                const gchar *prev, gpointer *prev_data,
-                gpointer user_data)
-{
-  json_state_t *state = (json_state_t *)user_data;
-
-  g_string_append_c(state->buffer, '}');
-
-  state->need_comma = TRUE;
-
-  return FALSE;
-}
-
 static void
 tf_json_append_key(const gchar *name, json_state_t *state)
 {
@@ -387,15 +347,132 @@ tf_json_append_with_type_hint(const gchar *name, LogMessageValueType type, json_
   g_assert_not_reached();
 }
 
+static gint
+tf_json_value_pairs_sort(const gchar *s1, const gchar *s2)
+{
+  return strcmp(s2, s1);
+}
+
+/*
+ * $(format-json) emitter
+ *
+ * Produces the same document as value_pairs_walk() would, but writes the
+ * output directly instead of going through the generic walker callbacks.
+ * Names are tokenized in place and the only state we keep is the list of
+ * prefixes of the currently open objects, stored back-to-back (NUL
+ * terminated) in a scratch buffer, so no per name-value pair allocations
+ * take place.
+ */
+typedef struct
+{
+  json_state_t super;
+  gchar key_delimiter;
+  gint depth;
+  GString *prefixes;
+  GString *path;
+  GString *key;
+} json_emitter_t;
+
+static const gchar *
+tf_json_emitter_peek_prefix(json_emitter_t *self, gsize *prefix_len)
+{
+  const gchar *prefix_end = self->prefixes->str + self->prefixes->len - 1;
+  const gchar *prefix = prefix_end;
+
+  while (prefix > self->prefixes->str && *(prefix - 1) != '\0')
+    prefix--;
+
+  *prefix_len = prefix_end - prefix;
+  return prefix;
+}
+
+static void
+tf_json_emitter_open_object(json_emitter_t *self, const gchar *key, gsize key_len)
+{
+  json_state_t *state = &self->super;
+
+  g_string_append_len(self->prefixes, self->path->str, self->path->len + 1);
+  self->depth++;
+
+  if (state->need_comma)
+    g_string_append_c(state->buffer, ',');
+  g_string_append_c(state->buffer, '"');
+  tf_json_append_escaped(state->buffer, key, key_len);
+  g_string_append(state->buffer, "\":{");
+  state->need_comma = FALSE;
+}
+
+/* close open objects until we find one that name is part of (NULL closes all) */
+static void
+tf_json_emitter_close_objects_until(json_emitter_t *self, const gchar *name)
+{
+  json_state_t *state = &self->super;
+
+  while (self->depth > 0)
+    {
+      gsize prefix_len;
+      const gchar *prefix = tf_json_emitter_peek_prefix(self, &prefix_len);
+
+      if (name && strncmp(name, prefix, prefix_len) == 0)
+        break;
+
+      g_string_truncate(self->prefixes, prefix - self->prefixes->str);
+      self->depth--;
+
+      g_string_append_c(state->buffer, '}');
+      state->need_comma = TRUE;
+    }
+}
+
+/* open the objects name refers to and return its last token as the key */
+static const gchar *
+tf_json_emitter_open_objects_for_name(json_emitter_t *self, const gchar *name)
+{
+  ValuePairsNameTokenizer tokenizer;
+  const gchar *token, *next_token;
+  gsize token_len, next_token_len;
+  gint level = 0;
+
+  value_pairs_name_tokenizer_init(&tokenizer, name, self->key_delimiter);
+  if (!value_pairs_name_tokenizer_next(&tokenizer, &token, &token_len))
+    return name;
+
+  g_string_truncate(self->path, 0);
+  while (value_pairs_name_tokenizer_next(&tokenizer, &next_token, &next_token_len))
+    {
+      if (level > 0)
+        g_string_append_c(self->path, self->key_delimiter);
+      g_string_append_len(self->path, token, token_len);
+
+      if (level >= self->depth)
+        tf_json_emitter_open_object(self, token, token_len);
+
+      level++;
+      token = next_token;
+      token_len = next_token_len;
+    }
+
+  /* the last token is NUL terminated unless the name ends with a delimiter */
+  if (token[token_len] == '\0')
+    return token;
+
+  g_string_truncate(self->key, 0);
+  g_string_append_len(self->key, token, token_len);
+  return self->key->str;
+}
+
 static gboolean
-tf_json_value(const gchar *name, const gchar *prefix,
-              LogMessageValueType type, const gchar *value, gsize value_len,
-              gpointer *prefix_data, gpointer user_data)
+tf_json_emitter_value(const gchar *name, LogMessageValueType type, const gchar *value, gsize value_len,
+                      gpointer user_data)
 {
-  json_state_t *state = (json_state_t *)user_data;
+  json_emitter_t *self = (json_emitter_t *) user_data;
+  json_state_t *state = &self->super;
   gboolean drop;
 
-  if (tf_json_append_with_type_hint(name, type, state, value, value_len, state->template_options->on_error, &drop))
+  tf_json_emitter_close_objects_until(self, name);
+  const gchar *key = tf_json_emitter_open_objects_for_name(self, name);
+
+  if (tf_json_append_with_type_hint(key, type, state, value, value_len, state->template_options->on_error, &drop))
     state->need_comma = TRUE;
 
   return drop;
@@ -404,15 +481,28 @@ tf_json_value(const gchar *name, const gchar *prefix,
 static gboolean
 tf_json_append(TFJsonState *state, GString *result, LogMessage *msg, LogTemplateEvalOptions *options)
 {
-  json_state_t invocation_state;
+  json_emitter_t emitter;
 
-  invocation_state.need_comma = FALSE;
-  invocation_state.buffer = result;
-  invocation_state.template_options = options->opts;
+  emitter.super.need_comma = FALSE;
+  emitter.super.buffer = result;
+  emitter.super.template_options = options->opts;
+  emitter.key_delimiter = state->key_delimiter;
+  emitter.depth = 0;
+  emitter.prefixes = scratch_buffers_alloc();
+  emitter.path = scratch_buffers_alloc();
+  emitter.key = scratch_buffers_alloc();
 
-  return value_pairs_walk(state->vp,
-                          tf_json_obj_start, tf_json_value, tf_json_obj_end,
-                          msg, options, state->key_delimiter, &invocation_state);
+  g_string_append_c(result, '{');
+
+  gboolean success = value_pairs_foreach_sorted(state->vp,
+                                                tf_json_emitter_value,
+                                                (GCompareFunc) tf_json_value_pairs_sort, msg, options,
+                                                &emitter);
+
+  tf_json_emitter_close_objects_until(&emitter, NULL);
+  g_string_append_c(result, '}');
+
+  return success;
 }
 
 static void
@@ -455,12 +545,6 @@ tf_flat_json_value(const gchar *name,
   return drop;
 }
 
-static gint
-tf_flat_value_pairs_sort(const gchar *s1, const gchar *s2)
-{
-  return strcmp(s2, s1);
-}
-
 static gboolean
 tf_flat_json_append(TFJsonState *state, GString *result, LogMessage *msg, LogTemplateEvalOptions *options)
 {
@@ -474,7 +558,7 @@ tf_flat_json_append(TFJsonState *state, GString *result, LogMessage *msg, LogTem
 
   gboolean success = value_pairs_foreach_sorted(state->vp,
                                                 tf_flat_json_value,
-                                                (GCompareFunc) tf_flat_value_pairs_sort, msg, options,
+                                                (GCompareFunc) tf_json_value_pairs_sort, msg, options,
                                                 &invocation_state);
 
   g_string_append_c(invocation_state.buffer, '}');
@@ -326,12 +326,10 @@ json_tokener_error_desc(enum json_tokener_error err)
 #endif
 
 static gboolean
-json_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_options, const gchar *input,
-                    gsize input_len)
+_process_with_tokener(JSONParser *self, struct json_tokener *tok, LogMessage **pmsg,
+                      const LogPathOptions *path_options, const gchar *input, gsize input_len)
 {
-  JSONParser *self = (JSONParser *) s;
   struct json_object *jso;
-  struct json_tokener *tok;
 
   msg_trace("json-parser message processing started",
             evt_tag_str("input", input),
@@ -353,17 +351,14 @@ json_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_
         input++;
     }
 
-  tok = json_tokener_new();
   jso = json_tokener_parse_ex(tok, input, input_len);
   if (tok->err != json_tokener_success || !jso)
     {
       msg_debug("json-parser(): failed to parse JSON payload",
                 evt_tag_str("input", input),
                 tok->err != json_tokener_success ? evt_tag_str ("json_error", json_tokener_error_desc(tok->err)) : NULL);
-      json_tokener_free (tok);
       return FALSE;
     }
-  json_tokener_free(tok);
 
   log_msg_make_writable(pmsg, path_options);
   if (!json_parser_extract(self, jso, *pmsg))
@@ -379,6 +374,36 @@ json_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_
   return TRUE;
 }
 
+static gboolean
+json_parser_process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_options, const gchar *input,
+                    gsize input_len)
+{
+  JSONParser *self = (JSONParser *) s;
+  struct json_tokener *tok = json_tokener_new();
+
+  gboolean result = _process_with_tokener(self, tok, pmsg, path_options, input, input_len);
+
+  json_tokener_free(tok);
+  return result;
+}
+
+/* a single tokener is reused for the whole batch, instead of allocating one per message */
+static void
+json_parser_process_batch(LogParser *s, LogMessage **pmsgs, const LogPathOptions **path_options,
+                          const gchar **inputs, const gsize *input_lens, gboolean *results, gint num_msgs)
+{
+  JSONParser *self = (JSONParser *) s;
+  struct json_tokener *tok = json_tokener_new();
+
+  for (gint i = 0; i < num_msgs; i++)
+    {
+      json_tokener_reset(tok);
+      results[i] = _process_with_tokener(self, tok, &pmsgs[i], path_options[i], inputs[i], input_lens[i]);
+    }
+
+  json_tokener_free(tok);
+}
+
 static LogPipe *
 json_parser_clone(LogPipe *s)
 {
@@ -415,6 +440,7 @@ json_parser_new(GlobalConfig *cfg)
   self->super.super.free_fn = json_parser_free;
   self->super.super.clone = json_parser_clone;
   self->super.process = json_parser_process;
+  self->super.process_batch = json_parser_process_batch;
   self->key_delimiter = '.';
 
   return &self->super;
@@ -23,11 +23,14 @@
 
 #include <criterion/criterion.h>
 #include "libtest/cr_template.h"
+#include "libtest/stopwatch.h"
 
 #include "apphook.h"
 #include "plugin.h"
 #include "cfg.h"
 #include "logmsg/logmsg.h"
+#include "value-pairs/value-pairs.h"
+#include "utf8utils.h"
 
 void
 setup(void)
@@ -426,6 +429,68 @@ Test(format_json, test_format_flat_json_with_type_hints)
                          "{\"b\":{\"subkey\":\"bar\"}}");
 }
 
+/* the value_pairs_walk() based implementation $(format-json) used to have, for comparison */
+static gboolean
+_walker_obj_start(const gchar *name,
+                  const gchar *prefix, gpointer *prefix_data,
+                  const gchar *prev, gpointer *prev_data,
+                  gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  if (result->len > 0 && result->str[result->len - 1] != '{')
+    g_string_append_c(result, ',');
+
+  if (name)
+    {
+      g_string_append_c(result, '"');
+      append_unsafe_utf8_as_escaped(result, name, -1, AUTF8_UNSAFE_QUOTE, "\\u%04x", "\\\\x%02x");
+      g_string_append(result, "\":{");
+    }
+  else
+    g_string_append_c(result, '{');
+  return FALSE;
+}
+
+static gboolean
+_walker_obj_end(const gchar *name,
+                const gchar *prefix, gpointer *prefix_data,
+                const gchar *prev, gpointer *prev_data,
+                gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  g_string_append_c(result, '}');
+  return FALSE;
+}
+
+static gboolean
+_walker_value(const gchar *name, const gchar *prefix,
+              LogMessageValueType type, const gchar *value, gsize value_len,
+              gpointer *prefix_data, gpointer user_data)
+{
+  GString *result = (GString *) user_data;
+
+  if (result->str[result->len - 1] != '{')
+    g_string_append_c(result, ',');
+
+  g_string_append_c(result, '"');
+  append_unsafe_utf8_as_escaped(result, name, -1, AUTF8_UNSAFE_QUOTE, "\\u%04x", "\\\\x%02x");
+  g_string_append(result, "\":\"");
+  append_unsafe_utf8_as_escaped(result, value, value_len, AUTF8_UNSAFE_QUOTE, "\\u%04x", "\\\\x%02x");
+  g_string_append_c(result, '"');
+  return FALSE;
+}
+
+static void
+_format_json_with_walker(ValuePairs *vp, LogMessage *msg, GString *result)
+{
+  LogTemplateEvalOptions options = {&configuration->template_options, LTZ_LOCAL, 0, NULL, LM_VT_STRING};
+
+  g_string_truncate(result, 0);
+  value_pairs_walk(vp, _walker_obj_start, _walker_value, _walker_obj_end, msg, &options, '.', result);
+}
+
 Test(format_json, test_format_json_performance)
 {
   perftest_template("$(format-json APP.*)\n");
@@ -444,6 +509,40 @@ Test(format_json, test_format_json_performance)
                     "--exclude .SDATA.* "
                     "..RSTAMP='${R_UNIXTIME}${R_TZ}' "
                     "..TAGS=${TAGS})\n");
+
+  LogMessage *msg = create_sample_message();
+  GString *result = g_string_new("");
+  ValuePairs *vp = value_pairs_new(configuration);
+  value_pairs_add_scope(vp, "all-nv-pairs");
+  value_pairs_set_cast_to_strings(vp, TRUE);
+
+  start_stopwatch();
+  for (gint i = 0; i < 100000; i++)
+    _format_json_with_walker(vp, msg, result);
+  stop_stopwatch_and_display_result(100000, "      %-90s", "value_pairs_walk() based JSON formatting");
+  perftest_template("$(format-json --cast --leave-initial-dot --scope all-nv-pairs)\n");
+
+  value_pairs_unref(vp);
+  g_string_free(result, TRUE);
+  log_msg_unref(msg);
+}
+
+Test(format_json, test_format_json_matches_value_pairs_walk)
+{
+  const gchar *template = "$(format-json --cast --leave-initial-dot --scope all-nv-pairs)";
+  LogMessage *msg = create_sample_message();
+  GString *expected = g_string_new("");
+
+  ValuePairs *vp = value_pairs_new(configuration);
+  value_pairs_add_scope(vp, "all-nv-pairs");
+  value_pairs_set_cast_to_strings(vp, TRUE);
+
+  _format_json_with_walker(vp, msg, expected);
+  assert_template_format_msg(template, expected->str, msg);
+
+  value_pairs_unref(vp);
+  g_string_free(expected, TRUE);
+  log_msg_unref(msg);
 }
 
 Test(format_json, test_format_json_with_key_delimiter)
@@ -46,8 +46,9 @@ _process(LogParser *s, LogMessage **pmsg, const LogPathOptions *path_options,
             evt_tag_msg_reference(*pmsg));
 
   LogTemplateEvalOptions options = {&cfg->template_options, LTZ_LOCAL, 0, NULL, LM_VT_STRING};
-  value_pairs_foreach(self->value_pairs, _map_name_values,
-                      msg, &options, msg);
+  /* values are set one by one, the order does not matter */
+  value_pairs_foreach_unsorted(self->value_pairs, _map_name_values,
+                               msg, &options, msg);
 
   return TRUE;
 }